@@ -0,0 +1,222 @@
+/*
+	Name: GdiCanvas.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of the GdiCanvas class.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GdiCanvas.h"
+#include <cstring>
+#include <vector>
+
+//------------------------------------------------------------------
+// Constructor/ Destructors
+//------------------------------------------------------------------
+
+// Constructor taking device context & pen width multiplier
+GdiCanvas::GdiCanvas(HDC _hDC, int lineScale)
+{
+	hDC = _hDC;
+	BlackPen = CreatePen(PS_SOLID, lineScale, 0x00000000);
+	WhitePen = CreatePen(PS_SOLID, lineScale, 0x00ffffff);
+	ThinGrayPen = CreatePen(PS_SOLID, lineScale, 0x00808080);
+	ThickBlackPen = CreatePen(PS_SOLID, 3 * lineScale, 0x00000000);
+	hFont = hOldFont = NULL;
+	fontSpec = {NULL, 0, false};
+}
+
+// Destructor
+GdiCanvas::~GdiCanvas()
+{
+	SelectObject(hDC, GetStockObject(BLACK_PEN));
+	if (hFont) {
+		SelectObject(hDC, hOldFont);
+		DeleteObject(hFont);
+	}
+	clearClip();
+	setOrigin(0, 0);
+	DeleteObject(BlackPen);
+	DeleteObject(WhitePen);
+	DeleteObject(ThinGrayPen);
+	DeleteObject(ThickBlackPen);
+}
+
+HDC GdiCanvas::getDC() const
+{
+	return hDC;
+}
+
+//------------------------------------------------------------------
+// Placement
+//------------------------------------------------------------------
+
+void GdiCanvas::setOrigin(int x, int y)
+{
+	SetWindowOrgEx(hDC, x, y, NULL);
+}
+
+// Clip to a rectangle in device pixels
+void GdiCanvas::setClip(int left, int top, int right, int bottom)
+{
+	HRGN hRgn = CreateRectRgn(left, top, right, bottom);
+	SelectClipRgn(hDC, hRgn);
+	DeleteObject(hRgn);
+}
+
+void GdiCanvas::clearClip()
+{
+	SelectClipRgn(hDC, NULL);
+}
+
+//------------------------------------------------------------------
+// Drawing tools
+//------------------------------------------------------------------
+
+void GdiCanvas::selectPen(CanvasPen pen)
+{
+	switch (pen) {
+		case PEN_NULL:
+			SelectObject(hDC, GetStockObject(NULL_PEN));
+			break;
+		case PEN_BLACK:
+			SelectObject(hDC, BlackPen);
+			break;
+		case PEN_WHITE:
+			SelectObject(hDC, WhitePen);
+			break;
+		case PEN_GRID:
+			SelectObject(hDC, ThinGrayPen);
+			break;
+		case PEN_WALL:
+			SelectObject(hDC, ThickBlackPen);
+			break;
+	}
+}
+
+void GdiCanvas::selectBrush(CanvasBrush brush)
+{
+	switch (brush) {
+		case BRUSH_NULL:
+			SelectObject(hDC, GetStockObject(NULL_BRUSH));
+			break;
+		case BRUSH_BLACK:
+			SelectObject(hDC, GetStockObject(BLACK_BRUSH));
+			break;
+		case BRUSH_WHITE:
+			SelectObject(hDC, GetStockObject(WHITE_BRUSH));
+			break;
+	}
+}
+
+/*
+	Select a font, reusing the current one if it matches.
+	Map painting asks for the same few fonts over & over,
+	so this saves a CreateFont for most text drawn.
+*/
+void GdiCanvas::selectFont(const CanvasFont& font)
+{
+	// Reuse current font if same request
+	if (hFont && font.height == fontSpec.height
+	        && font.bold == fontSpec.bold
+	        && !strcmp(font.face, fontSpec.face)) {
+		return;
+	}
+
+	// Create font with desired height
+	HFONT hNewFont =
+	    CreateFont(
+	        -font.height, 0, 0, 0, font.bold ? FW_BOLD : FW_NORMAL,
+	        FALSE, FALSE, FALSE, DEFAULT_CHARSET, OUT_TT_PRECIS,
+	        CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
+	        DEFAULT_PITCH | FF_DONTCARE, font.face
+	    );
+
+	// Swap it in, deleting any prior font
+	HFONT hPrior = (HFONT) SelectObject(hDC, hNewFont);
+	if (hFont) {
+		DeleteObject(hFont);
+	}
+	else {
+		hOldFont = hPrior;
+	}
+	hFont = hNewFont;
+	fontSpec = font;
+}
+
+//------------------------------------------------------------------
+// Shapes & lines
+//------------------------------------------------------------------
+
+void GdiCanvas::rectangle(int left, int top, int right, int bottom)
+{
+	Rectangle(hDC, left, top, right, bottom);
+}
+
+void GdiCanvas::ellipse(int left, int top, int right, int bottom)
+{
+	Ellipse(hDC, left, top, right, bottom);
+}
+
+void GdiCanvas::polygon(const CanvasPoint *pts, int count)
+{
+	std::vector<POINT> points(count);
+	for (int i = 0; i < count; i++) {
+		points[i] = {(LONG) pts[i].x, (LONG) pts[i].y};
+	}
+	Polygon(hDC, points.data(), count);
+}
+
+void GdiCanvas::moveTo(int x, int y)
+{
+	MoveToEx(hDC, x, y, NULL);
+}
+
+void GdiCanvas::lineTo(int x, int y)
+{
+	LineTo(hDC, x, y);
+}
+
+void GdiCanvas::arc(
+    int left, int top, int right, int bottom,
+    int xStart, int yStart, int xEnd, int yEnd)
+{
+	Arc(hDC, left, top, right, bottom, xStart, yStart, xEnd, yEnd);
+}
+
+//------------------------------------------------------------------
+// Text
+//------------------------------------------------------------------
+
+CanvasSize GdiCanvas::textExtent(const char *text)
+{
+	SIZE textSize;
+	GetTextExtentPoint32(hDC, text, (int) strlen(text), &textSize);
+	return {(int) textSize.cx, (int) textSize.cy};
+}
+
+int GdiCanvas::textHeight()
+{
+	TEXTMETRIC tm;
+	GetTextMetrics(hDC, &tm);
+	return (int) tm.tmHeight;
+}
+
+void GdiCanvas::textOut(
+    int x, int y, const char *text, CanvasTextAlign align, bool opaque)
+{
+	switch (align) {
+		case ALIGN_TOP_LEFT:
+			SetTextAlign(hDC, TA_LEFT | TA_TOP);
+			break;
+		case ALIGN_TOP_CENTER:
+			SetTextAlign(hDC, TA_CENTER | TA_TOP);
+			break;
+		case ALIGN_BASELINE_CENTER:
+			SetTextAlign(hDC, TA_CENTER | TA_BASELINE);
+			break;
+	}
+	SetBkMode(hDC, opaque ? OPAQUE : TRANSPARENT);
+	TextOut(hDC, x, y, text, (int) strlen(text));
+}
@@ -0,0 +1,60 @@
+/*
+	Name: GdiCanvas.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: GridCanvas drawing on a Windows device context.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GDICANVAS_H
+#define GDICANVAS_H
+#include <windows.h>
+#include "GridCanvas.h"
+
+/*
+	GdiCanvas interface
+	Does not own the device context; owns its pens & font.
+	Line scale multiplies pen widths, for devices much finer
+	than the screen (e.g., printers).
+*/
+class GdiCanvas: public GridCanvas {
+	public:
+
+		// Constructor
+		GdiCanvas(HDC hDC, int lineScale = 1);
+		~GdiCanvas();
+
+		// Accessors
+		HDC getDC() const;
+
+		// GridCanvas implementation
+		void setOrigin(int x, int y) override;
+		void setClip(int left, int top, int right, int bottom) override;
+		void clearClip() override;
+		void selectPen(CanvasPen pen) override;
+		void selectBrush(CanvasBrush brush) override;
+		void selectFont(const CanvasFont& font) override;
+		void rectangle(int left, int top, int right, int bottom) override;
+		void ellipse(int left, int top, int right, int bottom) override;
+		void polygon(const CanvasPoint *pts, int count) override;
+		void moveTo(int x, int y) override;
+		void lineTo(int x, int y) override;
+		void arc(
+		    int left, int top, int right, int bottom,
+		    int xStart, int yStart, int xEnd, int yEnd) override;
+		CanvasSize textExtent(const char *text) override;
+		int textHeight() override;
+		void textOut(
+		    int x, int y, const char *text,
+		    CanvasTextAlign align, bool opaque) override;
+
+	private:
+
+		// Data fields
+		HDC hDC;
+		HPEN BlackPen, WhitePen, ThinGrayPen, ThickBlackPen;
+		HFONT hFont, hOldFont;
+		CanvasFont fontSpec;
+};
+#endif
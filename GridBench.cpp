@@ -0,0 +1,1077 @@
+/*
+	Name: GridBench.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Command-line benchmark of path queries on a map.
+		Loads a map (or generates a cave or dungeon), then times
+		random distance queries between open cells by A*, by
+		jump-point search & by door graph, checking that all agree,
+		field of view & movement range from each query's start,
+		& a whole distance field & room numbering kept up through
+		random edits, & region edits in bulk checked against the
+		same edits cell by cell. Or times painting (as on a map dense with
+		stamped features) tile by tile at several cell sizes.
+		Or stress-tests map snapshots: one thread edits while others
+		paint tiles from snapshots, & every tile is checked against
+		the map as it stood at its snapshot (see "make stress").
+		Builds without windows.h.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridMap.h"
+#include "GridField.h"
+#include "GridGenerate.h"
+#include "GridPaths.h"
+#include "GridRooms.h"
+#include "GridRoutes.h"
+#include "GridSight.h"
+#include "RasterCanvas.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+// What to time
+enum BenchMode {
+	BENCH_QUERIES, BENCH_PAINT, BENCH_STRESS
+};
+
+/*
+	Benchmark settings from the command line.
+*/
+struct BenchOptions {
+	BenchMode mode;
+	const char *kind;
+	const char *mapFile;
+	unsigned width, height;
+	unsigned seed, queries;
+	bool diagonals;
+};
+
+// Kinds of edit in the snapshot stress test
+enum StressEditKind {
+	STRESS_FLOOR, STRESS_OBJECT, STRESS_NWALL, STRESS_BLOCK
+};
+
+/*
+	One edit made by the stress test writer: a cell's floor,
+	object or north wall, or the floor of a block (which can span
+	storage strips). Logged so any version can be rebuilt.
+*/
+struct StressEdit {
+	StressEditKind kind;
+	GridRect rect;
+	int value;
+};
+
+// Kinds of region edit checked in bulk against cell by cell
+enum BulkEditKind {
+	BULK_FLOOR, BULK_OBJECTS, BULK_PERIMETER
+};
+
+// Region edit: kind, region & floor or wall to set
+struct BulkEdit {
+	BulkEditKind kind;
+	GridRegion region;
+	int value;
+};
+
+// Map snapshot handed from the writer to a reader
+struct StressSnapshot {
+	GridMap *map;
+	unsigned version;
+};
+
+// Tile painted by a reader: version painted from, place & pixel hash
+struct StressTile {
+	unsigned version, left, top;
+	unsigned long long hash;
+};
+
+// Reader threads & tile size in the snapshot stress test
+const unsigned StressReaders = 4;
+const unsigned StressTilePixels = 128;
+
+// Function prototypes
+void PrintUsage();
+bool ParseOptions(int argc, char *argv[], BenchOptions& options);
+GridMap* MakeMap(const BenchOptions& options);
+GridMap* MakeFeatureMap(unsigned width, unsigned height);
+void RunQueries(
+    GridPaths& paths, const std::vector<GridCoord>& pairs, bool jump,
+    std::vector<unsigned>& distances);
+void RunRouteQueries(
+    GridRoutes& routes, const std::vector<GridCoord>& pairs,
+    std::vector<unsigned>& distances);
+void RunSightQueries(const GridMap& map, const std::vector<GridCoord>& pairs);
+void RunRangeQueries(
+    const GridMap& map, const MoveOptions& move,
+    const std::vector<GridCoord>& pairs);
+GridCoord EditRandomCell(
+    GridMap& map, const std::vector<GridCoord>& open, std::mt19937& random);
+unsigned RunFieldEdits(
+    GridMap& map, const MoveOptions& move, const std::vector<GridCoord>& open,
+    unsigned edits, std::mt19937& random);
+unsigned RunRoomEdits(
+    GridMap& map, const std::vector<GridCoord>& open, unsigned edits,
+    std::mt19937& random);
+unsigned RunBulkEdits(const GridMap& map, unsigned edits, std::mt19937& random);
+BulkEdit MakeBulkEdit(const GridMap& map, std::mt19937& random);
+GridRect ApplyBulkEdit(GridMap& map, const BulkEdit& edit);
+void ApplyCellEdits(GridMap& map, const BulkEdit& edit);
+void RunPaintTiles(GridMap& map, unsigned tiles, unsigned seed);
+StressEdit MakeStressEdit(const GridMap& map, std::mt19937& random);
+void ApplyStressEdit(GridMap& map, const StressEdit& edit);
+unsigned long long PaintTileHash(
+    GridMap& map, RasterCanvas& canvas, unsigned left, unsigned top);
+void RunStressReader(
+    std::atomic<StressSnapshot*>& latest, const std::atomic<bool>& done,
+    unsigned seed, std::vector<StressTile>& tiles);
+unsigned RunSnapshotStress(const GridMap& map, unsigned edits, unsigned seed);
+
+/*
+	Command-line entry point.
+*/
+int main(int argc, char *argv[])
+{
+	// Parse command line
+	BenchOptions options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return 2;
+	}
+
+	// Get map
+	GridMap *map = MakeMap(options);
+	if (!map) {
+		return 1;
+	}
+	if (options.mode == BENCH_PAINT) {
+		RunPaintTiles(*map, options.queries, options.seed);
+		delete map;
+		return 0;
+	}
+	if (options.mode == BENCH_STRESS) {
+		unsigned numDiffer =
+		    RunSnapshotStress(*map, options.queries, options.seed);
+		delete map;
+		return numDiffer ? 1 : 0;
+	}
+
+	// Pick query endpoints among open cells
+	std::vector<GridCoord> open;
+	for (unsigned x = 0; x < map->getWidthCells(); x++) {
+		const GridCell *column = map->getColumn(x);
+		for (unsigned y = 0; y < map->getHeightCells(); y++) {
+			if (column[y].floor == FLOOR_OPEN) {
+				open.push_back({x, y});
+			}
+		}
+	}
+	if (open.empty()) {
+		fprintf(stderr, "Map has no open cells\n");
+		delete map;
+		return 1;
+	}
+	std::mt19937 random(options.seed);
+	std::vector<GridCoord> pairs;
+	for (unsigned i = 0; i < 2 * options.queries; i++) {
+		pairs.push_back(open[random() % open.size()]);
+	}
+
+	// Time all searches
+	// (secret doors passable, as for the referee)
+	MoveOptions move;
+	move.diagonals = options.diagonals;
+	move.pass.secretDoors = true;
+	GridPaths paths(*map, move);
+	printf("Map %u x %u, %u queries\n",
+	       map->getWidthCells(), map->getHeightCells(), options.queries);
+	std::vector<unsigned> distances[3];
+	for (int jump = 0; jump <= 1; jump++) {
+		RunQueries(paths, pairs, jump, distances[jump]);
+	}
+	GridRoutes routes(*map, move);
+	RunRouteQueries(routes, pairs, distances[2]);
+	RunSightQueries(*map, pairs);
+	RunRangeQueries(*map, move, pairs);
+
+	// Check agreement
+	unsigned numDiffer = 0;
+	for (unsigned i = 0; i < options.queries; i++) {
+		if (distances[0][i] != distances[1][i]
+		        || distances[0][i] != distances[2][i]) {
+			numDiffer++;
+		}
+	}
+	if (numDiffer) {
+		fprintf(stderr, "Searches disagree on %u queries\n", numDiffer);
+	}
+
+	// Edit the map, keeping a distance field & rooms up to date
+	numDiffer += RunFieldEdits(*map, move, open, options.queries, random);
+	numDiffer += RunRoomEdits(*map, open, options.queries, random);
+	numDiffer += RunBulkEdits(*map, options.queries, random);
+	delete map;
+	return numDiffer ? 1 : 0;
+}
+
+/*
+	Print command-line help.
+*/
+void PrintUsage()
+{
+	fprintf(stderr,
+	    "Usage: gridbench [options] cave|dungeon|features|file.gmap\n"
+	    "Options:\n"
+	    "  -m mode     What to run: queries (default), paint or stress\n"
+	    "  -w cells    Generated map width (default 1000)\n"
+	    "  -h cells    Generated map height (default 1000)\n"
+	    "  -s seed     Seed for map & queries (default 1)\n"
+	    "  -n count    Number of queries, tiles or edits (default 1000)\n"
+	    "  -o          Orthogonal moves only (no diagonals)\n");
+}
+
+/*
+	Parse the command line into options.
+	Returns false on any error.
+*/
+bool ParseOptions(int argc, char *argv[], BenchOptions& options)
+{
+	// Set defaults
+	options.mode = BENCH_QUERIES;
+	options.kind = NULL;
+	options.mapFile = NULL;
+	options.width = options.height = 1000;
+	options.seed = 1;
+	options.queries = 1000;
+	options.diagonals = true;
+
+	// Read arguments
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg[0] != '-') {
+			if (options.kind || options.mapFile) {
+				fprintf(stderr, "Extra argument: %s\n", arg);
+				return false;
+			}
+			if (!strcmp(arg, "cave") || !strcmp(arg, "dungeon")
+			        || !strcmp(arg, "features")) {
+				options.kind = arg;
+			}
+			else {
+				options.mapFile = arg;
+			}
+		}
+		else if (!strcmp(arg, "-m") && hasValue) {
+			const char *mode = argv[++i];
+			if (!strcmp(mode, "queries")) {
+				options.mode = BENCH_QUERIES;
+			}
+			else if (!strcmp(mode, "paint")) {
+				options.mode = BENCH_PAINT;
+			}
+			else if (!strcmp(mode, "stress")) {
+				options.mode = BENCH_STRESS;
+			}
+			else {
+				fprintf(stderr, "Unknown mode: %s\n", mode);
+				return false;
+			}
+		}
+		else if (!strcmp(arg, "-w") && hasValue) {
+			int width = atoi(argv[++i]);
+			if (width < 1) {
+				fprintf(stderr, "Bad width: %s\n", argv[i]);
+				return false;
+			}
+			options.width = width;
+		}
+		else if (!strcmp(arg, "-h") && hasValue) {
+			int height = atoi(argv[++i]);
+			if (height < 1) {
+				fprintf(stderr, "Bad height: %s\n", argv[i]);
+				return false;
+			}
+			options.height = height;
+		}
+		else if (!strcmp(arg, "-s") && hasValue) {
+			options.seed = strtoul(argv[++i], NULL, 10);
+		}
+		else if (!strcmp(arg, "-n") && hasValue) {
+			int count = atoi(argv[++i]);
+			if (count < 1) {
+				fprintf(stderr, "Bad count: %s\n", argv[i]);
+				return false;
+			}
+			options.queries = count;
+		}
+		else if (!strcmp(arg, "-o")) {
+			options.diagonals = false;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n", arg);
+			return false;
+		}
+	}
+	return options.kind || options.mapFile;
+}
+
+/*
+	Load or generate the map to search (new; caller deletes).
+	Returns NULL on failure.
+*/
+GridMap* MakeMap(const BenchOptions& options)
+{
+	if (options.mapFile) {
+		const char *file = options.mapFile;
+		std::vector<char> filename(file, file + strlen(file) + 1);
+		GridMap *map = new GridMap(filename.data());
+		if (!map->isFileLoadOk()) {
+			fprintf(stderr, "Could not read map: %s\n", options.mapFile);
+			delete map;
+			return NULL;
+		}
+		return map;
+	}
+	if (!strcmp(options.kind, "features")) {
+		return MakeFeatureMap(options.width, options.height);
+	}
+	if (!strcmp(options.kind, "dungeon")) {
+		DungeonOptions dungeon;
+		dungeon.seed = options.seed;
+		return GenerateDungeon(options.width, options.height, dungeon);
+	}
+	CaveOptions cave;
+	cave.seed = options.seed;
+	return GenerateCave(options.width, options.height, cave);
+}
+
+/*
+	Make a map dense with stamped features (new; caller deletes):
+	open floor with spiral stairs, statues & stalagmites in turn
+	(diagonally, so each shows in every row & column).
+*/
+GridMap* MakeFeatureMap(unsigned width, unsigned height)
+{
+	GridMap *map = new GridMap(width, height);
+	map->clearMap(FLOOR_OPEN);
+	for (unsigned x = 0; x < width; x++) {
+		for (unsigned y = 0; y < height; y++) {
+			switch ((x + y) % 3) {
+				case 0:
+					map->setCellFloor({x, y}, FLOOR_SPIRALSTAIRS);
+					break;
+				case 1:
+					map->setCellObject({x, y}, OBJECT_STATUE);
+					break;
+				default:
+					map->setCellObject({x, y}, OBJECT_STALAGMITE);
+					break;
+			}
+		}
+	}
+	return map;
+}
+
+/*
+	Run & time all queries by one search, saving distances.
+*/
+void RunQueries(
+    GridPaths& paths, const std::vector<GridCoord>& pairs, bool jump,
+    std::vector<unsigned>& distances)
+{
+	unsigned queries = pairs.size() / 2, numFound = 0;
+	unsigned long long expanded = 0;
+	distances.clear();
+	auto startTime = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < queries; i++) {
+		unsigned distance = paths.getDistance(
+		    pairs[2 * i], pairs[2 * i + 1], jump);
+		distances.push_back(distance);
+		expanded += paths.getNodesExpanded();
+		if (distance != NO_PATH) {
+			numFound++;
+		}
+	}
+	double seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	printf("%-10s %u paths found in %.3f s (%.1f queries/s), "
+	       "%.0f nodes expanded per query\n",
+	       jump ? "Jump point" : "A*", numFound, seconds,
+	       seconds > 0 ? queries / seconds : 0.0,
+	       (double) expanded / queries);
+}
+
+/*
+	Build the door graph, then run & time all queries by it,
+	saving distances.
+*/
+void RunRouteQueries(
+    GridRoutes& routes, const std::vector<GridCoord>& pairs,
+    std::vector<unsigned>& distances)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	routes.build();
+	double buildSeconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	printf("Door graph %u rooms, %u doors built in %.3f s\n",
+	       routes.getRoomCount(), routes.getDoorCount(), buildSeconds);
+	unsigned queries = pairs.size() / 2, numFound = 0;
+	distances.clear();
+	startTime = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < queries; i++) {
+		unsigned distance = routes.getDistance(pairs[2 * i], pairs[2 * i + 1]);
+		distances.push_back(distance);
+		if (distance != NO_PATH) {
+			numFound++;
+		}
+	}
+	double seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	printf("%-10s %u paths found in %.3f s (%.1f queries/s)\n",
+	       "Doors", numFound, seconds,
+	       seconds > 0 ? queries / seconds : 0.0);
+}
+
+/*
+	Run & time field of view from the start of each query
+	(as for a token moving there).
+*/
+void RunSightQueries(const GridMap& map, const std::vector<GridCoord>& pairs)
+{
+	GridSight sight(map);
+	unsigned queries = pairs.size() / 2;
+	unsigned long long area = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < queries; i++) {
+		sight.clearVisible();
+		sight.addViewpoint(pairs[2 * i]);
+		GridRect bounds = sight.getVisibleBounds();
+		area += (unsigned long long) (bounds.right - bounds.left)
+		        * (bounds.bottom - bounds.top);
+	}
+	double seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	printf("%-10s %u views in %.3f s (%.1f us per view), "
+	       "%.0f cells in view bounds\n",
+	       "Sight", queries, seconds, seconds * 1e6 / queries,
+	       (double) area / queries);
+}
+
+/*
+	Run & time a movement range (within RangeSquares plain steps)
+	from the start of each query, as for a token dragged there.
+*/
+void RunRangeQueries(
+    const GridMap& map, const MoveOptions& move,
+    const std::vector<GridCoord>& pairs)
+{
+	const unsigned RangeSquares = 30;
+	GridField field(map, move);
+	unsigned queries = pairs.size() / 2;
+	unsigned long long settled = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < queries; i++) {
+		field.setSources({pairs[2 * i]}, RangeSquares * move.stepCost);
+		settled += field.getNodesSettled();
+	}
+	double seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	printf("%-10s %u ranges in %.3f s (%.1f us per range), "
+	       "%.0f nodes settled per range\n",
+	       "Range", queries, seconds, seconds * 1e6 / queries,
+	       (double) settled / queries);
+}
+
+/*
+	Find a whole distance field from the first open cell, then
+	make random edits (walls & floors), updating the field after
+	each, & check it against a fresh one. Returns the number of
+	cells that differ.
+*/
+unsigned RunFieldEdits(
+    GridMap& map, const MoveOptions& move, const std::vector<GridCoord>& open,
+    unsigned edits, std::mt19937& random)
+{
+	GridField field(map, move);
+	auto startTime = std::chrono::steady_clock::now();
+	field.setSources({open[0]});
+	double seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	printf("%-10s %u nodes settled in %.3f s\n",
+	       "Field", field.getNodesSettled(), seconds);
+
+	// Edit & update
+	unsigned long long settled = 0;
+	startTime = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < edits; i++) {
+		GridCoord gc = EditRandomCell(map, open, random);
+		field.updateCell(gc);
+		settled += field.getNodesSettled();
+	}
+	seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	printf("%-10s %u edits in %.3f s (%.1f us per edit), "
+	       "%.0f nodes settled per edit\n",
+	       "Updates", edits, seconds, seconds * 1e6 / edits,
+	       (double) settled / edits);
+
+	// Check against a fresh field
+	GridField fresh(map, move);
+	fresh.setSources({open[0]});
+	unsigned numDiffer = 0;
+	for (unsigned x = 0; x < map.getWidthCells(); x++) {
+		for (unsigned y = 0; y < map.getHeightCells(); y++) {
+			if (field.getDistance({x, y}) != fresh.getDistance({x, y})) {
+				numDiffer++;
+			}
+		}
+	}
+	if (numDiffer) {
+		fprintf(stderr, "Updated field differs on %u cells\n", numDiffer);
+	}
+	return numDiffer;
+}
+
+/*
+	Make one random edit at an open cell (toggle a wall, a door,
+	or water), returning the cell edited.
+*/
+GridCoord EditRandomCell(
+    GridMap& map, const std::vector<GridCoord>& open, std::mt19937& random)
+{
+	GridCoord gc = open[random() % open.size()];
+	switch (random() % 3) {
+		case 0:
+			if (map.canBuildNWall(gc)) {
+				map.setCellNWall(gc, map.getCellNWall(gc) == WALL_OPEN
+				                 ? WALL_FILL : WALL_OPEN);
+			}
+			break;
+		case 1:
+			if (map.canBuildWWall(gc)) {
+				map.setCellWWall(gc, map.getCellWWall(gc) == WALL_OPEN
+				                 ? WALL_SINGLE_DOOR : WALL_OPEN);
+			}
+			break;
+		default:
+			map.setCellFloor(gc, map.getCellFloor(gc) == FLOOR_OPEN
+			                 ? FLOOR_WATER : FLOOR_OPEN);
+			break;
+	}
+	return gc;
+}
+
+/*
+	Time numbering rooms on the map, then keeping the numbering
+	up through random edits. Checks the result against numbering
+	afresh (same segments, kinds & labels), returning the number
+	of cells that differ.
+*/
+unsigned RunRoomEdits(
+    GridMap& map, const std::vector<GridCoord>& open, unsigned edits,
+    std::mt19937& random)
+{
+	GridRooms rooms(map);
+	auto startTime = std::chrono::steady_clock::now();
+	rooms.build();
+	double seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	printf("%-10s %u rooms found in %.3f s\n",
+	       "Rooms", rooms.getRoomCount(), seconds);
+
+	// Edit & update
+	startTime = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < edits; i++) {
+		rooms.updateCell(EditRandomCell(map, open, random));
+	}
+	seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	printf("%-10s %u edits in %.3f s (%.1f us per edit), %u rooms\n",
+	       "Updates", edits, seconds, seconds * 1e6 / edits,
+	       rooms.getRoomCount());
+
+	// Check against rooms found afresh: segments must match
+	// one to one, with the same kind, size & label
+	GridRooms fresh(map);
+	fresh.build();
+	std::vector<unsigned> match(rooms.getSegmentLimit(), 0);
+	std::vector<unsigned> matchFresh(fresh.getSegmentLimit(), 0);
+	unsigned numDiffer = 0;
+	for (unsigned x = 0; x < map.getWidthCells(); x++) {
+		for (unsigned y = 0; y < map.getHeightCells(); y++) {
+			for (int half = 0; half <= 1; half++) {
+				unsigned a = rooms.getSegment({x, y}, half);
+				unsigned b = fresh.getSegment({x, y}, half);
+				if (!a || !b) {
+					numDiffer += a != b;
+					continue;
+				}
+				const RoomSegment& infoA = rooms.getSegmentInfo(a);
+				const RoomSegment& infoB = fresh.getSegmentInfo(b);
+				if (!match[a] && !matchFresh[b]) {
+					match[a] = b;
+					matchFresh[b] = a;
+				}
+				if (match[a] != b || matchFresh[b] != a
+				        || infoA.kind != infoB.kind || infoA.cells != infoB.cells
+				        || infoA.label.x != infoB.label.x
+				        || infoA.label.y != infoB.label.y) {
+					numDiffer++;
+				}
+			}
+		}
+	}
+	if (numDiffer) {
+		fprintf(stderr, "Updated rooms differ on %u cells\n", numDiffer);
+	}
+	return numDiffer;
+}
+
+/*
+	Make random region edits (fill floors, clear objects & wall
+	around) on one copy of the map in bulk & on another cell by cell
+	with the single-cell setters, timing each. After every edit the
+	copies must match around the region, & the bulk edit must report
+	every cell it changed. Returns the number of cells that differ.
+*/
+unsigned RunBulkEdits(const GridMap& map, unsigned edits, std::mt19937& random)
+{
+	GridMap bulk(map), single(map);
+	double bulkSeconds = 0, singleSeconds = 0;
+	unsigned numDiffer = 0;
+	for (unsigned i = 0; i < edits; i++) {
+		BulkEdit edit = MakeBulkEdit(map, random);
+		GridMap before(bulk);
+		auto startTime = std::chrono::steady_clock::now();
+		GridRect changed = ApplyBulkEdit(bulk, edit);
+		auto midTime = std::chrono::steady_clock::now();
+		ApplyCellEdits(single, edit);
+		auto endTime = std::chrono::steady_clock::now();
+		bulkSeconds +=
+		    std::chrono::duration<double>(midTime - startTime).count();
+		singleSeconds +=
+		    std::chrono::duration<double>(endTime - midTime).count();
+
+		// Compare cells in & just around the region
+		const GridRect& r = edit.region.bounds;
+		unsigned right = std::min(r.right + 1, map.getWidthCells());
+		unsigned bottom = std::min(r.bottom + 1, map.getHeightCells());
+		for (unsigned x = r.left; x < right; x++) {
+			const GridCell *a = bulk.getColumn(x);
+			const GridCell *b = single.getColumn(x);
+			const GridCell *was = before.getColumn(x);
+			for (unsigned y = r.top; y < bottom; y++) {
+				bool inChanged = x >= changed.left && x < changed.right
+				                 && y >= changed.top && y < changed.bottom;
+				if (memcmp(&a[y], &b[y], sizeof(GridCell))
+				        || (!inChanged
+				            && memcmp(&a[y], &was[y], sizeof(GridCell)))) {
+					numDiffer++;
+				}
+			}
+		}
+	}
+	printf("%-10s %u region edits in %.3f s (%.1f us per edit), "
+	       "cell by cell in %.3f s\n",
+	       "Bulk", edits, bulkSeconds, bulkSeconds * 1e6 / edits,
+	       singleSeconds);
+	if (numDiffer) {
+		fprintf(stderr, "Bulk edits differ on %u cells\n", numDiffer);
+	}
+	return numDiffer;
+}
+
+/*
+	Make a random region edit: a block up to 32 cells square,
+	half the time masked to about three cells in four.
+*/
+BulkEdit MakeBulkEdit(const GridMap& map, std::mt19937& random)
+{
+	const int floors[] = {FLOOR_OPEN, FLOOR_FILL, FLOOR_WATER, FLOOR_NWFILL};
+	const int walls[] = {WALL_FILL, WALL_OPEN, WALL_SINGLE_DOOR};
+	BulkEdit edit;
+	GridRect& r = edit.region.bounds;
+	r.left = random() % map.getWidthCells();
+	r.top = random() % map.getHeightCells();
+	r.right = r.left + 1 + random() % 32;
+	r.bottom = r.top + 1 + random() % 32;
+	r.right = std::min(r.right, map.getWidthCells());
+	r.bottom = std::min(r.bottom, map.getHeightCells());
+	if (random() % 2) {
+		edit.region.mask.resize((r.right - r.left) * (r.bottom - r.top));
+		for (unsigned char& in: edit.region.mask) {
+			in = random() % 4 != 0;
+		}
+	}
+	switch (random() % 3) {
+		case 0:
+			edit.kind = BULK_FLOOR;
+			edit.value = floors[random() % 4];
+			break;
+		case 1:
+			edit.kind = BULK_OBJECTS;
+			edit.value = OBJECT_NONE;
+			break;
+		default:
+			edit.kind = BULK_PERIMETER;
+			edit.value = walls[random() % 3];
+			break;
+	}
+	return edit;
+}
+
+// Make a region edit in bulk, returning the block changed
+GridRect ApplyBulkEdit(GridMap& map, const BulkEdit& edit)
+{
+	switch (edit.kind) {
+		case BULK_FLOOR:
+			return map.fillFloor(edit.region, edit.value);
+		case BULK_OBJECTS:
+			return map.clearObjects(edit.region);
+		default:
+			return map.setPerimeterWalls(edit.region, edit.value);
+	}
+}
+
+/*
+	Make a region edit cell by cell with the single-cell setters:
+	floors first, then (for fill types) objects & walls no longer
+	allowed cleared; or objects cleared; or walls set on every edge
+	out of the region, where they can be built.
+*/
+void ApplyCellEdits(GridMap& map, const BulkEdit& edit)
+{
+	const GridRegion& region = edit.region;
+	const GridRect& r = region.bounds;
+	unsigned width = map.getWidthCells(), height = map.getHeightCells();
+	bool open = (edit.value == WALL_OPEN);
+	for (unsigned x = r.left; x < r.right; x++) {
+		for (unsigned y = r.top; y < r.bottom; y++) {
+			if (!IsInRegion(region, {x, y})) {
+				continue;
+			}
+			switch (edit.kind) {
+				case BULK_FLOOR:
+					map.setCellFloor({x, y}, edit.value);
+					break;
+				case BULK_OBJECTS:
+					map.setCellObject({x, y}, OBJECT_NONE);
+					break;
+				default:
+					if (!IsInRegion(region, {x, y - 1})
+					        && (open || map.canBuildNWall({x, y})))
+						map.setCellNWall({x, y}, edit.value);
+					if (y + 1 < height && !IsInRegion(region, {x, y + 1})
+					        && (open || map.canBuildNWall({x, y + 1})))
+						map.setCellNWall({x, y + 1}, edit.value);
+					if (!IsInRegion(region, {x - 1, y})
+					        && (open || map.canBuildWWall({x, y})))
+						map.setCellWWall({x, y}, edit.value);
+					if (x + 1 < width && !IsInRegion(region, {x + 1, y})
+					        && (open || map.canBuildWWall({x + 1, y})))
+						map.setCellWWall({x + 1, y}, edit.value);
+					break;
+			}
+		}
+	}
+	if (edit.kind != BULK_FLOOR
+	        || !IsFloorFillType((FloorType) edit.value)) {
+		return;
+	}
+	for (unsigned x = r.left; x < r.right; x++) {
+		for (unsigned y = r.top; y < r.bottom; y++) {
+			if (!IsInRegion(region, {x, y})) {
+				continue;
+			}
+			if (map.getCellFloor({x, y}) == FLOOR_FILL
+			        && map.getCellObject({x, y}))
+				map.setCellObject({x, y}, OBJECT_NONE);
+			if (map.getCellWWall({x, y}) && !map.canBuildWWall({x, y}))
+				map.setCellWWall({x, y}, WALL_OPEN);
+			if (map.getCellNWall({x, y}) && !map.canBuildNWall({x, y}))
+				map.setCellNWall({x, y}, WALL_OPEN);
+			if (x + 1 < width && map.getCellWWall({x + 1, y})
+			        && !map.canBuildWWall({x + 1, y}))
+				map.setCellWWall({x + 1, y}, WALL_OPEN);
+			if (y + 1 < height && map.getCellNWall({x, y + 1})
+			        && !map.canBuildNWall({x, y + 1}))
+				map.setCellNWall({x, y + 1}, WALL_OPEN);
+		}
+	}
+}
+
+/*
+	Time painting the same random tiles (TilePixels square, as the
+	editor paints) at the smallest, default & a large cell size,
+	after timing the feature geometry made for each size.
+*/
+void RunPaintTiles(GridMap& map, unsigned tiles, unsigned seed)
+{
+	const unsigned TilePixels = 256;
+	const unsigned sizes[] = {
+		GridMap::getCellSizeMin(), GridMap::getCellSizeDefault(), 40
+	};
+	printf("Map %u x %u, %u tiles of %u pixels\n",
+	       map.getWidthCells(), map.getHeightCells(), tiles, TilePixels);
+	RasterCanvas canvas(TilePixels, TilePixels);
+	for (unsigned size: sizes) {
+
+		// Scale feature geometry
+		auto startTime = std::chrono::steady_clock::now();
+		map.setCellSizePixels(size);
+		double geometrySeconds =
+		    std::chrono::duration<double>(
+		        std::chrono::steady_clock::now() - startTime).count();
+
+		// Paint tiles (same places for every size)
+		unsigned tileCells = TilePixels / size;
+		unsigned tilesWide = (map.getWidthCells() + tileCells - 1) / tileCells;
+		unsigned tilesHigh =
+		    (map.getHeightCells() + tileCells - 1) / tileCells;
+		std::mt19937 random(seed);
+		unsigned long long cells = 0;
+		startTime = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < tiles; i++) {
+			unsigned left = random() % tilesWide * tileCells;
+			unsigned top = random() % tilesHigh * tileCells;
+			unsigned right = std::min(left + tileCells, map.getWidthCells());
+			unsigned bottom = std::min(top + tileCells, map.getHeightCells());
+			canvas.clear(SHADE_WHITE);
+			canvas.setOrigin(left * size, top * size);
+			map.paintRegion(canvas, left, top, right, bottom);
+			cells += (unsigned long long) (right - left) * (bottom - top);
+		}
+		double seconds =
+		    std::chrono::duration<double>(
+		        std::chrono::steady_clock::now() - startTime).count();
+		printf("Paint %2u px geometry in %.1f us, %u tiles in %.3f s "
+		       "(%.1f us per tile, %.0f ns per cell)\n",
+		       size, geometrySeconds * 1e6, tiles, seconds,
+		       seconds * 1e6 / tiles, seconds * 1e9 / cells);
+	}
+}
+
+/*
+	Make a random edit for the snapshot stress test.
+*/
+StressEdit MakeStressEdit(const GridMap& map, std::mt19937& random)
+{
+	const unsigned MaxBlock = 20;
+	unsigned width = map.getWidthCells(), height = map.getHeightCells();
+	StressEdit edit;
+	edit.kind = (StressEditKind) (random() % 4);
+	unsigned x = random() % width, y = random() % height;
+	unsigned right = x + 1 + random() % MaxBlock;
+	unsigned bottom = y + 1 + random() % MaxBlock;
+	edit.rect = {x, y, std::min(right, width), std::min(bottom, height)};
+	switch (edit.kind) {
+		case STRESS_FLOOR:
+		case STRESS_BLOCK:
+			edit.value = random() % 2 ? FLOOR_OPEN
+			             : random() % 2 ? FLOOR_WATER : FLOOR_FILL;
+			break;
+		case STRESS_OBJECT:
+			edit.value = random() % 2 ? OBJECT_NONE
+			             : random() % 2 ? OBJECT_STATUE : OBJECT_STALAGMITE;
+			break;
+		default:
+			edit.value = random() % 2 ? WALL_FILL : WALL_OPEN;
+			break;
+	}
+	return edit;
+}
+
+/*
+	Apply a stress test edit (the same way when writing & when
+	rebuilding a version to check against).
+*/
+void ApplyStressEdit(GridMap& map, const StressEdit& edit)
+{
+	GridCoord gc = {edit.rect.left, edit.rect.top};
+	switch (edit.kind) {
+		case STRESS_FLOOR:
+			map.setCellFloor(gc, edit.value);
+			break;
+		case STRESS_OBJECT:
+			if (map.getCellFloor(gc) != FLOOR_FILL) {
+				map.setCellObject(gc, edit.value);
+			}
+			break;
+		case STRESS_NWALL:
+			if (map.canBuildNWall(gc)) {
+				map.setCellNWall(gc, edit.value);
+			}
+			break;
+		default:
+			map.fillFloor({edit.rect, {}}, edit.value);
+			break;
+	}
+}
+
+/*
+	Paint a tile of a map (top-left cell given) & hash its pixels
+	(FNV-1a).
+*/
+unsigned long long PaintTileHash(
+    GridMap& map, RasterCanvas& canvas, unsigned left, unsigned top)
+{
+	unsigned size = map.getCellSizePixels();
+	unsigned tileCells = StressTilePixels / size;
+	unsigned right = std::min(left + tileCells, map.getWidthCells());
+	unsigned bottom = std::min(top + tileCells, map.getHeightCells());
+	canvas.clear(SHADE_WHITE);
+	canvas.setOrigin(left * size, top * size);
+	map.paintRegion(canvas, left, top, right, bottom);
+	unsigned long long hash = 14695981039346656037ull;
+	for (int y = 0; y < canvas.getHeight(); y++) {
+		const unsigned char *row = canvas.getRow(y);
+		for (int x = 0; x < canvas.getWidth(); x++) {
+			hash = (hash ^ row[x]) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+/*
+	Stress test reader thread: until done, take the newest snapshot
+	(if any is waiting) & paint a random tile from the one held,
+	as the editor's tile renderer does, saving each tile's hash.
+*/
+void RunStressReader(
+    std::atomic<StressSnapshot*>& latest, const std::atomic<bool>& done,
+    unsigned seed, std::vector<StressTile>& tiles)
+{
+	std::mt19937 random(seed);
+	RasterCanvas canvas(StressTilePixels, StressTilePixels);
+	StressSnapshot *current = NULL;
+	while (!done) {
+		StressSnapshot *snapshot = latest.exchange(NULL);
+		if (snapshot) {
+			if (current) {
+				delete current->map;
+				delete current;
+			}
+			current = snapshot;
+		}
+		if (!current) {
+			std::this_thread::yield();
+			continue;
+		}
+		GridMap& map = *current->map;
+		unsigned tileCells = StressTilePixels / map.getCellSizePixels();
+		unsigned left = random() % map.getWidthCells() / tileCells * tileCells;
+		unsigned top = random() % map.getHeightCells() / tileCells * tileCells;
+		tiles.push_back({current->version, left, top,
+		                 PaintTileHash(map, canvas, left, top)});
+	}
+	if (current) {
+		delete current->map;
+		delete current;
+	}
+}
+
+/*
+	Stress-test copy-on-write snapshots: this thread makes random
+	edits, handing a snapshot of each version to reader threads
+	(through an atomic swap, as the tile renderer does), while they
+	paint tiles from whatever snapshots they hold. Then every tile
+	is painted again from the map rebuilt at its version, & must
+	match. Returns the number of tiles that differ.
+	Build with ThreadSanitizer to check for data races too.
+*/
+unsigned RunSnapshotStress(const GridMap& map, unsigned edits, unsigned seed)
+{
+	// Start readers
+	std::atomic<StressSnapshot*> latest(NULL);
+	std::atomic<bool> done(false);
+	std::vector<std::vector<StressTile>> readerTiles(StressReaders);
+	std::vector<std::thread> readers;
+	for (unsigned i = 0; i < StressReaders; i++) {
+		readers.emplace_back(
+		    RunStressReader, std::ref(latest), std::cref(done),
+		    seed + 1 + i, std::ref(readerTiles[i]));
+	}
+
+	// Edit & publish each version
+	auto startTime = std::chrono::steady_clock::now();
+	GridMap live(map);
+	std::mt19937 random(seed);
+	std::vector<StressEdit> log;
+	for (unsigned version = 0; version <= edits; version++) {
+		if (version > 0) {
+			log.push_back(MakeStressEdit(live, random));
+			ApplyStressEdit(live, log.back());
+		}
+		StressSnapshot *old =
+		    latest.exchange(new StressSnapshot {new GridMap(live), version});
+		if (old) {
+			delete old->map;
+			delete old;
+		}
+		std::this_thread::yield();
+	}
+	done = true;
+	for (std::thread& reader: readers) {
+		reader.join();
+	}
+	StressSnapshot *left = latest.exchange(NULL);
+	if (left) {
+		delete left->map;
+		delete left;
+	}
+	double seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+
+	// Repaint each tile from its version, rebuilt in order
+	std::vector<StressTile> tiles;
+	for (const std::vector<StressTile>& some: readerTiles) {
+		tiles.insert(tiles.end(), some.begin(), some.end());
+	}
+	std::stable_sort(
+	    tiles.begin(), tiles.end(),
+	    [](const StressTile& a, const StressTile& b) {
+	        return a.version < b.version;
+	    });
+	GridMap check(map);
+	RasterCanvas canvas(StressTilePixels, StressTilePixels);
+	unsigned applied = 0, numDiffer = 0, versions = 0;
+	for (unsigned i = 0; i < tiles.size(); i++) {
+		const StressTile& tile = tiles[i];
+		while (applied < tile.version) {
+			ApplyStressEdit(check, log[applied++]);
+		}
+		if (i == 0 || tile.version != tiles[i - 1].version) {
+			versions++;
+		}
+		if (PaintTileHash(check, canvas, tile.left, tile.top) != tile.hash) {
+			numDiffer++;
+		}
+	}
+	printf("%-10s %u edits in %.3f s, %u readers painted %u tiles "
+	       "from %u versions\n",
+	       "Stress", edits, seconds, StressReaders,
+	       (unsigned) tiles.size(), versions);
+	if (numDiffer) {
+		fprintf(stderr, "%u tiles differ from their versions\n", numDiffer);
+	}
+	return numDiffer;
+}
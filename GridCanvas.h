@@ -0,0 +1,95 @@
+/*
+	Name: GridCanvas.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Abstract drawing surface used to paint grid maps.
+		Mirrors the handful of GDI calls the map painter needs,
+		so maps can be drawn on a window, a printer, or a
+		platform-independent raster image.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDCANVAS_H
+#define GRIDCANVAS_H
+
+/*
+	Structure for a canvas pixel coordinate.
+*/
+struct CanvasPoint {
+	int x, y;
+};
+
+/*
+	Structure for a canvas extent in pixels.
+*/
+struct CanvasSize {
+	int cx, cy;
+};
+
+// Pens for outlines & lines
+enum CanvasPen {
+	PEN_NULL, PEN_BLACK, PEN_WHITE, PEN_GRID, PEN_WALL
+};
+
+// Brushes for filled shapes
+enum CanvasBrush {
+	BRUSH_NULL, BRUSH_BLACK, BRUSH_WHITE
+};
+
+// Text reference point
+enum CanvasTextAlign {
+	ALIGN_TOP_LEFT, ALIGN_TOP_CENTER, ALIGN_BASELINE_CENTER
+};
+
+/*
+	Structure for a font request.
+	Height is the character (em) height in pixels.
+*/
+struct CanvasFont {
+	const char *face;
+	int height;
+	bool bold;
+};
+
+/*
+	GridCanvas interface
+	Shape semantics follow GDI: rectangles & ellipses exclude
+	their right & bottom edges, and lines exclude their last point.
+	The origin is the drawing coordinate shown at pixel (0, 0);
+	the clip rectangle is in pixels, regardless of origin.
+*/
+class GridCanvas {
+	public:
+		virtual ~GridCanvas() {}
+
+		// Placement
+		virtual void setOrigin(int x, int y) = 0;
+		virtual void setClip(int left, int top, int right, int bottom) = 0;
+		virtual void clearClip() = 0;
+
+		// Drawing tools
+		virtual void selectPen(CanvasPen pen) = 0;
+		virtual void selectBrush(CanvasBrush brush) = 0;
+		virtual void selectFont(const CanvasFont& font) = 0;
+
+		// Shapes (outlined with pen, filled with brush)
+		virtual void rectangle(int left, int top, int right, int bottom) = 0;
+		virtual void ellipse(int left, int top, int right, int bottom) = 0;
+		virtual void polygon(const CanvasPoint *pts, int count) = 0;
+
+		// Lines & arcs (pen only)
+		virtual void moveTo(int x, int y) = 0;
+		virtual void lineTo(int x, int y) = 0;
+		virtual void arc(
+		    int left, int top, int right, int bottom,
+		    int xStart, int yStart, int xEnd, int yEnd) = 0;
+
+		// Text (in the selected font)
+		virtual CanvasSize textExtent(const char *text) = 0;
+		virtual int textHeight() = 0;
+		virtual void textOut(
+		    int x, int y, const char *text,
+		    CanvasTextAlign align, bool opaque) = 0;
+};
+#endif
@@ -0,0 +1,133 @@
+/*
+	Name: GridExport.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of banded map image export.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridExport.h"
+#include "GridSvg.h"
+#include "RasterCanvas.h"
+#include "ImageFile.h"
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+// Check for a format ExportMapImage() can write
+bool IsExportFormat(const char *format)
+{
+	if (!strcmp(format, "svg")) {
+		return true;
+	}
+	ImageWriter *writer = NewImageWriter(format);
+	bool known = (writer != NULL);
+	delete writer;
+	return known;
+}
+
+/*
+	Pick the number of pixel rows per band.
+	Fills the memory budget, rounded down to whole cell rows
+	where possible so fewer cells straddle two bands.
+*/
+unsigned GetExportBandRows(const GridMap& map, size_t memoryBudget)
+{
+	unsigned long long width = map.getWidthPixels();
+	unsigned long long height = map.getHeightPixels();
+	unsigned long long rows = width ? memoryBudget / width : height;
+	unsigned cellSize = map.getCellSizePixels();
+	if (rows >= cellSize) {
+		rows -= rows % cellSize;
+	}
+	if (rows > height) {
+		rows = height;
+	}
+	return rows > 0 ? (unsigned) rows : 1;
+}
+
+/*
+	Paint a map band by band & stream it to an image file.
+	Output is pixel-identical to painting the map all at once.
+	A cancelled export deletes its partial file.
+	The "svg" format is drawn as vectors instead (see GridSvg).
+*/
+ExportResult ExportMapImage(
+    GridMap& map, const char *filename, const char *format,
+    size_t memoryBudget, ExportProgressFunc progress, void *progressData)
+{
+	if (!strcmp(format, "svg")) {
+		return ExportMapSvg(map, filename, progress, progressData);
+	}
+
+	// Check image size (canvas coordinates are ints)
+	unsigned long long width = map.getWidthPixels();
+	unsigned long long height = map.getHeightPixels();
+	if (width == 0 || height == 0 || width > INT_MAX || height > INT_MAX) {
+		return EXPORT_TOO_LARGE;
+	}
+
+	// Open image file
+	ImageWriter *writer = NewImageWriter(format);
+	if (!writer) {
+		return EXPORT_BAD_FORMAT;
+	}
+	if (!writer->open(filename, (unsigned) width, (unsigned) height)) {
+		delete writer;
+		return EXPORT_WRITE_FAILED;
+	}
+
+	// Paint & write each band
+	ExportResult result = EXPORT_OK;
+	unsigned cellSize = map.getCellSizePixels();
+	unsigned bandRows = GetExportBandRows(map, memoryBudget);
+	RasterCanvas canvas((int) width, bandRows);
+	for (unsigned top = 0; top < height && result == EXPORT_OK;
+	        top += bandRows) {
+		unsigned rows = height - top < bandRows ? height - top : bandRows;
+		canvas.clear(SHADE_WHITE);
+		canvas.setOrigin(0, top);
+		map.paintRegion(
+		    canvas, 0, top / cellSize,
+		    map.getWidthCells(), (top + rows - 1) / cellSize + 1);
+		for (unsigned y = 0; y < rows && result == EXPORT_OK; y++) {
+			if (!writer->writeRow(canvas.getRow(y))) {
+				result = EXPORT_WRITE_FAILED;
+			}
+		}
+		if (result == EXPORT_OK && progress
+		        && !progress(progressData, top + rows, height)) {
+			result = EXPORT_CANCELLED;
+		}
+	}
+
+	// Close file
+	if (!writer->close() && result == EXPORT_OK) {
+		result = EXPORT_WRITE_FAILED;
+	}
+	delete writer;
+	if (result == EXPORT_CANCELLED) {
+		remove(filename);
+	}
+	return result;
+}
+
+// Describe an export outcome for the user
+const char* GetExportResultText(ExportResult result)
+{
+	switch (result) {
+		case EXPORT_OK:
+			return "Export complete";
+		case EXPORT_BAD_FORMAT:
+			return "Unknown image format";
+		case EXPORT_TOO_LARGE:
+			return "Map too large for an image";
+		case EXPORT_WRITE_FAILED:
+			return "Could not write image file";
+		case EXPORT_CANCELLED:
+			return "Export cancelled";
+		default:
+			return "Unknown export error";
+	}
+}
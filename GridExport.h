@@ -0,0 +1,41 @@
+/*
+	Name: GridExport.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Export of a whole map to an image file.
+		The map is painted in horizontal bands sized to a memory
+		budget, and each band is streamed to the image writer,
+		so even gigapixel images use constant memory.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDEXPORT_H
+#define GRIDEXPORT_H
+#include "GridMap.h"
+
+// Default memory for one band of pixels
+const size_t EXPORT_BUDGET_DEFAULT = 64 << 20;
+
+// Export outcomes
+enum ExportResult {
+	EXPORT_OK, EXPORT_BAD_FORMAT, EXPORT_TOO_LARGE,
+	EXPORT_WRITE_FAILED, EXPORT_CANCELLED
+};
+
+/*
+	Progress callback, called after each band is written.
+	Return false to cancel the export.
+*/
+typedef bool (*ExportProgressFunc)(
+    void *data, unsigned long long rowsDone, unsigned long long rowsTotal);
+
+// Function prototypes
+bool IsExportFormat(const char *format);
+unsigned GetExportBandRows(const GridMap& map, size_t memoryBudget);
+ExportResult ExportMapImage(
+    GridMap& map, const char *filename, const char *format,
+    size_t memoryBudget, ExportProgressFunc progress = NULL,
+    void *progressData = NULL);
+const char* GetExportResultText(ExportResult result);
+#endif
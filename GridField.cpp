@@ -0,0 +1,290 @@
+/*
+	Name: GridField.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of distance fields.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridField.h"
+#include <algorithm>
+#include <cassert>
+using std::min;
+using std::max;
+
+//------------------------------------------------------------------
+// Construction & sources
+//------------------------------------------------------------------
+
+GridField::GridField(const GridMap& _map, const MoveOptions& _options)
+{
+	map = &_map;
+	options = _options;
+	width = map->getWidthCells();
+	height = map->getHeightCells();
+	cells = width * height;
+	limit = NO_PATH;
+	costs.assign((size_t) cells * 2, NO_PATH);
+	parents.assign((size_t) cells * 2, NO_NODE);
+	listed.assign((size_t) cells * 2, false);
+	queued = settled = 0;
+
+	// Ring of buckets longer than the dearest single move
+	unsigned entry = max(options.waterCost, options.stairsCost);
+	unsigned dearest = max(
+	    options.stepCost + entry + options.doorCost,
+	    max(options.diagonalCost + entry, options.doorCost));
+	buckets.resize(dearest + 1);
+}
+
+/*
+	Find the cost to every cell from the nearest source, up to a
+	limit (cells dearer than that are left unreached). Sources
+	in rock are ignored; a source in a split cell starts from
+	both halves, as for GridPaths.
+*/
+void GridField::setSources(
+    const std::vector<GridCoord>& _sources, unsigned _limit)
+{
+	assert(map->getWidthCells() == width && map->getHeightCells() == height);
+	sources = _sources;
+	limit = _limit;
+	for (unsigned node: reached) {
+		costs[node] = NO_PATH;
+		parents[node] = NO_NODE;
+		listed[node] = false;
+	}
+	reached.clear();
+	settled = 0;
+	seedSources({0, 0, width, height});
+	run();
+}
+
+/*
+	Fix up the field after edits to a block of cells. Moves that
+	may have changed lie within the block & one cell around it,
+	so drop the nodes reached by such a move (& everything reached
+	through them), then search again from the costs kept beside
+	the nodes dropped & within the block.
+*/
+void GridField::updateCells(GridRect edited)
+{
+	assert(map->getWidthCells() == width && map->getHeightCells() == height);
+	if (edited.left >= edited.right || edited.top >= edited.bottom) {
+		return;
+	}
+	GridRect block = {
+		edited.left ? edited.left - 1 : 0,
+		edited.top ? edited.top - 1 : 0,
+		min(edited.right + 1, width),
+		min(edited.bottom + 1, height)
+	};
+	settled = 0;
+
+	// Drop nodes reached from within the block (or sources there)
+	dropStack.clear();
+	for (unsigned x = block.left; x < block.right; x++) {
+		for (unsigned y = block.top; y < block.bottom; y++) {
+			for (int half = 0; half <= 1; half++) {
+				unsigned node = x * height + y + (half ? cells : 0);
+				if (costs[node] != NO_PATH
+				        && (parents[node] == NO_NODE
+				            || isInside(parents[node], block))) {
+					costs[node] = NO_PATH;
+					parents[node] = NO_NODE;
+					dropStack.push_back(node);
+				}
+			}
+		}
+	}
+	for (size_t i = 0; i < dropStack.size(); i++) {
+		dropBelow(dropStack[i]);
+	}
+
+	// Search again from around the nodes dropped & within the block
+	GridMove moves[MOVE_MAX];
+	for (unsigned node: dropStack) {
+		unsigned count = GetMoves(
+		    *map, getCoord(node), node < cells ? 0 : 1, options, moves);
+		for (unsigned i = 0; i < count; i++) {
+			unsigned next = moves[i].cell.x * height + moves[i].cell.y
+			                + (moves[i].half ? cells : 0);
+			if (costs[next] != NO_PATH) {
+				seeds.push_back({costs[next], next});
+			}
+		}
+	}
+	for (unsigned x = block.left; x < block.right; x++) {
+		for (unsigned y = block.top; y < block.bottom; y++) {
+			for (int half = 0; half <= 1; half++) {
+				unsigned node = x * height + y + (half ? cells : 0);
+				if (costs[node] != NO_PATH) {
+					seeds.push_back({costs[node], node});
+				}
+			}
+		}
+	}
+	seedSources(block);
+	run();
+	dropStack.clear();
+}
+
+// Fix up the field after edits to one cell
+void GridField::updateCell(GridCoord gc)
+{
+	updateCells({gc.x, gc.y, gc.x + 1, gc.y + 1});
+}
+
+//------------------------------------------------------------------
+// Results
+//------------------------------------------------------------------
+
+// Get the cost to a cell (either half) from the nearest source
+unsigned GridField::getDistance(GridCoord gc) const
+{
+	assert(gc.x < width && gc.y < height);
+	unsigned cell = gc.x * height + gc.y;
+	return min(costs[cell], costs[cell + cells]);
+}
+
+unsigned GridField::getLimit() const
+{
+	return limit;
+}
+
+const std::vector<GridCoord>& GridField::getSources() const
+{
+	return sources;
+}
+
+// Get the nodes settled by the last search (whole or update)
+unsigned GridField::getNodesSettled() const
+{
+	return settled;
+}
+
+//------------------------------------------------------------------
+// Search
+//------------------------------------------------------------------
+
+// Start from each open half of each source within a block
+void GridField::seedSources(GridRect block)
+{
+	for (GridCoord gc: sources) {
+		if (gc.x < block.left || gc.x >= block.right
+		        || gc.y < block.top || gc.y >= block.bottom) {
+			continue;
+		}
+		FloorType floor = map->getCellFloor(gc);
+		unsigned start = gc.x * height + gc.y;
+		if (GetCellSideHalf(floor, NORTH) != NO_HALF
+		        || GetCellSideHalf(floor, SOUTH) != NO_HALF) {
+			reachNode(start, NO_NODE, 0);
+		}
+		if (IsFloorSplit(floor)) {
+			reachNode(start + cells, NO_NODE, 0);
+		}
+	}
+}
+
+// Reach a node at a cost, if cheaper than before & within the limit
+void GridField::reachNode(unsigned node, unsigned parent, unsigned cost)
+{
+	if (cost > limit || cost >= costs[node]) {
+		return;
+	}
+	if (!listed[node]) {
+		listed[node] = true;
+		reached.push_back(node);
+	}
+	costs[node] = cost;
+	parents[node] = parent;
+	buckets[cost % buckets.size()].push_back(node);
+	queued++;
+}
+
+// Expand a node by every single move
+void GridField::expandNode(unsigned node)
+{
+	GridMove moves[MOVE_MAX];
+	unsigned count = GetMoves(
+	    *map, getCoord(node), node < cells ? 0 : 1, options, moves);
+	unsigned cost = costs[node];
+	for (unsigned i = 0; i < count; i++) {
+		const GridMove& move = moves[i];
+		unsigned next = move.cell.x * height + move.cell.y;
+		reachNode(next + (move.half ? cells : 0), node, cost + move.cost);
+	}
+}
+
+/*
+	Settle queued nodes in order of cost, a bucket at a time.
+	Seeds (nodes already costed) join the queue when the search
+	gets to their cost; with nothing queued, it skips ahead to
+	the next. Entries no longer at their node's cost are stale.
+*/
+void GridField::run()
+{
+	std::sort(seeds.begin(), seeds.end());
+	size_t nextSeed = 0;
+	unsigned ring = (unsigned) buckets.size();
+	unsigned current = 0;
+	while (queued || nextSeed < seeds.size()) {
+		if (!queued) {
+			current = seeds[nextSeed].first;
+		}
+		while (nextSeed < seeds.size() && seeds[nextSeed].first == current) {
+			buckets[current % ring].push_back(seeds[nextSeed++].second);
+			queued++;
+		}
+		std::vector<unsigned>& bucket = buckets[current % ring];
+		for (size_t i = 0; i < bucket.size(); i++) {
+			unsigned node = bucket[i];
+			queued--;
+			if (costs[node] == current) {
+				settled++;
+				expandNode(node);
+			}
+		}
+		bucket.clear();
+		current++;
+	}
+	seeds.clear();
+}
+
+/*
+	Drop every node reached from a dropped node, adding them to
+	the drop stack. Moves are the same both ways, so the nodes
+	reached from one are among its moves.
+*/
+void GridField::dropBelow(unsigned node)
+{
+	GridMove moves[MOVE_MAX];
+	unsigned count = GetMoves(
+	    *map, getCoord(node), node < cells ? 0 : 1, options, moves);
+	for (unsigned i = 0; i < count; i++) {
+		unsigned next = moves[i].cell.x * height + moves[i].cell.y
+		                + (moves[i].half ? cells : 0);
+		if (parents[next] == node) {
+			costs[next] = NO_PATH;
+			parents[next] = NO_NODE;
+			dropStack.push_back(next);
+		}
+	}
+}
+
+// Get the cell of a node
+GridCoord GridField::getCoord(unsigned node) const
+{
+	unsigned cell = node % cells;
+	return {cell / height, cell % height};
+}
+
+// Is a node's cell within a block?
+bool GridField::isInside(unsigned node, GridRect block) const
+{
+	GridCoord gc = getCoord(node);
+	return gc.x >= block.left && gc.x < block.right
+	       && gc.y >= block.top && gc.y < block.bottom;
+}
@@ -0,0 +1,81 @@
+/*
+	Name: GridField.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Distance fields & movement ranges on a map.
+		The cost from the nearest of a set of sources (tokens,
+		stairs & so on) to every cell within a limit, by the moves
+		& costs of GridPaths. Dijkstra's search with a bucket queue
+		(move costs are small integers) over flat arrays of cost &
+		parent per cell half. Edits re-search only the cells whose
+		cheapest way in ran through the cells edited, from the
+		costs kept around them.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDFIELD_H
+#define GRIDFIELD_H
+#include "GridPaths.h"
+#include <utility>
+#include <vector>
+
+/*
+	GridField interface
+	Costs match GridPaths with the same options. After any edit
+	to the map, call updateCells() with the cells whose floor or
+	north or west wall changed (the map must keep its size).
+*/
+class GridField {
+	public:
+
+		// Constructor
+		GridField(const GridMap& map, const MoveOptions& options = MoveOptions());
+
+		// Sources & editing
+		void setSources(
+		    const std::vector<GridCoord>& sources, unsigned limit = NO_PATH);
+		void updateCells(GridRect cells);
+		void updateCell(GridCoord gc);
+
+		// Results (NO_PATH if not reached within the limit)
+		unsigned getDistance(GridCoord gc) const;
+		unsigned getLimit() const;
+		const std::vector<GridCoord>& getSources() const;
+		unsigned getNodesSettled() const;
+
+	private:
+
+		// Search
+		void seedSources(GridRect cells);
+		void reachNode(unsigned node, unsigned parent, unsigned cost);
+		void expandNode(unsigned node);
+		void run();
+		void dropBelow(unsigned node);
+		GridCoord getCoord(unsigned node) const;
+		bool isInside(unsigned node, GridRect cells) const;
+
+		// Map & settings
+		const GridMap *map;
+		MoveOptions options;
+		unsigned width, height, cells;
+		std::vector<GridCoord> sources;
+		unsigned limit;
+
+		// Cost & parent per node (second halves after the cells),
+		// & the nodes ever reached, to clear for new sources
+		std::vector<unsigned> costs, parents;
+		std::vector<unsigned> reached;
+		std::vector<bool> listed;
+
+		// Bucket queue: a ring of buckets by cost (more than the
+		// dearest move, so all queued fit), & seeds to start from
+		// as (cost, node), taken in as the search gets to them
+		std::vector<std::vector<unsigned>> buckets;
+		std::vector<std::pair<unsigned, unsigned>> seeds;
+		unsigned queued, settled;
+
+		// Nodes to drop on an edit
+		std::vector<unsigned> dropStack;
+};
+#endif
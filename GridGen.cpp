@@ -0,0 +1,344 @@
+/*
+	Name: GridGen.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Command-line generator of GridMapper maps.
+		Writes procedural maps (caves, rooms & corridors, or maps
+		learned from a sample map) as .gmap files, one per seed,
+		spreading the maps over a pool of threads.
+		Builds without windows.h.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridMap.h"
+#include "GridGenerate.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	Generator settings from the command line.
+	Maps are made for seeds firstSeed to firstSeed + count - 1.
+*/
+struct GenerateOptions {
+	const char *kind;
+	unsigned width, height;
+	unsigned firstSeed, count;
+	const char *outDir;
+	unsigned threads;
+	bool quiet;
+	CaveOptions cave;
+	DungeonOptions dungeon;
+	const char *sampleFile;
+	SampleOptions sample;
+	SamplePatterns patterns;
+};
+
+// Function prototypes
+void PrintUsage();
+bool ParseOptions(int argc, char *argv[], GenerateOptions& options);
+GridMap* GenerateMap(
+    const GenerateOptions& options, unsigned seed, unsigned threads);
+bool GenerateMapFile(
+    const GenerateOptions& options, unsigned seed, unsigned threads,
+    std::string& message);
+
+/*
+	Command-line entry point.
+*/
+int main(int argc, char *argv[])
+{
+	// Parse command line
+	GenerateOptions options;
+	if (!ParseOptions(argc, argv, options)) {
+		PrintUsage();
+		return 2;
+	}
+
+	// Learn sample patterns (once, for all maps)
+	if (!strcmp(options.kind, "sample")) {
+		if (!options.sampleFile) {
+			fprintf(stderr, "Sample maps need a sample file (-m)\n");
+			return 2;
+		}
+		const char *file = options.sampleFile;
+		std::vector<char> filename(file, file + strlen(file) + 1);
+		GridMap sample(filename.data());
+		if (!sample.isFileLoadOk()) {
+			fprintf(stderr, "Could not read sample map: %s\n",
+			        options.sampleFile);
+			return 1;
+		}
+		if (!LearnPatterns(sample, options.sample, options.patterns)) {
+			fprintf(stderr, "Sample map too small for patterns: %s\n",
+			        options.sampleFile);
+			return 1;
+		}
+	}
+
+	// Generate maps across thread pool
+	// (one map alone gets all threads to itself)
+	unsigned poolSize = std::min(options.threads, options.count);
+	unsigned mapThreads = poolSize > 1 ? 1 : options.threads;
+	std::atomic<unsigned> nextMap(0);
+	std::atomic<unsigned> numFailed(0);
+	std::mutex outputMutex;
+	auto startTime = std::chrono::steady_clock::now();
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < poolSize; t++) {
+		pool.push_back(std::thread([&]() {
+			unsigned i;
+			while ((i = nextMap++) < options.count) {
+				std::string message;
+				bool ok = GenerateMapFile(
+				    options, options.firstSeed + i, mapThreads, message);
+				if (!ok) {
+					numFailed++;
+				}
+				if (!ok || !options.quiet) {
+					std::lock_guard<std::mutex> lock(outputMutex);
+					fprintf(ok ? stdout : stderr, "%s\n", message.c_str());
+				}
+			}
+		}));
+	}
+	for (std::thread& worker: pool) {
+		worker.join();
+	}
+
+	// Report throughput
+	double seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	unsigned numDone = options.count - numFailed;
+	printf("Generated %u of %u maps in %.3f s on %u threads "
+	       "(%.1f maps/s)\n",
+	       numDone, options.count, seconds, options.threads,
+	       seconds > 0 ? numDone / seconds : 0.0);
+	return numFailed ? 1 : 0;
+}
+
+/*
+	Print command-line help.
+*/
+void PrintUsage()
+{
+	fprintf(stderr,
+	    "Usage: gridgen [options] cave|dungeon|sample\n"
+	    "Options:\n"
+	    "  -w cells    Map width (default 100)\n"
+	    "  -h cells    Map height (default 100)\n"
+	    "  -s seed     First seed (default 1)\n"
+	    "  -n count    Number of maps, one per seed (default 1)\n"
+	    "  -o dir      Output directory (default: current)\n"
+	    "  -j threads  Number of worker threads (default: all cores)\n"
+	    "  -q          Quiet; only report errors & totals\n"
+	    "Caves:\n"
+	    "  -f percent  Initial rock (default 45)\n"
+	    "  -i passes   Smoothing passes (default 5)\n"
+	    "Dungeons:\n"
+	    "  -S cells    Sector size, made in parallel (default 48)\n"
+	    "Samples:\n"
+	    "  -m file     Sample map to learn from (required)\n"
+	    "  -p cells    Pattern size (default 3)\n"
+	    "  -r count    Rotations & reflections of sample, 1-8 (default 1)\n"
+	    "  -e          Keep to the sample's edges (don't wrap patterns)\n");
+}
+
+/*
+	Parse the command line into options.
+	Returns false on any error.
+*/
+bool ParseOptions(int argc, char *argv[], GenerateOptions& options)
+{
+	// Set defaults
+	options.kind = NULL;
+	options.width = options.height = 100;
+	options.firstSeed = 1;
+	options.count = 1;
+	options.outDir = NULL;
+	options.sampleFile = NULL;
+	options.threads = std::thread::hardware_concurrency();
+	options.quiet = false;
+	if (options.threads == 0) {
+		options.threads = 1;
+	}
+
+	// Read arguments
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg[0] != '-') {
+			if (options.kind
+			        || (strcmp(arg, "cave") && strcmp(arg, "dungeon")
+			            && strcmp(arg, "sample"))) {
+				fprintf(stderr, "Unknown map kind: %s\n", arg);
+				return false;
+			}
+			options.kind = arg;
+		}
+		else if (!strcmp(arg, "-w") && hasValue) {
+			int width = atoi(argv[++i]);
+			if (width < 1) {
+				fprintf(stderr, "Bad width: %s\n", argv[i]);
+				return false;
+			}
+			options.width = width;
+		}
+		else if (!strcmp(arg, "-h") && hasValue) {
+			int height = atoi(argv[++i]);
+			if (height < 1) {
+				fprintf(stderr, "Bad height: %s\n", argv[i]);
+				return false;
+			}
+			options.height = height;
+		}
+		else if (!strcmp(arg, "-s") && hasValue) {
+			options.firstSeed = strtoul(argv[++i], NULL, 10);
+		}
+		else if (!strcmp(arg, "-n") && hasValue) {
+			int count = atoi(argv[++i]);
+			if (count < 1) {
+				fprintf(stderr, "Bad map count: %s\n", argv[i]);
+				return false;
+			}
+			options.count = count;
+		}
+		else if (!strcmp(arg, "-o") && hasValue) {
+			options.outDir = argv[++i];
+		}
+		else if (!strcmp(arg, "-j") && hasValue) {
+			int threads = atoi(argv[++i]);
+			if (threads < 1) {
+				fprintf(stderr, "Bad thread count: %s\n", argv[i]);
+				return false;
+			}
+			options.threads = threads;
+		}
+		else if (!strcmp(arg, "-q")) {
+			options.quiet = true;
+		}
+		else if (!strcmp(arg, "-f") && hasValue) {
+			int percent = atoi(argv[++i]);
+			if (percent < 0 || percent > 100) {
+				fprintf(stderr, "Bad rock percent: %s\n", argv[i]);
+				return false;
+			}
+			options.cave.fillPercent = percent;
+		}
+		else if (!strcmp(arg, "-i") && hasValue) {
+			int passes = atoi(argv[++i]);
+			if (passes < 0) {
+				fprintf(stderr, "Bad pass count: %s\n", argv[i]);
+				return false;
+			}
+			options.cave.iterations = passes;
+		}
+		else if (!strcmp(arg, "-S") && hasValue) {
+			int size = atoi(argv[++i]);
+			if (size < 1) {
+				fprintf(stderr, "Bad sector size: %s\n", argv[i]);
+				return false;
+			}
+			options.dungeon.sectorCells = size;
+		}
+		else if (!strcmp(arg, "-m") && hasValue) {
+			options.sampleFile = argv[++i];
+		}
+		else if (!strcmp(arg, "-p") && hasValue) {
+			int size = atoi(argv[++i]);
+			if (size < 2) {
+				fprintf(stderr, "Bad pattern size: %s\n", argv[i]);
+				return false;
+			}
+			options.sample.patternCells = size;
+		}
+		else if (!strcmp(arg, "-r") && hasValue) {
+			int symmetry = atoi(argv[++i]);
+			if (symmetry < 1 || symmetry > 8) {
+				fprintf(stderr, "Bad symmetry count: %s\n", argv[i]);
+				return false;
+			}
+			options.sample.symmetry = symmetry;
+		}
+		else if (!strcmp(arg, "-e")) {
+			options.sample.wrap = false;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n", arg);
+			return false;
+		}
+	}
+	return options.kind != NULL;
+}
+
+/*
+	Generate one map of the kind asked for (new; caller deletes).
+	Returns NULL if a sample map can't be solved.
+*/
+GridMap* GenerateMap(
+    const GenerateOptions& options, unsigned seed, unsigned threads)
+{
+	if (!strcmp(options.kind, "dungeon")) {
+		DungeonOptions dungeon = options.dungeon;
+		dungeon.seed = seed;
+		dungeon.threads = threads;
+		return GenerateDungeon(options.width, options.height, dungeon);
+	}
+	if (!strcmp(options.kind, "sample")) {
+		SampleOptions sample = options.sample;
+		sample.seed = seed;
+		sample.threads = threads;
+		return GenerateFromSample(
+		    options.patterns, options.width, options.height, sample);
+	}
+	CaveOptions cave = options.cave;
+	cave.seed = seed;
+	cave.threads = threads;
+	return GenerateCave(options.width, options.height, cave);
+}
+
+/*
+	Generate & save one map file, named by kind & seed.
+	Sets a message for the user.
+*/
+bool GenerateMapFile(
+    const GenerateOptions& options, unsigned seed, unsigned threads,
+    std::string& message)
+{
+	// Make filename
+	std::string name = std::string(options.kind) + "-"
+	                   + std::to_string(seed) + ".gmap";
+	if (options.outDir) {
+		std::string dir = options.outDir;
+		if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') {
+			dir += '/';
+		}
+		name = dir + name;
+	}
+	if (name.size() >= (size_t) GRID_FILENAME_MAX) {
+		message = "Output name too long: " + name;
+		return false;
+	}
+
+	// Generate & save
+	GridMap *map = GenerateMap(options, seed, threads);
+	if (!map) {
+		message = "Could not solve map from sample: " + name;
+		return false;
+	}
+	std::vector<char> filename(name.begin(), name.end());
+	filename.push_back('\0');
+	map->setFilename(filename.data());
+	bool ok = map->save();
+	delete map;
+	message = ok ? name : "Could not write map file: " + name;
+	return ok;
+}
@@ -0,0 +1,1547 @@
+/*
+	Name: GridGenerate.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of procedural map generators.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridGenerate.h"
+#include "GridRegions.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using std::min;
+using std::max;
+
+// Bitboard words (bit set for rock)
+typedef uint64_t Bits;
+const unsigned WORD_BITS = 64;
+const Bits ALL_ROCK = ~(Bits) 0;
+
+// Bits of random number per cell, for chances in 1024
+const unsigned CHANCE_BITS = 10;
+const unsigned CHANCE_ONE = 1 << CHANCE_BITS;
+
+/*
+	Map cells as bits, in strips of 64 columns, each strip a word
+	per row stored top to bottom (column-major, like the map).
+	Bits past the width in the last strip are kept set,
+	so the cells beyond the east edge read as rock.
+*/
+struct Bitboard {
+	unsigned width, height, strips;
+	Bits padding;
+	std::vector<Bits> words;
+
+	Bits* strip(unsigned k) {
+		return &words[(size_t) k * height];
+	}
+};
+
+//------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------
+
+// Scramble a 64-bit value (SplitMix64 finalizer)
+static inline uint64_t Mix64(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+// Next of a stream of random words (SplitMix64)
+static inline uint64_t NextRandom(uint64_t& state)
+{
+	return Mix64(state += 0x9e3779b97f4a7c15ULL);
+}
+
+// Bits set where at least two of three are set
+static inline Bits Majority(Bits a, Bits b, Bits c)
+{
+	return (a & b) | (a & c) | (b & c);
+}
+
+// Cells west & east of a word's cells, given the words beside it
+static inline Bits WestOf(Bits word, Bits westWord)
+{
+	return (word << 1) | (westWord >> (WORD_BITS - 1));
+}
+
+static inline Bits EastOf(Bits word, Bits eastWord)
+{
+	return (word >> 1) | (eastWord << (WORD_BITS - 1));
+}
+
+// Random number in [0, n)
+static inline unsigned RandomBelow(uint64_t& state, unsigned n)
+{
+	return (unsigned) ((NextRandom(state) >> 32) * n >> 32);
+}
+
+/*
+	Random bits, each set with a chance in CHANCE_ONE.
+	Bit-sliced: CHANCE_BITS random words make a random number
+	per bit, compared against the chance a bit plane at a time.
+*/
+static inline Bits RandomBits(uint64_t& state, unsigned chance)
+{
+	if (chance >= CHANCE_ONE) {
+		return ALL_ROCK;
+	}
+	Bits less = 0, equal = ALL_ROCK;
+	for (int b = CHANCE_BITS - 1; b >= 0; b--) {
+		Bits random = NextRandom(state);
+		if (chance >> b & 1) {
+			less |= equal & ~random;
+			equal &= random;
+		}
+		else {
+			equal &= ~random;
+		}
+	}
+	return less;
+}
+
+/*
+	Run a task over bands [first, last) of count items
+	(strips of the bitboard) on threads, waiting for all to finish.
+*/
+static void RunBands(
+    unsigned count, unsigned threads,
+    const std::function<void(unsigned, unsigned)>& task)
+{
+	threads = max(1u, min(threads, count));
+	if (threads == 1) {
+		task(0, count);
+		return;
+	}
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < threads; t++) {
+		unsigned first = (unsigned) ((unsigned long long) count * t / threads);
+		unsigned last =
+		    (unsigned) ((unsigned long long) count * (t + 1) / threads);
+		pool.push_back(std::thread(task, first, last));
+	}
+	for (std::thread& worker: pool) {
+		worker.join();
+	}
+}
+
+//------------------------------------------------------------------
+// Caves
+//------------------------------------------------------------------
+
+/*
+	Fill a strip with random rock.
+	Each strip has its own random stream, so threads don't matter.
+*/
+static void RandomRockStrip(
+    Bitboard& board, unsigned k, uint64_t seed, unsigned chance)
+{
+	uint64_t state = Mix64(seed ^ Mix64(k));
+	Bits *strip = board.strip(k);
+	Bits padding = k + 1 == board.strips ? board.padding : 0;
+	for (unsigned y = 0; y < board.height; y++) {
+		strip[y] = RandomBits(state, chance) | padding;
+	}
+}
+
+/*
+	Count rock in each cell of a word & its west & east neighbours,
+	as a 2-bit number per cell (bit planes ones & twos).
+	Rows outside the map are all rock (3 each).
+*/
+static inline void CountTriples(
+    const Bits *west, const Bits *strip, const Bits *east,
+    unsigned y, unsigned height, Bits& ones, Bits& twos)
+{
+	if (y >= height) {
+		ones = twos = ALL_ROCK;
+		return;
+	}
+	Bits word = strip[y];
+	Bits w = WestOf(word, west ? west[y] : ALL_ROCK);
+	Bits e = EastOf(word, east ? east[y] : ALL_ROCK);
+	ones = w ^ word ^ e;
+	twos = Majority(w, word, e);
+}
+
+/*
+	One smoothing pass over a strip, from one board to the other:
+	rock where 5 or more of the 3x3 cells are rock.
+	Triple counts of the rows above, at & below are added as
+	bit planes (full adders), so each word of 64 cells takes
+	a few dozen logic operations, reading three strips in order.
+*/
+static void SmoothStrip(Bitboard& from, Bitboard& to, unsigned k)
+{
+	unsigned height = from.height;
+	const Bits *west = k ? from.strip(k - 1) : NULL;
+	const Bits *strip = from.strip(k);
+	const Bits *east = k + 1 < from.strips ? from.strip(k + 1) : NULL;
+	Bits *result = to.strip(k);
+	Bits padding = east ? 0 : to.padding;
+	Bits a, b, c, d, e, f;
+	CountTriples(west, strip, east, (unsigned) -1, height, a, d);
+	CountTriples(west, strip, east, 0, height, b, e);
+	for (unsigned y = 0; y < height; y++) {
+		CountTriples(west, strip, east, y + 1, height, c, f);
+
+		// Sum = ones + 2 twos over the three rows, tested for >= 5
+		Bits sum1 = a ^ b ^ c, carry1 = Majority(a, b, c);
+		Bits twos2 = d ^ e ^ f, fours2 = Majority(d, e, f);
+		Bits sum2 = carry1 ^ twos2, carry2 = carry1 & twos2;
+		Bits sum4 = carry2 ^ fours2, sum8 = carry2 & fours2;
+		result[y] = sum8 | (sum4 & (sum2 | sum1)) | padding;
+		a = b;
+		b = c;
+		d = e;
+		e = f;
+	}
+}
+
+/*
+	Cave cells by 3-bit code: rock, diagonal fills NW, NE, SW, SE,
+	then open with no object, a stalagmite, or rubble.
+*/
+static const GridCell CaveCells[8] = {
+	{FLOOR_FILL, WALL_OPEN, WALL_OPEN, OBJECT_NONE},
+	{FLOOR_NWFILL, WALL_OPEN, WALL_OPEN, OBJECT_NONE},
+	{FLOOR_NEFILL, WALL_OPEN, WALL_OPEN, OBJECT_NONE},
+	{FLOOR_SWFILL, WALL_OPEN, WALL_OPEN, OBJECT_NONE},
+	{FLOOR_SEFILL, WALL_OPEN, WALL_OPEN, OBJECT_NONE},
+	{FLOOR_OPEN, WALL_OPEN, WALL_OPEN, OBJECT_NONE},
+	{FLOOR_OPEN, WALL_OPEN, WALL_OPEN, OBJECT_STALAGMITE},
+	{FLOOR_OPEN, WALL_OPEN, WALL_OPEN, OBJECT_RUBBLE}
+};
+
+/*
+	Make the cells of one strip's columns (64 or fewer),
+	column-major into cells: rock is fill, open corners with rock
+	on just two sides are diagonal fills, & open cells get
+	objects by chance (stalagmites only beside rock).
+	The cell codes are worked out 64 at a time as three bit planes
+	per row; then each column is looked up top to bottom.
+*/
+static void MakeCaveColumns(
+    Bitboard& board, unsigned k, uint64_t seed,
+    unsigned stalagmiteChance, unsigned rubbleChance,
+    std::vector<Bits> (&planes)[3], std::vector<GridCell>& cells)
+{
+	unsigned height = board.height;
+	const Bits *westStrip = k ? board.strip(k - 1) : NULL;
+	const Bits *strip = board.strip(k);
+	const Bits *eastStrip = k + 1 < board.strips ? board.strip(k + 1) : NULL;
+	uint64_t state = Mix64(seed ^ Mix64(k));
+
+	// Code bit planes by row
+	for (std::vector<Bits>& plane: planes) {
+		plane.resize(height);
+	}
+	for (unsigned y = 0; y < height; y++) {
+		Bits rock = strip[y];
+		Bits north = y ? strip[y - 1] : ALL_ROCK;
+		Bits south = y + 1 < height ? strip[y + 1] : ALL_ROCK;
+		Bits west = WestOf(rock, westStrip ? westStrip[y] : ALL_ROCK);
+		Bits east = EastOf(rock, eastStrip ? eastStrip[y] : ALL_ROCK);
+		Bits open = ~rock;
+		Bits nw = open & north & west & ~south & ~east;
+		Bits ne = open & north & east & ~south & ~west;
+		Bits sw = open & south & west & ~north & ~east;
+		Bits se = open & south & east & ~north & ~west;
+		Bits plain = open & ~(nw | ne | sw | se);
+		Bits stalagmite = plain & (north | south | west | east)
+		                  & RandomBits(state, stalagmiteChance);
+		Bits rubble =
+		    plain & ~stalagmite & RandomBits(state, rubbleChance);
+		Bits empty = plain & ~stalagmite & ~rubble;
+		planes[0][y] = nw | sw | empty | rubble;
+		planes[1][y] = ne | sw | stalagmite | rubble;
+		planes[2][y] = se | plain;
+	}
+
+	// Cells a column at a time
+	unsigned columns = min(WORD_BITS, board.width - k * WORD_BITS);
+	const Bits *ones = planes[0].data(), *twos = planes[1].data();
+	const Bits *fours = planes[2].data();
+	cells.resize((size_t) columns * height);
+	for (unsigned i = 0; i < columns; i++) {
+		GridCell *column = &cells[(size_t) i * height];
+		for (unsigned y = 0; y < height; y++) {
+			column[y] = CaveCells[(ones[y] >> i & 1) | (twos[y] >> i & 1) << 1
+			                      | (fours[y] >> i & 1) << 2];
+		}
+	}
+}
+
+/*
+	Generate a cave map (new; caller deletes).
+	Strips of the bitboard are split in bands over threads for
+	each pass, & then made into cells a strip at a time.
+*/
+GridMap* GenerateCave(
+    unsigned width, unsigned height, const CaveOptions& options)
+{
+	GridMap *map = new GridMap(width, height);
+	if (width == 0 || height == 0) {
+		return map;
+	}
+	unsigned threads = options.threads;
+	if (threads == 0) {
+		threads = max(1u, std::thread::hardware_concurrency());
+	}
+
+	// Random rock
+	Bitboard board[2];
+	for (Bitboard& b: board) {
+		b.width = width;
+		b.height = height;
+		b.strips = (width + WORD_BITS - 1) / WORD_BITS;
+		b.padding = width % WORD_BITS
+		            ? ALL_ROCK << (width % WORD_BITS) : 0;
+		b.words.resize((size_t) b.strips * height);
+	}
+	unsigned strips = board[0].strips;
+	unsigned chance = options.fillPercent * CHANCE_ONE / 100;
+	uint64_t seed = Mix64(options.seed);
+	RunBands(strips, threads, [&](unsigned first, unsigned last) {
+		for (unsigned k = first; k < last; k++) {
+			RandomRockStrip(board[0], k, seed, chance);
+		}
+	});
+
+	// Smoothing passes
+	for (unsigned i = 0; i < options.iterations; i++) {
+		Bitboard& from = board[i % 2];
+		Bitboard& to = board[(i + 1) % 2];
+		RunBands(strips, threads, [&](unsigned first, unsigned last) {
+			for (unsigned k = first; k < last; k++) {
+				SmoothStrip(from, to, k);
+			}
+		});
+	}
+
+	// Cells (map set under lock)
+	Bitboard& result = board[options.iterations % 2];
+	uint64_t objectSeed = Mix64(seed);
+	unsigned stalagmiteChance =
+	    options.stalagmitePermille * CHANCE_ONE / 1000;
+	unsigned rubbleChance = options.rubblePermille * CHANCE_ONE / 1000;
+	std::mutex mapMutex;
+	RunBands(strips, threads, [&](unsigned first, unsigned last) {
+		std::vector<Bits> planes[3];
+		std::vector<GridCell> cells;
+		for (unsigned k = first; k < last; k++) {
+			MakeCaveColumns(
+			    result, k, objectSeed, stalagmiteChance, rubbleChance,
+			    planes, cells);
+			std::lock_guard<std::mutex> lock(mapMutex);
+			unsigned left = k * WORD_BITS;
+			unsigned columns = min(WORD_BITS, width - left);
+			for (unsigned i = 0; i < columns; i++) {
+				map->setColumn(left + i, &cells[(size_t) i * height]);
+			}
+		}
+	});
+	return map;
+}
+
+//------------------------------------------------------------------
+// Dungeons
+//------------------------------------------------------------------
+
+// Side of each square bucket of the room hash
+const unsigned ROOM_BUCKET_CELLS = 16;
+
+// What a sector cell has become (corridors never overwrite rooms)
+enum SectorTag {
+	TAG_ROCK, TAG_CORRIDOR, TAG_ROOM
+};
+
+/*
+	One sector being made, in its own coordinates.
+	Cells & tags are column-major, as in a CellBlock.
+	Rooms are hashed into square buckets, each listing the rooms
+	(with their margin) that touch it, for overlap tests.
+*/
+struct DungeonSector {
+	unsigned width, height;
+	uint64_t state;
+	CellBlock block;
+	std::vector<unsigned char> tags;
+	std::vector<GridRect> rooms;
+	unsigned bucketsWide, bucketsHigh;
+	std::vector<std::vector<unsigned>> buckets;
+	std::vector<GridCoord> portals;
+	std::vector<GridCoord> doorNorth, doorWest;
+
+	GridCell* column(unsigned x) {
+		return &block.cells[(size_t) x * height];
+	}
+	unsigned char* tagColumn(unsigned x) {
+		return &tags[(size_t) x * height];
+	}
+};
+
+// Random point on the edge between two sectors (fixed by seed)
+static unsigned PortalOffset(uint64_t seed, uint64_t edge, unsigned length)
+{
+	uint64_t state = Mix64(seed ^ Mix64(edge));
+	return length > 2 ? 1 + RandomBelow(state, length - 2)
+	       : RandomBelow(state, length);
+}
+
+// Block of hash buckets touched by a room & its margin
+static GridRect GetRoomBuckets(GridRect room)
+{
+	return {
+		(room.left - 1) / ROOM_BUCKET_CELLS,
+		(room.top - 1) / ROOM_BUCKET_CELLS,
+		room.right / ROOM_BUCKET_CELLS + 1,
+		room.bottom / ROOM_BUCKET_CELLS + 1
+	};
+}
+
+/*
+	Would a room touch any placed room (sides or corners)?
+	Only rooms hashed in the buckets it touches are tested.
+*/
+static bool RoomOverlaps(const DungeonSector& sector, GridRect room)
+{
+	GridRect area = GetRoomBuckets(room);
+	for (unsigned bx = area.left; bx < area.right; bx++) {
+		for (unsigned by = area.top; by < area.bottom; by++) {
+			for (unsigned i:
+			        sector.buckets[by * sector.bucketsWide + bx]) {
+				const GridRect& other = sector.rooms[i];
+				if (room.left <= other.right && other.left <= room.right
+				        && room.top <= other.bottom
+				        && other.top <= room.bottom) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// Add a room to the sector & its hash buckets
+static void AddRoom(DungeonSector& sector, GridRect room)
+{
+	unsigned index = sector.rooms.size();
+	sector.rooms.push_back(room);
+	GridRect area = GetRoomBuckets(room);
+	for (unsigned bx = area.left; bx < area.right; bx++) {
+		for (unsigned by = area.top; by < area.bottom; by++) {
+			sector.buckets[by * sector.bucketsWide + bx].push_back(index);
+		}
+	}
+}
+
+/*
+	Place rooms at random, each clear of the others & of the
+	sector edges by at least one cell of rock, & carve them out.
+*/
+static void PlaceRooms(DungeonSector& sector, const DungeonOptions& options)
+{
+	unsigned roomMin = max(1u, options.roomMin);
+	unsigned sizes = max(roomMin, options.roomMax) - roomMin + 1;
+	GridCell open = {FLOOR_OPEN, WALL_OPEN, WALL_OPEN, OBJECT_NONE};
+	for (unsigned i = 0; i < options.roomTries; i++) {
+		unsigned width = roomMin + RandomBelow(sector.state, sizes);
+		unsigned height = roomMin + RandomBelow(sector.state, sizes);
+		if (width + 2 > sector.width || height + 2 > sector.height) {
+			continue;
+		}
+		unsigned left =
+		    1 + RandomBelow(sector.state, sector.width - width - 1);
+		unsigned top =
+		    1 + RandomBelow(sector.state, sector.height - height - 1);
+		GridRect room = {left, top, left + width, top + height};
+		if (!RoomOverlaps(sector, room)) {
+			AddRoom(sector, room);
+			for (unsigned x = room.left; x < room.right; x++) {
+				std::fill(
+				    sector.column(x) + room.top,
+				    sector.column(x) + room.bottom, open);
+				std::fill(
+				    sector.tagColumn(x) + room.top,
+				    sector.tagColumn(x) + room.bottom, TAG_ROOM);
+			}
+		}
+	}
+}
+
+// Middle cell of a room
+static GridCoord RoomCenter(const GridRect& room)
+{
+	return {(room.left + room.right) / 2, (room.top + room.bottom) / 2};
+}
+
+// Room with center nearest a point (among the first count)
+static unsigned NearestRoom(
+    const DungeonSector& sector, GridCoord point, unsigned count)
+{
+	unsigned nearest = 0, best = UINT_MAX;
+	for (unsigned i = 0; i < count; i++) {
+		GridCoord center = RoomCenter(sector.rooms[i]);
+		unsigned distance =
+		    (center.x > point.x ? center.x - point.x : point.x - center.x)
+		    + (center.y > point.y ? center.y - point.y : point.y - center.y);
+		if (distance < best) {
+			best = distance;
+			nearest = i;
+		}
+	}
+	return nearest;
+}
+
+/*
+	Carve a straight corridor from one cell to another
+	(in a row or a column), noting doors where it crosses
+	a room's edge. Columns are carved as whole spans.
+*/
+static void CarveStraight(DungeonSector& sector, GridCoord from, GridCoord to)
+{
+	GridCell open = {FLOOR_OPEN, WALL_OPEN, WALL_OPEN, OBJECT_NONE};
+
+	// Doors between room & non-room neighbours along the way
+	bool vertical = (from.x == to.x);
+	unsigned start = vertical ? min(from.y, to.y) : min(from.x, to.x);
+	unsigned end = vertical ? max(from.y, to.y) : max(from.x, to.x);
+	for (unsigned i = start + 1; i <= end; i++) {
+		GridCoord cell = vertical ? GridCoord{from.x, i}
+		                 : GridCoord{i, from.y};
+		GridCoord before = vertical ? GridCoord{from.x, i - 1}
+		                   : GridCoord{i - 1, from.y};
+		bool inRoom = sector.tagColumn(cell.x)[cell.y] == TAG_ROOM;
+		bool beforeInRoom =
+		    sector.tagColumn(before.x)[before.y] == TAG_ROOM;
+		if (inRoom != beforeInRoom) {
+			(vertical ? sector.doorNorth : sector.doorWest).push_back(cell);
+		}
+	}
+
+	// Carve (rooms stay rooms)
+	if (vertical) {
+		std::fill(
+		    sector.column(from.x) + start, sector.column(from.x) + end + 1,
+		    open);
+		unsigned char *tags = sector.tagColumn(from.x);
+		for (unsigned y = start; y <= end; y++) {
+			tags[y] = max(tags[y], (unsigned char) TAG_CORRIDOR);
+		}
+	}
+	else {
+		for (unsigned x = start; x <= end; x++) {
+			sector.column(x)[from.y] = open;
+			unsigned char& tag = sector.tagColumn(x)[from.y];
+			tag = max(tag, (unsigned char) TAG_CORRIDOR);
+		}
+	}
+}
+
+// Carve an L-shaped corridor, turning either way at random
+static void CarveCorridor(DungeonSector& sector, GridCoord from, GridCoord to)
+{
+	GridCoord corner = RandomBelow(sector.state, 2)
+	                   ? GridCoord{to.x, from.y} : GridCoord{from.x, to.y};
+	CarveStraight(sector, from, corner);
+	CarveStraight(sector, corner, to);
+}
+
+/*
+	Set doors on noted room entrances, by chance & type:
+	mostly single, some double, some secret.
+*/
+static void PlaceDoors(DungeonSector& sector, const DungeonOptions& options)
+{
+	for (int side = 0; side < 2; side++) {
+		for (GridCoord gc: side ? sector.doorWest : sector.doorNorth) {
+			if (RandomBelow(sector.state, 100) >= options.doorPercent) {
+				continue;
+			}
+			unsigned kind = RandomBelow(sector.state, 10);
+			unsigned char wall = kind < 6 ? WALL_SINGLE_DOOR
+			                     : kind < 8 ? WALL_DOUBLE_DOOR
+			                     : WALL_SECRET_DOOR;
+			GridCell& cell = sector.column(gc.x)[gc.y];
+			(side ? cell.wwall : cell.nwall) = wall;
+		}
+	}
+}
+
+// Put stairs in a room, & pillars in big rooms, by chance
+static void PlaceFeatures(
+    DungeonSector& sector, const DungeonOptions& options)
+{
+	if (sector.rooms.empty()) {
+		return;
+	}
+	if (RandomBelow(sector.state, 100) < options.stairsPercent) {
+		const GridRect& room = sector.rooms[
+		    RandomBelow(sector.state, sector.rooms.size())];
+		static const unsigned char stairs[] = {
+			FLOOR_NSTAIRS, FLOOR_WSTAIRS, FLOOR_SPIRALSTAIRS
+		};
+		GridCoord gc = {
+			room.left + RandomBelow(sector.state, room.right - room.left),
+			room.top + RandomBelow(sector.state, room.bottom - room.top)
+		};
+		sector.column(gc.x)[gc.y].floor =
+		    stairs[RandomBelow(sector.state, 3)];
+	}
+	for (const GridRect& room: sector.rooms) {
+		if (room.right - room.left >= 5 && room.bottom - room.top >= 5
+		        && RandomBelow(sector.state, 100) < options.pillarPercent) {
+			for (unsigned x = room.left + 1; x + 1 < room.right; x += 2) {
+				for (unsigned y = room.top + 1; y + 1 < room.bottom;
+				        y += 2) {
+					GridCell& cell = sector.column(x)[y];
+					if (cell.floor == FLOOR_OPEN) {
+						cell.object = OBJECT_PILLAR;
+					}
+				}
+			}
+		}
+	}
+}
+
+/*
+	Make one sector: rooms, corridors linking each room to its
+	nearest older one & each edge point to its nearest room,
+	then doors, stairs & pillars.
+*/
+static void MakeDungeonSector(
+    DungeonSector& sector, const DungeonOptions& options)
+{
+	size_t cells = (size_t) sector.width * sector.height;
+	sector.block.width = sector.width;
+	sector.block.height = sector.height;
+	sector.block.cells.assign(
+	    cells, {FLOOR_FILL, WALL_OPEN, WALL_OPEN, OBJECT_NONE});
+	sector.block.eastWalls.assign(sector.height, WALL_OPEN);
+	sector.block.southWalls.assign(sector.width, WALL_OPEN);
+	sector.tags.assign(cells, TAG_ROCK);
+	sector.bucketsWide = sector.width / ROOM_BUCKET_CELLS + 1;
+	sector.bucketsHigh = sector.height / ROOM_BUCKET_CELLS + 1;
+	sector.buckets.assign(
+	    sector.bucketsWide * sector.bucketsHigh, std::vector<unsigned>());
+
+	// Rooms & corridors
+	PlaceRooms(sector, options);
+	for (unsigned i = 1; i < sector.rooms.size(); i++) {
+		unsigned j = NearestRoom(sector, RoomCenter(sector.rooms[i]), i);
+		CarveCorridor(
+		    sector, RoomCenter(sector.rooms[i]),
+		    RoomCenter(sector.rooms[j]));
+	}
+	GridCoord middle = {sector.width / 2, sector.height / 2};
+	for (GridCoord portal: sector.portals) {
+		GridCoord target = sector.rooms.empty() ? middle
+		                   : RoomCenter(sector.rooms[
+		                         NearestRoom(
+		                             sector, portal, sector.rooms.size())]);
+		CarveCorridor(sector, portal, target);
+	}
+
+	// Doors & features
+	PlaceDoors(sector, options);
+	PlaceFeatures(sector, options);
+}
+
+/*
+	Generate a dungeon map (new; caller deletes).
+	Sectors are made in bands over threads, each from its own
+	random stream, & pasted into the map under a lock. No doors
+	lie on sector edges, so the order of pasting doesn't matter.
+*/
+GridMap* GenerateDungeon(
+    unsigned width, unsigned height, const DungeonOptions& options)
+{
+	GridMap *map = new GridMap(width, height);
+	if (width == 0 || height == 0) {
+		return map;
+	}
+	unsigned threads = options.threads;
+	if (threads == 0) {
+		threads = max(1u, std::thread::hardware_concurrency());
+	}
+	unsigned size = max(options.sectorCells, 1u);
+	unsigned sectorsWide = (width + size - 1) / size;
+	unsigned sectorsHigh = (height + size - 1) / size;
+	uint64_t seed = Mix64(options.seed);
+
+	// Make sectors (edges numbered by the sector west or north)
+	std::mutex mapMutex;
+	auto makeSectors = [&](unsigned first, unsigned last) {
+		DungeonSector sector;
+		for (unsigned s = first; s < last; s++) {
+			unsigned sx = s % sectorsWide, sy = s / sectorsWide;
+			unsigned left = sx * size, top = sy * size;
+			sector.width = min(size, width - left);
+			sector.height = min(size, height - top);
+			sector.state = Mix64(seed ^ Mix64(s));
+			sector.rooms.clear();
+			sector.portals.clear();
+			sector.doorNorth.clear();
+			sector.doorWest.clear();
+			if (sx > 0) {
+				sector.portals.push_back({0, PortalOffset(
+				    seed, 2 * (s - 1), sector.height)});
+			}
+			if (sx + 1 < sectorsWide) {
+				sector.portals.push_back({sector.width - 1, PortalOffset(
+				    seed, 2 * s, sector.height)});
+			}
+			if (sy > 0) {
+				sector.portals.push_back({PortalOffset(
+				    seed, 2 * (s - sectorsWide) + 1, sector.width), 0});
+			}
+			if (sy + 1 < sectorsHigh) {
+				sector.portals.push_back({PortalOffset(
+				    seed, 2 * s + 1, sector.width), sector.height - 1});
+			}
+			MakeDungeonSector(sector, options);
+			std::lock_guard<std::mutex> lock(mapMutex);
+			map->pasteCells(sector.block, {left, top});
+		}
+	};
+	RunBands(sectorsWide * sectorsHigh, threads, makeSectors);
+	return map;
+}
+
+
+//------------------------------------------------------------------
+// Samples (wave function collapse)
+//------------------------------------------------------------------
+
+// No pattern (yet) at a place
+const unsigned NO_PATTERN = UINT_MAX;
+
+// Most patterns at a place for a change there to be passed on
+// (more would cost more than they rule out); the later tries of a
+// grown region pass on more, finding contradictions sooner so hard
+// regions settle, at several times the cost
+const unsigned PROPAGATE_MAX = 8;
+const unsigned GROWN_PROPAGATE_MAX = 32;
+
+// Decided places around a region that may be reopened
+const unsigned REGION_MARGIN = 4;
+
+// Places around a contradiction first reset, & most doublings
+const unsigned RESET_RADIUS = 2;
+const unsigned RESET_DOUBLINGS = 4;
+
+// Places of a wave to each reset it may make (a wave that needs
+// many more rarely settles; better to try again, or grow)
+const unsigned RESET_PLACES = 16;
+
+// Tries of a region (each from its own random stream)
+const unsigned REGION_TRIES = 4;
+
+// Steps to the neighbour in each Direction
+static const int DirectionX[4] = {0, 0, 1, -1};
+static const int DirectionY[4] = {-1, 1, 0, 0};
+
+/*
+	What a place in a wave is: being solved (in the region, or
+	undecided beyond it), decided before (but may be reopened near
+	a contradiction), or decided & fixed (the outer ring).
+*/
+enum PlaceKind {
+	PLACE_FREE, PLACE_DECIDED, PLACE_FIXED
+};
+
+/*
+	Wave over one region of pattern places & the decided places
+	around it (column-major): a bitset of the patterns still
+	possible at each place, with their count & weight sums for
+	the entropy. A place opens with all the patterns but those with
+	no neighbour on a side where it has one; opens holds these
+	bitsets (& their counts & sums) by the place's sides mask.
+	Free places with more than one pattern are queued to collapse
+	in a binary heap by entropy (least first), each place knowing
+	its slot so it can move as its entropy changes. Places with up
+	to propagateMax patterns pass their changes on.
+*/
+struct PatternWave {
+	const SamplePatterns *patterns;
+	const double *logWeights;
+	unsigned width, height, words, failed, propagateMax;
+	uint64_t state;
+	std::vector<uint64_t> domains, opens;
+	std::vector<unsigned> counts, openCounts;
+	std::vector<double> sums, logSums, openSums, openLogSums;
+	std::vector<unsigned char> kinds, sides, stacked;
+	std::vector<unsigned> stack;
+	std::vector<uint64_t> reach;
+	std::vector<unsigned> heap, slots;
+	std::vector<double> entropies;
+
+	uint64_t* domain(unsigned i) {
+		return &domains[(size_t) i * words];
+	}
+	const uint64_t* open(unsigned sides) const {
+		return &opens[(size_t) sides * words];
+	}
+	const uint64_t* allowed(int dir, unsigned p) const {
+		return &patterns->allowed[dir][(size_t) p * words];
+	}
+};
+
+// Random number in [0, 1)
+static inline double RandomUnit(uint64_t& state)
+{
+	return (NextRandom(state) >> 11) / 9007199254740992.0;
+}
+
+// Cells of part of a pattern, as a key
+static std::string PatternPart(
+    const SamplePatterns& patterns, unsigned p,
+    unsigned left, unsigned top, unsigned right, unsigned bottom)
+{
+	std::string key;
+	for (unsigned x = left; x < right; x++) {
+		const GridCell *column =
+		    &patterns.cells[((size_t) p * patterns.size + x) * patterns.size];
+		key.append((const char *) (column + top),
+		           (bottom - top) * sizeof(GridCell));
+	}
+	return key;
+}
+
+/*
+	Learn the patterns of a sample map (& its rotations &
+	reflections, & across its edges, as asked). Neighbours are
+	allowed where their squares agree on all the cells they share,
+	found by grouping patterns by their edge parts rather than
+	testing every pair.
+	Returns false if the sample is smaller than a pattern.
+*/
+bool LearnPatterns(
+    const GridMap& sample, const SampleOptions& options,
+    SamplePatterns& patterns)
+{
+	unsigned size = max(1u, options.patternCells);
+	patterns = SamplePatterns();
+	patterns.size = size;
+
+	// Views of the sample (turns, flips, & flips of quarter turns)
+	std::vector<GridMap*> views;
+	unsigned symmetry = max(1u, min(options.symmetry, 8u));
+	static const MapTransform transforms[] = {
+		ROTATE_90, ROTATE_180, ROTATE_270, FLIP_HORZ, FLIP_VERT
+	};
+	for (unsigned i = 1; i < symmetry; i++) {
+		if (i <= 5) {
+			views.push_back(new GridMap(sample, transforms[i - 1]));
+		}
+		else {
+			GridMap turned(sample, i == 6 ? ROTATE_90 : ROTATE_270);
+			views.push_back(new GridMap(turned, FLIP_HORZ));
+		}
+	}
+
+	// Distinct squares & their counts (wrapping, squares start at
+	// every cell, running off the east & south edges onto the west
+	// & north ones)
+	std::unordered_map<std::string, unsigned> index;
+	for (unsigned v = 0; v < symmetry; v++) {
+		const GridMap& view = v ? *views[v - 1] : sample;
+		unsigned width = view.getWidthCells();
+		unsigned height = view.getHeightCells();
+		if (width < size || height < size) {
+			continue;
+		}
+		unsigned across = options.wrap ? width : width - size + 1;
+		unsigned down = options.wrap ? height : height - size + 1;
+		for (unsigned x = 0; x < across; x++) {
+			for (unsigned y = 0; y < down; y++) {
+				std::string key;
+				for (unsigned i = 0; i < size; i++) {
+					const GridCell *column = view.getColumn((x + i) % width);
+					if (y + size <= height) {
+						key.append((const char *) (column + y),
+						           size * sizeof(GridCell));
+						continue;
+					}
+					for (unsigned j = 0; j < size; j++) {
+						key.append((const char *) (column + (y + j) % height),
+						           sizeof(GridCell));
+					}
+				}
+				auto found = index.find(key);
+				if (found != index.end()) {
+					patterns.weights[found->second] += 1;
+					continue;
+				}
+				index[key] = patterns.count++;
+				patterns.weights.push_back(1);
+				const GridCell *cells = (const GridCell *) key.data();
+				patterns.cells.insert(
+				    patterns.cells.end(), cells, cells + size * size);
+			}
+		}
+	}
+	for (GridMap *view: views) {
+		delete view;
+	}
+	if (patterns.count == 0) {
+		return false;
+	}
+
+	// Neighbours: east of p if p's east part is q's west part,
+	// south of p if p's south part is q's north part
+	unsigned words = (patterns.count + WORD_BITS - 1) / WORD_BITS;
+	patterns.words = words;
+	for (std::vector<uint64_t>& allowed: patterns.allowed) {
+		allowed.assign((size_t) patterns.count * words, 0);
+	}
+	for (int dir: {EAST, SOUTH}) {
+		unsigned dx = dir == EAST, dy = dir == SOUTH;
+		std::unordered_map<std::string, std::vector<unsigned>> leading;
+		for (unsigned q = 0; q < patterns.count; q++) {
+			leading[PatternPart(
+			    patterns, q, 0, 0, size - dx, size - dy)].push_back(q);
+		}
+		for (unsigned p = 0; p < patterns.count; p++) {
+			auto found = leading.find(
+			    PatternPart(patterns, p, dx, dy, size, size));
+			if (found == leading.end()) {
+				continue;
+			}
+			for (unsigned q: found->second) {
+				patterns.allowed[dir][(size_t) p * words + q / WORD_BITS] |=
+				    (uint64_t) 1 << (q % WORD_BITS);
+				patterns.allowed[Opposite[dir]][
+				    (size_t) q * words + p / WORD_BITS] |=
+				    (uint64_t) 1 << (p % WORD_BITS);
+			}
+		}
+	}
+	return true;
+}
+
+// Shannon entropy of the weighted patterns left at a place
+static double PlaceEntropy(const PatternWave& wave, unsigned i)
+{
+	double sum = wave.sums[i];
+	return wave.counts[i] > 1 && sum > 0
+	       ? log(sum) - wave.logSums[i] / sum : 0;
+}
+
+// Move the place in a heap slot up or down to where it belongs
+static void SiftPlace(PatternWave& wave, unsigned slot)
+{
+	std::vector<unsigned>& heap = wave.heap;
+	unsigned i = heap[slot];
+	double entropy = wave.entropies[i];
+	while (slot > 0 && wave.entropies[heap[(slot - 1) / 2]] > entropy) {
+		heap[slot] = heap[(slot - 1) / 2];
+		wave.slots[heap[slot]] = slot;
+		slot = (slot - 1) / 2;
+	}
+	for (;;) {
+		unsigned child = 2 * slot + 1;
+		if (child >= heap.size()) {
+			break;
+		}
+		if (child + 1 < heap.size()
+		        && wave.entropies[heap[child + 1]]
+		           < wave.entropies[heap[child]]) {
+			child++;
+		}
+		if (wave.entropies[heap[child]] >= entropy) {
+			break;
+		}
+		heap[slot] = heap[child];
+		wave.slots[heap[slot]] = slot;
+		slot = child;
+	}
+	heap[slot] = i;
+	wave.slots[i] = slot;
+}
+
+/*
+	Queue a free place to collapse at its entropy (with a little
+	noise to break ties), or move it if queued already; places
+	down to one pattern leave the queue.
+*/
+static void QueuePlace(PatternWave& wave, unsigned i)
+{
+	std::vector<unsigned>& heap = wave.heap;
+	unsigned slot = wave.slots[i];
+	if (wave.counts[i] <= 1 || wave.kinds[i] != PLACE_FREE) {
+		if (slot != NO_PATTERN) {
+			wave.slots[i] = NO_PATTERN;
+			unsigned last = heap.back();
+			heap.pop_back();
+			if (last != i) {
+				heap[slot] = last;
+				wave.slots[last] = slot;
+				SiftPlace(wave, slot);
+			}
+		}
+		return;
+	}
+	wave.entropies[i] =
+	    PlaceEntropy(wave, i) + 1e-6 * RandomUnit(wave.state);
+	if (slot == NO_PATTERN) {
+		slot = heap.size();
+		heap.push_back(i);
+	}
+	SiftPlace(wave, slot);
+}
+
+// Queue a place to pass on its patterns
+static void StackPlace(PatternWave& wave, unsigned i)
+{
+	if (!wave.stacked[i]) {
+		wave.stacked[i] = true;
+		wave.stack.push_back(i);
+	}
+}
+
+// Sum the count & weights of the patterns at a place
+static void SumPatterns(PatternWave& wave, unsigned i)
+{
+	const SamplePatterns& patterns = *wave.patterns;
+	const uint64_t *domain = wave.domain(i);
+	wave.counts[i] = 0;
+	wave.sums[i] = wave.logSums[i] = 0;
+	for (unsigned w = 0; w < wave.words; w++) {
+		for (uint64_t bits = domain[w]; bits; bits &= bits - 1) {
+			unsigned p = w * WORD_BITS + __builtin_ctzll(bits);
+			wave.counts[i]++;
+			wave.sums[i] += patterns.weights[p];
+			wave.logSums[i] += wave.logWeights[p];
+		}
+	}
+}
+
+// Open a place with all the patterns it may have
+static void OpenPlace(PatternWave& wave, unsigned i)
+{
+	unsigned sides = wave.sides[i];
+	const uint64_t *open = wave.open(sides);
+	std::copy(open, open + wave.words, wave.domain(i));
+	wave.counts[i] = wave.openCounts[sides];
+	wave.sums[i] = wave.openSums[sides];
+	wave.logSums[i] = wave.openLogSums[sides];
+}
+
+/*
+	Work out the patterns a place opens with, for each mask
+	of sides with neighbours: those with a neighbour on each
+	side that may itself open there (with the side back, the same
+	sides across, & maybe none beyond), taking out patterns until
+	none are left to take.
+*/
+static void MakeOpens(PatternWave& wave)
+{
+	const SamplePatterns& patterns = *wave.patterns;
+	unsigned words = wave.words;
+	wave.opens.assign(16 * words, 0);
+	for (unsigned sides = 0; sides < 16; sides++) {
+		uint64_t *open = &wave.opens[(size_t) sides * words];
+		for (unsigned p = 0; p < patterns.count; p++) {
+			open[p / WORD_BITS] |= (uint64_t) 1 << (p % WORD_BITS);
+		}
+	}
+	for (bool taken = true; taken;) {
+		taken = false;
+		for (unsigned sides = 0; sides < 16; sides++) {
+			uint64_t *open = &wave.opens[(size_t) sides * words];
+			for (unsigned p = 0; p < patterns.count; p++) {
+				uint64_t bit = (uint64_t) 1 << (p % WORD_BITS);
+				if (!(open[p / WORD_BITS] & bit)) {
+					continue;
+				}
+				bool lonely = false;
+				for (int dir = 0; dir < 4 && !lonely; dir++) {
+					if (!(sides >> dir & 1)) {
+						continue;
+					}
+					unsigned across = dir == NORTH || dir == SOUTH
+					                  ? 1 << EAST | 1 << WEST
+					                  : 1 << NORTH | 1 << SOUTH;
+					const uint64_t *allowed = wave.allowed(dir, p);
+					const uint64_t *next =
+					    wave.open((sides & across) | 1 << Opposite[dir]);
+					lonely = true;
+					for (unsigned w = 0; w < words && lonely; w++) {
+						lonely = !(allowed[w] & next[w]);
+					}
+				}
+				if (lonely) {
+					open[p / WORD_BITS] &= ~bit;
+					taken = true;
+				}
+			}
+		}
+	}
+	wave.openCounts.assign(16, 0);
+	wave.openSums.assign(16, 0);
+	wave.openLogSums.assign(16, 0);
+	for (unsigned sides = 0; sides < 16; sides++) {
+		const uint64_t *open = wave.open(sides);
+		for (unsigned p = 0; p < patterns.count; p++) {
+			if (open[p / WORD_BITS] >> (p % WORD_BITS) & 1) {
+				wave.openCounts[sides]++;
+				wave.openSums[sides] += patterns.weights[p];
+				wave.openLogSums[sides] += wave.logWeights[p];
+			}
+		}
+	}
+}
+
+/*
+	Take patterns from a place (a bitset word at a time), queueing
+	it to pass the change on & to collapse at its new entropy.
+	Returns false if the place has none left.
+*/
+static bool RemovePatterns(
+    PatternWave& wave, unsigned i, const uint64_t *removed)
+{
+	const SamplePatterns& patterns = *wave.patterns;
+	uint64_t *domain = wave.domain(i);
+	unsigned taken = 0, left = 0;
+	for (unsigned w = 0; w < wave.words; w++) {
+		taken += __builtin_popcountll(domain[w] & removed[w]);
+		left += __builtin_popcountll(domain[w] & ~removed[w]);
+	}
+	if (!taken) {
+		return true;
+	}
+	if (!left) {
+		return false;
+	}
+
+	// Sums less those taken, or of those left if fewer
+	if (left < taken) {
+		for (unsigned w = 0; w < wave.words; w++) {
+			domain[w] &= ~removed[w];
+		}
+		SumPatterns(wave, i);
+	}
+	else {
+		for (unsigned w = 0; w < wave.words; w++) {
+			uint64_t bits = domain[w] & removed[w];
+			domain[w] &= ~bits;
+			for (; bits; bits &= bits - 1) {
+				unsigned p = w * WORD_BITS + __builtin_ctzll(bits);
+				wave.sums[i] -= patterns.weights[p];
+				wave.logSums[i] -= wave.logWeights[p];
+			}
+		}
+		wave.counts[i] = left;
+	}
+	StackPlace(wave, i);
+	QueuePlace(wave, i);
+	return true;
+}
+
+/*
+	Pass on the changes to places on the stack: each free neighbour
+	keeps only the patterns allowed by some pattern left here,
+	merged as bitsets, & passes on its own change in turn.
+	Places still with many patterns pass nothing on; they rule
+	out little, & each neighbour is checked again on collapse.
+	Returns false on a contradiction (a place with no patterns,
+	noted as failed).
+*/
+static bool Propagate(PatternWave& wave)
+{
+	unsigned words = wave.words;
+	std::vector<uint64_t>& reach = wave.reach;
+	while (!wave.stack.empty()) {
+		unsigned i = wave.stack.back();
+		wave.stack.pop_back();
+		wave.stacked[i] = false;
+		if (wave.counts[i] > wave.propagateMax) {
+			continue;
+		}
+		const uint64_t *domain = wave.domain(i);
+		unsigned x = i / wave.height, y = i % wave.height;
+		for (int dir = 0; dir < 4; dir++) {
+			unsigned nx = x + DirectionX[dir], ny = y + DirectionY[dir];
+			if (nx >= wave.width || ny >= wave.height) {
+				continue;
+			}
+			unsigned n = nx * wave.height + ny;
+			if (wave.kinds[n] != PLACE_FREE) {
+				continue;
+			}
+			std::fill(reach.begin(), reach.end(), ALL_ROCK);
+			if (wave.counts[n] < wave.counts[i]) {
+				// Test each pattern there (fewer) against those here
+				const uint64_t *there = wave.domain(n);
+				for (unsigned w = 0; w < words; w++) {
+					for (uint64_t bits = there[w]; bits; bits &= bits - 1) {
+						const uint64_t *allowed = wave.allowed(
+						    Opposite[dir], w * WORD_BITS + __builtin_ctzll(bits));
+						for (unsigned k = 0; k < words; k++) {
+							if (allowed[k] & domain[k]) {
+								reach[w] &= ~(bits & -bits);
+								break;
+							}
+						}
+					}
+				}
+			}
+			else {
+				// Merge what the patterns here allow
+				for (unsigned w = 0; w < words; w++) {
+					for (uint64_t bits = domain[w]; bits; bits &= bits - 1) {
+						const uint64_t *allowed = wave.allowed(
+						    dir, w * WORD_BITS + __builtin_ctzll(bits));
+						for (unsigned k = 0; k < words; k++) {
+							reach[k] &= ~allowed[k];
+						}
+					}
+				}
+			}
+			if (!RemovePatterns(wave, n, reach.data())) {
+				wave.failed = n;
+				for (unsigned j: wave.stack) {
+					wave.stacked[j] = false;
+				}
+				wave.stack.clear();
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/*
+	Reopen the square of places around a contradiction (free, or
+	decided before) to all the patterns they may have,
+	& pass the patterns of the places around it back in.
+	The rest of the wave is kept.
+*/
+static void ResetArea(PatternWave& wave, unsigned center, unsigned radius)
+{
+	unsigned cx = center / wave.height, cy = center % wave.height;
+	unsigned left = cx > radius ? cx - radius : 0;
+	unsigned top = cy > radius ? cy - radius : 0;
+	unsigned right = min(cx + radius + 1, wave.width);
+	unsigned bottom = min(cy + radius + 1, wave.height);
+	for (unsigned x = left; x < right; x++) {
+		for (unsigned y = top; y < bottom; y++) {
+			unsigned i = x * wave.height + y;
+			if (wave.kinds[i] == PLACE_FREE
+			        || wave.kinds[i] == PLACE_DECIDED) {
+				wave.kinds[i] = PLACE_FREE;
+				OpenPlace(wave, i);
+				QueuePlace(wave, i);
+			}
+		}
+	}
+	for (unsigned x = left ? left - 1 : 0; x < min(right + 1, wave.width);
+	        x++) {
+		for (unsigned y = top ? top - 1 : 0;
+		        y < min(bottom + 1, wave.height); y++) {
+			StackPlace(wave, x * wave.height + y);
+		}
+	}
+}
+
+// Leave just one pattern at a place, picked by weight
+static void CollapsePlace(PatternWave& wave, unsigned i)
+{
+	const SamplePatterns& patterns = *wave.patterns;
+	const uint64_t *domain = wave.domain(i);
+	double pick = RandomUnit(wave.state) * wave.sums[i];
+	unsigned chosen = NO_PATTERN;
+	for (unsigned w = 0; w < wave.words && pick >= 0; w++) {
+		for (uint64_t bits = domain[w]; bits && pick >= 0;
+		        bits &= bits - 1) {
+			chosen = w * WORD_BITS + __builtin_ctzll(bits);
+			pick -= patterns.weights[chosen];
+		}
+	}
+	std::vector<uint64_t>& removed = wave.reach;
+	std::fill(removed.begin(), removed.end(), ALL_ROCK);
+	removed[chosen / WORD_BITS] &= ~((uint64_t) 1 << (chosen % WORD_BITS));
+	RemovePatterns(wave, i, removed.data());
+}
+
+/*
+	Solve a region of the pattern grid (column-major, gridHeight
+	high), next to the patterns already decided around it.
+	Decided places near the region are in the wave too, so a
+	contradiction can reopen them as well as undo collapses near
+	it: a square around it is reset, doubled in size each time
+	until a collapse works. On success the region (& whatever was
+	reopened) is decided; if contradictions go on, returns false,
+	leaving the grid as it was.
+*/
+static bool SolveRegion(
+    PatternWave& wave, std::vector<unsigned>& decided,
+    unsigned gridWidth, unsigned gridHeight, GridRect region)
+{
+	const SamplePatterns& patterns = *wave.patterns;
+	unsigned words = wave.words;
+	unsigned left = region.left > REGION_MARGIN + 1
+	                ? region.left - REGION_MARGIN - 1 : 0;
+	unsigned top = region.top > REGION_MARGIN + 1
+	               ? region.top - REGION_MARGIN - 1 : 0;
+	unsigned right = min(region.right + REGION_MARGIN + 1, gridWidth);
+	unsigned bottom = min(region.bottom + REGION_MARGIN + 1, gridHeight);
+	wave.width = right - left;
+	wave.height = bottom - top;
+	size_t places = (size_t) wave.width * wave.height;
+	wave.domains.assign(places * words, 0);
+	wave.counts.assign(places, 0);
+	wave.sums.assign(places, 0);
+	wave.logSums.assign(places, 0);
+	wave.kinds.assign(places, PLACE_FREE);
+	wave.sides.assign(places, 0);
+	wave.stacked.assign(places, false);
+	wave.reach.resize(words);
+	wave.stack.clear();
+	wave.heap.clear();
+	wave.slots.assign(places, NO_PATTERN);
+	wave.entropies.resize(places);
+
+	// Kinds of place (undecided places beyond the region are solved
+	// too, as a look ahead, so the region doesn't end in a pattern
+	// that can't be followed; they're left undecided after)
+	auto inRegion = [&](unsigned gx, unsigned gy) {
+		return gx >= region.left && gx < region.right
+		       && gy >= region.top && gy < region.bottom;
+	};
+	for (unsigned x = 0; x < wave.width; x++) {
+		for (unsigned y = 0; y < wave.height; y++) {
+			unsigned gx = left + x, gy = top + y;
+			unsigned char& kind = wave.kinds[x * wave.height + y];
+			if (!inRegion(gx, gy)
+			        && decided[(size_t) gx * gridHeight + gy] != NO_PATTERN) {
+				bool ring = x == 0 || y == 0
+				            || x + 1 == wave.width || y + 1 == wave.height;
+				kind = ring ? PLACE_FIXED : PLACE_DECIDED;
+			}
+		}
+	}
+
+	// Open free places, & set decided ones to their patterns (sides
+	// with neighbours are those in the grid, in the wave or not)
+	for (unsigned x = 0; x < wave.width; x++) {
+		for (unsigned y = 0; y < wave.height; y++) {
+			unsigned i = x * wave.height + y;
+			for (int dir = 0; dir < 4; dir++) {
+				unsigned nx = left + x + DirectionX[dir];
+				unsigned ny = top + y + DirectionY[dir];
+				if (nx < gridWidth && ny < gridHeight) {
+					wave.sides[i] |= 1 << dir;
+				}
+			}
+			if (wave.kinds[i] == PLACE_FREE) {
+				OpenPlace(wave, i);
+				QueuePlace(wave, i);
+				continue;
+			}
+			unsigned p = decided[(size_t) (left + x) * gridHeight + top + y];
+			uint64_t *domain = wave.domain(i);
+			domain[p / WORD_BITS] = (uint64_t) 1 << (p % WORD_BITS);
+			wave.counts[i] = 1;
+			wave.sums[i] = patterns.weights[p];
+			wave.logSums[i] = wave.logWeights[p];
+			StackPlace(wave, i);
+		}
+	}
+
+	// Collapse least entropy first, passing on each
+	// (& resetting around contradictions, within a budget)
+	unsigned doublings = 0, resets = 0;
+	bool settled = Propagate(wave);
+	while (!settled || !wave.heap.empty()) {
+		if (!settled) {
+			if (doublings > RESET_DOUBLINGS
+			        || ++resets > places / RESET_PLACES) {
+				return false;
+			}
+			ResetArea(wave, wave.failed, RESET_RADIUS << doublings++);
+			settled = Propagate(wave);
+			continue;
+		}
+		CollapsePlace(wave, wave.heap[0]);
+		settled = Propagate(wave);
+		if (settled && doublings) {
+			doublings--;
+		}
+	}
+
+	// Decide the free places (but not the look ahead)
+	for (unsigned x = 0; x < wave.width; x++) {
+		for (unsigned y = 0; y < wave.height; y++) {
+			unsigned i = x * wave.height + y;
+			unsigned gx = left + x, gy = top + y;
+			if (wave.kinds[i] != PLACE_FREE
+			        || (!inRegion(gx, gy)
+			            && decided[(size_t) gx * gridHeight + gy]
+			               == NO_PATTERN)) {
+				continue;
+			}
+			const uint64_t *domain = wave.domain(i);
+			unsigned w = 0;
+			while (!domain[w]) {
+				w++;
+			}
+			decided[(size_t) (left + x) * gridHeight + top + y] =
+			    w * WORD_BITS + __builtin_ctzll(domain[w]);
+		}
+	}
+	return true;
+}
+
+/*
+	Generate a map like a sample, from its learned patterns
+	(new; caller deletes). Each place of the pattern grid stands for
+	the pattern at that corner, overlapping those beside it; the
+	grid is solved region by region, from the northwest corner.
+	A region that can't be solved in its tries is tried again
+	grown by a region west, north & east (reopening those), & so on
+	until it takes in the map that far; returns NULL if even that
+	can't be solved.
+*/
+GridMap* GenerateFromSample(
+    const SamplePatterns& patterns, unsigned width, unsigned height,
+    const SampleOptions& options)
+{
+	GridMap *map = new GridMap(width, height);
+	if (width == 0 || height == 0 || patterns.count == 0) {
+		return map;
+	}
+	unsigned size = patterns.size;
+	unsigned gridWidth = width >= size ? width - size + 1 : 1;
+	unsigned gridHeight = height >= size ? height - size + 1 : 1;
+	unsigned regionCells = max(1u, options.regionCells);
+	std::vector<unsigned> decided(
+	    (size_t) gridWidth * gridHeight, NO_PATTERN);
+	std::vector<double> logWeights;
+	for (double weight: patterns.weights) {
+		logWeights.push_back(weight * log(weight));
+	}
+	uint64_t seed = Mix64(options.seed);
+
+	unsigned threads = options.threads;
+	if (threads == 0) {
+		threads = max(1u, std::thread::hardware_concurrency());
+	}
+	PatternWave start;
+	start.patterns = &patterns;
+	start.logWeights = logWeights.data();
+	start.words = patterns.words;
+	MakeOpens(start);
+
+	// Solve regions in diagonal steps, each region after those west
+	// & north of it; regions of a step are skewed far enough apart
+	// that their waves never meet, so they solve on separate threads
+	unsigned regionsWide = (gridWidth + regionCells - 1) / regionCells;
+	unsigned regionsHigh = (gridHeight + regionCells - 1) / regionCells;
+	unsigned skew =
+	    1 + (2 * (REGION_MARGIN + 1) + regionCells - 1) / regionCells;
+	unsigned steps = regionsWide + skew * (regionsHigh - 1);
+	auto solve = [&](PatternWave& wave, GridRect region, uint64_t stream,
+	                 bool grown) {
+		for (unsigned i = 0; i < REGION_TRIES; i++) {
+			wave.state = Mix64(seed ^ Mix64(stream * REGION_TRIES + i));
+			wave.propagateMax = grown && i >= REGION_TRIES / 2
+			                    ? GROWN_PROPAGATE_MAX : PROPAGATE_MAX;
+			if (SolveRegion(wave, decided, gridWidth, gridHeight, region)) {
+				return true;
+			}
+		}
+		return false;
+	};
+	auto regionRect = [&](unsigned rx, unsigned ry, unsigned grown) {
+		GridRect rect = {
+			(rx > grown ? rx - grown : 0) * regionCells,
+			(ry > grown ? ry - grown : 0) * regionCells,
+			min((rx + grown + 1) * regionCells, gridWidth),
+			min((ry + 1) * regionCells, gridHeight)
+		};
+		return rect;
+	};
+	uint64_t regionCount = (uint64_t) regionsWide * regionsHigh;
+	std::vector<GridCoord> stepRegions;
+	std::vector<char> stepFailed;
+	for (unsigned step = 0; step < steps; step++) {
+		stepRegions.clear();
+		for (unsigned ry = 0; ry < regionsHigh && skew * ry <= step; ry++) {
+			if (step - skew * ry < regionsWide) {
+				stepRegions.push_back({step - skew * ry, ry});
+			}
+		}
+		stepFailed.assign(stepRegions.size(), false);
+		RunBands(stepRegions.size(), threads,
+		         [&](unsigned first, unsigned last) {
+			PatternWave wave = start;
+			for (unsigned k = first; k < last; k++) {
+				GridCoord r = stepRegions[k];
+				uint64_t index = (uint64_t) r.y * regionsWide + r.x;
+				stepFailed[k] =
+				    !solve(wave, regionRect(r.x, r.y, 0), index, false);
+			}
+		});
+
+		// Grow the regions that failed, one at a time (grown, their
+		// waves may meet)
+		for (unsigned k = 0; k < stepRegions.size(); k++) {
+			if (!stepFailed[k]) {
+				continue;
+			}
+			GridCoord r = stepRegions[k];
+			uint64_t index = (uint64_t) r.y * regionsWide + r.x;
+			PatternWave wave = start;
+			bool solved = false;
+			for (unsigned grown = 1; !solved; grown++) {
+				if (grown > r.x && grown > r.y
+				        && r.x + grown >= regionsWide) {
+					delete map;
+					return NULL;
+				}
+				solved = solve(wave, regionRect(r.x, r.y, grown),
+				               grown * regionCount + index, true);
+			}
+		}
+	}
+
+	// Cells from the patterns (the last place in each row & column
+	// gives all its pattern's cells; others just their corner)
+	CellBlock block;
+	block.width = width;
+	block.height = height;
+	block.cells.assign(
+	    (size_t) width * height,
+	    {FLOOR_FILL, WALL_OPEN, WALL_OPEN, OBJECT_NONE});
+	block.eastWalls.assign(height, WALL_OPEN);
+	block.southWalls.assign(width, WALL_OPEN);
+	for (unsigned x = 0; x < width; x++) {
+		unsigned px = min(x, gridWidth - 1);
+		GridCell *column = &block.cells[(size_t) x * height];
+		for (unsigned y = 0; y < height; y++) {
+			unsigned py = min(y, gridHeight - 1);
+			unsigned p = decided[(size_t) px * gridHeight + py];
+			if (p != NO_PATTERN) {
+				column[y] = patterns.cells[
+				    ((size_t) p * size + x - px) * size + y - py];
+			}
+		}
+	}
+	map->pasteCells(block, {0, 0});
+	return map;
+}
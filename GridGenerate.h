@@ -0,0 +1,103 @@
+/*
+	Name: GridGenerate.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Procedural map generators.
+		Caves are grown by a cellular automaton on bitboards,
+		64 cells to a word, with bands of strips on separate threads.
+		Dungeons of rooms & corridors are made in square sectors,
+		each on its own (so in parallel), joined at their edges.
+		The same seed & settings always give the same map.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDGENERATE_H
+#define GRIDGENERATE_H
+#include "GridMap.h"
+#include <cstdint>
+#include <vector>
+
+/*
+	Settings for a cave.
+	Rock starts at random (fillPercent of cells), then each
+	smoothing pass makes a cell rock if 5 or more of the 9 cells
+	around & including it are rock (outside the map is rock).
+	Stalagmites go on open cells beside rock, rubble anywhere open.
+*/
+struct CaveOptions {
+	unsigned seed = 1;
+	unsigned fillPercent = 45;
+	unsigned iterations = 5;
+	unsigned stalagmitePermille = 20;
+	unsigned rubblePermille = 4;
+	unsigned threads = 0;               // zero for all cores
+};
+
+/*
+	Settings for a rooms & corridors dungeon.
+	Each sector places rooms at random where they don't touch,
+	links each to its nearest older room, & links a point on each
+	edge it shares (fixed by the seed, so both sides agree) to its
+	nearest room. Room entrances get doors by chance; some sectors
+	get stairs, & some big rooms pillars.
+*/
+struct DungeonOptions {
+	unsigned seed = 1;
+	unsigned sectorCells = 48;
+	unsigned roomMin = 3, roomMax = 9;  // room sides in cells
+	unsigned roomTries = 40;            // per sector
+	unsigned doorPercent = 80;          // of room entrances
+	unsigned stairsPercent = 30;        // of sectors
+	unsigned pillarPercent = 30;        // of rooms 5x5 or more
+	unsigned threads = 0;               // zero for all cores
+};
+
+/*
+	Settings for learning from a sample map & generating like it.
+	Patterns are squares of patternCells cells (floor, walls &
+	object), from the sample & as many as symmetry of its 8
+	rotations & reflections (more are slower, but give more varied
+	maps); with wrap, also across its edges, as if it tiled the
+	plane (without, squares near its edges may have no way on, &
+	big maps fill with the few that repeat forever, as stripes).
+	New maps are solved a square region of regionCells at a time,
+	next to those already done (looking ahead past its edges); a
+	region that comes to a contradiction is tried again, & then
+	grown over the regions west, north & east of it; regions far
+	enough apart are solved in parallel.
+*/
+struct SampleOptions {
+	unsigned seed = 1;
+	unsigned patternCells = 3;
+	unsigned symmetry = 1;              // 1 to 8
+	bool wrap = true;
+	unsigned regionCells = 32;
+	unsigned threads = 0;               // zero for all cores
+};
+
+/*
+	Patterns learned from a sample map: cells of each distinct
+	square (column-major, size x size apiece), how often each was
+	seen, & for each direction a bitset per pattern of the patterns
+	that may lie next to it that way (words to a bitset).
+*/
+struct SamplePatterns {
+	unsigned size = 0, count = 0, words = 0;
+	std::vector<GridCell> cells;
+	std::vector<double> weights;
+	std::vector<uint64_t> allowed[4];   // by Direction
+};
+
+// Function prototypes
+GridMap* GenerateCave(
+    unsigned width, unsigned height, const CaveOptions& options);
+GridMap* GenerateDungeon(
+    unsigned width, unsigned height, const DungeonOptions& options);
+bool LearnPatterns(
+    const GridMap& sample, const SampleOptions& options,
+    SamplePatterns& patterns);
+GridMap* GenerateFromSample(
+    const SamplePatterns& patterns, unsigned width, unsigned height,
+    const SampleOptions& options);
+#endif
@@ -9,10 +9,12 @@
 */
 #include "GridMap.h"
 #include <stdio.h>
+#include <cstring>
 #include <algorithm>
 #include <cstdlib>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 using std::min;
 using std::max;
 
@@ -61,6 +63,85 @@ bool IsFloorSemiOpen(FloorType floor)
 	return IsFloorOpenType(floor) || IsFloorDiagonalFill(floor);
 }
 
+// Is this cell in a region?
+bool IsInRegion(const GridRegion& region, GridCoord gc)
+{
+	const GridRect& r = region.bounds;
+	if (gc.x < r.left || gc.x >= r.right
+	        || gc.y < r.top || gc.y >= r.bottom) {
+		return false;
+	}
+	return region.mask.empty()
+	       || region.mask[(size_t) (gc.x - r.left) * (r.bottom - r.top)
+	                      + (gc.y - r.top)];
+}
+
+//------------------------------------------------------------------
+// Unit-circle tables for stamped features
+//------------------------------------------------------------------
+
+/*
+	Angles are computed exactly as the old per-cell drawing code did,
+	so the scaled geometry is pixel-identical to what it produced.
+*/
+
+// One unit-circle vertex
+struct UnitVertex {
+	double cosine, sine;
+};
+
+// All unit-circle vertices for stamped features
+struct UnitCircleTables {
+	UnitVertex spiralArcStart, spiralArcEnd;
+	UnitVertex spiralSpokes[SPIRAL_SPOKES + 1];
+	UnitVertex statueStar[STATUE_STAR_POINTS];
+	UnitVertex stalagmiteSpokes[STALAGMITE_SPOKES];
+};
+
+// Get vertex on unit circle at given angle
+static UnitVertex MakeUnitVertex(double angle)
+{
+	return { cos(angle), sin(angle) };
+}
+
+// Build the unit-circle tables
+static UnitCircleTables MakeUnitCircleTables()
+{
+	UnitCircleTables t;
+
+	// Spiral stairs arc (open at top) and spokes
+	double arcStartAngle = TAU/4 + 0.5;
+	double arcEndAngle   = TAU/4 - 0.5;
+	double arcSweepAngle = TAU - (arcStartAngle - arcEndAngle);
+	double anglePerSpoke = arcSweepAngle / SPIRAL_SPOKES;
+	t.spiralArcStart = MakeUnitVertex(arcStartAngle);
+	t.spiralArcEnd = MakeUnitVertex(arcEndAngle);
+	for (int i = 0; i <= SPIRAL_SPOKES; ++i) {
+		t.spiralSpokes[i] = MakeUnitVertex(arcStartAngle + anglePerSpoke * i);
+	}
+
+	// Statue star (alternating outer and inner vertices)
+	double startAngle = -TAU / 4;
+	double angleStep = TAU / STATUE_STAR_POINTS;
+	for (int i = 0; i < STATUE_STAR_POINTS; ++i) {
+		t.statueStar[i] = MakeUnitVertex(startAngle + i * angleStep);
+	}
+
+	// Stalagmite partial spokes
+	for (int i = 0; i < STALAGMITE_SPOKES; ++i) {
+		double angle = i * (TAU / STALAGMITE_SPOKES);
+		t.stalagmiteSpokes[i] = MakeUnitVertex(angle);
+	}
+	return t;
+}
+
+// Get the unit-circle tables (built once, on first use)
+static const UnitCircleTables& GetUnitCircleTables()
+{
+	static const UnitCircleTables tables = MakeUnitCircleTables();
+	return tables;
+}
+
 //------------------------------------------------------------------
 // Display code handlers
 //------------------------------------------------------------------
@@ -110,6 +191,7 @@ void GridMap::setCellSizePixels(unsigned cellSize)
 	displayCode =
 	    (displayCode & ~MASK_CELL_SIZE)
 	    | (cellSize & MASK_CELL_SIZE);
+	makeFeatureGeometry();
 }
 
 // Do we want to see rough edges?
@@ -136,6 +218,236 @@ void GridMap::toggleNoGrid()
 	displayCode ^= MASK_HIDE_GRID;
 }
 
+//------------------------------------------------------------------
+// Transforms
+//------------------------------------------------------------------
+
+// Side of a cell a transform moves each side to
+// (indexed by transform, then by Direction)
+static constexpr Direction TransformSides[5][4] = {
+	{EAST, WEST, SOUTH, NORTH},     // ROTATE_90
+	{SOUTH, NORTH, WEST, EAST},     // ROTATE_180
+	{WEST, EAST, NORTH, SOUTH},     // ROTATE_270
+	{NORTH, SOUTH, WEST, EAST},     // FLIP_HORZ
+	{SOUTH, NORTH, EAST, WEST}      // FLIP_VERT
+};
+
+// Side of a cell a transform moves to each side (the inverse)
+static constexpr Direction TransformSidesFrom[5][4] = {
+	{WEST, EAST, NORTH, SOUTH},     // ROTATE_90
+	{SOUTH, NORTH, WEST, EAST},     // ROTATE_180
+	{EAST, WEST, SOUTH, NORTH},     // ROTATE_270
+	{NORTH, SOUTH, WEST, EAST},     // FLIP_HORZ
+	{SOUTH, NORTH, EAST, WEST}      // FLIP_VERT
+};
+
+// Cells per side of the blocks transformed at a time
+const unsigned TRANSFORM_BLOCK = 64;
+
+// Does a transform swap width & height?
+bool IsTransformTurn(MapTransform transform)
+{
+	return transform == ROTATE_90 || transform == ROTATE_270;
+}
+
+// Get a diagonal floor corner as a side pair, moved & rebuilt
+static FloorType TransformCorner(
+    MapTransform transform, Direction vertical, Direction horizontal)
+{
+	Direction a = TransformSides[transform][vertical];
+	Direction b = TransformSides[transform][horizontal];
+	bool north = (a == NORTH || b == NORTH);
+	bool west = (a == WEST || b == WEST);
+	return north ? (west ? FLOOR_NWFILL : FLOOR_NEFILL)
+	       : (west ? FLOOR_SWFILL : FLOOR_SEFILL);
+}
+
+/*
+	Make the table of floors after a transform: diagonal fills
+	move corner, and diagonal walls, doors & stairs change
+	direction with a quarter turn or a mirror image.
+*/
+static void MakeTransformFloors(
+    MapTransform transform, unsigned char floors[256])
+{
+	for (int i = 0; i < 256; i++) {
+		floors[i] = (unsigned char) i;
+	}
+	floors[FLOOR_NWFILL] = TransformCorner(transform, NORTH, WEST);
+	floors[FLOOR_NEFILL] = TransformCorner(transform, NORTH, EAST);
+	floors[FLOOR_SWFILL] = TransformCorner(transform, SOUTH, WEST);
+	floors[FLOOR_SEFILL] = TransformCorner(transform, SOUTH, EAST);
+	if (transform != ROTATE_180) {
+		floors[FLOOR_NEWALL] = FLOOR_NWWALL;
+		floors[FLOOR_NWWALL] = FLOOR_NEWALL;
+		floors[FLOOR_NEDOOR] = FLOOR_NWDOOR;
+		floors[FLOOR_NWDOOR] = FLOOR_NEDOOR;
+	}
+	if (IsTransformTurn(transform)) {
+		floors[FLOOR_NSTAIRS] = FLOOR_WSTAIRS;
+		floors[FLOOR_WSTAIRS] = FLOOR_NSTAIRS;
+	}
+}
+
+/*
+	Get the wall on one side of a cell in columns of cells.
+	South & east walls belong to the next cells; past the last
+	they come from the edge walls given, else are open.
+*/
+static inline unsigned char SideWall(
+    const GridCell *const *cells, unsigned width, unsigned height,
+    const unsigned char *east, const unsigned char *south,
+    unsigned x, unsigned y, Direction side)
+{
+	switch (side) {
+		case NORTH:
+			return cells[x][y].nwall;
+		case WEST:
+			return cells[x][y].wwall;
+		case SOUTH:
+			return y + 1 < height ? cells[x][y+1].nwall
+			       : south ? south[x] : (unsigned char) WALL_OPEN;
+		default:
+			return x + 1 < width ? cells[x+1][y].wwall
+			       : east ? east[y] : (unsigned char) WALL_OPEN;
+	}
+}
+
+// Get where a transform moves a cell
+static inline GridCoord TransformCoord(
+    MapTransform transform, unsigned width, unsigned height,
+    unsigned x, unsigned y)
+{
+	switch (transform) {
+		case ROTATE_90:
+			return {height - 1 - y, x};
+		case ROTATE_180:
+			return {width - 1 - x, height - 1 - y};
+		case ROTATE_270:
+			return {y, width - 1 - x};
+		case FLIP_HORZ:
+			return {width - 1 - x, y};
+		default:
+			return {x, height - 1 - y};
+	}
+}
+
+/*
+	Transform columns of cells (width x height) into new columns
+	(height x width for a quarter turn). Each new cell takes the
+	walls from the old sides that land on its north & west.
+	Quarter turns work in square blocks, so reads & writes stay
+	within a few cache lines per column rather than striding
+	over the whole map; other transforms go column to column.
+	Built per transform, so the inner loop has no switches left.
+*/
+template <MapTransform transform>
+static void TransformCellsAs(
+    const GridCell *const *from, unsigned width, unsigned height,
+    const unsigned char *east, const unsigned char *south,
+    GridCell *const *to)
+{
+	unsigned char floors[256];
+	MakeTransformFloors(transform, floors);
+	constexpr Direction northFrom = TransformSidesFrom[transform][NORTH];
+	constexpr Direction westFrom = TransformSidesFrom[transform][WEST];
+	unsigned block = IsTransformTurn(transform) ? TRANSFORM_BLOCK : height;
+	for (unsigned bx = 0; bx < width; bx += block) {
+		unsigned right = min(bx + block, width);
+		for (unsigned by = 0; by < height; by += block) {
+			unsigned bottom = min(by + block, height);
+			for (unsigned x = bx; x < right; x++) {
+				const GridCell *column = from[x];
+				for (unsigned y = by; y < bottom; y++) {
+					GridCoord c =
+					    TransformCoord(transform, width, height, x, y);
+					GridCell& cell = to[c.x][c.y];
+					cell.floor = floors[column[y].floor];
+					cell.object = column[y].object;
+					cell.nwall = SideWall(
+					    from, width, height, east, south, x, y, northFrom);
+					cell.wwall = SideWall(
+					    from, width, height, east, south, x, y, westFrom);
+				}
+			}
+		}
+	}
+}
+
+// Transform columns of cells (see TransformCellsAs)
+static void TransformCells(
+    const GridCell *const *from, unsigned width, unsigned height,
+    const unsigned char *east, const unsigned char *south,
+    MapTransform transform, GridCell *const *to)
+{
+	switch (transform) {
+		case ROTATE_90:
+			TransformCellsAs<ROTATE_90>(from, width, height, east, south, to);
+			break;
+		case ROTATE_180:
+			TransformCellsAs<ROTATE_180>(
+			    from, width, height, east, south, to);
+			break;
+		case ROTATE_270:
+			TransformCellsAs<ROTATE_270>(
+			    from, width, height, east, south, to);
+			break;
+		case FLIP_HORZ:
+			TransformCellsAs<FLIP_HORZ>(from, width, height, east, south, to);
+			break;
+		case FLIP_VERT:
+			TransformCellsAs<FLIP_VERT>(from, width, height, east, south, to);
+			break;
+	}
+}
+
+/*
+	Transform a copied block of cells in place,
+	with its east & south edge walls.
+*/
+void TransformCellBlock(CellBlock& block, MapTransform transform)
+{
+	unsigned width = block.width, height = block.height;
+	bool turn = IsTransformTurn(transform);
+	CellBlock result;
+	result.width = turn ? height : width;
+	result.height = turn ? width : height;
+	result.cells.resize(block.cells.size());
+	std::vector<const GridCell*> from(width);
+	std::vector<GridCell*> to(result.width);
+	for (unsigned x = 0; x < width; x++) {
+		from[x] = block.cells.data() + (size_t) x * height;
+	}
+	for (unsigned x = 0; x < result.width; x++) {
+		to[x] = result.cells.data() + (size_t) x * result.height;
+	}
+	const unsigned char *east = block.eastWalls.data();
+	const unsigned char *south = block.southWalls.data();
+	TransformCells(
+	    from.data(), width, height, east, south, transform, to.data());
+
+	// New edge walls come from the old sides moved east & south
+	Direction eastFrom = TransformSidesFrom[transform][EAST];
+	Direction southFrom = TransformSidesFrom[transform][SOUTH];
+	result.eastWalls.assign(result.height, WALL_OPEN);
+	result.southWalls.assign(result.width, WALL_OPEN);
+	for (unsigned x = 0; x < width; x++) {
+		for (unsigned y = 0; y < height; y++) {
+			GridCoord c = TransformCoord(transform, width, height, x, y);
+			if (c.x + 1 == result.width) {
+				result.eastWalls[c.y] = SideWall(
+				    from.data(), width, height, east, south, x, y, eastFrom);
+			}
+			if (c.y + 1 == result.height) {
+				result.southWalls[c.x] = SideWall(
+				    from.data(), width, height, east, south, x, y,
+				    southFrom);
+			}
+		}
+	}
+	block = result;
+}
+
 //------------------------------------------------------------------
 // Constructor/ Destructors
 //------------------------------------------------------------------
@@ -147,21 +459,10 @@ GridMap::GridMap(unsigned _width, unsigned _height)
 	height = _height;
 	displayCode = 0;
 	setCellSizePixels(getCellSizeDefault());
-	grid = new GridCell*[width];
-	for (unsigned x = 0; x < width; x++)
-		grid[x] = new GridCell[height];
-	for (unsigned x = 0; x < width; x++) {
-		for (unsigned y = 0; y < height; y++) {
-			grid[x][y].floor = FLOOR_FILL;
-			grid[x][y].nwall = WALL_OPEN;
-			grid[x][y].wwall = WALL_OPEN;
-			grid[x][y].object = OBJECT_NONE;
-		}
-	}
+	makeStrips();               // zeroed: fill, no walls or objects
 	filename[0] = '\0';
 	changed = false;
 	fileLoadOk = true;
-	makeStandardPens();
 }
 
 // Constructor taking filename
@@ -184,10 +485,7 @@ GridMap::GridMap(char *_filename)
 	fread(&displayCode, sizeof(int), 1, f);
 	fread(&width, sizeof(int), 1, f);
 	fread(&height, sizeof(int), 1, f);
-	grid = new GridCell*[width];
-	for (unsigned x = 0; x < width; x++) {
-		grid[x] = new GridCell[height];
-	}
+	makeStrips();
 	for (unsigned x = 0; x < width; x++) {
 		fread(grid[x], sizeof(GridCell), height, f);
 	}
@@ -197,7 +495,7 @@ GridMap::GridMap(char *_filename)
 	changed = false;
 	fileLoadOk = true;
 	setFilename(_filename);
-	makeStandardPens();
+	makeFeatureGeometry();
 	return;
 
 fail:
@@ -207,17 +505,157 @@ fail:
 	fileLoadOk = false;
 }
 
+/*
+	Copy constructor: cells, file name & display settings.
+	Cell strips are shared, not copied (just a pointer per column),
+	so this is a cheap snapshot: either map may then be changed,
+	copying only the strips it writes. The copy may be painted
+	on another thread while this map is edited, without locks.
+	Copy only on the thread that changes this map.
+	The copy has no canvas until painted.
+*/
+GridMap::GridMap(const GridMap& other)
+{
+	width = other.width;
+	height = other.height;
+	displayCode = other.displayCode;
+	grid = new GridCell*[width];
+	memcpy(grid, other.grid, width * sizeof(GridCell*));
+	strips = other.strips;
+	for (CellStrip *strip: strips) {
+		strip->refs++;
+	}
+	strcpy(filename, other.filename);
+	changed = other.changed;
+	fileLoadOk = other.fileLoadOk;
+	geometry = other.geometry;
+}
+
+/*
+	Transforming constructor: a rotated or mirrored copy
+	(cells, file name & display settings), marked changed.
+*/
+GridMap::GridMap(const GridMap& other, MapTransform transform)
+{
+	bool turn = IsTransformTurn(transform);
+	width = turn ? other.height : other.width;
+	height = turn ? other.width : other.height;
+	displayCode = other.displayCode;
+	makeStrips();
+	TransformCells(
+	    other.grid, other.width, other.height, NULL, NULL,
+	    transform, grid);
+	strcpy(filename, other.filename);
+	changed = true;
+	fileLoadOk = other.fileLoadOk;
+	geometry = other.geometry;
+}
+
+/*
+	Resizing constructor: a copy with new dimensions (file name &
+	display settings), marked changed. Each old cell (x, y) moves
+	to (x + shiftX, y + shiftY); cells moved off the new map are
+	cropped, and cells not covered are filled. Overlapping columns
+	are copied whole, and walls left on the new border cleared.
+*/
+GridMap::GridMap(
+    const GridMap& other, unsigned _width, unsigned _height,
+    int shiftX, int shiftY)
+{
+	width = _width;
+	height = _height;
+	displayCode = other.displayCode;
+	makeStrips();               // zeroed: fill, no walls or objects
+
+	// Copy the overlap (in old coordinates)
+	long long left = max(0LL, (long long) -shiftX);
+	long long right = min((long long) other.width,
+	                      (long long) width - shiftX);
+	long long top = max(0LL, (long long) -shiftY);
+	long long bottom = min((long long) other.height,
+	                       (long long) height - shiftY);
+	if (left < right && top < bottom) {
+		for (long long x = left; x < right; x++) {
+			memcpy(grid[x + shiftX] + (top + shiftY), other.grid[x] + top,
+			       (size_t) (bottom - top) * sizeof(GridCell));
+		}
+		for (unsigned x = 0; x < width; x++) {
+			grid[x][0].nwall = WALL_OPEN;
+		}
+		for (unsigned y = 0; y < height; y++) {
+			grid[0][y].wwall = WALL_OPEN;
+		}
+	}
+	strcpy(filename, other.filename);
+	changed = true;
+	fileLoadOk = other.fileLoadOk;
+	geometry = other.geometry;
+}
+
 // Destructor
 GridMap::~GridMap()
 {
-	DeleteObject(ThinGrayPen);
-	DeleteObject(ThickBlackPen);
-	for (unsigned x = 0; x < width; x++) {
-		delete [] grid[x];
+	for (CellStrip *strip: strips) {
+		releaseStrip(strip);
 	}
 	delete [] grid;
 }
 
+//------------------------------------------------------------------
+// Cell storage
+//------------------------------------------------------------------
+
+// Allocate unshared strips for all columns (cells zeroed)
+void GridMap::makeStrips()
+{
+	grid = new GridCell*[width];
+	strips.resize((width + STRIP_COLUMNS - 1) / STRIP_COLUMNS);
+	for (unsigned s = 0; s < strips.size(); s++) {
+		unsigned columns = min(STRIP_COLUMNS, width - s * STRIP_COLUMNS);
+		strips[s] = new CellStrip;
+		strips[s]->refs = 1;
+		strips[s]->cells.resize((size_t) columns * height);
+		pointStripColumns(s);
+	}
+}
+
+// Point grid columns into one strip
+void GridMap::pointStripColumns(unsigned s)
+{
+	unsigned left = s * STRIP_COLUMNS;
+	unsigned right = min(left + STRIP_COLUMNS, width);
+	for (unsigned x = left; x < right; x++) {
+		grid[x] = strips[s]->cells.data() + (size_t) (x - left) * height;
+	}
+}
+
+// Drop one reference to a strip, deleting it if the last
+void GridMap::releaseStrip(CellStrip *strip)
+{
+	if (strip->refs.fetch_sub(1) == 1) {
+		delete strip;
+	}
+}
+
+/*
+	Get a column to change, first copying its strip if shared
+	(copy on write). A strip held only here can't become shared
+	meanwhile, as only this thread copies this map.
+*/
+GridCell* GridMap::writeColumn(unsigned x)
+{
+	unsigned s = x / STRIP_COLUMNS;
+	if (strips[s]->refs.load() > 1) {
+		CellStrip *copy = new CellStrip;
+		copy->refs = 1;
+		copy->cells = strips[s]->cells;
+		releaseStrip(strips[s]);
+		strips[s] = copy;
+		pointStripColumns(s);
+	}
+	return grid[x];
+}
+
 // Save to previously stored filename
 int GridMap::save()
 {
@@ -257,14 +695,14 @@ unsigned GridMap::getHeightCells() const
 	return height;
 }
 
-unsigned GridMap::getWidthPixels() const
+unsigned long long GridMap::getWidthPixels() const
 {
-	return width * getCellSizePixels();
+	return (unsigned long long) width * getCellSizePixels();
 }
 
-unsigned GridMap::getHeightPixels() const
+unsigned long long GridMap::getHeightPixels() const
 {
-	return height * getCellSizePixels();
+	return (unsigned long long) height * getCellSizePixels();
 }
 
 FloorType GridMap::getCellFloor(GridCoord gc) const
@@ -279,6 +717,13 @@ WallType GridMap::getCellNWall(GridCoord gc) const
 	return (WallType) grid[gc.x][gc.y].nwall;
 }
 
+// Raw cells of one column (height entries), for fast scans
+const GridCell* GridMap::getColumn(unsigned x) const
+{
+	assert(x < width);
+	return grid[x];
+}
+
 WallType GridMap::getCellWWall(GridCoord gc) const
 {
 	assert(gc.x < width && gc.y < height);
@@ -362,6 +807,63 @@ bool GridMap::canBuildWWall(GridCoord gc) const
 	return true;
 }
 
+// Whole cell as one word (zero for plain fill)
+static inline uint32_t CellWord(const GridCell& cell)
+{
+	static_assert(sizeof(GridCell) == sizeof(uint32_t), "cell not a word");
+	uint32_t word;
+	memcpy(&word, &cell, sizeof(word));
+	return word;
+}
+
+// Does a column hold anything but plain fill?
+static bool ColumnHasContent(const GridCell *column, unsigned height)
+{
+	uint32_t any = 0;
+	for (unsigned y = 0; y < height; y++) {
+		any |= CellWord(column[y]);
+	}
+	return any != 0;
+}
+
+/*
+	Get the block of cells holding anything but plain fill
+	(empty if none). Each column is scanned whole as words
+	in a branch-free loop the compiler can vectorize; rows are
+	then narrowed from the ends of just the columns found.
+*/
+GridRect GridMap::getContentBounds() const
+{
+	GridRect bounds = {width, height, 0, 0};
+	std::vector<bool> content(width);
+	for (unsigned x = 0; x < width; x++) {
+		if (ColumnHasContent(grid[x], height)) {
+			content[x] = true;
+			bounds.left = min(bounds.left, x);
+			bounds.right = x + 1;
+		}
+	}
+	if (bounds.right == 0) {
+		return {0, 0, 0, 0};
+	}
+	for (unsigned x = bounds.left; x < bounds.right; x++) {
+		if (content[x]) {
+			const GridCell *column = grid[x];
+			unsigned y = 0;
+			while (y < bounds.top && !CellWord(column[y])) {
+				y++;
+			}
+			bounds.top = y;
+			y = height;
+			while (y > bounds.bottom && !CellWord(column[y - 1])) {
+				y--;
+			}
+			bounds.bottom = y;
+		}
+	}
+	return bounds;
+}
+
 //------------------------------------------------------------------
 // Mutators
 //------------------------------------------------------------------
@@ -369,59 +871,604 @@ bool GridMap::canBuildWWall(GridCoord gc) const
 void GridMap::setCellFloor(GridCoord gc, int floor)
 {
 	assert(gc.x < width && gc.y < height);
-	grid[gc.x][gc.y].floor = floor;
+	writeColumn(gc.x)[gc.y].floor = floor;
 	changed = true;
 }
 
 void GridMap::setCellNWall(GridCoord gc, int wall)
 {
 	assert(gc.x < width && gc.y < height);
-	grid[gc.x][gc.y].nwall = wall;
+	writeColumn(gc.x)[gc.y].nwall = wall;
 	changed = true;
 }
 
 void GridMap::setCellWWall(GridCoord gc, int wall)
 {
 	assert(gc.x < width && gc.y < height);
-	grid[gc.x][gc.y].wwall = wall;
+	writeColumn(gc.x)[gc.y].wwall = wall;
 	changed = true;
 }
 
 void GridMap::setCellObject(GridCoord gc, int object)
 {
 	assert(gc.x < width && gc.y < height);
-	grid[gc.x][gc.y].object = object;
+	writeColumn(gc.x)[gc.y].object = object;
 	changed = true;
 }
 
 void GridMap::setFilename(char *name)
 {
-	strncpy(filename, name, GRID_FILENAME_MAX);
+	strncpy(filename, name, GRID_FILENAME_MAX - 1);
+	filename[GRID_FILENAME_MAX - 1] = '\0';
 }
 
 // Clear the entire map
 void GridMap::clearMap(int _floor)
 {
 	for (unsigned x = 0; x < width; x++) {
+		GridCell *column = writeColumn(x);
 		for (unsigned y = 0; y < height; y++) {
-			grid[x][y].floor = _floor;
-			grid[x][y].wwall = WALL_OPEN;
-			grid[x][y].nwall = WALL_OPEN;
-			grid[x][y].object = OBJECT_NONE;
+			column[y].floor = _floor;
+			column[y].wwall = WALL_OPEN;
+			column[y].nwall = WALL_OPEN;
+			column[y].object = OBJECT_NONE;
 		}
 	}
 	changed = true;
 }
 
+// Set a whole column of cells at once
+void GridMap::setColumn(unsigned x, const GridCell *cells)
+{
+	assert(x < width);
+	memcpy(writeColumn(x), cells, height * sizeof(GridCell));
+	changed = true;
+}
+
+/*
+	Flood fill floor from one cell: every cell reached through open
+	walls, with the same floor as the start, gets the new floor.
+	Then objects & walls no longer allowed are cleared (as FillCell()
+	does for one cell), so the whole fill is one batch of edits.
+	Uses vertical spans (as cells are stored) & a stack of seeds.
+	Returns false if nothing changed; else the block edited.
+*/
+bool GridMap::floodFillFloor(GridCoord gc, int floor, GridRect& edited)
+{
+	assert(gc.x < width && gc.y < height);
+	unsigned char oldFloor = grid[gc.x][gc.y].floor;
+	if (oldFloor == floor) {
+		return false;
+	}
+
+	// Fill spans, seeding neighbor columns from each
+	std::vector<Span> spans;
+	std::vector<GridCoord> seeds(1, gc);
+	while (!seeds.empty()) {
+		GridCoord seed = seeds.back();
+		seeds.pop_back();
+		const GridCell *column = grid[seed.x];
+		if (column[seed.y].floor != oldFloor) {
+			continue;
+		}
+		unsigned top = seed.y, bottom = seed.y + 1;
+		while (top > 0 && column[top-1].floor == oldFloor
+		        && column[top].nwall == WALL_OPEN) {
+			top--;
+		}
+		while (bottom < height && column[bottom].floor == oldFloor
+		        && column[bottom].nwall == WALL_OPEN) {
+			bottom++;
+		}
+		GridCell *fill = writeColumn(seed.x);
+		for (unsigned y = top; y < bottom; y++) {
+			fill[y].floor = floor;
+		}
+		spans.push_back({seed.x, top, bottom});
+		if (seed.x > 0) {
+			seedFloodSpans(seed.x - 1, top, bottom, seed.x, oldFloor, seeds);
+		}
+		if (seed.x + 1 < width) {
+			seedFloodSpans(
+			    seed.x + 1, top, bottom, seed.x + 1, oldFloor, seeds);
+		}
+	}
+
+	// Clear features as for one filled cell
+	bool fillType = IsFloorFillType((FloorType) floor);
+	if (fillType) {
+		for (const Span& span: spans) {
+			clearDisallowedSpan(span);
+		}
+	}
+	edited = getSpansBlock(spans, fillType);
+	changed = true;
+	return true;
+}
+
+/*
+	Set the floor of every cell in a region.
+	Objects & walls no longer allowed are cleared after
+	(as FillCell() does for one cell).
+*/
+GridRect GridMap::fillFloor(const GridRegion& region, int floor)
+{
+	std::vector<Span> spans;
+	getRegionSpans(region, spans);
+	for (const Span& span: spans) {
+		GridCell *column = writeColumn(span.x);
+		for (unsigned y = span.top; y < span.bottom; y++) {
+			column[y].floor = floor;
+		}
+	}
+	bool fillType = IsFloorFillType((FloorType) floor);
+	if (fillType) {
+		for (const Span& span: spans) {
+			clearDisallowedSpan(span);
+		}
+	}
+	changed = changed || !spans.empty();
+	return getSpansBlock(spans, fillType);
+}
+
+// Clear every object in a region
+GridRect GridMap::clearObjects(const GridRegion& region)
+{
+	std::vector<Span> spans;
+	getRegionSpans(region, spans);
+	for (const Span& span: spans) {
+		GridCell *column = writeColumn(span.x);
+		for (unsigned y = span.top; y < span.bottom; y++) {
+			column[y].object = OBJECT_NONE;
+		}
+	}
+	changed = changed || !spans.empty();
+	return getSpansBlock(spans, false);
+}
+
+/*
+	Set walls all around the outside of a region (on each edge
+	between a cell in it & one out of it), where they can be built.
+*/
+GridRect GridMap::setPerimeterWalls(const GridRegion& region, int wall)
+{
+	std::vector<Span> spans;
+	getRegionSpans(region, spans);
+	bool open = (wall == WALL_OPEN);
+	for (const Span& span: spans) {
+		unsigned x = span.x;
+
+		// North & south ends of span
+		if (open || canBuildNWall({x, span.top}))
+			writeColumn(x)[span.top].nwall = wall;
+		if (span.bottom < height
+		        && (open || canBuildNWall({x, span.bottom})))
+			writeColumn(x)[span.bottom].nwall = wall;
+
+		// West & east sides, where neighbors are out of region
+		for (unsigned y = span.top; y < span.bottom; y++) {
+			if (!IsInRegion(region, {x - 1, y})
+			        && (open || canBuildWWall({x, y})))
+				writeColumn(x)[y].wwall = wall;
+			if (x + 1 < width && !IsInRegion(region, {x + 1, y})
+			        && (open || canBuildWWall({x + 1, y})))
+				writeColumn(x + 1)[y].wwall = wall;
+		}
+	}
+	changed = changed || !spans.empty();
+	return getSpansBlock(spans, true);
+}
+
+/*
+	Box-draw a room: floor a block, clear walls inside it,
+	and wall it all around (where walls can be built).
+*/
+GridRect GridMap::drawRoom(GridRect room, int floor, int wall)
+{
+	GridRegion region = {room, std::vector<unsigned char>()};
+	fillFloor(region, floor);
+	std::vector<Span> spans;
+	getRegionSpans(region, spans);
+	for (const Span& span: spans) {
+		GridCell *column = writeColumn(span.x);
+		for (unsigned y = span.top; y < span.bottom; y++) {
+			if (y > span.top)
+				column[y].nwall = WALL_OPEN;
+			if (span.x > room.left)
+				column[y].wwall = WALL_OPEN;
+		}
+	}
+	setPerimeterWalls(region, wall);
+	return getSpansBlock(spans, true);
+}
+
+// Is a floor open on a side? (Diagonal fills open on two.)
+static bool IsFloorSideOpen(FloorType floor, Direction side)
+{
+	switch (floor) {
+		case FLOOR_FILL: return false;
+		case FLOOR_NWFILL: return side == SOUTH || side == EAST;
+		case FLOOR_NEFILL: return side == SOUTH || side == WEST;
+		case FLOOR_SWFILL: return side == NORTH || side == EAST;
+		case FLOOR_SEFILL: return side == NORTH || side == WEST;
+		default: return IsFloorOpenType(floor);
+	}
+}
+
+// Get the terrain of a floor for auto-walling:
+// 1 for dry floor (with stairs), 2 for water, 0 if neither
+static int GetFloorTerrain(FloorType floor)
+{
+	switch (floor) {
+		case FLOOR_OPEN:
+		case FLOOR_NSTAIRS:
+		case FLOOR_WSTAIRS:
+		case FLOOR_SPIRALSTAIRS:
+			return 1;
+		case FLOOR_WATER:
+			return 2;
+		default:
+			return 0;
+	}
+}
+
+// Do two floors differ in terrain (both dry floor or water)?
+static bool IsTerrainChange(unsigned char a, unsigned char b)
+{
+	int terrainA = GetFloorTerrain((FloorType) a);
+	int terrainB = GetFloorTerrain((FloorType) b);
+	return terrainA && terrainB && terrainA != terrainB;
+}
+
+/*
+	Wall a region from its floors in one sweep down its spans.
+	If smoothing, fill cells at the steps of a staircase edge first
+	become diagonal fills (all found from the floors as they were).
+	Then open edges between dry floor & water get walls (edges all
+	around the outside too, as for setPerimeterWalls()), and walls
+	& objects the floors no longer allow are cleared.
+*/
+GridRect GridMap::autoWall(const GridRegion& region, int wall, bool smooth)
+{
+	std::vector<Span> spans;
+	getRegionSpans(region, spans);
+
+	// Smooth staircase steps
+	if (smooth) {
+		std::vector<std::pair<GridCoord, FloorType>> steps;
+		for (const Span& span: spans) {
+			for (unsigned y = span.top; y < span.bottom; y++) {
+				FloorType corner = getStepCorner({span.x, y});
+				if (corner != FLOOR_FILL)
+					steps.push_back({{span.x, y}, corner});
+			}
+		}
+		for (const auto& step: steps) {
+			GridCell& cell = writeColumn(step.first.x)[step.first.y];
+			cell.floor = step.second;
+			cell.object = OBJECT_NONE;
+		}
+	}
+
+	// Wall edges between terrains
+	for (const Span& span: spans) {
+		unsigned x = span.x;
+		for (unsigned y = span.top; y < span.bottom; y++) {
+			if (isTerrainEdge({x, y}, NORTH))
+				writeColumn(x)[y].nwall = wall;
+			if (isTerrainEdge({x, y}, WEST))
+				writeColumn(x)[y].wwall = wall;
+			if (x + 1 < width && !IsInRegion(region, {x + 1, y})
+			        && isTerrainEdge({x + 1, y}, WEST))
+				writeColumn(x + 1)[y].wwall = wall;
+		}
+		if (span.bottom < height && isTerrainEdge({x, span.bottom}, NORTH))
+			writeColumn(x)[span.bottom].nwall = wall;
+	}
+
+	// Clear what the floors now disallow
+	for (const Span& span: spans) {
+		clearDisallowedSpan(span);
+	}
+	changed = changed || !spans.empty();
+	return getSpansBlock(spans, true);
+}
+
+/*
+	Copy a block of cells (clipped to the map), a column at a time,
+	with the walls along its east & south edges.
+*/
+void GridMap::copyCells(GridRect rect, CellBlock& block) const
+{
+	rect.right = min(rect.right, width);
+	rect.bottom = min(rect.bottom, height);
+	block.width = rect.right > rect.left ? rect.right - rect.left : 0;
+	block.height = rect.bottom > rect.top ? rect.bottom - rect.top : 0;
+	block.cells.resize((size_t) block.width * block.height);
+	for (unsigned i = 0; i < block.width; i++) {
+		memcpy(block.cells.data() + (size_t) i * block.height,
+		       grid[rect.left + i] + rect.top,
+		       block.height * sizeof(GridCell));
+	}
+	block.eastWalls.assign(block.height, WALL_OPEN);
+	for (unsigned j = 0; rect.right < width && j < block.height; j++) {
+		block.eastWalls[j] = grid[rect.right][rect.top + j].wwall;
+	}
+	block.southWalls.assign(block.width, WALL_OPEN);
+	for (unsigned i = 0; rect.bottom < height && i < block.width; i++) {
+		block.southWalls[i] = grid[rect.left + i][rect.bottom].nwall;
+	}
+}
+
+/*
+	Paste a block of cells with its top-left at a cell
+	(clipped to the map), a column at a time. Its edge walls go
+	on the cells east & south of it, then any walls the new floors
+	don't allow (here or on neighbors) are cleared.
+	Returns the block of cells changed.
+*/
+GridRect GridMap::pasteCells(const CellBlock& block, GridCoord at)
+{
+	if (at.x >= width || at.y >= height || block.cells.empty()) {
+		return {0, 0, 0, 0};
+	}
+	unsigned right = min(at.x + block.width, width);
+	unsigned bottom = min(at.y + block.height, height);
+	std::vector<Span> spans;
+	for (unsigned x = at.x; x < right; x++) {
+		memcpy(writeColumn(x) + at.y,
+		       &block.cells[(size_t) (x - at.x) * block.height],
+		       (bottom - at.y) * sizeof(GridCell));
+		spans.push_back({x, at.y, bottom});
+	}
+	if (right == at.x + block.width && right < width) {
+		GridCell *column = writeColumn(right);
+		for (unsigned y = at.y; y < bottom; y++) {
+			column[y].wwall = block.eastWalls[y - at.y];
+		}
+	}
+	if (bottom == at.y + block.height && bottom < height) {
+		for (unsigned x = at.x; x < right; x++) {
+			writeColumn(x)[bottom].nwall = block.southWalls[x - at.x];
+		}
+	}
+	for (const Span& span: spans) {
+		clearDisallowedSpan(span);
+	}
+	changed = changed || !spans.empty();
+	return getSpansBlock(spans, true);
+}
+
+/*
+	Get a region as vertical spans of cells (clipped to the map),
+	so each edit runs down columns as they are stored.
+*/
+void GridMap::getRegionSpans(
+    const GridRegion& region, std::vector<Span>& spans) const
+{
+	const GridRect& r = region.bounds;
+	unsigned right = min(r.right, width);
+	unsigned bottom = min(r.bottom, height);
+	for (unsigned x = r.left; x < right; x++) {
+		if (region.mask.empty()) {
+			if (r.top < bottom)
+				spans.push_back({x, r.top, bottom});
+			continue;
+		}
+		const unsigned char *in =
+		    &region.mask[(size_t) (x - r.left) * (r.bottom - r.top)];
+		for (unsigned y = r.top; y < bottom; y++) {
+			if (!in[y - r.top]) {
+				continue;
+			}
+			if (y == r.top || !in[y - r.top - 1]) {
+				spans.push_back({x, y, y + 1});
+			}
+			else {
+				spans.back().bottom = y + 1;
+			}
+		}
+	}
+}
+
+/*
+	Clear objects & walls no longer allowed on & around cells
+	in a span after their floors change (as FillCell() does for one).
+*/
+void GridMap::clearDisallowedSpan(const Span& span)
+{
+	unsigned x = span.x;
+	for (unsigned y = span.top; y < span.bottom; y++) {
+		if (grid[x][y].floor == FLOOR_FILL && grid[x][y].object)
+			writeColumn(x)[y].object = OBJECT_NONE;
+		if (grid[x][y].wwall && !canBuildWWall({x, y}))
+			writeColumn(x)[y].wwall = WALL_OPEN;
+		if (grid[x][y].nwall && !canBuildNWall({x, y}))
+			writeColumn(x)[y].nwall = WALL_OPEN;
+		if (x + 1 < width && grid[x+1][y].wwall
+		        && !canBuildWWall({x + 1, y}))
+			writeColumn(x + 1)[y].wwall = WALL_OPEN;
+		if (y + 1 < height && grid[x][y+1].nwall
+		        && !canBuildNWall({x, y + 1}))
+			writeColumn(x)[y + 1].nwall = WALL_OPEN;
+	}
+}
+
+/*
+	Get the block covering spans (empty if none),
+	with the cells east & south if their walls may have changed.
+*/
+GridRect GridMap::getSpansBlock(
+    const std::vector<Span>& spans, bool withWalls) const
+{
+	if (spans.empty()) {
+		return {0, 0, 0, 0};
+	}
+	GridRect block = {width, height, 0, 0};
+	for (const Span& span: spans) {
+		block.left = min(block.left, span.x);
+		block.top = min(block.top, span.top);
+		block.right = max(block.right, span.x + 1);
+		block.bottom = max(block.bottom, span.bottom);
+	}
+	if (withWalls) {
+		block.right = min(block.right + 1, width);
+		block.bottom = min(block.bottom + 1, height);
+	}
+	return block;
+}
+
+/*
+	Get the diagonal fill to smooth a fill cell at a step of a
+	staircase edge: open on just one side north or south & one
+	east or west, with a step next to it along the diagonal alike
+	(or smoothed already). FLOOR_FILL if none.
+*/
+FloorType GridMap::getStepCorner(GridCoord gc) const
+{
+	FloorType corner = getFillCorner(gc);
+	if (corner == FLOOR_FILL) {
+		return FLOOR_FILL;
+	}
+	int dx = (corner == FLOOR_NWFILL || corner == FLOOR_SWFILL) ? 1 : -1;
+	int dy = (corner == FLOOR_NWFILL || corner == FLOOR_NEFILL) ? 1 : -1;
+	for (int step = -1; step <= 1; step += 2) {
+		GridCoord next = {gc.x + step * dx, gc.y - step * dy};
+		if (next.x < width && next.y < height
+		        && (grid[next.x][next.y].floor == corner
+		            || getFillCorner(next) == corner))
+			return corner;
+	}
+	return FLOOR_FILL;
+}
+
+/*
+	Get the diagonal fill a fill cell could become, from the sides
+	its neighbors open onto it (just one north or south, & one
+	east or west). FLOOR_FILL if none.
+*/
+FloorType GridMap::getFillCorner(GridCoord gc) const
+{
+	unsigned x = gc.x, y = gc.y;
+	if (grid[x][y].floor != FLOOR_FILL) {
+		return FLOOR_FILL;
+	}
+	bool north = y > 0
+	             && IsFloorSideOpen((FloorType) grid[x][y-1].floor, SOUTH);
+	bool south = y + 1 < height
+	             && IsFloorSideOpen((FloorType) grid[x][y+1].floor, NORTH);
+	bool west = x > 0
+	            && IsFloorSideOpen((FloorType) grid[x-1][y].floor, EAST);
+	bool east = x + 1 < width
+	            && IsFloorSideOpen((FloorType) grid[x+1][y].floor, WEST);
+	if (north == south || west == east) {
+		return FLOOR_FILL;
+	}
+	return south ? (east ? FLOOR_NWFILL : FLOOR_NEFILL)
+	       : (east ? FLOOR_SWFILL : FLOOR_SEFILL);
+}
+
+/*
+	Should auto-walling wall the north or west edge of a cell?
+	Yes if open now & buildable, between dry floor & water.
+*/
+bool GridMap::isTerrainEdge(GridCoord gc, Direction side) const
+{
+	unsigned x = gc.x, y = gc.y;
+	if (side == NORTH) {
+		return y > 0 && y < height && grid[x][y].nwall == WALL_OPEN
+		       && IsTerrainChange(grid[x][y-1].floor, grid[x][y].floor)
+		       && canBuildNWall(gc);
+	}
+	return x > 0 && x < width && grid[x][y].wwall == WALL_OPEN
+	       && IsTerrainChange(grid[x-1][y].floor, grid[x][y].floor)
+	       && canBuildWWall(gc);
+}
+
+/*
+	Seed flood fill spans in a column next to a filled span:
+	one seed per run of cells with the old floor, open to the
+	filled span (west wall of column wallX) & to each other.
+*/
+void GridMap::seedFloodSpans(
+    unsigned x, unsigned top, unsigned bottom, unsigned wallX,
+    unsigned char floor, std::vector<GridCoord>& seeds) const
+{
+	const GridCell *column = grid[x];
+	const GridCell *walls = grid[wallX];
+	bool inRun = false;
+	for (unsigned y = top; y < bottom; y++) {
+		bool open = column[y].floor == floor && walls[y].wwall == WALL_OPEN;
+		if (open && (!inRun || column[y].nwall != WALL_OPEN)) {
+			seeds.push_back({x, y});
+		}
+		inRun = open;
+	}
+}
+
 //------------------------------------------------------------------
 // Drawing code
 //------------------------------------------------------------------
 
-// Make standard pens
-void GridMap::makeStandardPens()
+/*
+	Scale the unit-circle tables to the current cell size.
+	Called on any cell size change, so painting a feature
+	only needs to translate these offsets to the cell.
+*/
+void GridMap::makeFeatureGeometry()
 {
-	ThinGrayPen = CreatePen(PS_SOLID, 1, 0x00808080);
-	ThickBlackPen = CreatePen(PS_SOLID, 3, 0x00000000);
+	const UnitCircleTables& unit = GetUnitCircleTables();
+	int cellSize = getCellSizePixels();
+	int halfCell = cellSize / 2;
+	geometry.cellSize = cellSize;
+
+	// Spiral stairs (y-axis flipped for screen)
+	int radius = halfCell;
+	geometry.spiralRadius = radius;
+	geometry.spiralInnerRadius = (int)(radius * 0.20);
+	geometry.spiralArcStart = {
+		(int)(radius * unit.spiralArcStart.cosine),
+		-(int)(radius * unit.spiralArcStart.sine)
+	};
+	geometry.spiralArcEnd = {
+		(int)(radius * unit.spiralArcEnd.cosine),
+		-(int)(radius * unit.spiralArcEnd.sine)
+	};
+	for (int i = 0; i <= SPIRAL_SPOKES; ++i) {
+		geometry.spiralSpokes[i] = {
+			(int)(radius * unit.spiralSpokes[i].cosine),
+			-(int)(radius * unit.spiralSpokes[i].sine)
+		};
+	}
+
+	// Statue star (outer radius & golden-ratio inner radius)
+	int outerR = (int)(halfCell * 0.70);
+	int innerR = (int)(outerR * 0.382);
+	geometry.statueRadius = outerR;
+	for (int i = 0; i < STATUE_STAR_POINTS; ++i) {
+		int r = (i % 2 == 0) ? outerR : innerR;
+		geometry.statueStar[i] = {
+			(int)(r * unit.statueStar[i].cosine),
+			(int)(r * unit.statueStar[i].sine)
+		};
+	}
+
+	// Stalagmites, for each possible random size
+	for (int k = 0; k < STALAGMITE_SIZES; ++k) {
+		double circleFraction = 0.30 + 0.01 * k;
+		int circleDiameter = (int)(cellSize * circleFraction);
+		int r = circleDiameter / 2;
+		geometry.stalagmiteDiameter[k] = circleDiameter;
+		for (int i = 0; i < STALAGMITE_SPOKES; ++i) {
+			const UnitVertex& v = unit.stalagmiteSpokes[i];
+			geometry.stalagmiteOuter[k][i] = {
+				(int)(r * v.cosine), (int)(r * v.sine)
+			};
+			geometry.stalagmiteInner[k][i] = {
+				(int)((r / 2.0) * v.cosine), (int)((r / 2.0) * v.sine)
+			};
+		}
+	}
 }
 
 // Hash a coordinate (for use as random seed)
@@ -437,21 +1484,128 @@ unsigned GridMap::cellHash(GridCoord gc) const
 	return h;
 }
 
-// Paint entire map on device context
-void GridMap::paint(HDC hDC)
+// Paint entire map on a canvas
+void GridMap::paint(GridCanvas& _canvas)
 {
-	hMainDC = hDC;
-	for (unsigned x = 0; x < width; x++) {
-		for (unsigned y = 0; y < height; y++) {
+	canvas = &_canvas;
+	paintCells(0, 0, width, height);
+}
+
+/*
+	Paint the cells in a rectangle [left, right) x [top, bottom)
+	on a canvas that only needs to show that area (e.g., one band
+	of a large export). Cells within the paint margin are painted
+	too, in the same order as paint(), so every pixel inside the
+	region comes out exactly as in a full paint.
+	Does not replace the canvas used by later paintCell() calls.
+*/
+void GridMap::paintRegion(
+    GridCanvas& _canvas, unsigned left, unsigned top,
+    unsigned right, unsigned bottom)
+{
+	unsigned margin = getPaintMarginCells();
+	left = left > margin ? left - margin : 0;
+	top = top > margin ? top - margin : 0;
+	right = right + margin < width ? right + margin : width;
+	bottom = bottom + margin < height ? bottom + margin : height;
+	GridCanvas *oldCanvas = canvas;
+	canvas = &_canvas;
+	paintCells(left, top, right, bottom);
+	canvas = oldCanvas;
+}
+
+// Paint a block of cells, columns outermost
+void GridMap::paintCells(
+    unsigned left, unsigned top, unsigned right, unsigned bottom)
+{
+	for (unsigned x = left; x < right; x++) {
+		for (unsigned y = top; y < bottom; y++) {
 			paintCell({x, y}, false);
 		}
 	}
 }
 
 /*
-	Paint one cell on device context
+	How far (in cells) painting one cell can reach.
+	Walls overhang one cell; rough edges recurse two cells
+	out (see paintCell) and bleed up to half a cell beyond.
+*/
+unsigned GridMap::getPaintMarginCells() const
+{
+	return displayRoughEdges() ? 3 : 1;
+}
+
+/*
+	Get the randomized shapes for one cell, for vector export.
+	Draws on the same random sequence as paintCell(),
+	so fractal edges & scattered objects match the painted map.
+	Cells with no rough edge report solidFill and no polygons.
+*/
+void GridMap::getCellShapes(GridCoord gc, CellShapes& shapes)
+{
+	int cellSize = getCellSizePixels();
+	CanvasPoint p = {(int)(gc.x * cellSize), (int)(gc.y * cellSize)};
+	FloorType floor = getCellFloor(gc);
+	ObjectType object = getCellObject(gc);
+	shapes.points.clear();
+	shapes.polygonSizes.clear();
+	shapes.solidFill = (floor == FLOOR_FILL);
+	shapes.stalagmiteSize = -1;
 
-	Assumes we've previously called paint() to store hMainDC.
+	// Seed randomizations for this cell
+	seedRandom(cellHash(gc));
+
+	/*
+		Filled space: one outline around the cell, tracing the same
+		fractal edges the painter fills as four quadrants.
+		(Only exposed edges consume random numbers.)
+	*/
+	if (floor == FLOOR_FILL && displayRoughEdges()
+	    && (isExposedEdge(gc, NORTH) || isExposedEdge(gc, EAST)
+	        || isExposedEdge(gc, SOUTH) || isExposedEdge(gc, WEST)))
+	{
+		const Direction order[4] = {NORTH, EAST, SOUTH, WEST};
+		shapes.solidFill = false;
+		for (int i = 0; i < 4; i++) {
+			CanvasPoint a, b;
+			getVertexPoints(p, a, b, order[i]);
+			if (isExposedEdge(gc, order[i])) {
+				generateFractalCurveRecursive(
+				    a, b, shapes.points,
+				    cellSize * DISPLACEMENT_SCALE, RECURSION_LIMIT);
+			}
+			else {
+				shapes.points.push_back(b);
+			}
+		}
+		shapes.polygonSizes.push_back((int)(shapes.points.size()));
+	}
+
+	// Diagonal half-filled space
+	if (IsFloorDiagonalFill(floor)) {
+		makeDiagonalFill(p, floor, shapes.points);
+		shapes.polygonSizes.push_back((int)(shapes.points.size()));
+	}
+
+	// Scattered objects
+	if (object == OBJECT_RUBBLE) {
+		makeRubbleMarks(shapes.rubble);
+	}
+	if (object == OBJECT_STALAGMITE) {
+		shapes.stalagmiteSize = makeStalagmite(shapes.stalagmiteCenter);
+	}
+}
+
+// Get stamped feature geometry for the current cell size
+const FeatureGeometry& GridMap::getFeatureGeometry() const
+{
+	return geometry;
+}
+
+/*
+	Paint one cell on canvas
+
+	Assumes we've previously called paint() to store the canvas.
 
 	NOTE ON RECURSION:
 	Recursion here handles rough edges bleeding into neighbor spaces.
@@ -465,7 +1619,8 @@ void GridMap::paint(HDC hDC)
 void GridMap::paintCell(
     GridCoord gc, bool partialRepaint, int recursionDepth)
 {
-	assert(hMainDC != NULL);
+	assert(canvas != NULL);
+	assert(geometry.cellSize == getCellSizePixels());
 	
 	// Handle recursion limit for open redraws
 	if (recursionDepth > 1 && IsFloorSemiOpen(getCellFloor(gc))) {
@@ -473,11 +1628,11 @@ void GridMap::paintCell(
 	}
 
 	// Seed randomizations for this cell
-	srand(cellHash(gc));
+	seedRandom(cellHash(gc));
 
 	// Paint everything controlled by this cell
 	int cellSize = getCellSizePixels();
-	POINT p = {(LONG)(gc.x * cellSize), (LONG)(gc.y * cellSize)};
+	CanvasPoint p = {(int)(gc.x * cellSize), (int)(gc.y * cellSize)};
 	paintCellFloor(p, getCellFloor(gc));
 	paintCellObject(p, getCellObject(gc));
 	paintCellNWall(p, getCellNWall(gc));
@@ -515,26 +1670,26 @@ void GridMap::paintCell(
 }
 
 // Paint one cell's floor
-void GridMap::paintCellFloor(POINT p, FloorType floor)
+void GridMap::paintCellFloor(CanvasPoint p, FloorType floor)
 {
 	int cellSize = getCellSizePixels();
 
 	// If we're a filled cell with no rough edges,
 	// then simply paint a black rectangle and return
 	if (floor == FLOOR_FILL && !displayRoughEdges()) {
-		SelectObject(hMainDC, GetStockObject(BLACK_PEN));
-		SelectObject(hMainDC, GetStockObject(BLACK_BRUSH));
-		Rectangle(hMainDC, p.x, p.y, p.x + cellSize, p.y + cellSize);
+		canvas->selectPen(PEN_BLACK);
+		canvas->selectBrush(BRUSH_BLACK);
+		canvas->rectangle(p.x, p.y, p.x + cellSize, p.y + cellSize);
 		return;
 	}
 
 	// Paint a white rectangle as background
-	SelectObject(hMainDC, GetStockObject(WHITE_PEN));
-	SelectObject(hMainDC, GetStockObject(WHITE_BRUSH));
-	Rectangle(hMainDC, p.x, p.y, p.x + cellSize, p.y + cellSize);
+	canvas->selectPen(PEN_WHITE);
+	canvas->selectBrush(BRUSH_WHITE);
+	canvas->rectangle(p.x, p.y, p.x + cellSize, p.y + cellSize);
 
 	// Set pen for other features
-	SelectObject(hMainDC, GetStockObject(BLACK_PEN));
+	canvas->selectPen(PEN_BLACK);
 
 	// Draw a filled space with rough edges
 	if (floor == FLOOR_FILL) {
@@ -548,34 +1703,34 @@ void GridMap::paintCellFloor(POINT p, FloorType floor)
 		for (int s = 0; s <= stairsPerSquare; s++) {
 			int d = s * cellSize / stairsPerSquare;
 			if (floor == FLOOR_NSTAIRS) {
-				MoveToEx(hMainDC, p.x, p.y + d, NULL);
-				LineTo(hMainDC, p.x + cellSize, p.y + d);
+				canvas->moveTo(p.x, p.y + d);
+				canvas->lineTo(p.x + cellSize, p.y + d);
 			}
 			else {
-				MoveToEx(hMainDC, p.x + d, p.y, NULL);
-				LineTo(hMainDC, p.x + d, p.y + cellSize);
+				canvas->moveTo(p.x + d, p.y);
+				canvas->lineTo(p.x + d, p.y + cellSize);
 			}
 		}
 	}
 
 	// Diagonal Wall NW/SE
 	if (floor == FLOOR_NWWALL || floor == FLOOR_NWDOOR) {
-		SelectObject(hMainDC, ThickBlackPen);
-		MoveToEx(hMainDC, p.x, p.y, NULL);
-		LineTo(hMainDC, p.x + cellSize, p.y + cellSize);
+		canvas->selectPen(PEN_WALL);
+		canvas->moveTo(p.x, p.y);
+		canvas->lineTo(p.x + cellSize, p.y + cellSize);
 	}
 
 	// Diagonal Wall NE/SW
 	if (floor == FLOOR_NEWALL || floor == FLOOR_NEDOOR) {
-		SelectObject(hMainDC, ThickBlackPen);
-		MoveToEx(hMainDC, p.x + cellSize, p.y, NULL);
-		LineTo(hMainDC, p.x, p.y + cellSize);
+		canvas->selectPen(PEN_WALL);
+		canvas->moveTo(p.x + cellSize, p.y);
+		canvas->lineTo(p.x, p.y + cellSize);
 	}
 
 	// Diagonal Door (diamond in square center)
 	if (floor == FLOOR_NEDOOR || floor == FLOOR_NWDOOR) {
-		SelectObject(hMainDC, GetStockObject(BLACK_PEN));
-		SelectObject(hMainDC, GetStockObject(WHITE_BRUSH));
+		canvas->selectPen(PEN_BLACK);
+		canvas->selectBrush(BRUSH_WHITE);
 
 		// Find cell center & door corners
 		int halfCell = cellSize / 2;
@@ -584,72 +1739,51 @@ void GridMap::paintCellFloor(POINT p, FloorType floor)
 		int offset = (int)(halfCell * SQRT2_2);
 
 		// Set four corners of door & draw polygon
-		POINT pts[4] = {
+		CanvasPoint pts[4] = {
 			{cx - offset, cy},
 			{cx, cy + offset},
 			{cx + offset, cy},
 			{cx, cy - offset}
 		};
-		Polygon(hMainDC, pts, 4);
+		canvas->polygon(pts, 4);
 	}
 
 	// Diagonal half-filled space
 	if (IsFloorDiagonalFill(floor)) {
-		if (displayRoughEdges()) {
-			drawDiagonalFillRough(p, floor);
-		}
-		else {
-			drawDiagonalFillSmooth(p, floor);
-		}
+		std::vector<CanvasPoint> shape;
+		makeDiagonalFill(p, floor, shape);
+		canvas->selectBrush(BRUSH_BLACK);
+		canvas->polygon(shape.data(), (int)(shape.size()));
 	}
 
 	// Spiral stairs (arc, circle, and spokes)
 	if (floor == FLOOR_SPIRALSTAIRS) {
 
-		// Find parameters
+		// Find center & radius
 		int halfCell = cellSize / 2;
-		int radius = halfCell;
 		int cx = p.x + halfCell;
 		int cy = p.y + halfCell;
-
-		// Arc parameters (open at top)
-		double arcStartAngle = TAU/4 + 0.5;
-		double arcEndAngle   = TAU/4 - 0.5;
-
-		// Calculate bounding rect of the circle
-		int left   = cx - radius;
-		int top    = cy - radius;
-		int right  = cx + radius;
-		int bottom = cy + radius;
-
-		// Calculate arc start/end points
-		int xStart = cx + (int)(radius * cos(arcStartAngle));
-		int yStart = cy - (int)(radius * sin(arcStartAngle));
-		int xEnd   = cx + (int)(radius * cos(arcEndAngle));
-		int yEnd   = cy - (int)(radius * sin(arcEndAngle));
+		int radius = geometry.spiralRadius;
 
 		// Draw main circle with arc missing
-		Arc(hMainDC, left, top, right, bottom, xStart, yStart, xEnd, yEnd);
-
-		// Draw center circle (percent of outer radius)
-		int innerRadius = (int)(radius * 0.20);
-		SelectObject(hMainDC, GetStockObject(BLACK_BRUSH));
-		Ellipse(hMainDC,
-		        cx - innerRadius, cy - innerRadius,
-		        cx + innerRadius, cy + innerRadius);
-
-		// Compute spoke dimensions
-		const int numSpokes = 12;
-		double arcSweepAngle = TAU - (arcStartAngle - arcEndAngle);
-		double anglePerSpoke = arcSweepAngle / numSpokes;
+		canvas->arc(
+		    cx - radius, cy - radius, cx + radius, cy + radius,
+		    cx + geometry.spiralArcStart.x, cy + geometry.spiralArcStart.y,
+		    cx + geometry.spiralArcEnd.x, cy + geometry.spiralArcEnd.y);
+
+		// Draw center circle
+		int innerRadius = geometry.spiralInnerRadius;
+		canvas->selectBrush(BRUSH_BLACK);
+		canvas->ellipse(
+		    cx - innerRadius, cy - innerRadius,
+		    cx + innerRadius, cy + innerRadius);
 
 		// Draw the spokes
-		for (int i = 0; i <= numSpokes; ++i) {
-			double angle = arcStartAngle + anglePerSpoke * i;
-			int xOuter = cx + (int)(radius * cos(angle));
-			int yOuter = cy - (int)(radius * sin(angle));
-			MoveToEx(hMainDC, cx, cy, nullptr);
-			LineTo(hMainDC, xOuter, yOuter);
+		for (int i = 0; i <= SPIRAL_SPOKES; ++i) {
+			canvas->moveTo(cx, cy);
+			canvas->lineTo(
+			    cx + geometry.spiralSpokes[i].x,
+			    cy + geometry.spiralSpokes[i].y);
 		}
 	}
 
@@ -666,8 +1800,8 @@ void GridMap::paintCellFloor(POINT p, FloorType floor)
 			int startY = p.y + max(0, -offset);
 			int endX = p.x + min(cellSize, cellSize + offset);
 			int endY = p.y + min(cellSize, cellSize - offset);
-			MoveToEx(hMainDC, startX, startY, NULL);
-			LineTo(hMainDC, endX, endY);
+			canvas->moveTo(startX, startY);
+			canvas->lineTo(endX, endY);
 		}
 
 		// Draw lines from top-right to bottom-left
@@ -676,43 +1810,43 @@ void GridMap::paintCellFloor(POINT p, FloorType floor)
 			int startY = p.y + max(0, offset - cellSize);
 			int endX = p.x + max(0, offset - cellSize);
 			int endY = p.y + min(cellSize, offset);
-			MoveToEx(hMainDC, startX, startY, NULL);
-			LineTo(hMainDC, endX, endY);
+			canvas->moveTo(startX, startY);
+			canvas->lineTo(endX, endY);
 		}
 	}
 }
 
 // Paint one cell's north wall
-void GridMap::paintCellNWall(POINT p, WallType wall)
+void GridMap::paintCellNWall(CanvasPoint p, WallType wall)
 {
 	int cellSize = getCellSizePixels();
 
 	// Paint grid line as needed
 	if (wall != WALL_OPEN) {
-		SelectObject(hMainDC, ThickBlackPen);
-		MoveToEx(hMainDC, p.x, p.y, NULL);
-		LineTo(hMainDC, p.x + cellSize, p.y);
+		canvas->selectPen(PEN_WALL);
+		canvas->moveTo(p.x, p.y);
+		canvas->lineTo(p.x + cellSize, p.y);
 	}
 	else if (!displayNoGrid()) {
-		SelectObject(hMainDC, ThinGrayPen);
-		MoveToEx(hMainDC, p.x, p.y, NULL);
-		LineTo(hMainDC, p.x + cellSize, p.y);
+		canvas->selectPen(PEN_GRID);
+		canvas->moveTo(p.x, p.y);
+		canvas->lineTo(p.x + cellSize, p.y);
 	}
 
 	// Set door size, pen, brush
 	int h = cellSize / 4; // half door size
-	SelectObject(hMainDC, GetStockObject(BLACK_PEN));
-	SelectObject(hMainDC, GetStockObject(WHITE_BRUSH));
+	canvas->selectPen(PEN_BLACK);
+	canvas->selectBrush(BRUSH_WHITE);
 
 	// Single door
 	if (wall == WALL_SINGLE_DOOR) {
-		Rectangle(hMainDC, p.x+h+1, p.y-h+1, p.x+3*h, p.y+h);
+		canvas->rectangle(p.x+h+1, p.y-h+1, p.x+3*h, p.y+h);
 	}
 
 	// Double door
 	if (wall == WALL_DOUBLE_DOOR) {
-		Rectangle(hMainDC, p.x+2, p.y-h+1, p.x+2*h+1, p.y+h);
-		Rectangle(hMainDC, p.x+2*h, p.y-h+1, p.x+4*h-1, p.y+h);
+		canvas->rectangle(p.x+2, p.y-h+1, p.x+2*h+1, p.y+h);
+		canvas->rectangle(p.x+2*h, p.y-h+1, p.x+4*h-1, p.y+h);
 	}
 
 	// Secret door
@@ -722,36 +1856,36 @@ void GridMap::paintCellNWall(POINT p, WallType wall)
 }
 
 // Paint one cell's west wall
-void GridMap::paintCellWWall(POINT p, WallType wall)
+void GridMap::paintCellWWall(CanvasPoint p, WallType wall)
 {
 	int cellSize = getCellSizePixels();
 
 	// Paint grid line as needed
 	if (wall != WALL_OPEN) {
-		SelectObject(hMainDC, ThickBlackPen);
-		MoveToEx(hMainDC, p.x, p.y, NULL);
-		LineTo(hMainDC, p.x, p.y + cellSize);
+		canvas->selectPen(PEN_WALL);
+		canvas->moveTo(p.x, p.y);
+		canvas->lineTo(p.x, p.y + cellSize);
 	}
 	else if (!displayNoGrid()) {
-		SelectObject(hMainDC, ThinGrayPen);
-		MoveToEx(hMainDC, p.x, p.y, NULL);
-		LineTo(hMainDC, p.x, p.y + cellSize);
+		canvas->selectPen(PEN_GRID);
+		canvas->moveTo(p.x, p.y);
+		canvas->lineTo(p.x, p.y + cellSize);
 	}
 
 	// Set door size, pen, brush
 	int h = cellSize / 4; // half door size
-	SelectObject(hMainDC, GetStockObject(BLACK_PEN));
-	SelectObject(hMainDC, GetStockObject(WHITE_BRUSH));
+	canvas->selectPen(PEN_BLACK);
+	canvas->selectBrush(BRUSH_WHITE);
 
 	// Single door
 	if (wall == WALL_SINGLE_DOOR) {
-		Rectangle(hMainDC, p.x-h+1, p.y+h+1, p.x+h, p.y+3*h);
+		canvas->rectangle(p.x-h+1, p.y+h+1, p.x+h, p.y+3*h);
 	}
 
 	// Double door
 	if (wall == WALL_DOUBLE_DOOR) {
-		Rectangle(hMainDC, p.x-h+1, p.y+2, p.x+h, p.y+2*h+1);
-		Rectangle(hMainDC, p.x-h+1, p.y+2*h, p.x+h, p.y+4*h-1);
+		canvas->rectangle(p.x-h+1, p.y+2, p.x+h, p.y+2*h+1);
+		canvas->rectangle(p.x-h+1, p.y+2*h, p.x+h, p.y+4*h-1);
 	}
 
 	// Secret door
@@ -764,42 +1898,29 @@ void GridMap::paintCellWWall(POINT p, WallType wall)
 	Draw secret door (letter 'S') centered at point p
 	Also paints background behind letter
 */
-void GridMap::drawSecretDoor(POINT p)
+void GridMap::drawSecretDoor(CanvasPoint p)
 {
 	int fontHeight = (int)(getCellSizePixels() * 0.70);
 
-	// Create a font with desired height
-	HFONT hFont =
-	    CreateFont(
-	        -fontHeight, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-	        ANSI_CHARSET, OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS,
-	        DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, TEXT("Arial")
-	    );
-	HFONT hOldFont = (HFONT) SelectObject(hMainDC, hFont);
+	// Select a font with desired height
+	canvas->selectFont({"Arial", fontHeight, false});
 
 	// Measure actual text size
-	SIZE textSize;
-	GetTextExtentPoint32(hMainDC, TEXT("S"), 1, &textSize);
+	CanvasSize textSize = canvas->textExtent("S");
 
 	// Compute top-left of text to center it at (x, y)
 	int textX = p.x - textSize.cx / 2;
 	int textY = p.y - textSize.cy / 2;
 
 	// Draw the letter "S"
-	SetBkMode(hMainDC, OPAQUE);
-	SetTextAlign(hMainDC, TA_LEFT | TA_TOP);
-	TextOut(hMainDC, textX, textY, TEXT("S"), 1);
-
-	// Clean up
-	SelectObject(hMainDC, hOldFont);
-	DeleteObject(hFont);
+	canvas->textOut(textX, textY, "S", ALIGN_TOP_LEFT, true);
 }
 
 // Paint one cell's object
-void GridMap::paintCellObject(POINT p, ObjectType object)
+void GridMap::paintCellObject(CanvasPoint p, ObjectType object)
 {
 	int cellSize = getCellSizePixels();
-	SelectObject(hMainDC, GetStockObject(BLACK_PEN));
+	canvas->selectPen(PEN_BLACK);
 
 	// Pillar object (black circle)
 	if (object == OBJECT_PILLAR) {
@@ -807,42 +1928,33 @@ void GridMap::paintCellObject(POINT p, ObjectType object)
 		int cx = p.x + halfCell;
 		int cy = p.y + halfCell;
 		int radius = (int)(halfCell * 0.50);
-		SelectObject(hMainDC, GetStockObject(BLACK_BRUSH));
-		Ellipse(hMainDC, cx - radius, cy - radius, cx + radius, cy + radius);
+		canvas->selectBrush(BRUSH_BLACK);
+		canvas->ellipse(cx - radius, cy - radius, cx + radius, cy + radius);
 	}
 
 	// Statue object (circle with 5-pointed star inside)
 	if (object == OBJECT_STATUE) {
-		const int NUM_POINTS = 5;
 
 		// Compute center of square and radius of circle
 		int halfCell = cellSize / 2;
 		int cx = p.x + halfCell;
 		int cy = p.y + halfCell;
-		int radius = (int)(halfCell * 0.70);
+		int radius = geometry.statueRadius;
 
 		// Draw the circle
-		SelectObject(hMainDC, GetStockObject(WHITE_BRUSH));
-		Ellipse(hMainDC, cx - radius, cy - radius, cx + radius, cy + radius);
-
-		// Get parameters for 10 points (outer and inner vertices)
-		int outerR = radius;
-		int innerR = (int)(radius * 0.382);  // Golden ratio
-		double startAngle = -TAU / 4;
-		double angleStep = TAU / (NUM_POINTS * 2);
-
-		// Compute the points
-		POINT starPts[10];
-		for (int i = 0; i < 10; ++i) {
-			double angle = startAngle + i * angleStep;
-			int r = (i % 2 == 0) ? outerR : innerR;
-			starPts[i].x = cx + (int)(r * cos(angle));
-			starPts[i].y = cy + (int)(r * sin(angle));
+		canvas->selectBrush(BRUSH_WHITE);
+		canvas->ellipse(cx - radius, cy - radius, cx + radius, cy + radius);
+
+		// Translate the star points (outer and inner vertices)
+		CanvasPoint starPts[STATUE_STAR_POINTS];
+		for (int i = 0; i < STATUE_STAR_POINTS; ++i) {
+			starPts[i].x = cx + geometry.statueStar[i].x;
+			starPts[i].y = cy + geometry.statueStar[i].y;
 		}
 
 		// Fill the star
-		SelectObject(hMainDC, GetStockObject(BLACK_BRUSH));
-		Polygon(hMainDC, starPts, 10);
+		canvas->selectBrush(BRUSH_BLACK);
+		canvas->polygon(starPts, STATUE_STAR_POINTS);
 	}
 
 	// Trapdoor object (square with "T" inside)
@@ -853,35 +1965,18 @@ void GridMap::paintCellObject(POINT p, ObjectType object)
 		int innerY = p.y + (cellSize - innerSize) / 2;
 
 		// Draw the inner square
-		SelectObject(hMainDC, GetStockObject(NULL_BRUSH));
-		Rectangle(hMainDC, innerX, innerY,
-		          innerX + innerSize, innerY + innerSize);
-
-		// Set text alignment and background mode
-		SetBkMode(hMainDC, TRANSPARENT);
-		SetTextAlign(hMainDC, TA_CENTER | TA_BASELINE);
+		canvas->selectBrush(BRUSH_NULL);
+		canvas->rectangle(innerX, innerY,
+		                  innerX + innerSize, innerY + innerSize);
 
-		// Create font scaled to 80% of inner square
+		// Select font scaled to 80% of inner square
 		int fontHeight = (int)(innerSize * ratio);
-		HFONT hFont =
-		    CreateFont(
-		        -fontHeight, 0, 0, 0, FW_BOLD,
-		        FALSE, FALSE, FALSE,
-		        ANSI_CHARSET, OUT_DEFAULT_PRECIS,
-		        CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-		        DEFAULT_PITCH | FF_SWISS,
-		        TEXT("Arial")
-		    );
-		HFONT hOldFont = (HFONT)SelectObject(hMainDC, hFont);
+		canvas->selectFont({"Arial", fontHeight, true});
 
 		// Draw the "T" centered in the inner square
 		int textX = innerX + innerSize / 2;
 		int textY = innerY + innerSize / 2 + (int)(fontHeight * 0.43);
-		TextOut(hMainDC, textX, textY, TEXT("T"), 1);
-
-		// Cleanup
-		SelectObject(hMainDC, hOldFont);
-		DeleteObject(hFont);
+		canvas->textOut(textX, textY, "T", ALIGN_BASELINE_CENTER, false);
 	}
 
 	// Pit object (square with "X" inside)
@@ -893,17 +1988,17 @@ void GridMap::paintCellObject(POINT p, ObjectType object)
 		int innerY = p.y + (cellSize - innerSize) / 2;
 
 		// Draw the square outline
-		SelectObject(hMainDC, GetStockObject(NULL_BRUSH));
-		Rectangle(
-			hMainDC, innerX, innerY, innerX + innerSize, innerY + innerSize);
+		canvas->selectBrush(BRUSH_NULL);
+		canvas->rectangle(
+			innerX, innerY, innerX + innerSize, innerY + innerSize);
 
 		// Top-left to bottom-right diagonal
-		MoveToEx(hMainDC, innerX, innerY, nullptr);
-		LineTo(hMainDC, innerX + innerSize, innerY + innerSize);
+		canvas->moveTo(innerX, innerY);
+		canvas->lineTo(innerX + innerSize, innerY + innerSize);
 
 		// Top-right to bottom-left diagonal
-		MoveToEx(hMainDC, innerX + innerSize, innerY, nullptr);
-		LineTo(hMainDC, innerX, innerY + innerSize);
+		canvas->moveTo(innerX + innerSize, innerY);
+		canvas->lineTo(innerX, innerY + innerSize);
 	}
 
 	// Rubble texture (bunch of random "x" characters)
@@ -911,35 +2006,21 @@ void GridMap::paintCellObject(POINT p, ObjectType object)
 
 		int fontHeight = (int)(cellSize * 0.30);
 
-		// Create font with desied height
-		HFONT hFont =
-		    CreateFont(
-		        -fontHeight, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-		        DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-		        DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, TEXT("Consolas")
-		    );
-		HFONT hOldFont = (HFONT)SelectObject(hMainDC, hFont);
+		// Select font with desired height
+		canvas->selectFont({"Consolas", fontHeight, true});
 
 		// Measure actual text size
-		SIZE textSize;
-		GetTextExtentPoint32(hMainDC, TEXT("x"), 1, &textSize);
-
-		// Transparent background so characters don't overwrite fill
-		SetBkMode(hMainDC, TRANSPARENT);
-		SetTextAlign(hMainDC, TA_LEFT | TA_TOP);
+		CanvasSize textSize = canvas->textExtent("x");
 
 		// Draw a number of random "x" characters
-		for (int i = 0; i < 10; ++i) {
-			int pctx = rand() % 100;
-			int pcty = rand() % 100;
-			int tx = p.x + (cellSize - textSize.cx) * pctx / 100;
-			int ty = p.y + (cellSize - textSize.cy) * pcty / 100;
-			TextOut(hMainDC, tx, ty, TEXT("x"), 1);
+		// (transparent so characters don't overwrite fill)
+		CanvasPoint marks[RUBBLE_MARKS];
+		makeRubbleMarks(marks);
+		for (int i = 0; i < RUBBLE_MARKS; ++i) {
+			int tx = p.x + (cellSize - textSize.cx) * marks[i].x / 100;
+			int ty = p.y + (cellSize - textSize.cy) * marks[i].y / 100;
+			canvas->textOut(tx, ty, "x", ALIGN_TOP_LEFT, false);
 		}
-
-		// Cleanup
-		SelectObject(hMainDC, hOldFont);
-		DeleteObject(hFont);
 	}
 
 	// X-Mark (character "X" in center of square)
@@ -947,78 +2028,99 @@ void GridMap::paintCellObject(POINT p, ObjectType object)
 
 		int fontHeight = (int)(cellSize * 0.65);
 
-		// Create font
-		HFONT hFont =
-		    CreateFont(
-		        -fontHeight, 0, 0, 0, FW_BOLD, FALSE, FALSE, FALSE,
-		        DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-		        DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, TEXT("Segoe UI")
-		    );
-		HFONT hOldFont = (HFONT)SelectObject(hMainDC, hFont);
-
-		// Set alignment and background mode
-		SetTextAlign(hMainDC, TA_CENTER);
-		SetBkMode(hMainDC, TRANSPARENT);
+		// Select font
+		canvas->selectFont({"Segoe UI", fontHeight, true});
 
 		// Get text metrics
-		TEXTMETRIC tm;
-		GetTextMetrics(hMainDC, &tm);
-		int textHeight = tm.tmHeight;
+		int textHeight = canvas->textHeight();
 
 		// Compute center of square
 		int centerX = p.x + cellSize / 2;
 		int centerY = p.y + cellSize / 2 - textHeight / 2;
 
 		// Draw the character
-		TextOut(hMainDC, centerX, centerY, TEXT("X"), 1);
-
-		// Cleanup
-		SelectObject(hMainDC, hOldFont);
-		DeleteObject(hFont);
+		canvas->textOut(centerX, centerY, "X", ALIGN_TOP_CENTER, false);
 	}
 
 	// Stalagmite (circle with partial spokes, random location)
 	if (object == OBJECT_STALAGMITE) {
 
-		double circleFraction = 0.30 + 0.01 * (rand() % 20);
-		int circleDiameter = (int)(cellSize * circleFraction);
-		int radius = circleDiameter / 2;
-
-		// Clamp random position to stay inside square
-		int maxOffset = cellSize - circleDiameter;
-		int pctx = rand() % 100;
-		int pcty = rand() % 100;
-		int randX = p.x + pctx * maxOffset / 100;
-		int randY = p.y + pcty * maxOffset / 100;
-		int cx = randX + radius;
-		int cy = randY + radius;
+		CanvasPoint center;
+		int size = makeStalagmite(center);
+		int radius = geometry.stalagmiteDiameter[size] / 2;
+		int cx = p.x + center.x;
+		int cy = p.y + center.y;
 
 		// Draw the filled circle
-		Ellipse(hMainDC, cx - radius, cy - radius, cx + radius, cy + radius);
+		canvas->ellipse(cx - radius, cy - radius, cx + radius, cy + radius);
 
 		// Draw partial spokes
-		const int numLines = 4;
-		for (int i = 0; i < numLines; ++i) {
-			double angle = i * (TAU / numLines);
-			int xOuter = cx + (int)(radius * cos(angle));
-			int yOuter = cy + (int)(radius * sin(angle));
-			int xInner = cx + (int)((radius / 2.0) * cos(angle));
-			int yInner = cy + (int)((radius / 2.0) * sin(angle));
-			MoveToEx(hMainDC, xOuter, yOuter, NULL);
-			LineTo(hMainDC, xInner, yInner);
+		for (int i = 0; i < STALAGMITE_SPOKES; ++i) {
+			const CanvasPoint& outer = geometry.stalagmiteOuter[size][i];
+			const CanvasPoint& inner = geometry.stalagmiteInner[size][i];
+			canvas->moveTo(cx + outer.x, cy + outer.y);
+			canvas->lineTo(cx + inner.x, cy + inner.y);
 		}
 	}
 }
 
+/*
+	Seed the per-cell random generator.
+	This is the same linear congruential generator as the
+	Microsoft C runtime's rand(), so rough edges & scattered
+	features look as they always have on Windows, but the
+	state is per-map (safe for concurrent rendering) and
+	identical on every platform.
+*/
+void GridMap::seedRandom(unsigned seed)
+{
+	randomState = seed;
+}
+
+// Get a random integer from 0 to RANDOM_MAX
+int GridMap::randomInt()
+{
+	randomState = randomState * 214013u + 2531011u;
+	return (int)((randomState >> 16) & RANDOM_MAX);
+}
+
 // Get a random float between -1 and +1
-double GridMap::randomUnit() const
+double GridMap::randomUnit()
 {
-	return 2.0 * rand() / RAND_MAX - 1.0;
+	return 2.0 * randomInt() / RANDOM_MAX - 1.0;
+}
+
+// Pick random rubble placements (percent of free space in cell)
+void GridMap::makeRubbleMarks(CanvasPoint marks[RUBBLE_MARKS])
+{
+	for (int i = 0; i < RUBBLE_MARKS; ++i) {
+		marks[i].x = randomInt() % 100;
+		marks[i].y = randomInt() % 100;
+	}
+}
+
+/*
+	Pick a random stalagmite size & position inside the cell.
+	Returns the size index; center is relative to the cell corner.
+*/
+int GridMap::makeStalagmite(CanvasPoint& center)
+{
+	int size = randomInt() % STALAGMITE_SIZES;
+	int circleDiameter = geometry.stalagmiteDiameter[size];
+	int radius = circleDiameter / 2;
+
+	// Clamp random position to stay inside square
+	int maxOffset = getCellSizePixels() - circleDiameter;
+	int pctx = randomInt() % 100;
+	int pcty = randomInt() % 100;
+	center.x = pctx * maxOffset / 100 + radius;
+	center.y = pcty * maxOffset / 100 + radius;
+	return size;
 }
 
 // Find the two vertices of a space in a given direction
 void GridMap::getVertexPoints(
-    POINT p, POINT& a, POINT& b, Direction dir) const
+    CanvasPoint p, CanvasPoint& a, CanvasPoint& b, Direction dir) const
 {
 	int cellSize = getCellSizePixels();
 	switch (dir) {
@@ -1043,7 +2145,7 @@ void GridMap::getVertexPoints(
 
 // Generate a fractal line between two points
 void GridMap::generateFractalCurveRecursive(
-    POINT start, POINT end, std::vector<POINT>& path,
+    CanvasPoint start, CanvasPoint end, std::vector<CanvasPoint>& path,
     double displacement, int depthToGo)
 {
 	// Compute distance
@@ -1071,7 +2173,7 @@ void GridMap::generateFractalCurveRecursive(
 		double offset = displacement * randomUnit();
 		mx += perpX * offset;
 		my += perpY * offset;
-		POINT midpoint = {(LONG) mx, (LONG) my};
+		CanvasPoint midpoint = {(int) mx, (int) my};
 
 		// Recursive calls
 		generateFractalCurveRecursive(
@@ -1081,50 +2183,46 @@ void GridMap::generateFractalCurveRecursive(
 	}
 }
 
-// Draw a quadrant of a filled square, with fractal edge
-void GridMap::drawFillQuadrantRough(POINT p, Direction dir)
+// Make a quadrant of a filled square, with fractal edge
+void GridMap::makeFillQuadrantRough(
+    CanvasPoint p, Direction dir, std::vector<CanvasPoint>& shape)
 {
 	// Get dimensions
 	int cellSize = getCellSizePixels();
-	POINT center = { p.x + cellSize / 2, p.y + cellSize / 2 };
+	CanvasPoint center = { p.x + cellSize / 2, p.y + cellSize / 2 };
 
 	// Set outer vertices
-	POINT a, b;
+	CanvasPoint a, b;
 	getVertexPoints(p, a, b, dir);
 
 	// Construct the closed shape
-	std::vector<POINT> shape;
 	shape.push_back(a);
 	generateFractalCurveRecursive(
 	    a, b, shape, cellSize * DISPLACEMENT_SCALE, RECURSION_LIMIT);
 	shape.push_back(center);
 	shape.push_back(a);
-
-	// Fill polygon with black
-	SelectObject(hMainDC, GetStockObject(BLACK_BRUSH));
-	Polygon(hMainDC, shape.data(), (int)(shape.size()));
 }
 
-// Draw a quadrant of a filled square, with smooth edge
-void GridMap::drawFillQuadrantSmooth(POINT p, Direction dir)
+// Make a quadrant of a filled square, with smooth edge
+void GridMap::makeFillQuadrantSmooth(
+    CanvasPoint p, Direction dir, std::vector<CanvasPoint>& shape)
 {
 	int cellSize = getCellSizePixels();
-	POINT center = { p.x + cellSize / 2, p.y + cellSize / 2 };
+	CanvasPoint center = { p.x + cellSize / 2, p.y + cellSize / 2 };
 
 	// Set outer vertices
-	POINT a, b;
+	CanvasPoint a, b;
 	getVertexPoints(p, a, b, dir);
 
 	// Construct the triangle
-	POINT triangle[3] = { a, b, center };
-
-	// Fill with black
-	SelectObject(hMainDC, GetStockObject(BLACK_BRUSH));
-	Polygon(hMainDC, triangle, 3);
+	shape.push_back(a);
+	shape.push_back(b);
+	shape.push_back(center);
 }
 
-// Draw a quadrant of a filled space
-void GridMap::drawFillQuadrant(POINT p, Direction dir)
+// Make a quadrant of a filled space
+void GridMap::makeFillQuadrant(
+    CanvasPoint p, Direction dir, std::vector<CanvasPoint>& shape)
 {
 	assert(displayRoughEdges());
 
@@ -1135,13 +2233,22 @@ void GridMap::drawFillQuadrant(POINT p, Direction dir)
 
 	// Rough-up if exposed edge
 	if (isExposedEdge(gc, dir)) {
-		drawFillQuadrantRough(p, dir);
+		makeFillQuadrantRough(p, dir, shape);
 	}
 	else {
-		drawFillQuadrantSmooth(p, dir);
+		makeFillQuadrantSmooth(p, dir, shape);
 	}
 }
 
+// Draw a quadrant of a filled space
+void GridMap::drawFillQuadrant(CanvasPoint p, Direction dir)
+{
+	std::vector<CanvasPoint> shape;
+	makeFillQuadrant(p, dir, shape);
+	canvas->selectBrush(BRUSH_BLACK);
+	canvas->polygon(shape.data(), (int)(shape.size()));
+}
+
 /*
 	Determine if a given cell edge is an exposed surface
 	(boundary between fill & open spaces, possibly roughed)
@@ -1196,7 +2303,7 @@ bool GridMap::isExposedEdge(GridCoord gc, Direction dir) const
 }
 
 // Draw a filled space, possibly with fractal edges
-void GridMap::drawFillSpaceRough(POINT p)
+void GridMap::drawFillSpaceRough(CanvasPoint p)
 {
 	assert(displayRoughEdges());
 
@@ -1207,8 +2314,9 @@ void GridMap::drawFillSpaceRough(POINT p)
 	drawFillQuadrant(p, WEST);
 }
 
-// Draw a diagonally filled space with fractal edge
-void GridMap::drawDiagonalFillRough(POINT p, FloorType floor)
+// Make a diagonally filled space with fractal edge
+void GridMap::makeDiagonalFillRough(
+    CanvasPoint p, FloorType floor, std::vector<CanvasPoint>& shape)
 {
 	assert(IsFloorDiagonalFill(floor));
 
@@ -1216,7 +2324,7 @@ void GridMap::drawDiagonalFillRough(POINT p, FloorType floor)
 	int cellSize = getCellSizePixels();
 
 	// Set diagonal endpoints
-	POINT start, end;
+	CanvasPoint start, end;
 	if (floor == FLOOR_NEFILL || floor == FLOOR_SWFILL) {
 		start = { p.x, p.y };
 		end   = { p.x + cellSize, p.y + cellSize };
@@ -1227,7 +2335,7 @@ void GridMap::drawDiagonalFillRough(POINT p, FloorType floor)
 	}
 
 	// Set extra vertex
-	POINT extraVertex;
+	CanvasPoint extraVertex;
 	switch (floor) {
 		case FLOOR_NWFILL:
 			extraVertex = { p.x, p.y };
@@ -1242,31 +2350,27 @@ void GridMap::drawDiagonalFillRough(POINT p, FloorType floor)
 			extraVertex = { p.x, p.y + cellSize };
 			break;
 		default:
-			assert(FALSE);
+			assert(false);
 			break;
 	}
 
 	// Construct the closed shape
-	std::vector<POINT> shape;
 	shape.push_back(start);
 	generateFractalCurveRecursive(
 	    start, end, shape, cellSize * DISPLACEMENT_SCALE, RECURSION_LIMIT);
 	shape.push_back(extraVertex);
 	shape.push_back(start);
-
-	// Fill polygon
-	SelectObject(hMainDC, GetStockObject(BLACK_BRUSH));
-	Polygon(hMainDC, shape.data(), (int)(shape.size()));
 }
 
-// Draw a diagonally filled space (with smooth edge)
-void GridMap::drawDiagonalFillSmooth(POINT p, FloorType floor)
+// Make a diagonally filled space (with smooth edge)
+void GridMap::makeDiagonalFillSmooth(
+    CanvasPoint p, FloorType floor, std::vector<CanvasPoint>& shape)
 {
 	assert(IsFloorDiagonalFill(floor));
 	int cellSize = getCellSizePixels();
 
 	// Construct the triangle
-	POINT triangle[3];
+	CanvasPoint triangle[3];
 	switch (floor) {
 		case FLOOR_NWFILL:
 			triangle[0] = { p.x, p.y };
@@ -1289,11 +2393,22 @@ void GridMap::drawDiagonalFillSmooth(POINT p, FloorType floor)
 			triangle[2] = { p.x + cellSize, p.y };
 			break;
 		default:
-			assert(FALSE);
+			assert(false);
 			break;
 	}
 
-	// Fill polygon
-	SelectObject(hMainDC, GetStockObject(BLACK_BRUSH));
-	Polygon(hMainDC, triangle, 3);
+	// Append to shape
+	shape.insert(shape.end(), triangle, triangle + 3);
+}
+
+// Make a diagonally filled space, rough or smooth per display
+void GridMap::makeDiagonalFill(
+    CanvasPoint p, FloorType floor, std::vector<CanvasPoint>& shape)
+{
+	if (displayRoughEdges()) {
+		makeDiagonalFillRough(p, floor, shape);
+	}
+	else {
+		makeDiagonalFillSmooth(p, floor, shape);
+	}
 }
@@ -9,7 +9,9 @@
 */
 #ifndef GRIDMAP_H
 #define GRIDMAP_H
-#include <windows.h>
+#include "GridCanvas.h"
+#include <atomic>
+#include <cstddef>
 #include <vector>
 
 /*
@@ -19,6 +21,21 @@ struct GridCoord {
 	unsigned x, y;
 };
 
+// Block of cells [left, right) x [top, bottom)
+struct GridRect {
+	unsigned left, top, right, bottom;
+};
+
+/*
+	Region of cells for bulk edits: a block, and optionally a mask
+	of which cells in it are included (column-major, nonzero for in).
+	An empty mask includes the whole block.
+*/
+struct GridRegion {
+	GridRect bounds;
+	std::vector<unsigned char> mask;
+};
+
 /*
 	Structure for a single grid cell.
 	Controls its owns floor, north & west walls, and any object.
@@ -27,6 +44,31 @@ struct GridCell {
 	unsigned char floor, nwall, wwall, object;
 };
 
+// Columns in each strip of cell storage
+const unsigned STRIP_COLUMNS = 8;
+
+/*
+	Strip of whole columns of cells (column-major).
+	Strips are shared between a map & its copies (snapshots),
+	possibly on other threads, and copied before any change
+	while shared; so a shared strip never changes.
+*/
+struct CellStrip {
+	std::atomic<unsigned> refs;
+	std::vector<GridCell> cells;
+};
+
+/*
+	Block of cells copied out of a map (column-major, as stored).
+	Cells own their north & west walls, so the walls on the east
+	& south edges of the block are kept on the side.
+*/
+struct CellBlock {
+	unsigned width, height;
+	std::vector<GridCell> cells;
+	std::vector<unsigned char> eastWalls, southWalls;
+};
+
 /*
 	Enumerations for cell contents.
 	Never reorder/renumber these,
@@ -59,15 +101,72 @@ enum Direction {
 	NORTH, SOUTH, EAST, WEST
 };
 
+// Whole-map transforms (rotations clockwise)
+enum MapTransform {
+	ROTATE_90, ROTATE_180, ROTATE_270, FLIP_HORZ, FLIP_VERT
+};
+
 // Feature info function(s)
 bool IsFloorFillType(FloorType floor);
 bool IsFloorOpenType(FloorType floor);
 bool IsFloorDiagonalFill(FloorType floor);
 bool IsFloorSemiOpen(FloorType floor);
 
+// Region function(s)
+bool IsInRegion(const GridRegion& region, GridCoord gc);
+
+// Transform function(s)
+bool IsTransformTurn(MapTransform transform);
+void TransformCellBlock(CellBlock& block, MapTransform transform);
+
 // Filename max length
 const int GRID_FILENAME_MAX = 256;
 
+// Stamped feature counts
+const int SPIRAL_SPOKES = 12;
+const int STATUE_STAR_POINTS = 10;
+const int STALAGMITE_SPOKES = 4;
+const int STALAGMITE_SIZES = 20;
+const int RUBBLE_MARKS = 10;
+
+/*
+	Geometry for stamped features, scaled to one cell size.
+	Offsets are relative to the feature center;
+	rebuilt only when the cell size changes.
+*/
+struct FeatureGeometry {
+	unsigned cellSize;
+
+	// Spiral stairs
+	int spiralRadius, spiralInnerRadius;
+	CanvasPoint spiralArcStart, spiralArcEnd;
+	CanvasPoint spiralSpokes[SPIRAL_SPOKES + 1];
+
+	// Statue
+	int statueRadius;
+	CanvasPoint statueStar[STATUE_STAR_POINTS];
+
+	// Stalagmites (one entry per random size)
+	int stalagmiteDiameter[STALAGMITE_SIZES];
+	CanvasPoint stalagmiteOuter[STALAGMITE_SIZES][STALAGMITE_SPOKES];
+	CanvasPoint stalagmiteInner[STALAGMITE_SIZES][STALAGMITE_SPOKES];
+};
+
+/*
+	Randomized shapes for one cell, as painted (for vector export).
+	Fill polygons are stored back to back in points, in map pixels.
+	Rubble marks are percent placements within the cell;
+	the stalagmite center is relative to the cell corner.
+*/
+struct CellShapes {
+	bool solidFill;
+	std::vector<CanvasPoint> points;
+	std::vector<int> polygonSizes;
+	int stalagmiteSize;
+	CanvasPoint stalagmiteCenter;
+	CanvasPoint rubble[RUBBLE_MARKS];
+};
+
 /*
 	GridMap interface
 */
@@ -77,6 +176,12 @@ class GridMap {
 		// Constructors
 		GridMap(unsigned width, unsigned height);
 		GridMap(char *filename);
+		GridMap(const GridMap& other);
+		GridMap(const GridMap& other, MapTransform transform);
+		GridMap(
+		    const GridMap& other, unsigned width, unsigned height,
+		    int shiftX, int shiftY);
+		GridMap& operator=(const GridMap& other) = delete;
 		~GridMap();
 
 		// Accessors
@@ -85,14 +190,16 @@ class GridMap {
 		const char* getFilename() const;
 		unsigned getWidthCells() const;
 		unsigned getHeightCells() const;
-		unsigned getWidthPixels() const;
-		unsigned getHeightPixels() const;
+		unsigned long long getWidthPixels() const;
+		unsigned long long getHeightPixels() const;
 		FloorType getCellFloor(GridCoord gc) const;
 		ObjectType getCellObject(GridCoord gc) const;
 		WallType getCellNWall(GridCoord gc) const;
 		WallType getCellWWall(GridCoord gc) const;
+		const GridCell* getColumn(unsigned x) const;
 		bool canBuildNWall(GridCoord gc) const;
 		bool canBuildWWall(GridCoord gc) const;
+		GridRect getContentBounds() const;
 
 		// Mutators
 		void setCellFloor(GridCoord gc, int floor);
@@ -100,12 +207,33 @@ class GridMap {
 		void setCellNWall(GridCoord gc, int wall);
 		void setCellWWall(GridCoord gc, int wall);
 		void clearMap(int floor);
+		void setColumn(unsigned x, const GridCell *cells);
+		bool floodFillFloor(GridCoord gc, int floor, GridRect& edited);
+
+		// Bulk edits (each returns the block of cells changed)
+		GridRect fillFloor(const GridRegion& region, int floor);
+		GridRect clearObjects(const GridRegion& region);
+		GridRect setPerimeterWalls(const GridRegion& region, int wall);
+		GridRect drawRoom(GridRect room, int floor, int wall);
+		GridRect autoWall(const GridRegion& region, int wall, bool smooth);
+
+		// Copy & paste cells
+		void copyCells(GridRect rect, CellBlock& block) const;
+		GridRect pasteCells(const CellBlock& block, GridCoord at);
 		void setFilename(char *name);
 
-		// Paint on a display context
-		void paint(HDC hDC);
+		// Paint on a canvas
+		void paint(GridCanvas& canvas);
+		void paintRegion(
+		    GridCanvas& canvas, unsigned left, unsigned top,
+		    unsigned right, unsigned bottom);
 		void paintCell(
 			GridCoord gc, bool partialRepaint, int recursionDepth = 0);
+		unsigned getPaintMarginCells() const;
+
+		// Shapes for vector export
+		void getCellShapes(GridCoord gc, CellShapes& shapes);
+		const FeatureGeometry& getFeatureGeometry() const;
 
 		// Save to file
 		int save();
@@ -124,40 +252,87 @@ class GridMap {
 	private:
 
 		// Painting helper functions
+		void paintCells(
+		    unsigned left, unsigned top, unsigned right, unsigned bottom);
 		unsigned cellHash(GridCoord gc) const;
-		void paintCellFloor(POINT p, FloorType floor);
-		void paintCellObject(POINT p, ObjectType object);
-		void paintCellNWall(POINT p, WallType wall);
-		void paintCellWWall(POINT p, WallType wall);
-		void drawSecretDoor(POINT p);
-		void makeStandardPens();
+		void paintCellFloor(CanvasPoint p, FloorType floor);
+		void paintCellObject(CanvasPoint p, ObjectType object);
+		void paintCellNWall(CanvasPoint p, WallType wall);
+		void paintCellWWall(CanvasPoint p, WallType wall);
+		void drawSecretDoor(CanvasPoint p);
+		void makeFeatureGeometry();
+
+		// Cell storage helpers
+		void makeStrips();
+		void pointStripColumns(unsigned strip);
+		static void releaseStrip(CellStrip *strip);
+		GridCell* writeColumn(unsigned x);
+
+		// Bulk edit helpers
+		struct Span {
+			unsigned x, top, bottom;
+		};
+		void getRegionSpans(
+		    const GridRegion& region, std::vector<Span>& spans) const;
+		void clearDisallowedSpan(const Span& span);
+		GridRect getSpansBlock(
+		    const std::vector<Span>& spans, bool withWalls) const;
+		FloorType getStepCorner(GridCoord gc) const;
+		FloorType getFillCorner(GridCoord gc) const;
+		bool isTerrainEdge(GridCoord gc, Direction side) const;
+		void seedFloodSpans(
+		    unsigned x, unsigned top, unsigned bottom, unsigned wallX,
+		    unsigned char floor, std::vector<GridCoord>& seeds) const;
+
+		// Per-cell random numbers
+		void seedRandom(unsigned seed);
+		int randomInt();
+		double randomUnit();
+		void makeRubbleMarks(CanvasPoint marks[RUBBLE_MARKS]);
+		int makeStalagmite(CanvasPoint& center);
 
 		// Rough-edge painting functions
-		double randomUnit() const;
 		bool isExposedEdge(GridCoord gc, Direction dir) const;
-		void getVertexPoints(POINT p, POINT& a, POINT& b, Direction dir) const;
-		void drawFillSpaceRough(POINT p);
-		void drawFillQuadrant(POINT p, Direction dir);
-		void drawFillQuadrantSmooth(POINT p, Direction dir);
-		void drawFillQuadrantRough(POINT p, Direction dir);
-		void drawDiagonalFillSmooth(POINT p, FloorType floor);
-		void drawDiagonalFillRough(POINT p, FloorType floor);
+		void getVertexPoints(
+		    CanvasPoint p, CanvasPoint& a, CanvasPoint& b, Direction dir) const;
+		void drawFillSpaceRough(CanvasPoint p);
+		void drawFillQuadrant(CanvasPoint p, Direction dir);
+		void makeFillQuadrant(
+		    CanvasPoint p, Direction dir, std::vector<CanvasPoint>& shape);
+		void makeFillQuadrantSmooth(
+		    CanvasPoint p, Direction dir, std::vector<CanvasPoint>& shape);
+		void makeFillQuadrantRough(
+		    CanvasPoint p, Direction dir, std::vector<CanvasPoint>& shape);
+		void makeDiagonalFill(
+		    CanvasPoint p, FloorType floor, std::vector<CanvasPoint>& shape);
+		void makeDiagonalFillSmooth(
+		    CanvasPoint p, FloorType floor, std::vector<CanvasPoint>& shape);
+		void makeDiagonalFillRough(
+		    CanvasPoint p, FloorType floor, std::vector<CanvasPoint>& shape);
 		void generateFractalCurveRecursive(
-		    POINT start, POINT end, std::vector<POINT>& path,
+		    CanvasPoint start, CanvasPoint end,
+		    std::vector<CanvasPoint>& path,
 		    double displacement, int depthToGo);
 		
-		// Data fields
+		// Data fields (grid points to each column in strips)
 		GridCell **grid;
+		std::vector<CellStrip*> strips;
 		unsigned width, height, displayCode;
 		char filename[GRID_FILENAME_MAX];
 		bool changed, fileLoadOk;
 
-		// Drawing context handles
-		HPEN ThinGrayPen = NULL, ThickBlackPen = NULL;
-		HDC hMainDC = NULL;
+		// Drawing canvas & random state
+		GridCanvas *canvas = NULL;
+		unsigned randomState = 0;
+
+		// Stamped feature geometry for current cell size
+		FeatureGeometry geometry;
 
 		// Constants for fractal edges
 		const int RECURSION_LIMIT = 4;
 		const double DISPLACEMENT_SCALE = 0.25;
+
+		// Constant for random numbers
+		static const int RANDOM_MAX = 0x7fff;
 };
 #endif
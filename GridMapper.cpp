@@ -8,19 +8,59 @@
 		Contact author at delta@superdan.net
 */
 #include "GridMapper.h"
+#include "GdiCanvas.h"
+#include "GridRegions.h"
+#include "GridExport.h"
+#include "GridField.h"
+#include "GridGenerate.h"
+#include "GridPaths.h"
+#include "GridPrint.h"
+#include "GridRooms.h"
+#include "GridRoutes.h"
+#include "GridSight.h"
+#include "GridThumb.h"
+#include "TileRenderer.h"
 #include "Resource.h"
+#include <algorithm>
 #include <sstream>
 #include <cassert>
+#include <cstdlib>
 #include <ctime>
 
 // Constants
 const int MAX_LOADSTRING = 100;
 const int DefaultMapWidth = 40;
 const int DefaultMapHeight = 30;
-const int DefaultPrintSquaresPerInch = 4;
+const double PosterOverlapInches = 0.25;
 const int ScrollWheelIncrement = 120;
+const int MinimapMaxSize = 160;
+const int MinimapMargin = 8;
+const COLORREF MinimapViewColor = 0x000000ff;
+const COLORREF RoomOutlineColor = 0x000000ff;
+const COLORREF SelectionColor = 0x00ff0000;
+const COLORREF PathColor = 0x0000a000;
+const COLORREF ViewerColor = 0x0000c0ff;
+const COLORREF ExploredColor = 0x00606060;
+const COLORREF RangeTokenColor = 0x00a000a0;
+const COLORREF RoomNumberColor = 0x00800000;
+const COLORREF FieldColors[] = {
+	0x00a0ffa0, 0x0080ffc0, 0x0080ffe0, 0x0080ffff,
+	0x0080e0ff, 0x0080c0ff, 0x0080a0ff, 0x008080ff
+};
+const int NumFieldColors = sizeof(FieldColors) / sizeof(COLORREF);
+const DWORD TintRop = 0x00A000C9;
+const unsigned MoveRangeSquares = 12;
+const unsigned FieldBandSquares = 5;
+const unsigned RouteEditCost = 512;
+const UINT ZoomSettleTimer = 1;
+const UINT ZoomSettleMs = 150;
+const UINT WM_TILEDONE = WM_APP + 1;
+const char CellClipFormatName[] = "GridMapper Cells";
 const char DefaultFileExt[] = "gmap";
 const char FileFilterStr[] = "GridMapper Files (*.gmap)\0*.gmap\0";
+const char ExportFilterStr[] =
+    "PNG Image (*.png)\0*.png\0TIFF Image (*.tif)\0*.tif\0"
+    "SVG Drawing (*.svg)\0*.svg\0";
 
 // Global variables
 HWND hMainWnd;
@@ -28,11 +68,40 @@ HINSTANCE hInst;
 HDC BkgdDC;
 HPEN BkgdPen;
 HBITMAP BkgdBitmap;
+HDC PreviewDC = NULL;
+HBITMAP PreviewBitmap = NULL;
+unsigned previewSize = 0;
+unsigned zoomTarget = 0;        // Cell size zooming to (0 if none)
+TileRenderer *tileRenderer = NULL;
 TCHAR szTitle[MAX_LOADSTRING];
 TCHAR szWindowClass[MAX_LOADSTRING];
 GridMap *gridmap = NULL;
 int selectedFeature = 0;
 bool LButtonCapture = false;
+bool MinimapDrag = false;
+bool FloodFillMode = false;
+bool RegionDrag = false;
+GridCoord regionStart = {0, 0};
+GridCoord regionEnd = {0, 0};
+bool HaveSelection = false;
+GridRect selection = {0, 0, 0, 0};
+GridRoutes *mapRoutes = NULL;
+bool HavePath = false;
+std::vector<GridCoord> shownPath;
+unsigned shownPathCost = NO_PATH;
+GridSight *mapSight = NULL;
+bool FogOfWar = false;
+std::vector<GridCoord> viewers;
+GridField *mapField = NULL;
+bool ShowField = false;
+bool FieldFromStairs = false;
+std::vector<GridCoord> rangeTokens;
+GridRooms *mapRooms = NULL;
+bool NumberRooms = false;
+UINT CellClipFormat = 0;
+MapThumbnail minimap;
+POINT strokeLast = {0, 0};
+RECT editedCells = {0, 0, 0, 0};
 
 // Function prototypes
 ATOM MyRegisterClass(HINSTANCE);
@@ -41,6 +110,7 @@ LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 LRESULT CALLBACK About(HWND, UINT, WPARAM, LPARAM);
 LRESULT CALLBACK NewDialog(HWND, UINT, WPARAM, LPARAM);
 LRESULT CALLBACK GridSizeDialog(HWND, UINT, WPARAM, LPARAM);
+LRESULT CALLBACK ResizeDialog(HWND, UINT, WPARAM, LPARAM);
 
 /*
 	Win32 application entry point.
@@ -133,6 +203,8 @@ void InitGridMapper()
 {
 	srand((unsigned int) time(NULL));
 	BkgdPen = CreatePen(PS_SOLID, 1, 0x00808080);
+	CellClipFormat = RegisterClipboardFormat(CellClipFormatName);
+	tileRenderer = new TileRenderer(hMainWnd, WM_TILEDONE);
 	InitFirstMap();
 }
 
@@ -180,6 +252,13 @@ LRESULT CALLBACK WndProc(
 		case WM_MOUSEWHEEL:
 			ScrollWheelHandler(wParam);
 			break;
+		case WM_TILEDONE:
+			TilesDone();
+			break;
+		case WM_TIMER:
+			if (wParam == ZoomSettleTimer)
+				CompleteZoom();
+			break;
 		case WM_KEYDOWN:
 			MyKeyHandler(wParam);
 			break;
@@ -189,20 +268,25 @@ LRESULT CALLBACK WndProc(
 			break;
 		case WM_LBUTTONUP:
 			LButtonCapture = false;
+			MinimapDrag = false;
+			if (RegionDrag)
+				FinishRegionDrag();
 			break;
 		case WM_LBUTTONDOWN:
 			LButtonCapture = true;
+			MinimapDrag = IsOnMinimap(lParam);
 			MyLButtonHandler(lParam);
 			break;
 		case WM_MOUSEMOVE:
 			if (LButtonCapture && (wParam & MK_LBUTTON))
-				MyLButtonHandler(lParam);
+				MyMouseDragHandler(lParam);
 			break;
 		case WM_CLOSE:
 			if (OkDiscardChanges())
 				return DefWindowProc(hWnd, message, wParam, lParam);
 			break;
 		case WM_DESTROY:
+			CancelZoom();
 			DestroyObjects();
 			PostQuitMessage(0);
 			break;
@@ -218,15 +302,20 @@ LRESULT CALLBACK WndProc(
 */
 bool ProcessCommand(int cmdId)
 {
+	// Settle any zoom in progress first
+	CompleteZoom();
+
 	// Catch commands requiring okay to discard changes
 	if (cmdId == IDM_NEW || cmdId == IDM_OPEN || cmdId == IDM_EXIT
-	        || cmdId == IDM_FILL_MAP || cmdId == IDM_CLEAR_MAP) {
+	        || cmdId == IDM_FILL_MAP || cmdId == IDM_CLEAR_MAP
+	        || cmdId == IDM_GENERATE_CAVE || cmdId == IDM_GENERATE_DUNGEON
+	        || cmdId == IDM_GENERATE_SAMPLE) {
 		if (!OkDiscardChanges())
 			return true;
 	}
 
 	// Catch feature-to-draw Tool selections
-	if (START_BASIC_FLOOR_TOOLS <= cmdId && cmdId <= END_OBJECT_TOOLS) {
+	if (START_BASIC_FLOOR_TOOLS <= cmdId && cmdId <= END_REGION_TOOLS) {
 		SetSelectedFeature(cmdId);
 		return true;
 	}
@@ -242,9 +331,52 @@ bool ProcessCommand(int cmdId)
 		case IDM_SAVE_AS:
 			SaveMapAs();
 			break;
+		case IDM_EXPORT:
+			ExportMap();
+			break;
 		case IDM_COPY:
 			CopyMap();
 			break;
+		case IDM_PASTE:
+			PasteCells();
+			break;
+		case IDM_ROTATE_RIGHT:
+			TransformMap(ROTATE_90);
+			break;
+		case IDM_ROTATE_LEFT:
+			TransformMap(ROTATE_270);
+			break;
+		case IDM_ROTATE_180:
+			TransformMap(ROTATE_180);
+			break;
+		case IDM_FLIP_HORZ:
+			TransformMap(FLIP_HORZ);
+			break;
+		case IDM_FLIP_VERT:
+			TransformMap(FLIP_VERT);
+			break;
+		case IDM_RESIZE_MAP:
+			DialogBox(
+			    hInst, (LPCTSTR) IDD_RESIZEMAP,
+			    hMainWnd, (DLGPROC) ResizeDialog);
+			break;
+		case IDM_CROP_MAP:
+			CropMap();
+			break;
+		case IDM_TRIM_MAP:
+			TrimMap();
+			break;
+		case IDM_AUTO_WALL:
+			AutoWallMap(false);
+			break;
+		case IDM_AUTO_WALL_SMOOTH:
+			AutoWallMap(true);
+			break;
+		case IDM_FILL_FLOOR:
+		case IDM_CLEAR_OBJECTS:
+		case IDM_WALL_PERIMETER:
+			EditSelection(cmdId);
+			break;
 		case IDM_PRINT:
 			PrintMap();
 			break;
@@ -257,12 +389,39 @@ bool ProcessCommand(int cmdId)
 		case IDM_CLEAR_MAP:
 			ClearMap(true);
 			break;
+		case IDM_GENERATE_CAVE:
+			GenerateCaveMap();
+			break;
+		case IDM_GENERATE_DUNGEON:
+			GenerateDungeonMap();
+			break;
+		case IDM_GENERATE_SAMPLE:
+			GenerateSampleMap();
+			break;
+		case IDM_CHECK_REGIONS:
+			CheckConnectivity();
+			break;
 		case IDM_HIDE_GRID:
 			ToggleGridLines();
 			break;
 		case IDM_ROUGH_EDGES:
 			ToggleRoughEdges();
 			break;
+		case IDM_FOG_OF_WAR:
+			ToggleFogOfWar();
+			break;
+		case IDM_RESET_EXPLORED:
+			ResetExplored();
+			break;
+		case IDM_STAIRS_DISTANCES:
+			ToggleStairsDistances();
+			break;
+		case IDM_NUMBER_ROOMS:
+			ToggleRoomNumbers();
+			break;
+		case IDM_FLOOD_FILL:
+			ToggleFloodFill();
+			break;
 		case IDM_NEW:
 			DialogBox(
 				hInst, (LPCTSTR) IDD_NEWMAP, 
@@ -289,6 +448,8 @@ bool ProcessCommand(int cmdId)
 */
 void DestroyObjects()
 {
+	delete tileRenderer;
+	DropPreview();
 	DeleteObject(BkgdDC);
 	DeleteObject(BkgdPen);
 	DeleteObject(BkgdBitmap);
@@ -304,12 +465,105 @@ unsigned GetGridSize()
 	return gridmap->getCellSizePixels();
 }
 
-void UpdateBkgdCell(GridCoord gc)
+/*
+	Mark one cell to repaint on background & update on minimap.
+	Cells add up until UpdateEditedCells() is called, so a batch
+	of edits is handed to the tile renderer just once.
+*/
+void RepaintCell(GridCoord gc)
+{
+	if (gc.x < gridmap->getWidthCells()
+	        && gc.y < gridmap->getHeightCells())
+		RepaintCells({gc.x, gc.y, gc.x + 1, gc.y + 1});
+}
+
+// Mark a block of cells to repaint, as for RepaintCell()
+// (minimap rebuilt whole if that's less work)
+void RepaintCells(GridRect cells)
 {
-	gridmap->paintCell(gc, true);
+	if (cells.left >= cells.right || cells.top >= cells.bottom)
+		return;
+	if (editedCells.left >= editedCells.right) {
+		editedCells = {(LONG) cells.left, (LONG) cells.top,
+		               (LONG) cells.right, (LONG) cells.bottom};
+	}
+	else {
+		editedCells.left = std::min(editedCells.left, (LONG) cells.left);
+		editedCells.top = std::min(editedCells.top, (LONG) cells.top);
+		editedCells.right = std::max(editedCells.right, (LONG) cells.right);
+		editedCells.bottom =
+		    std::max(editedCells.bottom, (LONG) cells.bottom);
+	}
+	unsigned long long area =
+	    (unsigned long long) (cells.right - cells.left)
+	    * (cells.bottom - cells.top);
+	unsigned long long block = minimap.blockCells;
+	if (area * block * block
+	        > (unsigned long long) gridmap->getWidthCells()
+	        * gridmap->getHeightCells()) {
+		RebuildMinimap();
+		return;
+	}
+	for (unsigned x = cells.left; x < cells.right; x++) {
+		for (unsigned y = cells.top; y < cells.bottom; y++) {
+			UpdateThumbnailCell(*gridmap, minimap, {x, y});
+		}
+	}
+}
+
+// Repaint the cells edited since last time (if any) & the window
+// (the background is repainted by the tile renderer)
+void UpdateEditedCells()
+{
+	if (editedCells.left >= editedCells.right)
+		return;
+	if (BkgdBitmap) {
+		tileRenderer->updateCells(
+		    *gridmap, editedCells.left, editedCells.top,
+		    editedCells.right, editedCells.bottom);
+	}
+	GridRect edited = {
+		(unsigned) editedCells.left, (unsigned) editedCells.top,
+		(unsigned) editedCells.right, (unsigned) editedCells.bottom
+	};
+	if (ShowField) {
+		mapField->updateCells(edited);
+	}
+	if (NumberRooms) {
+		mapRooms->updateCells(edited);
+	}
+	UpdateRoutes(edited);
+	editedCells = {0, 0, 0, 0};
 	UpdateEntireWindow();
 }
 
+/*
+	Keep the path tool's door graph up to date with cells edited
+	(dropped, to build again on next use, if so many cells changed
+	that re-costing the rooms around each would be more work: an
+	edit costs about as much as building for RouteEditCost cells).
+*/
+void UpdateRoutes(GridRect edited)
+{
+	if (!mapRoutes)
+		return;
+	unsigned long long area =
+	    (unsigned long long) (edited.right - edited.left)
+	    * (edited.bottom - edited.top);
+	if (area * RouteEditCost
+	        > (unsigned long long) gridmap->getWidthCells()
+	        * gridmap->getHeightCells()) {
+		delete mapRoutes;
+		mapRoutes = NULL;
+		return;
+	}
+	for (unsigned x = edited.left; x < edited.right; x++) {
+		for (unsigned y = edited.top; y < edited.bottom; y++) {
+			mapRoutes->updateCell({x, y});
+		}
+	}
+}
+
 void UpdateEntireWindow()
 {
 	RECT rw;
@@ -428,11 +682,12 @@ void ScrollWheelHandler(WPARAM wParam)
 	int steps = wheelDelta / ScrollWheelIncrement;
 
 	// Handle zoom-in or out (Ctrl pressed)
+	// (coalesced with any zoom still rendering)
 	if (wParam & MK_CONTROL) {
-		int newSize = GetGridSize() + steps;
+		int newSize = GetShownGridSize() + steps;
 		newSize = std::min(newSize, (int) gridmap->getCellSizeMax());
 		newSize = std::max(newSize, (int) gridmap->getCellSizeMin());
-		ChangeGridSize(newSize);
+		ZoomGridSize(newSize);
 	}
 
 	// Handle movement of scrollbars
@@ -472,6 +727,14 @@ unsigned GetVertScrollPos()
 void MyKeyHandler(WPARAM wParam)
 {
 	switch (wParam) {
+		case VK_ESCAPE:
+			if (HaveSelection || HavePath || (ShowField && !FieldFromStairs)) {
+				HaveSelection = false;
+				HavePath = false;
+				ShowField = ShowField && FieldFromStairs;
+				UpdateEntireWindow();
+			}
+			break;
 		case VK_LEFT:
 			SendMessage(hMainWnd, WM_HSCROLL, SB_LINELEFT, 0);
 			break;
@@ -512,14 +775,62 @@ void MyPaintWindow()
 	SelectObject(hdc, BkgdPen);
 
 	// If map available, blit from memory & paint background bottom-right
+	// (stretched as a preview while a zoom settles)
 	if (gridmap) {
-		BitBlt(
-		    hdc, 0, 0, rw.right, rw.bottom, BkgdDC,
-		    GetHorzScrollPos(), GetVertScrollPos(), SRCCOPY);
-		int rightPixel = gridmap->getWidthPixels() - GetHorzScrollPos();
-		int bottomPixel = gridmap->getHeightPixels() - GetVertScrollPos();
+		unsigned gridSize = GetGridSize();
+		unsigned shownSize = GetShownGridSize();
+		if (shownSize == gridSize) {
+			int hPos = GetHorzScrollPos();
+			int vPos = GetVertScrollPos();
+			tileRenderer->setViewport(
+			    hPos, vPos, hPos + rw.right, vPos + rw.bottom);
+			BitBlt(
+			    hdc, 0, 0, rw.right, rw.bottom, BkgdDC,
+			    hPos, vPos, SRCCOPY);
+			PaintPlaceholders(hdc, rw);
+		}
+		else {
+			SetStretchBltMode(hdc, COLORONCOLOR);
+			StretchBlt(
+			    hdc, 0, 0, rw.right, rw.bottom, BkgdDC,
+			    GetHorzScrollPos(), GetVertScrollPos(),
+			    rw.right * gridSize / shownSize,
+			    rw.bottom * gridSize / shownSize, SRCCOPY);
+		}
+		int rightPixel =
+		    (gridmap->getWidthPixels() - GetHorzScrollPos())
+		    * shownSize / gridSize;
+		int bottomPixel =
+		    (gridmap->getHeightPixels() - GetVertScrollPos())
+		    * shownSize / gridSize;
 		Rectangle(hdc, rightPixel, rw.top, rw.right, rw.bottom);
 		Rectangle(hdc, rw.left, bottomPixel, rw.right, rw.bottom);
+		if (ShowField) {
+			PaintField(hdc);
+			PaintRangeTokens(hdc);
+		}
+		if (FogOfWar) {
+			UpdateSight();
+			PaintFog(hdc);
+			PaintViewers(hdc);
+		}
+		if (NumberRooms) {
+			PaintRoomNumbers(hdc);
+		}
+		if (RegionDrag && (selectedFeature == IDM_REGION_ROOM
+		                   || selectedFeature == IDM_REGION_SELECT)) {
+			PaintRegionOutline(
+			    hdc, GetDragRect(),
+			    selectedFeature == IDM_REGION_ROOM
+			    ? RoomOutlineColor : SelectionColor);
+		}
+		else if (HaveSelection) {
+			PaintRegionOutline(hdc, selection, SelectionColor);
+		}
+		if (HavePath) {
+			PaintShownPath(hdc);
+		}
+		PaintMinimap(hdc);
 	}
 	else {
 		Rectangle(hdc, rw.left, rw.top, rw.right, rw.bottom);
@@ -529,20 +840,157 @@ void MyPaintWindow()
 
 void MyLButtonHandler(LPARAM lParam)
 {
-	// Extract click position
-	POINT p = {
+	// Edit only at the size shown
+	CompleteZoom();
+
+	// Scroll instead if click started on minimap
+	if (MinimapDrag) {
+		ScrollToMinimap(lParam);
+		return;
+	}
+
+	// Start a room, selection, path, viewer or range at click position
+	// (finished when button released)
+	strokeLast = GetMapPointFromLParam(lParam);
+	if (START_REGION_TOOLS < selectedFeature
+	        && selectedFeature < END_REGION_TOOLS) {
+		if (strokeLast.x < (LONG) gridmap->getWidthPixels()
+		        && strokeLast.y < (LONG) gridmap->getHeightPixels()) {
+			RegionDrag = true;
+			regionStart = regionEnd = GetGridCoordFromWindow(strokeLast);
+			if (selectedFeature == IDM_REGION_PATH) {
+				FindShownPath();
+			}
+			else if (selectedFeature == IDM_REGION_VIEW) {
+				PlaceViewer(GetKeyState(VK_SHIFT) < 0);
+			}
+			else if (selectedFeature == IDM_REGION_RANGE) {
+				PlaceRangeToken(GetKeyState(VK_SHIFT) < 0);
+			}
+			UpdateEntireWindow();
+		}
+		return;
+	}
+
+	// Start a stroke at click position
+	ApplyTool(strokeLast);
+	UpdateEditedCells();
+}
+
+/*
+	Continue a drag with the left button.
+	Takes every mouse move already queued too, draws the path
+	through all of them, and repaints once for the whole batch.
+*/
+void MyMouseDragHandler(LPARAM lParam)
+{
+	CompleteZoom();
+	for (;;) {
+
+		// Draw on to this point (unless scrolling by minimap)
+		// or stretch room, selection or path (or move viewer or token) to it
+		POINT p = GetMapPointFromLParam(lParam);
+		if (RegionDrag) {
+			regionEnd = {
+				std::min((unsigned) p.x / GetGridSize(),
+				         gridmap->getWidthCells() - 1),
+				std::min((unsigned) p.y / GetGridSize(),
+				         gridmap->getHeightCells() - 1)
+			};
+		}
+		else if (!MinimapDrag) {
+			StrokeLine(strokeLast, p);
+			strokeLast = p;
+		}
+
+		// Take next move if queued before any other mouse message
+		MSG msg;
+		if (!PeekMessage(&msg, hMainWnd, WM_MOUSEFIRST, WM_MOUSELAST,
+		                 PM_NOREMOVE)
+		        || msg.message != WM_MOUSEMOVE
+		        || !(msg.wParam & MK_LBUTTON))
+			break;
+		PeekMessage(&msg, hMainWnd, WM_MOUSEMOVE, WM_MOUSEMOVE, PM_REMOVE);
+		lParam = msg.lParam;
+	}
+
+	// Show the batch (or scroll to the last point on minimap)
+	if (MinimapDrag) {
+		ScrollToMinimap(lParam);
+	}
+	else if (RegionDrag) {
+		if (selectedFeature == IDM_REGION_PATH) {
+			FindShownPath();
+		}
+		else if (selectedFeature == IDM_REGION_VIEW) {
+			viewers.back() = regionEnd;
+		}
+		else if (selectedFeature == IDM_REGION_RANGE
+		         && (rangeTokens.back().x != regionEnd.x
+		             || rangeTokens.back().y != regionEnd.y)) {
+			rangeTokens.back() = regionEnd;
+			UpdateField();
+		}
+		UpdateEntireWindow();
+	}
+	else {
+		UpdateEditedCells();
+	}
+}
+
+// Get map position (pixels) of a mouse message
+POINT GetMapPointFromLParam(LPARAM lParam)
+{
+	return {
 		(LONG)(LOWORD(lParam) + GetHorzScrollPos()),
 		(LONG)(HIWORD(lParam) + GetVertScrollPos())
 	};
+}
+
+/*
+	Apply the selected tool along a line between two map points,
+	not counting the first (done already), so a fast drag skips
+	no cells. Floors & objects step cell by cell (Bresenham's line);
+	walls step pixel by pixel, as WallSelect() finds the nearest edge.
+*/
+void StrokeLine(POINT from, POINT to)
+{
+	bool walls = (GetWallTypeFromMenu(selectedFeature) != WALL_FAIL);
+	int step = walls ? 1 : GetGridSize();
+	int x = from.x / step, y = from.y / step;
+	int x1 = to.x / step, y1 = to.y / step;
+	int dx = abs(x1 - x), sx = (x < x1 ? 1 : -1);
+	int dy = -abs(y1 - y), sy = (y < y1 ? 1 : -1);
+	int error = dx + dy;
+	while (x != x1 || y != y1) {
+		int error2 = error * 2;
+		if (error2 >= dy) {
+			error += dy;
+			x += sx;
+		}
+		if (error2 <= dx) {
+			error += dx;
+			y += sy;
+		}
+		ApplyTool({(LONG)(x * step + step / 2), (LONG)(y * step + step / 2)});
+	}
+}
 
+// Apply the selected tool at a map point (pixels)
+void ApplyTool(POINT p)
+{
 	// Handle if we're on map area
-	if (p.x < (LONG) gridmap->getWidthPixels() &&
-	        p.y < (LONG) gridmap->getHeightPixels()) {
+	if (p.x >= 0 && p.y >= 0
+	        && p.x < (LONG) gridmap->getWidthPixels()
+	        && p.y < (LONG) gridmap->getHeightPixels()) {
 
-		// Place floors
+		// Place floors (or flood fill basic floors)
 		FloorType floor = GetFloorTypeFromMenu(selectedFeature);
 		if (floor != FLOOR_FAIL) {
-			FloorSelect(floor, p);
+			if (FloodFillMode && selectedFeature <= END_BASIC_FLOOR_TOOLS)
+				FloodFillSelect(floor, p);
+			else
+				FloorSelect(floor, p);
 			return;
 		}
 
@@ -580,9 +1028,396 @@ void FloorSelect(FloorType floor, POINT p)
 			FillCell(gc);
 		}
 		else {
-			UpdateBkgdCell(gc);
+			RepaintCell(gc);
+		}
+	}
+}
+
+/*
+	Flood fill the region around a point with a floor,
+	up to walls & other floors, repainting it as one block.
+*/
+void FloodFillSelect(FloorType floor, POINT p)
+{
+	GridRect cells;
+	if (gridmap->floodFillFloor(GetGridCoordFromWindow(p), floor, cells)) {
+		RepaintCells(cells);
+	}
+}
+
+// Get cells in room or selection being dragged
+GridRect GetDragRect()
+{
+	return {
+		std::min(regionStart.x, regionEnd.x),
+		std::min(regionStart.y, regionEnd.y),
+		std::max(regionStart.x, regionEnd.x) + 1,
+		std::max(regionStart.y, regionEnd.y) + 1
+	};
+}
+
+// Get window pixels covered by a block of cells
+RECT GetWindowRectOfCells(GridRect cells)
+{
+	int gridSize = GetGridSize();
+	int hPos = GetHorzScrollPos();
+	int vPos = GetVertScrollPos();
+	return {
+		(LONG) (cells.left * gridSize - hPos),
+		(LONG) (cells.top * gridSize - vPos),
+		(LONG) (cells.right * gridSize - hPos),
+		(LONG) (cells.bottom * gridSize - vPos)
+	};
+}
+
+// Draw an outline around a block of cells
+void PaintRegionOutline(HDC hdc, GridRect cells, COLORREF color)
+{
+	RECT outline = GetWindowRectOfCells(cells);
+	HBRUSH brush = CreateSolidBrush(color);
+	FrameRect(hdc, &outline, brush);
+	DeleteObject(brush);
+}
+
+/*
+	Finish dragging out a block of cells: draw a room
+	(as one batch of edits), or make it the selection.
+	A measured path stays shown till the next, & a viewer
+	or range token stays where it was dropped.
+*/
+void FinishRegionDrag()
+{
+	RegionDrag = false;
+	if (selectedFeature == IDM_REGION_ROOM) {
+		RepaintCells(gridmap->drawRoom(GetDragRect(), FLOOR_OPEN, WALL_FILL));
+		UpdateEditedCells();
+	}
+	else if (selectedFeature == IDM_REGION_PATH
+	         || selectedFeature == IDM_REGION_VIEW
+	         || selectedFeature == IDM_REGION_RANGE) {
+		UpdateEntireWindow();
+	}
+	else {
+		selection = GetDragRect();
+		HaveSelection = true;
+		UpdateEntireWindow();
+	}
+}
+
+/*
+	Find a cheapest path between the ends of the path tool's drag
+	(as the map stands now) to show, by the door graph (built on
+	first use & kept up to date by edits).
+*/
+void FindShownPath()
+{
+	if (!mapRoutes) {
+		mapRoutes = new GridRoutes(*gridmap);
+		mapRoutes->build();
+	}
+	shownPathCost = mapRoutes->findPath(regionStart, regionEnd, shownPath);
+	HavePath = true;
+}
+
+/*
+	Draw the shown path through its cell centers,
+	labelled at the end with its length in squares.
+*/
+void PaintShownPath(HDC hdc)
+{
+	int gridSize = GetGridSize();
+	int hPos = GetHorzScrollPos();
+	int vPos = GetVertScrollPos();
+	std::vector<POINT> points;
+	for (GridCoord gc: shownPath) {
+		points.push_back({
+			(LONG) (gc.x * gridSize + gridSize / 2 - hPos),
+			(LONG) (gc.y * gridSize + gridSize / 2 - vPos)
+		});
+	}
+	HPEN pen = CreatePen(PS_SOLID, 3, PathColor);
+	HGDIOBJ oldPen = SelectObject(hdc, pen);
+	if (points.size() > 1) {
+		Polyline(hdc, points.data(), (int) points.size());
+	}
+	SelectObject(hdc, oldPen);
+	DeleteObject(pen);
+
+	// Label cost in squares (one per plain step)
+	std::ostringstream label;
+	if (shownPathCost == NO_PATH) {
+		label << "No path";
+	}
+	else {
+		label << shownPathCost / (double) MoveOptions().stepCost
+		      << " squares";
+	}
+	std::string text = label.str();
+	RECT end = GetWindowRectOfCells(
+	    {regionEnd.x, regionEnd.y, regionEnd.x + 1, regionEnd.y + 1});
+	SetBkMode(hdc, TRANSPARENT);
+	SetTextColor(hdc, PathColor);
+	TextOut(hdc, end.right, end.bottom, text.c_str(), (int) text.size());
+}
+
+/*
+	Put a viewer at the start of the viewer tool's drag,
+	in place of the others (or added to them), & show the fog.
+*/
+void PlaceViewer(bool add)
+{
+	if (!add) {
+		viewers.clear();
+	}
+	viewers.push_back(regionStart);
+	if (!FogOfWar) {
+		ToggleFogOfWar();
+	}
+}
+
+/*
+	Recast what the viewers see on the map as it stands.
+	Views take microseconds, so this is done on every paint
+	(& edits of any kind show at once). Called from
+	MyPaintWindow, so each paint also adds what is seen then
+	to the explored cells.
+*/
+void UpdateSight()
+{
+	if (!mapSight) {
+		mapSight = new GridSight(*gridmap);
+	}
+	mapSight->setViewpoints(viewers);
+}
+
+/*
+	Cover the cells in the window no viewer has seen in black,
+	& hatch those seen before but not now. Cells are taken in
+	runs along each row, so each run is one fill.
+*/
+void PaintFog(HDC hdc)
+{
+	GridRect view = GetCellsInWindow();
+	int hPos = GetHorzScrollPos();
+	int vPos = GetVertScrollPos();
+	HBRUSH unseenBrush = (HBRUSH) GetStockObject(BLACK_BRUSH);
+	HBRUSH exploredBrush = CreateHatchBrush(HS_DIAGCROSS, ExploredColor);
+	SetBkMode(hdc, TRANSPARENT);
+	for (unsigned y = view.top; y < view.bottom; y++) {
+		unsigned x = view.left;
+		while (x < view.right) {
+			bool explored = mapSight->isExplored({x, y});
+			bool visible = mapSight->isVisible({x, y});
+			unsigned end = x + 1;
+			while (end < view.right
+			        && mapSight->isExplored({end, y}) == explored
+			        && mapSight->isVisible({end, y}) == visible) {
+				end++;
+			}
+			if (!visible) {
+				RECT cells = {
+					GetShownPixel(x, hPos), GetShownPixel(y, vPos),
+					GetShownPixel(end, hPos), GetShownPixel(y + 1, vPos)
+				};
+				FillRect(hdc, &cells, explored ? exploredBrush : unseenBrush);
+			}
+			x = end;
+		}
+	}
+	DeleteObject(exploredBrush);
+}
+
+// Get the cells in the window (at the size shown)
+GridRect GetCellsInWindow()
+{
+	RECT rw;
+	GetClientRect(hMainWnd, &rw);
+	unsigned gridSize = GetGridSize();
+	unsigned shownSize = GetShownGridSize();
+	unsigned hPos = GetHorzScrollPos();
+	unsigned vPos = GetVertScrollPos();
+	return {
+		hPos / gridSize, vPos / gridSize,
+		std::min((hPos + rw.right * gridSize / shownSize) / gridSize + 1,
+		         gridmap->getWidthCells()),
+		std::min((vPos + rw.bottom * gridSize / shownSize) / gridSize + 1,
+		         gridmap->getHeightCells())
+	};
+}
+
+// Get window pixel of a cell boundary at the size shown
+LONG GetShownPixel(unsigned cells, int scrollPos)
+{
+	int gridSize = GetGridSize();
+	return (LONG) ((int) cells * gridSize - scrollPos)
+	       * (LONG) GetShownGridSize() / gridSize;
+}
+
+// Mark each viewer with a dot in its cell
+void PaintViewers(HDC hdc)
+{
+	HBRUSH brush = CreateSolidBrush(ViewerColor);
+	HGDIOBJ oldBrush = SelectObject(hdc, brush);
+	HGDIOBJ oldPen = SelectObject(hdc, GetStockObject(BLACK_PEN));
+	for (GridCoord gc: viewers) {
+		RECT cell = GetWindowRectOfCells({gc.x, gc.y, gc.x + 1, gc.y + 1});
+		int inset = (cell.right - cell.left) / 4;
+		Ellipse(hdc, cell.left + inset, cell.top + inset,
+		        cell.right - inset, cell.bottom - inset);
+	}
+	SelectObject(hdc, oldPen);
+	SelectObject(hdc, oldBrush);
+	DeleteObject(brush);
+}
+
+/*
+	Put a token at the start of the range tool's drag,
+	in place of the others (or added to them), & show how far
+	the tokens can move from there.
+*/
+void PlaceRangeToken(bool add)
+{
+	if (!add) {
+		rangeTokens.clear();
+	}
+	rangeTokens.push_back(regionStart);
+	if (FieldFromStairs) {
+		ToggleStairsDistances();
+	}
+	UpdateField();
+}
+
+/*
+	Find the distance field shown anew: the range of the tokens
+	(within MoveRangeSquares plain steps), or the distance from
+	all stairs over the whole map. Edits after keep it up to date
+	by updating around the cells edited (see UpdateEditedCells()).
+*/
+void UpdateField()
+{
+	if (!mapField) {
+		mapField = new GridField(*gridmap);
+	}
+	if (FieldFromStairs) {
+		std::vector<GridCoord> stairs;
+		for (unsigned x = 0; x < gridmap->getWidthCells(); x++) {
+			const GridCell *column = gridmap->getColumn(x);
+			for (unsigned y = 0; y < gridmap->getHeightCells(); y++) {
+				switch (column[y].floor) {
+					case FLOOR_NSTAIRS:
+					case FLOOR_WSTAIRS:
+					case FLOOR_SPIRALSTAIRS:
+						stairs.push_back({x, y});
+						break;
+				}
+			}
+		}
+		mapField->setSources(stairs);
+	}
+	else {
+		mapField->setSources(
+		    rangeTokens, MoveRangeSquares * MoveOptions().stepCost);
+	}
+	ShowField = true;
+}
+
+/*
+	Tint the cells in the window reached by the distance field,
+	green near to red far: over the range for tokens, or in bands
+	of FieldBandSquares repeating out from the stairs. Tinting
+	(pattern AND screen) keeps the map drawn beneath.
+*/
+void PaintField(HDC hdc)
+{
+	GridRect view = GetCellsInWindow();
+	int hPos = GetHorzScrollPos();
+	int vPos = GetVertScrollPos();
+	HBRUSH brushes[NumFieldColors];
+	for (int i = 0; i < NumFieldColors; i++) {
+		brushes[i] = CreateSolidBrush(FieldColors[i]);
+	}
+	HGDIOBJ oldBrush = SelectObject(hdc, brushes[0]);
+	for (unsigned y = view.top; y < view.bottom; y++) {
+		unsigned x = view.left;
+		while (x < view.right) {
+			int band = GetFieldBand({x, y});
+			unsigned end = x + 1;
+			while (end < view.right && GetFieldBand({end, y}) == band) {
+				end++;
+			}
+			if (band >= 0) {
+				LONG left = GetShownPixel(x, hPos);
+				LONG top = GetShownPixel(y, vPos);
+				SelectObject(hdc, brushes[band]);
+				PatBlt(hdc, left, top, GetShownPixel(end, hPos) - left,
+				       GetShownPixel(y + 1, vPos) - top, TintRop);
+			}
+			x = end;
 		}
 	}
+	SelectObject(hdc, oldBrush);
+	for (int i = 0; i < NumFieldColors; i++) {
+		DeleteObject(brushes[i]);
+	}
+}
+
+// Get the color band of a cell in the distance field (-1 if not reached)
+int GetFieldBand(GridCoord gc)
+{
+	unsigned distance = mapField->getDistance(gc);
+	unsigned limit = mapField->getLimit();
+	if (distance == NO_PATH)
+		return -1;
+	if (limit != NO_PATH)
+		return distance * NumFieldColors / (limit + 1);
+	return distance / (FieldBandSquares * MoveOptions().stepCost)
+	       % NumFieldColors;
+}
+
+// Mark each range token with a dot in its cell
+void PaintRangeTokens(HDC hdc)
+{
+	if (FieldFromStairs)
+		return;
+	HBRUSH brush = CreateSolidBrush(RangeTokenColor);
+	HGDIOBJ oldBrush = SelectObject(hdc, brush);
+	HGDIOBJ oldPen = SelectObject(hdc, GetStockObject(BLACK_PEN));
+	for (GridCoord gc: rangeTokens) {
+		RECT cell = GetWindowRectOfCells({gc.x, gc.y, gc.x + 1, gc.y + 1});
+		int inset = (cell.right - cell.left) / 4;
+		Ellipse(hdc, cell.left + inset, cell.top + inset,
+		        cell.right - inset, cell.bottom - inset);
+	}
+	SelectObject(hdc, oldPen);
+	SelectObject(hdc, oldBrush);
+	DeleteObject(brush);
+}
+
+/*
+	Number each room in the window at its label cell, in reading
+	order over the whole map (so numbers don't shift on scrolling).
+	Edits keep the rooms up to date (see UpdateEditedCells()).
+*/
+void PaintRoomNumbers(HDC hdc)
+{
+	GridRect view = GetCellsInWindow();
+	std::vector<unsigned> rooms;
+	mapRooms->getRoomOrder(rooms);
+	SetBkMode(hdc, TRANSPARENT);
+	SetTextColor(hdc, RoomNumberColor);
+	for (unsigned i = 0; i < rooms.size(); i++) {
+		GridCoord gc = mapRooms->getSegmentInfo(rooms[i]).label;
+		if (gc.x < view.left || gc.x >= view.right
+		        || gc.y < view.top || gc.y >= view.bottom) {
+			continue;
+		}
+		std::ostringstream number;
+		number << i + 1;
+		std::string text = number.str();
+		RECT cell = GetWindowRectOfCells({gc.x, gc.y, gc.x + 1, gc.y + 1});
+		DrawText(hdc, text.c_str(), (int) text.size(), &cell,
+		         DT_CENTER | DT_VCENTER | DT_SINGLELINE | DT_NOCLIP);
+	}
 }
 
 void ObjectSelect(ObjectType object, POINT p)
@@ -591,7 +1426,7 @@ void ObjectSelect(ObjectType object, POINT p)
 	if (gridmap->getCellFloor(gc) != FLOOR_FILL
 	        && gridmap->getCellObject(gc) != object) {
 		gridmap->setCellObject(gc, object);
-		UpdateBkgdCell(gc);
+		RepaintCell(gc);
 	}
 }
 
@@ -632,8 +1467,8 @@ void ChangeWestWall(GridCoord gc, int newFeature)
 	if (gridmap->canBuildWWall(gc)
 	        && gridmap->getCellWWall(gc) != newFeature) {
 		gridmap->setCellWWall(gc, newFeature);
-		UpdateBkgdCell({gc.x-1, gc.y});
-		UpdateBkgdCell(gc);
+		RepaintCell({gc.x-1, gc.y});
+		RepaintCell(gc);
 	}
 }
 
@@ -642,16 +1477,22 @@ void ChangeNorthWall(GridCoord gc, int newFeature)
 	if (gridmap->canBuildNWall(gc)
 	        && gridmap->getCellNWall(gc) != newFeature) {
 		gridmap->setCellNWall(gc, newFeature);
-		UpdateBkgdCell({gc.x, gc.y-1});
-		UpdateBkgdCell(gc);
+		RepaintCell({gc.x, gc.y-1});
+		RepaintCell(gc);
 	}
 }
 
 void ClearMap(bool open)
 {
 	gridmap->clearMap(open ? FLOOR_OPEN : FLOOR_FILL);
-	gridmap->paint(BkgdDC);
-	UpdateEntireWindow();
+	if (ShowField) {
+		UpdateField();
+	}
+	if (NumberRooms) {
+		mapRooms->build();
+	}
+	RebuildMinimap();
+	RepaintMap();
 	SetSelectedFeature(open ? IDM_FLOOR_FILL : IDM_FLOOR_OPEN);
 }
 
@@ -662,27 +1503,84 @@ void ToggleGridLines()
 	CheckMenuItem(
 	    GetMenu(hMainWnd), IDM_HIDE_GRID,
 	    MF_BYCOMMAND | (hideGrid ? MF_CHECKED : MF_UNCHECKED));
-	SetBkgdDC();
-	UpdateEntireWindow();
+	RepaintMap();
 }
 
-void ToggleRoughEdges()
+// Show or hide the fog over what the viewers can't see
+void ToggleFogOfWar()
 {
-	gridmap->toggleRoughEdges();
-	bool roughEdges = gridmap->displayRoughEdges();
+	FogOfWar = !FogOfWar;
 	CheckMenuItem(
-	    GetMenu(hMainWnd), IDM_ROUGH_EDGES,
-	    MF_BYCOMMAND | (roughEdges ? MF_CHECKED : MF_UNCHECKED));
-	SetBkgdDC();
+	    GetMenu(hMainWnd), IDM_FOG_OF_WAR,
+	    MF_BYCOMMAND | (FogOfWar ? MF_CHECKED : MF_UNCHECKED));
 	UpdateEntireWindow();
 }
 
-/*
-	Perform a space-filling operation.
-	The new cell floor should be set before calling this function.
-	Now we need to wipe out any object, wipe ineligible adjacent walls,
-	and repaint all adjacent cells.
-*/
+// Forget what the viewers have seen, save what they see now
+void ResetExplored()
+{
+	if (mapSight) {
+		mapSight->clearExplored();
+		UpdateEntireWindow();
+	}
+}
+
+// Show or hide the distance from all stairs (in place of any range)
+void ToggleStairsDistances()
+{
+	FieldFromStairs = !FieldFromStairs;
+	CheckMenuItem(
+	    GetMenu(hMainWnd), IDM_STAIRS_DISTANCES,
+	    MF_BYCOMMAND | (FieldFromStairs ? MF_CHECKED : MF_UNCHECKED));
+	if (FieldFromStairs) {
+		UpdateField();
+	}
+	else {
+		ShowField = false;
+	}
+	UpdateEntireWindow();
+}
+
+// Show or hide room numbers (found afresh when shown)
+void ToggleRoomNumbers()
+{
+	NumberRooms = !NumberRooms;
+	CheckMenuItem(
+	    GetMenu(hMainWnd), IDM_NUMBER_ROOMS,
+	    MF_BYCOMMAND | (NumberRooms ? MF_CHECKED : MF_UNCHECKED));
+	if (NumberRooms) {
+		if (!mapRooms) {
+			mapRooms = new GridRooms(*gridmap);
+		}
+		mapRooms->build();
+	}
+	UpdateEntireWindow();
+}
+
+void ToggleFloodFill()
+{
+	FloodFillMode = !FloodFillMode;
+	CheckMenuItem(
+	    GetMenu(hMainWnd), IDM_FLOOD_FILL,
+	    MF_BYCOMMAND | (FloodFillMode ? MF_CHECKED : MF_UNCHECKED));
+}
+
+void ToggleRoughEdges()
+{
+	gridmap->toggleRoughEdges();
+	bool roughEdges = gridmap->displayRoughEdges();
+	CheckMenuItem(
+	    GetMenu(hMainWnd), IDM_ROUGH_EDGES,
+	    MF_BYCOMMAND | (roughEdges ? MF_CHECKED : MF_UNCHECKED));
+	RepaintMap();
+}
+
+/*
+	Perform a space-filling operation.
+	The new cell floor should be set before calling this function.
+	Now we need to wipe out any object, wipe ineligible adjacent walls,
+	and repaint all adjacent cells.
+*/
 void FillCell(GridCoord gc)
 {
 	// Get height & width
@@ -703,21 +1601,18 @@ void FillCell(GridCoord gc)
 
 	// Repaint prior cells
 	if (gc.x > 0)
-		gridmap->paintCell({gc.x-1, gc.y}, true);
+		RepaintCell({gc.x-1, gc.y});
 	if (gc.y > 0)
-		gridmap->paintCell({gc.x, gc.y-1}, true);
+		RepaintCell({gc.x, gc.y-1});
 
 	// Paint this cell
-	gridmap->paintCell(gc, true);
+	RepaintCell(gc);
 
 	// Repaint later cells
 	if (gc.x+1 < width)
-		gridmap->paintCell({gc.x+1, gc.y}, true);
+		RepaintCell({gc.x+1, gc.y});
 	if (gc.y+1 < height)
-		gridmap->paintCell({gc.x, gc.y+1}, true);
-
-	// Update window
-	UpdateEntireWindow();
+		RepaintCell({gc.x, gc.y+1});
 }
 
 // Map a menu item to a grid map floor feature
@@ -801,6 +1696,304 @@ ObjectType GetObjectTypeFromMenu(int menuID)
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Minimap functions
+//-----------------------------------------------------------------------------
+
+/*
+	Rebuild the minimap from the whole map.
+	Single cell edits update it in RepaintCell() instead.
+*/
+void RebuildMinimap()
+{
+	MakeThumbnail(*gridmap, MinimapMaxSize, MinimapMaxSize, minimap);
+}
+
+// Get minimap position in client area (bottom-right corner)
+RECT GetMinimapRect()
+{
+	RECT rw;
+	GetClientRect(hMainWnd, &rw);
+	RECT rm = {
+		rw.right - MinimapMargin - (LONG) minimap.width,
+		rw.bottom - MinimapMargin - (LONG) minimap.height,
+		rw.right - MinimapMargin,
+		rw.bottom - MinimapMargin
+	};
+	return rm;
+}
+
+// Is the minimap shown (window big enough)?
+bool IsMinimapShown()
+{
+	RECT rm = GetMinimapRect();
+	return !minimap.pixels.empty()
+	       && rm.left >= MinimapMargin && rm.top >= MinimapMargin;
+}
+
+// Is a client-area mouse position on the minimap?
+bool IsOnMinimap(LPARAM lParam)
+{
+	if (!gridmap || !IsMinimapShown())
+		return false;
+	RECT rm = GetMinimapRect();
+	int x = (short) LOWORD(lParam);
+	int y = (short) HIWORD(lParam);
+	return x >= rm.left && x < rm.right && y >= rm.top && y < rm.bottom;
+}
+
+// Convert map pixels to minimap pixels
+int MapToMinimap(int mapPixels)
+{
+	return (int) ((long long) mapPixels * minimap.cellPixels
+	              / (minimap.blockCells * GetGridSize()));
+}
+
+/*
+	Paint the minimap over the window's bottom-right corner,
+	with a frame & a box showing the part of the map in view.
+	Pixels are drawn straight from the gray thumbnail (no scaling).
+*/
+void PaintMinimap(HDC hdc)
+{
+	if (!IsMinimapShown())
+		return;
+	RECT rm = GetMinimapRect();
+
+	// Set up top-down 8-bit gray bitmap header
+	struct {
+		BITMAPINFOHEADER bmiHeader;
+		RGBQUAD bmiColors[256];
+	} info;
+	info.bmiHeader = {
+		sizeof(BITMAPINFOHEADER), (LONG) minimap.width,
+		-(LONG) minimap.height, 1, 8, BI_RGB, 0, 0, 0, 256, 0
+	};
+	for (int i = 0; i < 256; i++) {
+		info.bmiColors[i] = {(BYTE) i, (BYTE) i, (BYTE) i, 0};
+	}
+
+	// Draw thumbnail & frame
+	SetDIBitsToDevice(
+	    hdc, rm.left, rm.top, minimap.width, minimap.height,
+	    0, 0, 0, minimap.height, minimap.pixels.data(),
+	    (BITMAPINFO *) &info, DIB_RGB_COLORS);
+	RECT frame = {rm.left - 1, rm.top - 1, rm.right + 1, rm.bottom + 1};
+	FrameRect(hdc, &frame, (HBRUSH) GetStockObject(BLACK_BRUSH));
+
+	// Draw box around area in view
+	RECT rw;
+	GetClientRect(hMainWnd, &rw);
+	int left = MapToMinimap(GetHorzScrollPos());
+	int top = MapToMinimap(GetVertScrollPos());
+	RECT view = {
+		rm.left + left, rm.top + top,
+		std::min(rm.left + left + MapToMinimap(rw.right) + 1, rm.right),
+		std::min(rm.top + top + MapToMinimap(rw.bottom) + 1, rm.bottom)
+	};
+	HBRUSH viewBrush = CreateSolidBrush(MinimapViewColor);
+	FrameRect(hdc, &view, viewBrush);
+	DeleteObject(viewBrush);
+}
+
+/*
+	Scroll so the view is centered on a minimap position.
+	Used for clicks & drags starting on the minimap.
+*/
+void ScrollToMinimap(LPARAM lParam)
+{
+	// Find map pixel under mouse
+	RECT rw, rm = GetMinimapRect();
+	GetClientRect(hMainWnd, &rw);
+	int x = (short) LOWORD(lParam) - rm.left;
+	int y = (short) HIWORD(lParam) - rm.top;
+	int scale = minimap.blockCells * GetGridSize();
+	int mapX = x * scale / (int) minimap.cellPixels;
+	int mapY = y * scale / (int) minimap.cellPixels;
+
+	// Set scrollbars (clamped by Windows)
+	SCROLLINFO info = {
+		sizeof(SCROLLINFO), SIF_POS, 0, 0, 0, 0, 0
+	};
+	info.nPos = mapX - rw.right / 2;
+	SetScrollInfo(hMainWnd, SB_HORZ, &info, true);
+	info.nPos = mapY - rw.bottom / 2;
+	SetScrollInfo(hMainWnd, SB_VERT, &info, true);
+	UpdateEntireWindow();
+}
+
+//-----------------------------------------------------------------------------
+// Background painting & zoom functions
+//-----------------------------------------------------------------------------
+
+/*
+	Blit tiles finished by the tile renderer onto the background,
+	and redraw them on screen.
+*/
+void TilesDone()
+{
+	int hPos = GetHorzScrollPos();
+	int vPos = GetVertScrollPos();
+	HDC tileDC = CreateCompatibleDC(BkgdDC);
+	TileResult tile;
+	while (tileRenderer->takeTile(tile)) {
+		HGDIOBJ oldBitmap = SelectObject(tileDC, tile.hBitmap);
+		BitBlt(
+		    BkgdDC, tile.left, tile.top, tile.width, tile.height,
+		    tileDC, 0, 0, SRCCOPY);
+		SelectObject(tileDC, oldBitmap);
+		DeleteObject(tile.hBitmap);
+		RECT rt = {
+			tile.left - hPos, tile.top - vPos,
+			tile.left + tile.width - hPos, tile.top + tile.height - vPos
+		};
+		InvalidateRect(hMainWnd, &rt, false);
+	}
+	DeleteDC(tileDC);
+
+	// Drop zoom preview once the view is all painted
+	RECT rw;
+	GetClientRect(hMainWnd, &rw);
+	if (PreviewDC && tileRenderer->isAreaShown(
+	            hPos, vPos, hPos + rw.right, vPos + rw.bottom)) {
+		DropPreview();
+	}
+}
+
+/*
+	Cover tiles in view not painted yet: with the bitmap from
+	before a zoom, stretched to fit, or else plain gray.
+*/
+void PaintPlaceholders(HDC hdc, RECT rw)
+{
+	int tilePixels = tileRenderer->getTilePixels();
+	if (tilePixels == 0)
+		return;
+	long long gridSize = GetGridSize();
+	int hPos = GetHorzScrollPos();
+	int vPos = GetVertScrollPos();
+	int right =
+	    std::min((int) (hPos + rw.right), (int) gridmap->getWidthPixels());
+	int bottom =
+	    std::min((int) (vPos + rw.bottom), (int) gridmap->getHeightPixels());
+	SetStretchBltMode(hdc, COLORONCOLOR);
+	for (int top = vPos / tilePixels * tilePixels; top < bottom;
+	        top += tilePixels) {
+		for (int left = hPos / tilePixels * tilePixels; left < right;
+		        left += tilePixels) {
+			if (tileRenderer->isTileShown(
+			            left / tilePixels, top / tilePixels))
+				continue;
+			int width = std::min(left + tilePixels, right) - left;
+			int height = std::min(top + tilePixels, bottom) - top;
+			if (PreviewDC) {
+				StretchBlt(
+				    hdc, left - hPos, top - vPos, width, height, PreviewDC,
+				    (int) (left * previewSize / gridSize),
+				    (int) (top * previewSize / gridSize),
+				    (int) (width * previewSize / gridSize),
+				    (int) (height * previewSize / gridSize), SRCCOPY);
+			}
+			else {
+				RECT rt = {
+					left - hPos, top - vPos,
+					left - hPos + width, top - vPos + height
+				};
+				FillRect(hdc, &rt, (HBRUSH) GetStockObject(LTGRAY_BRUSH));
+			}
+		}
+	}
+}
+
+/*
+	Keep the background bitmap as a stand-in for tiles not yet
+	painted after a zoom (unless we're still keeping an older one).
+*/
+void KeepPreview()
+{
+	if (PreviewDC || !BkgdBitmap)
+		return;
+	PreviewDC = BkgdDC;
+	PreviewBitmap = BkgdBitmap;
+	previewSize = GetGridSize();
+	BkgdDC = NULL;
+	BkgdBitmap = NULL;
+}
+
+// Delete any zoom preview bitmap
+void DropPreview()
+{
+	if (PreviewDC) {
+		DeleteDC(PreviewDC);
+		DeleteObject(PreviewBitmap);
+		PreviewDC = NULL;
+		PreviewBitmap = NULL;
+	}
+}
+
+// Repaint the whole map in the background (same size bitmap)
+void RepaintMap()
+{
+	DropPreview();
+	tileRenderer->setMap(*gridmap, true);
+	UpdateEntireWindow();
+}
+
+// Get cell size on screen (zoom target while it settles)
+unsigned GetShownGridSize()
+{
+	return zoomTarget ? zoomTarget : GetGridSize();
+}
+
+/*
+	Zoom to a new cell size without blocking.
+	The current bitmap is shown stretched at once, and the new size
+	is applied once the wheel settles, so a fast spin only starts
+	painting the final size.
+*/
+void ZoomGridSize(unsigned size)
+{
+	zoomTarget = (size == GetGridSize() ? 0 : size);
+	if (zoomTarget)
+		SetTimer(hMainWnd, ZoomSettleTimer, ZoomSettleMs, NULL);
+	else
+		KillTimer(hMainWnd, ZoomSettleTimer);
+	UpdateEntireWindow();
+}
+
+/*
+	Apply any zoom still settling (also before the map is edited,
+	so edits act at the size shown).
+	Keeps the top-left corner of the view on the same map point.
+*/
+void CompleteZoom()
+{
+	KillTimer(hMainWnd, ZoomSettleTimer);
+	if (!zoomTarget)
+		return;
+	unsigned oldSize = GetGridSize();
+	unsigned newSize = zoomTarget;
+	unsigned long long hPos = GetHorzScrollPos();
+	unsigned long long vPos = GetVertScrollPos();
+	zoomTarget = 0;
+	ChangeGridSize(newSize);
+	SCROLLINFO info = {
+		sizeof(SCROLLINFO), SIF_POS, 0, 0, 0, 0, 0
+	};
+	info.nPos = (int) (hPos * newSize / oldSize);
+	SetScrollInfo(hMainWnd, SB_HORZ, &info, true);
+	info.nPos = (int) (vPos * newSize / oldSize);
+	SetScrollInfo(hMainWnd, SB_VERT, &info, true);
+	UpdateEntireWindow();
+}
+
+// Cancel any zoom still settling, keeping the current size
+void CancelZoom()
+{
+	KillTimer(hMainWnd, ZoomSettleTimer);
+	zoomTarget = 0;
+}
+
 //-----------------------------------------------------------------------------
 // Menu actions
 //-----------------------------------------------------------------------------
@@ -827,6 +2020,25 @@ void SetSelectedFeature(int feature)
 	CheckMenuRadioItem(
 	    hObjectsMenu, START_OBJECT_TOOLS, END_OBJECT_TOOLS,
 	    feature, MF_BYCOMMAND);
+
+	// Region tools
+	for (int tool = IDM_REGION_ROOM; tool <= IDM_REGION_RANGE; tool++) {
+		CheckMenuItem(
+		    hMenu, tool,
+		    MF_BYCOMMAND | (feature == tool ? MF_CHECKED : MF_UNCHECKED));
+	}
+
+	// Measured path goes with its tool
+	if (HavePath && feature != IDM_REGION_PATH) {
+		HavePath = false;
+		UpdateEntireWindow();
+	}
+
+	// As does a movement range
+	if (ShowField && !FieldFromStairs && feature != IDM_REGION_RANGE) {
+		ShowField = false;
+		UpdateEntireWindow();
+	}
 }
 
 bool OkDiscardChanges()
@@ -840,6 +2052,7 @@ bool OkDiscardChanges()
 	return (retval == IDOK);
 }
 
+// Make a new background bitmap, painted by the tile renderer
 void SetBkgdDC()
 {
 	DeleteObject(BkgdDC);
@@ -852,7 +2065,6 @@ void SetBkgdDC()
 	        gridmap->getHeightPixels());
 	if (BkgdBitmap) {
 		SelectObject(BkgdDC, BkgdBitmap);
-		gridmap->paint(BkgdDC);
 	}
 	else {
 		MessageBox(
@@ -860,10 +2072,12 @@ void SetBkgdDC()
 		    "\nMap will not display; try smaller grid size?",
 		    "Map Too Large", MB_OK|MB_ICONERROR);
 	}
+	tileRenderer->setMap(*gridmap);
 }
 
 void ChangeGridSize(int size)
 {
+	KeepPreview();
 	gridmap->setCellSizePixels(size);
 	SetBkgdDC();
 	SetScrollRange(true);
@@ -876,6 +2090,23 @@ void SetNewMap(GridMap *newmap)
 		delete gridmap;
 	}
 	gridmap = newmap;
+	HaveSelection = false;
+	HavePath = false;
+	delete mapRoutes;
+	mapRoutes = NULL;
+	delete mapSight;
+	mapSight = NULL;
+	viewers.clear();
+	delete mapField;
+	mapField = NULL;
+	ShowField = false;
+	FieldFromStairs = false;
+	rangeTokens.clear();
+	delete mapRooms;
+	mapRooms = NULL;
+	NumberRooms = false;
+	RebuildMinimap();
+	DropPreview();
 	SetBkgdDC();
 	SetScrollRange(true);
 	UpdateEntireWindow();
@@ -887,6 +2118,8 @@ void SetNewMap(GridMap *newmap)
 	              (gridmap->displayNoGrid() ? MF_CHECKED : MF_UNCHECKED));
 	CheckMenuItem(hMenu, IDM_ROUGH_EDGES, MF_BYCOMMAND |
 	              (gridmap->displayRoughEdges() ? MF_CHECKED : MF_UNCHECKED));
+	CheckMenuItem(hMenu, IDM_STAIRS_DISTANCES, MF_BYCOMMAND | MF_UNCHECKED);
+	CheckMenuItem(hMenu, IDM_NUMBER_ROOMS, MF_BYCOMMAND | MF_UNCHECKED);
 }
 
 bool NewMapFromSpecs(int newWidth, int newHeight)
@@ -963,18 +2196,75 @@ void SaveMap()
 		SaveMapAs();
 }
 
+/*
+	Export map image at full resolution.
+	Painted in bands straight to file, so this works even
+	when the map is too large for the background bitmap.
+*/
+void ExportMap()
+{
+	// Ask for image filename & type
+	char filename[GRID_FILENAME_MAX] = "\0";
+	OPENFILENAME info = {
+		sizeof(OPENFILENAME), hMainWnd, 0,
+		ExportFilterStr, 0, 0, 1, filename, GRID_FILENAME_MAX,
+		0, 0, 0, 0, OFN_OVERWRITEPROMPT, 0, 0, "png", 0, 0, 0
+	};
+	if (!GetSaveFileName(&info))
+		return;
+
+	// Export with progress in title bar
+	const char *format =
+	    info.nFilterIndex == 3 ? "svg" :
+	    info.nFilterIndex == 2 ? "tif" : "png";
+	HCURSOR oldCursor = SetCursor(LoadCursor(NULL, IDC_WAIT));
+	ExportResult result =
+	    ExportMapImage(
+	        *gridmap, filename, format, EXPORT_BUDGET_DEFAULT,
+	        ExportProgress, NULL);
+	SetCursor(oldCursor);
+	SetWindowText(hMainWnd, szTitle);
+	if (result != EXPORT_OK) {
+		MessageBox(
+		    hMainWnd, GetExportResultText(result), "Export Error",
+		    MB_OK|MB_ICONERROR);
+	}
+}
+
+// Show export progress in title bar
+bool ExportProgress(
+    void *data, unsigned long long rowsDone, unsigned long long rowsTotal)
+{
+	char title[MAX_LOADSTRING + 32];
+	sprintf_s(
+	    title, sizeof(title), "%s - Exporting %d%%",
+	    szTitle, (int) (rowsDone * 100 / rowsTotal));
+	SetWindowText(hMainWnd, title);
+	return true;
+}
+
 void CopyMap()
 {
+	// Copy just the cells selected, if any
+	if (HaveSelection) {
+		CopySelection();
+		return;
+	}
+
 	// Create bitmap with map image
+	// (painted here, as background tiles may still be pending)
 	HDC tempDC = CreateCompatibleDC(GetDC(hMainWnd));
 	HBITMAP hBitmap =
 	    CreateCompatibleBitmap(
 	        GetDC(hMainWnd),
 	        gridmap->getWidthPixels(), gridmap->getHeightPixels());
 	SelectObject(tempDC, hBitmap);
-	BitBlt(
-	    tempDC, 0, 0, gridmap->getWidthPixels(),
-	    gridmap->getHeightPixels(), BkgdDC, 0, 0, SRCCOPY);
+	{
+		GdiCanvas canvas(tempDC);
+		gridmap->paintRegion(
+		    canvas, 0, 0, gridmap->getWidthCells(),
+		    gridmap->getHeightCells());
+	}
 
 	// Put it on the clipboard
 	OpenClipboard(hMainWnd);
@@ -986,6 +2276,404 @@ void CopyMap()
 	DeleteDC(tempDC);
 }
 
+/*
+	Copy the selected cells to the clipboard: as cell data,
+	for pasting into this or another map, and as an image.
+	Cell data is the block size, then the cells (column-major),
+	then its east & south edge walls.
+*/
+void CopySelection()
+{
+	// Pack cells in global memory
+	CellBlock block;
+	gridmap->copyCells(selection, block);
+	size_t cellBytes = block.cells.size() * sizeof(GridCell);
+	HGLOBAL hCells = GlobalAlloc(
+	    GMEM_MOVEABLE,
+	    2 * sizeof(unsigned) + cellBytes + block.height + block.width);
+	if (!hCells)
+		return;
+	unsigned char *data = (unsigned char *) GlobalLock(hCells);
+	memcpy(data, &block.width, sizeof(unsigned));
+	memcpy(data + sizeof(unsigned), &block.height, sizeof(unsigned));
+	data += 2 * sizeof(unsigned);
+	memcpy(data, block.cells.data(), cellBytes);
+	memcpy(data + cellBytes, block.eastWalls.data(), block.height);
+	memcpy(data + cellBytes + block.height, block.southWalls.data(),
+	       block.width);
+	GlobalUnlock(hCells);
+
+	// Paint image of the selected cells
+	unsigned gridSize = GetGridSize();
+	HDC screenDC = GetDC(hMainWnd);
+	HDC tempDC = CreateCompatibleDC(screenDC);
+	HBITMAP hBitmap = CreateCompatibleBitmap(
+	    screenDC, block.width * gridSize, block.height * gridSize);
+	ReleaseDC(hMainWnd, screenDC);
+	HGDIOBJ oldBitmap = SelectObject(tempDC, hBitmap);
+	{
+		GdiCanvas canvas(tempDC);
+		canvas.setOrigin(selection.left * gridSize, selection.top * gridSize);
+		canvas.setClip(0, 0, block.width * gridSize, block.height * gridSize);
+		gridmap->paintRegion(
+		    canvas, selection.left, selection.top,
+		    selection.left + block.width, selection.top + block.height);
+	}
+	SelectObject(tempDC, oldBitmap);
+	DeleteDC(tempDC);
+
+	// Put both on the clipboard
+	OpenClipboard(hMainWnd);
+	EmptyClipboard();
+	SetClipboardData(CellClipFormat, hCells);
+	SetClipboardData(CF_BITMAP, hBitmap);
+	CloseClipboard();
+}
+
+/*
+	Paste cells from the clipboard at the top-left of the
+	selection (or of the view, if none), as one batch of edits.
+	The pasted cells become the selection.
+*/
+void PasteCells()
+{
+	// Unpack cells (checking size matches)
+	if (!IsClipboardFormatAvailable(CellClipFormat)
+	        || !OpenClipboard(hMainWnd))
+		return;
+	CellBlock block;
+	bool ok = false;
+	HGLOBAL hCells = GetClipboardData(CellClipFormat);
+	unsigned char *data =
+	    hCells ? (unsigned char *) GlobalLock(hCells) : NULL;
+	if (data) {
+		size_t size = GlobalSize(hCells);
+		if (size >= 2 * sizeof(unsigned)) {
+			memcpy(&block.width, data, sizeof(unsigned));
+			memcpy(&block.height, data + sizeof(unsigned), sizeof(unsigned));
+			size_t count = (size_t) block.width * block.height;
+			size_t cellBytes = count * sizeof(GridCell);
+			data += 2 * sizeof(unsigned);
+			ok = size >= 2 * sizeof(unsigned) + cellBytes
+			             + block.height + block.width;
+			if (ok) {
+				block.cells.resize(count);
+				memcpy(block.cells.data(), data, cellBytes);
+				block.eastWalls.assign(
+				    data + cellBytes, data + cellBytes + block.height);
+				block.southWalls.assign(
+				    data + cellBytes + block.height,
+				    data + cellBytes + block.height + block.width);
+			}
+		}
+		GlobalUnlock(hCells);
+	}
+	CloseClipboard();
+	if (!ok)
+		return;
+
+	// Paste & select
+	GridCoord at = HaveSelection
+	               ? GridCoord {selection.left, selection.top}
+	               : GridCoord {GetHorzScrollPos() / GetGridSize(),
+	                            GetVertScrollPos() / GetGridSize()};
+	GridRect edited = gridmap->pasteCells(block, at);
+	if (edited.right > edited.left) {
+		selection = {
+			at.x, at.y,
+			std::min(at.x + block.width, gridmap->getWidthCells()),
+			std::min(at.y + block.height, gridmap->getHeightCells())
+		};
+		HaveSelection = true;
+		RepaintCells(edited);
+		UpdateEditedCells();
+	}
+}
+
+/*
+	Rotate or mirror the selection, if any, else the whole map.
+*/
+void TransformMap(MapTransform transform)
+{
+	if (HaveSelection) {
+		TransformSelection(transform);
+		return;
+	}
+	int feature = selectedFeature;
+	SetNewMap(new GridMap(*gridmap, transform));
+	SetSelectedFeature(feature);
+}
+
+/*
+	Rotate or mirror the selected cells in place. A quarter turn
+	keeps the selection's center, so a non-square one sticks out
+	past it: that needs an okay to cover the cells outside, and
+	can't go off the map. Cells it leaves uncovered are filled in.
+	The transformed cells become the selection.
+*/
+void TransformSelection(MapTransform transform)
+{
+	// Place the transformed block
+	GridRect old = selection;
+	long long left = old.left, top = old.top;
+	long long width = old.right - old.left, height = old.bottom - old.top;
+	if (IsTransformTurn(transform)) {
+		left += (width - height) / 2;
+		top += (height - width) / 2;
+		std::swap(width, height);
+	}
+	if (left < 0 || top < 0
+	        || left + width > gridmap->getWidthCells()
+	        || top + height > gridmap->getHeightCells()) {
+		MessageBox(
+		    hMainWnd, "The turned selection would not fit on the map.",
+		    "Transform Selection", MB_OK|MB_ICONINFORMATION);
+		return;
+	}
+	GridRect moved = {
+		(unsigned) left, (unsigned) top,
+		(unsigned) (left + width), (unsigned) (top + height)
+	};
+	if (moved.left < old.left || moved.top < old.top
+	        || moved.right > old.right || moved.bottom > old.bottom) {
+		int retval =
+		    MessageBox(
+		        hMainWnd,
+		        "The turned selection covers cells outside it. "
+		        "Okay to replace them?",
+		        "Transform Selection", MB_OKCANCEL | MB_ICONWARNING);
+		if (retval != IDOK)
+			return;
+	}
+
+	// Transform a copy & paste it back
+	CellBlock block;
+	gridmap->copyCells(old, block);
+	TransformCellBlock(block, transform);
+	RepaintCells(gridmap->pasteCells(block, {moved.left, moved.top}));
+	selection = moved;
+
+	// Fill cells left uncovered
+	if (IsTransformTurn(transform) && width != height) {
+		GridRegion uncovered;
+		uncovered.bounds = old;
+		for (unsigned x = old.left; x < old.right; x++) {
+			for (unsigned y = old.top; y < old.bottom; y++) {
+				uncovered.mask.push_back(
+				    x < moved.left || x >= moved.right
+				    || y < moved.top || y >= moved.bottom);
+			}
+		}
+		RepaintCells(gridmap->fillFloor(uncovered, FLOOR_FILL));
+	}
+	UpdateEditedCells();
+}
+
+/*
+	Replace the map with a resized copy, keeping the tool selected.
+	Old cell (x, y) moves to (x + shiftX, y + shiftY).
+*/
+void ResizeMap(
+    unsigned newWidth, unsigned newHeight, int shiftX, int shiftY)
+{
+	int feature = selectedFeature;
+	SetNewMap(new GridMap(*gridmap, newWidth, newHeight, shiftX, shiftY));
+	SetSelectedFeature(feature);
+}
+
+// Crop the map to the selected cells
+void CropMap()
+{
+	if (!HaveSelection) {
+		MessageBox(
+		    hMainWnd, "Select an area to crop to first.", "Crop Map",
+		    MB_OK|MB_ICONINFORMATION);
+		return;
+	}
+	GridRect crop = selection;
+	ResizeMap(
+	    crop.right - crop.left, crop.bottom - crop.top,
+	    -(int) crop.left, -(int) crop.top);
+}
+
+// Crop the map to the block of cells with any contents
+void TrimMap()
+{
+	GridRect bounds = gridmap->getContentBounds();
+	if (bounds.right == 0) {
+		MessageBox(
+		    hMainWnd, "The map has no contents to trim to.", "Trim Map",
+		    MB_OK|MB_ICONINFORMATION);
+		return;
+	}
+	if (bounds.right - bounds.left < gridmap->getWidthCells()
+	        || bounds.bottom - bounds.top < gridmap->getHeightCells()) {
+		ResizeMap(
+		    bounds.right - bounds.left, bounds.bottom - bounds.top,
+		    -(int) bounds.left, -(int) bounds.top);
+	}
+}
+
+/*
+	Wall the selected cells (or the whole map) from their floors:
+	between floor & water, clearing walls no longer allowed, &
+	smoothing staircase edges into diagonal fills if asked.
+*/
+void AutoWallMap(bool smooth)
+{
+	GridRect all = {
+	    0, 0, gridmap->getWidthCells(), gridmap->getHeightCells()};
+	GridRegion region;
+	region.bounds = HaveSelection ? selection : all;
+	RepaintCells(gridmap->autoWall(region, WALL_FILL, smooth));
+	UpdateEditedCells();
+}
+
+/*
+	Edit the selected cells all at once: fill their floors,
+	clear their objects, or wall them all around.
+*/
+void EditSelection(int cmdId)
+{
+	if (!HaveSelection) {
+		MessageBox(
+		    hMainWnd, "Select an area to edit first.", "Edit Selection",
+		    MB_OK|MB_ICONINFORMATION);
+		return;
+	}
+	GridRegion region;
+	region.bounds = selection;
+	switch (cmdId) {
+		case IDM_FILL_FLOOR:
+			RepaintCells(gridmap->fillFloor(region, FLOOR_FILL));
+			break;
+		case IDM_CLEAR_OBJECTS:
+			RepaintCells(gridmap->clearObjects(region));
+			break;
+		case IDM_WALL_PERIMETER:
+			RepaintCells(gridmap->setPerimeterWalls(region, WALL_FILL));
+			break;
+	}
+	UpdateEditedCells();
+}
+
+/*
+	Replace the map with a new random cave of the same size,
+	keeping the tool selected.
+*/
+void GenerateCaveMap()
+{
+	CaveOptions options;
+	options.seed = (unsigned) time(NULL);
+	int feature = selectedFeature;
+	SetNewMap(
+	    GenerateCave(
+	        gridmap->getWidthCells(), gridmap->getHeightCells(), options));
+	SetSelectedFeature(feature);
+}
+
+/*
+	Replace the map with a new random dungeon of the same size,
+	keeping the tool selected.
+*/
+void GenerateDungeonMap()
+{
+	DungeonOptions options;
+	options.seed = (unsigned) time(NULL);
+	int feature = selectedFeature;
+	SetNewMap(
+	    GenerateDungeon(
+	        gridmap->getWidthCells(), gridmap->getHeightCells(), options));
+	SetSelectedFeature(feature);
+}
+
+/*
+	Replace the map with a new one of the same size
+	learned from a sample map the user picks,
+	keeping the tool selected.
+*/
+void GenerateSampleMap()
+{
+	// Ask for sample map
+	char filename[GRID_FILENAME_MAX] = "\0";
+	OPENFILENAME info = {
+		sizeof(OPENFILENAME), hMainWnd, 0,
+		FileFilterStr, 0, 0, 0, filename, GRID_FILENAME_MAX,
+		0, 0, 0, 0, 0, 0, 0, DefaultFileExt, 0, 0, 0
+	};
+	if (!GetOpenFileName(&info))
+		return;
+
+	// Learn patterns (all rotations & reflections: slower, but more
+	// varied, & maps here are small)
+	SampleOptions options;
+	options.seed = (unsigned) time(NULL);
+	options.symmetry = 8;
+	SamplePatterns patterns;
+	GridMap sample(filename);
+	if (!sample.isFileLoadOk()
+	        || !LearnPatterns(sample, options, patterns)) {
+		char msg[512];
+		sprintf_s(
+		    msg, sizeof(msg), "Could not learn from map file:\n%s",
+		    filename);
+		MessageBox(
+		    hMainWnd, msg, "Error", MB_OK|MB_ICONERROR);
+		return;
+	}
+
+	// Generate
+	GridMap *newmap = GenerateFromSample(
+	    patterns, gridmap->getWidthCells(), gridmap->getHeightCells(),
+	    options);
+	if (!newmap) {
+		char msg[512];
+		sprintf_s(
+		    msg, sizeof(msg), "Could not solve a map from:\n%s",
+		    filename);
+		MessageBox(
+		    hMainWnd, msg, "Error", MB_OK|MB_ICONERROR);
+		return;
+	}
+	int feature = selectedFeature;
+	SetNewMap(newmap);
+	SetSelectedFeature(feature);
+}
+
+/*
+	Report the separate open regions of the map, & how many
+	more there are with secret doors shut (so reached only
+	through secret doors).
+*/
+void CheckConnectivity()
+{
+	PassOptions options;
+	options.secretDoors = true;
+	GridRegions open(options);
+	open.labelMap(*gridmap);
+	options.secretDoors = false;
+	GridRegions shut(options);
+	shut.labelMap(*gridmap);
+	unsigned largest = 0;
+	for (unsigned label = 1; label < open.getLabelLimit(); label++) {
+		largest = std::max(largest, open.getRegionStats(label).cells);
+	}
+	char msg[256];
+	sprintf_s(
+	    msg, sizeof(msg),
+	    "Open regions: %u (largest %u cells)\n"
+	    "Reached only through secret doors: %u",
+	    open.getRegionCount(), largest,
+	    shut.getRegionCount() - open.getRegionCount());
+	MessageBox(
+	    hMainWnd, msg, "Connectivity", MB_OK|MB_ICONINFORMATION);
+}
+
+/*
+	Print map natively at printer resolution.
+	Maps larger than a page are split over several pages,
+	with an overlap strip & crop marks for assembly.
+*/
 void PrintMap()
 {
 	// Call print dialog
@@ -993,33 +2681,60 @@ void PrintMap()
 		sizeof(PRINTDLG), hMainWnd, 0, 0, 0,
 		PD_RETURNDC, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 	};
-	if (PrintDlg(&pd)) {
-
-		// Calculate print width in pixels
-		int printWidth =
-		    gridmap->getWidthPixels()
-		    * GetDeviceCaps(pd.hDC, LOGPIXELSX)
-		    / DefaultPrintSquaresPerInch
-		    / gridmap->getCellSizeDefault();
-
-		// Calculate print height in pixels
-		int printHeight =
-		    gridmap->getHeightPixels()
-		    * GetDeviceCaps(pd.hDC, LOGPIXELSY)
-		    / DefaultPrintSquaresPerInch
-		    / gridmap->getCellSizeDefault();
-
-		// Create the print job
-		DOCINFO di = {sizeof(DOCINFO), "GridMapper Document", 0, 0, 0};
-		StartDoc(pd.hDC, &di);
-		StartPage(pd.hDC);
-		StretchBlt(
-		    pd.hDC, 0, 0, printWidth, printHeight,
-		    BkgdDC, 0, 0, gridmap->getWidthPixels(),
-		    gridmap->getHeightPixels(), SRCCOPY);
-		EndPage(pd.hDC);
+	if (!PrintDlg(&pd))
+		return;
+
+	// Lay out pages (poster style if more than one)
+	int dpi = GetDeviceCaps(pd.hDC, LOGPIXELSX);
+	int pageWidth = GetDeviceCaps(pd.hDC, HORZRES);
+	int pageHeight = GetDeviceCaps(pd.hDC, VERTRES);
+	PrintLayout layout;
+	bool ok =
+	    MakePrintLayout(
+	        *gridmap, dpi, pageWidth, pageHeight, 0, false,
+	        EXPORT_BUDGET_DEFAULT, layout);
+	if (ok && GetPageCount(layout) > 1) {
+		ok = MakePrintLayout(
+		    *gridmap, dpi, pageWidth, pageHeight,
+		    (int) (dpi * PosterOverlapInches), true,
+		    EXPORT_BUDGET_DEFAULT, layout);
+	}
+	if (ok) {
+		ok = layout.cellSize >= GridMap::getCellSizeMin()
+		     && layout.cellSize <= GridMap::getCellSizeMax();
+	}
+	if (!ok) {
+		MessageBox(
+		    hMainWnd, "Could not fit map on printer pages.",
+		    "Print Error", MB_OK|MB_ICONERROR);
+		DeleteDC(pd.hDC);
+		return;
+	}
+
+	// Print each page band by band at device cell size,
+	// from a copy (sharing cells) so the editor map is untouched
+	GridMap printMap(*gridmap);
+	printMap.setCellSizePixels(layout.cellSize);
+	HCURSOR oldCursor = SetCursor(LoadCursor(NULL, IDC_WAIT));
+	DOCINFO di = {sizeof(DOCINFO), "GridMapper Document", 0, 0, 0};
+	if (StartDoc(pd.hDC, &di) > 0) {
+		GdiCanvas canvas(pd.hDC, layout.lineScale);
+		for (unsigned page = 0; page < GetPageCount(layout); page++) {
+			StartPage(pd.hDC);
+			for (int top = 0; top < layout.pageHeight;
+			        top += layout.bandRows) {
+				int bottom = top + layout.bandRows;
+				if (bottom > layout.pageHeight)
+					bottom = layout.pageHeight;
+				PaintPageBand(
+				    printMap, canvas, layout, page, top, bottom, 0);
+			}
+			EndPage(pd.hDC);
+		}
 		EndDoc(pd.hDC);
 	}
+	SetCursor(oldCursor);
+	DeleteDC(pd.hDC);
 }
 
 /*
@@ -1048,8 +2763,8 @@ void PrintMap()
   debug breakpoint as the "Print" dialog.
 
   If map is totally clear you'll notice lack of border on far right/bottom.
-  Fix requires making a new background image +1 size, getting pen &
-  drawing border, then StretchBlit that. Skipping that at this time.
+  Fix requires painting one extra pixel of border past the last cells
+  on each page. Skipping that at this time.
 -------------------------------------------------------------------------
 */
 
@@ -1087,6 +2802,64 @@ LRESULT CALLBACK NewDialog(
 }
 
 
+/*
+	"Resize Map" dialog box message handler.
+	The anchor is the side or corner the map grows or shrinks from
+	(IDC_ANCHOR_NW to IDC_ANCHOR_SE, by rows).
+*/
+LRESULT CALLBACK ResizeDialog(
+    HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
+{
+	switch (message) {
+
+		case WM_INITDIALOG:
+			SetDlgItemInt(
+			    hDlg, IDC_NEW_WIDTH, gridmap->getWidthCells(), FALSE);
+			SetDlgItemInt(
+			    hDlg, IDC_NEW_HEIGHT, gridmap->getHeightCells(), FALSE);
+			CheckRadioButton(
+			    hDlg, IDC_ANCHOR_NW, IDC_ANCHOR_SE, IDC_ANCHOR_NW);
+			return TRUE;
+
+		case WM_COMMAND:
+			int retval = LOWORD(wParam);
+			if (retval == IDOK) {
+				unsigned newWidth =
+				    GetDlgItemInt(hDlg, IDC_NEW_WIDTH, NULL, FALSE);
+				unsigned newHeight =
+				    GetDlgItemInt(hDlg, IDC_NEW_HEIGHT, NULL, FALSE);
+				if (newWidth == 0 || newHeight == 0) {
+					MessageBox(
+					    hDlg, "Map must be at least one square each way.",
+					    "Size Too Small", MB_OK|MB_ICONWARNING);
+					return TRUE;
+				}
+
+				// Shift cells by the anchor's share of the change
+				int anchor = 0;
+				while (anchor < 8 && !IsDlgButtonChecked(
+				           hDlg, IDC_ANCHOR_NW + anchor)) {
+					anchor++;
+				}
+				long long growX =
+				    (long long) newWidth - gridmap->getWidthCells();
+				long long growY =
+				    (long long) newHeight - gridmap->getHeightCells();
+				EndDialog(hDlg, retval);
+				ResizeMap(
+				    newWidth, newHeight, (int) (growX * (anchor % 3) / 2),
+				    (int) (growY * (anchor / 3) / 2));
+				return TRUE;
+			}
+			else if (retval == IDCANCEL) {
+				EndDialog(hDlg, retval);
+				return TRUE;
+			}
+			break;
+	}
+	return FALSE;
+}
+
 // "Set Grid Size" dialog box.message handler
 LRESULT CALLBACK GridSizeDialog(
     HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
@@ -19,7 +19,10 @@ unsigned GetGridSize();
 unsigned GetHorzScrollPos();
 unsigned GetVertScrollPos();
 void UpdateEntireWindow();
-void UpdateBkgdCell(GridCoord gc);
+void RepaintCell(GridCoord gc);
+void RepaintCells(GridRect cells);
+void UpdateEditedCells();
+void UpdateRoutes(GridRect edited);
 void SetScrollRange(bool zeroPos);
 void HorzScrollHandler(WPARAM wParam);
 void VertScrollHandler(WPARAM wParam);
@@ -27,7 +30,30 @@ void ScrollWheelHandler(WPARAM wParam);
 void MyKeyHandler(WPARAM wParam);
 void MyPaintWindow();
 void MyLButtonHandler(LPARAM lParam);
+void MyMouseDragHandler(LPARAM lParam);
+POINT GetMapPointFromLParam(LPARAM lParam);
+void StrokeLine(POINT from, POINT to);
+void ApplyTool(POINT p);
 void FloorSelect(FloorType floor, POINT p);
+void FloodFillSelect(FloorType floor, POINT p);
+GridRect GetDragRect();
+RECT GetWindowRectOfCells(GridRect cells);
+void PaintRegionOutline(HDC hdc, GridRect cells, COLORREF color);
+void FinishRegionDrag();
+void FindShownPath();
+void PaintShownPath(HDC hdc);
+void PlaceViewer(bool add);
+void UpdateSight();
+void PaintFog(HDC hdc);
+LONG GetShownPixel(unsigned cells, int scrollPos);
+void PaintViewers(HDC hdc);
+GridRect GetCellsInWindow();
+void PlaceRangeToken(bool add);
+void UpdateField();
+void PaintField(HDC hdc);
+int GetFieldBand(GridCoord gc);
+void PaintRangeTokens(HDC hdc);
+void PaintRoomNumbers(HDC hdc);
 void ObjectSelect(ObjectType object, POINT p);
 void WallSelect(WallType wall, POINT p);
 void ChangeWestWall(GridCoord gc, int newFeature);
@@ -44,10 +70,48 @@ bool NewMapFromFile(char *filename);
 void OpenMap();
 void SaveMapAs();
 void SaveMap();
+void ExportMap();
+bool ExportProgress(
+    void *data, unsigned long long rowsDone, unsigned long long rowsTotal);
 void CopyMap();
+void CopySelection();
+void PasteCells();
+void TransformMap(MapTransform transform);
+void TransformSelection(MapTransform transform);
+void ResizeMap(
+    unsigned newWidth, unsigned newHeight, int shiftX, int shiftY);
+void CropMap();
+void TrimMap();
+void AutoWallMap(bool smooth);
+void EditSelection(int cmdId);
+void GenerateCaveMap();
+void GenerateDungeonMap();
+void GenerateSampleMap();
+void CheckConnectivity();
 void PrintMap();
+void RebuildMinimap();
+RECT GetMinimapRect();
+bool IsMinimapShown();
+bool IsOnMinimap(LPARAM lParam);
+int MapToMinimap(int mapPixels);
+void PaintMinimap(HDC hdc);
+void ScrollToMinimap(LPARAM lParam);
+void TilesDone();
+void PaintPlaceholders(HDC hdc, RECT rw);
+void KeepPreview();
+void DropPreview();
+void RepaintMap();
+unsigned GetShownGridSize();
+void ZoomGridSize(unsigned size);
+void CompleteZoom();
+void CancelZoom();
 void ToggleGridLines();
 void ToggleRoughEdges();
+void ToggleFloodFill();
+void ToggleFogOfWar();
+void ResetExplored();
+void ToggleStairsDistances();
+void ToggleRoomNumbers();
 void DestroyObjects();
 bool ProcessCommand(int cmdId);
 GridCoord GetGridCoordFromWindow(POINT p);
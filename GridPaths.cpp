@@ -0,0 +1,649 @@
+/*
+	Name: GridPaths.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of shortest paths.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridPaths.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+using std::min;
+using std::max;
+
+// Node marks: heap slot when not queued or closed
+const unsigned NOT_QUEUED = UINT_MAX;
+const unsigned CLOSED = UINT_MAX - 1;
+
+// Is a floor whole & open (no diagonal), as diagonal moves need?
+static inline bool IsFloorWhole(FloorType floor)
+{
+	return IsFloorOpenType(floor) && !IsFloorSplit(floor);
+}
+
+// Is a cell (NULL off the map) open floor with open north & west walls?
+static inline bool IsCellClear(const GridCell *cell)
+{
+	return cell && cell->floor == FLOOR_OPEN && cell->nwall == WALL_OPEN
+	       && cell->wwall == WALL_OPEN;
+}
+
+// Is a cell (NULL off the map) clear, rock, or off the map?
+// Jumps pass only where all around is plain.
+static inline bool IsCellPlain(const GridCell *cell)
+{
+	return !cell || cell->floor == FLOOR_FILL || IsCellClear(cell);
+}
+
+// Sign of a difference
+static inline int Sign(int n)
+{
+	return (n > 0) - (n < 0);
+}
+
+//------------------------------------------------------------------
+// Move function(s)
+//------------------------------------------------------------------
+
+// Get the extra cost of entering a cell by floor
+unsigned GetEntryCost(unsigned char floor, const MoveOptions& options)
+{
+	switch (floor) {
+		case FLOOR_WATER:
+			return options.waterCost;
+		case FLOOR_NSTAIRS:
+		case FLOOR_WSTAIRS:
+		case FLOOR_SPIRALSTAIRS:
+			return options.stairsCost;
+		default:
+			return 0;
+	}
+}
+
+/*
+	Can we step corner to corner from a cell?
+	All four cells around the corner must be whole & open,
+	with no wall (or door) between them.
+*/
+static bool CanStepDiagonal(
+    const GridMap& map, unsigned x, unsigned y, int dx, int dy)
+{
+	unsigned nx = x + dx, ny = y + dy;
+	if (nx >= map.getWidthCells() || ny >= map.getHeightCells()) {
+		return false;
+	}
+	unsigned left = min(x, nx), top = min(y, ny);
+	const GridCell *west = map.getColumn(left);
+	const GridCell *east = map.getColumn(left + 1);
+	return IsFloorWhole((FloorType) west[top].floor)
+	       && IsFloorWhole((FloorType) west[top+1].floor)
+	       && IsFloorWhole((FloorType) east[top].floor)
+	       && IsFloorWhole((FloorType) east[top+1].floor)
+	       && west[top+1].nwall == WALL_OPEN
+	       && east[top+1].nwall == WALL_OPEN
+	       && east[top].wwall == WALL_OPEN
+	       && east[top+1].wwall == WALL_OPEN;
+}
+
+/*
+	Get every single move out of one half of a cell: across each
+	side open to it, to the other half of a diagonal door, & (from
+	a whole cell) to each corner cell where nothing is in the way.
+	Returns the number of moves.
+*/
+unsigned GetMoves(
+    const GridMap& map, GridCoord gc, int half, const MoveOptions& options,
+    GridMove moves[MOVE_MAX])
+{
+	unsigned x = gc.x, y = gc.y;
+	unsigned width = map.getWidthCells(), height = map.getHeightCells();
+	const GridCell *column = map.getColumn(x);
+	FloorType floor = (FloorType) column[y].floor;
+	unsigned count = 0;
+	for (int side = 0; side < 4; side++) {
+		if (GetCellSideHalf(floor, (Direction) side) != half) {
+			continue;
+		}
+		unsigned nx = x, ny = y;
+		unsigned char wall;
+		switch (side) {
+			case NORTH:
+				if (y == 0) continue;
+				ny = y - 1;
+				wall = column[y].nwall;
+				break;
+			case SOUTH:
+				if (y + 1 >= height) continue;
+				ny = y + 1;
+				wall = column[ny].nwall;
+				break;
+			case EAST:
+				if (x + 1 >= width) continue;
+				nx = x + 1;
+				wall = map.getColumn(nx)[y].wwall;
+				break;
+			default:
+				if (x == 0) continue;
+				nx = x - 1;
+				wall = column[y].wwall;
+				break;
+		}
+		if (!IsWallPassable((WallType) wall, options.pass)) {
+			continue;
+		}
+		unsigned char nextFloor = map.getColumn(nx)[ny].floor;
+		int nextHalf =
+		    GetCellSideHalf((FloorType) nextFloor, Opposite[side]);
+		if (nextHalf == NO_HALF) {
+			continue;
+		}
+		unsigned cost = options.stepCost + GetEntryCost(nextFloor, options)
+		                + (wall != WALL_OPEN ? options.doorCost : 0);
+		moves[count++] = {{nx, ny}, nextHalf, cost};
+	}
+	if (IsFloorSplit(floor) && AreHalvesJoined(floor, options.pass)) {
+		moves[count++] = {gc, 1 - half, options.doorCost};
+	}
+	if (options.diagonals && IsFloorWhole(floor)) {
+		for (int dx = -1; dx <= 1; dx += 2) {
+			for (int dy = -1; dy <= 1; dy += 2) {
+				if (CanStepDiagonal(map, x, y, dx, dy)) {
+					unsigned char nextFloor =
+					    map.getColumn(x + dx)[y + dy].floor;
+					unsigned cost = options.diagonalCost
+					                + GetEntryCost(nextFloor, options);
+					moves[count++] = {{x + dx, y + dy}, 0, cost};
+				}
+			}
+		}
+	}
+	return count;
+}
+
+//------------------------------------------------------------------
+// Construction & queries
+//------------------------------------------------------------------
+
+GridPaths::GridPaths(const GridMap& _map, const MoveOptions& _options)
+{
+	map = &_map;
+	options = _options;
+	width = map->getWidthCells();
+	height = map->getHeightCells();
+	cells = width * height;
+	nodes.assign(cells, {NO_PATH, NO_NODE, NOT_QUEUED});
+	goal = {0, 0};
+	goalNode = NO_NODE;
+	expanded = 0;
+
+	// Estimate with the cheapest moves possible, so never too high
+	heuristicStep = options.stepCost;
+	heuristicDiagonal = 2 * options.stepCost;
+	if (options.diagonals) {
+		heuristicStep = min(heuristicStep, options.diagonalCost);
+		heuristicDiagonal = min(heuristicDiagonal, options.diagonalCost);
+	}
+
+	// Jump pruning holds only while a diagonal costs more than
+	// one step but less than two
+	canJump = options.diagonals && options.diagonalCost >= options.stepCost
+	          && options.diagonalCost < 2 * options.stepCost;
+}
+
+/*
+	Find a cheapest path between two cells (from any open half of
+	the first to any half of the second), as the cells passed
+	through in order. Returns its cost.
+*/
+unsigned GridPaths::findPath(
+    GridCoord from, GridCoord to, std::vector<GridCoord>& path, bool jump)
+{
+	path.clear();
+	unsigned cost = search(from, to, jump);
+	if (cost == NO_PATH) {
+		return cost;
+	}
+
+	// Walk back from the goal, filling in jumps a cell at a time
+	unsigned node = goalNode;
+	while (node != NO_NODE) {
+		unsigned cell = node % cells;
+		GridCoord gc = {cell / height, cell % height};
+		unsigned parent = nodes[getState(node)].parent;
+		if (path.empty() || path.back().x != gc.x || path.back().y != gc.y) {
+			path.push_back(gc);
+		}
+		if (parent != NO_NODE) {
+			unsigned prior = parent % cells;
+			int dx = Sign((int) (prior / height) - (int) gc.x);
+			int dy = Sign((int) (prior % height) - (int) gc.y);
+			GridCoord end = {prior / height, prior % height};
+			while (abs((int) end.x - (int) gc.x) > 1
+			        || abs((int) end.y - (int) gc.y) > 1) {
+				gc.x += dx;
+				gc.y += dy;
+				path.push_back(gc);
+			}
+		}
+		node = parent;
+	}
+	std::reverse(path.begin(), path.end());
+	return cost;
+}
+
+// Get the cost of a cheapest path between two cells (or NO_PATH)
+unsigned GridPaths::getDistance(GridCoord from, GridCoord to, bool jump)
+{
+	return search(from, to, jump);
+}
+
+// Get the nodes taken off the open list by the last query
+unsigned GridPaths::getNodesExpanded() const
+{
+	return expanded;
+}
+
+//------------------------------------------------------------------
+// Search
+//------------------------------------------------------------------
+
+/*
+	A* search from one cell to another; returns the cost.
+	In jump mode, a node amid plain open floor & rock expands
+	by jumps (see jump()); others a move at a time. Jump mode
+	needs diagonal moves costing between one & two steps (else
+	the search is plain A*).
+*/
+unsigned GridPaths::search(GridCoord from, GridCoord to, bool jump)
+{
+	assert(map->getWidthCells() == width && map->getHeightCells() == height);
+	assert(from.x < width && from.y < height);
+	assert(to.x < width && to.y < height);
+
+	// Clear the last query
+	for (unsigned node: touched) {
+		if (node < cells) {
+			nodes[node] = {NO_PATH, NO_NODE, NOT_QUEUED};
+		}
+	}
+	touched.clear();
+	nodes.resize(cells);
+	splitSlots.clear();
+	heap.clear();
+	expanded = 0;
+	goal = to;
+	goalNode = NO_NODE;
+
+	// Start from each open half
+	FloorType floor = map->getCellFloor(from);
+	unsigned start = from.x * height + from.y;
+	if (GetCellSideHalf(floor, NORTH) != NO_HALF
+	        || GetCellSideHalf(floor, SOUTH) != NO_HALF) {
+		reachNode(start, NO_NODE, 0);
+	}
+	if (IsFloorSplit(floor)) {
+		reachNode(start + cells, NO_NODE, 0);
+	}
+
+	// Expand best nodes until the goal comes up
+	unsigned goalCell = to.x * height + to.y;
+	while (!heap.empty()) {
+		unsigned node = popHeap();
+		expanded++;
+		if (node % cells == goalCell) {
+			goalNode = node;
+			return nodes[getState(node)].cost;
+		}
+		if (jump && canJump && node < cells && isClear(node / height, node % height)
+		        && isPlainAround(node / height, node % height)) {
+			expandJumps(node);
+		}
+		else {
+			expandAll(node);
+		}
+	}
+	return NO_PATH;
+}
+
+// Expand a node by every single move
+void GridPaths::expandAll(unsigned node)
+{
+	unsigned cell = node % cells;
+	GridCoord gc = {cell / height, cell % height};
+	unsigned cost = nodes[getState(node)].cost;
+	GridMove moves[MOVE_MAX];
+	unsigned count = GetMoves(*map, gc, node < cells ? 0 : 1, options, moves);
+	for (unsigned i = 0; i < count; i++) {
+		const GridMove& move = moves[i];
+		unsigned next = move.cell.x * height + move.cell.y;
+		reachNode(next + (move.half ? cells : 0), node, cost + move.cost);
+	}
+}
+
+/*
+	Expand a node amid plain floor & rock by jumps. Where all
+	around is plain floor, jump only the ways it could go on
+	without a shorter way round (straight on, or diagonally on
+	& straight along either side); else jump every way.
+*/
+void GridPaths::expandJumps(unsigned node)
+{
+	int x = node / height, y = node % height;
+	unsigned parent = nodes[node].parent;
+	if (parent != NO_NODE && isRoomy(x, y)) {
+		int dx = Sign(x - (int) (parent / height));
+		int dy = Sign(y - (int) (parent % height));
+		jumpFrom(node, dx, dy);
+		if (dx && dy) {
+			jumpFrom(node, dx, 0);
+			jumpFrom(node, 0, dy);
+		}
+	}
+	else {
+		for (int dx = -1; dx <= 1; dx++) {
+			for (int dy = -1; dy <= 1; dy++) {
+				if (dx || dy) {
+					jumpFrom(node, dx, dy);
+				}
+			}
+		}
+	}
+}
+
+// Jump one way from a node & reach where it stops (if anywhere)
+void GridPaths::jumpFrom(unsigned node, int dx, int dy)
+{
+	int x = node / height, y = node % height;
+	if (jump(x, y, dx, dy)) {
+		unsigned steps = max(
+		    abs(x - (int) (node / height)), abs(y - (int) (node % height)));
+		unsigned step = dx && dy ? options.diagonalCost : options.stepCost;
+		reachNode(x * height + y, node, nodes[node].cost + steps * step);
+	}
+}
+
+/*
+	Jump one way from a cell amid plain floor & rock (so all
+	around it is plain floor or rock), moving it to the next cell
+	worth expanding: the goal, one near anything but plain floor
+	& rock, or one beside rock with a neighbour no cheaper to
+	reach another way. Diagonal jumps also stop where a straight
+	jump to either side would. Corners are never cut.
+	Returns false if blocked first.
+*/
+bool GridPaths::jump(int& x, int& y, int dx, int dy) const
+{
+	if (!dy) {
+		return jumpEastWest(x, y, dx);
+	}
+	if (!dx) {
+		return jumpNorthSouth(x, y, dy);
+	}
+	for (;;) {
+		if (!isClear(x + dx, y + dy) || !isClear(x + dx, y)
+		        || !isClear(x, y + dy)) {
+			return false;
+		}
+		x += dx;
+		y += dy;
+		if ((unsigned) x == goal.x && (unsigned) y == goal.y) {
+			return true;
+		}
+
+		// Check only the cells newly around (the rest were before)
+		if (!isPlain(x + dx, y - 1) || !isPlain(x + dx, y)
+		        || !isPlain(x + dx, y + 1) || !isPlain(x - 1, y + dy)
+		        || !isPlain(x, y + dy)) {
+			return true;
+		}
+		int sx = x, sy = y;
+		if (jumpEastWest(sx, sy, dx)) {
+			return true;
+		}
+		sx = x;
+		sy = y;
+		if (jumpNorthSouth(sx, sy, dy)) {
+			return true;
+		}
+	}
+}
+
+// Jump east or west (see jump()), a column at a time
+bool GridPaths::jumpEastWest(int& x, int& y, int dx) const
+{
+	const GridCell *behind = getColumnAt(x - dx);
+	const GridCell *here = getColumnAt(x);
+	const GridCell *ahead = getColumnAt(x + dx);
+	for (;;) {
+		if (!IsCellClear(getCellIn(ahead, y))) {
+			return false;
+		}
+		x += dx;
+		behind = here;
+		here = ahead;
+		ahead = getColumnAt(x + dx);
+		if ((unsigned) x == goal.x && (unsigned) y == goal.y) {
+			return true;
+		}
+		if (!IsCellPlain(getCellIn(ahead, y - 1))
+		        || !IsCellPlain(getCellIn(ahead, y))
+		        || !IsCellPlain(getCellIn(ahead, y + 1))) {
+			return true;
+		}
+		if ((IsCellClear(getCellIn(here, y - 1))
+		        && !IsCellClear(getCellIn(behind, y - 1)))
+		        || (IsCellClear(getCellIn(here, y + 1))
+		            && !IsCellClear(getCellIn(behind, y + 1)))) {
+			return true;
+		}
+	}
+}
+
+// Jump north or south (see jump()), down three columns
+bool GridPaths::jumpNorthSouth(int& x, int& y, int dy) const
+{
+	const GridCell *west = getColumnAt(x - 1);
+	const GridCell *here = getColumnAt(x);
+	const GridCell *east = getColumnAt(x + 1);
+	for (;;) {
+		if (!IsCellClear(getCellIn(here, y + dy))) {
+			return false;
+		}
+		y += dy;
+		if ((unsigned) x == goal.x && (unsigned) y == goal.y) {
+			return true;
+		}
+		if (!IsCellPlain(getCellIn(west, y + dy))
+		        || !IsCellPlain(getCellIn(here, y + dy))
+		        || !IsCellPlain(getCellIn(east, y + dy))) {
+			return true;
+		}
+		if ((IsCellClear(getCellIn(west, y))
+		        && !IsCellClear(getCellIn(west, y - dy)))
+		        || (IsCellClear(getCellIn(east, y))
+		            && !IsCellClear(getCellIn(east, y - dy)))) {
+			return true;
+		}
+	}
+}
+
+// Get a column, or NULL off the map
+const GridCell* GridPaths::getColumnAt(int x) const
+{
+	return (unsigned) x < width ? map->getColumn(x) : NULL;
+}
+
+// Get a cell in a column, or NULL off the map
+const GridCell* GridPaths::getCellIn(const GridCell *column, int y) const
+{
+	return column && (unsigned) y < height ? column + y : NULL;
+}
+
+// Is a cell plain open floor with open north & west walls?
+bool GridPaths::isClear(int x, int y) const
+{
+	return IsCellClear(getCellIn(getColumnAt(x), y));
+}
+
+// Is a cell & all around it clear?
+bool GridPaths::isRoomy(int x, int y) const
+{
+	if (x < 1 || y < 1 || (unsigned) x + 1 >= width
+	        || (unsigned) y + 1 >= height) {
+		return false;
+	}
+	for (int cx = x - 1; cx <= x + 1; cx++) {
+		const GridCell *column = map->getColumn(cx);
+		for (int cy = y - 1; cy <= y + 1; cy++) {
+			if (column[cy].floor != FLOOR_OPEN
+			        || column[cy].nwall != WALL_OPEN
+			        || column[cy].wwall != WALL_OPEN) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Is a cell either clear or rock (or off the map)?
+bool GridPaths::isPlain(int x, int y) const
+{
+	return IsCellPlain(getCellIn(getColumnAt(x), y));
+}
+
+// Is a cell & all around it plain?
+bool GridPaths::isPlainAround(int x, int y) const
+{
+	for (int cx = x - 1; cx <= x + 1; cx++) {
+		for (int cy = y - 1; cy <= y + 1; cy++) {
+			if (!isPlain(cx, cy)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Estimate the cost from a cell to the goal (never too high)
+unsigned GridPaths::getHeuristic(unsigned cell) const
+{
+	unsigned dx = abs((int) (cell / height) - (int) goal.x);
+	unsigned dy = abs((int) (cell % height) - (int) goal.y);
+	unsigned diagonal = min(dx, dy);
+	return diagonal * heuristicDiagonal
+	       + (max(dx, dy) - diagonal) * heuristicStep;
+}
+
+// Reach a node at a cost, if cheaper than before
+void GridPaths::reachNode(unsigned node, unsigned parent, unsigned cost)
+{
+	unsigned index = getState(node);
+	NodeState& state = nodes[index];
+	unsigned slot = state.slot;
+	if (slot == CLOSED || cost >= state.cost) {
+		return;
+	}
+	if (state.cost == NO_PATH) {
+		touched.push_back(node);
+	}
+	state.cost = cost;
+	state.parent = parent;
+	unsigned remain = getHeuristic(node % cells);
+	if (slot == NOT_QUEUED) {
+		slot = (unsigned) heap.size();
+		heap.push_back({cost + remain, remain, node, index});
+		state.slot = slot;
+	}
+	else {
+		heap[slot].estimate = cost + remain;
+	}
+	siftUp(slot);
+}
+
+/*
+	Find where a node's scratch is, giving the second half of a
+	split cell a slot after the cells the first time it's reached
+	in a query (so only split cells a search reaches take room).
+*/
+unsigned GridPaths::getState(unsigned node)
+{
+	if (node < cells) {
+		return node;
+	}
+	auto found = splitSlots.find(node - cells);
+	if (found != splitSlots.end()) {
+		return found->second;
+	}
+	unsigned slot = (unsigned) nodes.size();
+	splitSlots[node - cells] = slot;
+	nodes.push_back({NO_PATH, NO_NODE, NOT_QUEUED});
+	return slot;
+}
+
+//------------------------------------------------------------------
+// Open list
+//------------------------------------------------------------------
+
+// Should one entry come off the heap before another?
+bool GridPaths::isHeapBefore(const HeapEntry& a, const HeapEntry& b) const
+{
+	return a.estimate < b.estimate
+	       || (a.estimate == b.estimate && a.remain < b.remain);
+}
+
+// Move an entry up the heap to its place
+void GridPaths::siftUp(unsigned slot)
+{
+	HeapEntry entry = heap[slot];
+	while (slot > 0) {
+		unsigned up = (slot - 1) / 2;
+		if (!isHeapBefore(entry, heap[up])) {
+			break;
+		}
+		heap[slot] = heap[up];
+		nodes[heap[slot].state].slot = slot;
+		slot = up;
+	}
+	heap[slot] = entry;
+	nodes[entry.state].slot = slot;
+}
+
+// Move an entry down the heap to its place
+void GridPaths::siftDown(unsigned slot)
+{
+	HeapEntry entry = heap[slot];
+	unsigned size = (unsigned) heap.size();
+	for (;;) {
+		unsigned down = slot * 2 + 1;
+		if (down >= size) {
+			break;
+		}
+		if (down + 1 < size && isHeapBefore(heap[down + 1], heap[down])) {
+			down++;
+		}
+		if (!isHeapBefore(heap[down], entry)) {
+			break;
+		}
+		heap[slot] = heap[down];
+		nodes[heap[slot].state].slot = slot;
+		slot = down;
+	}
+	heap[slot] = entry;
+	nodes[entry.state].slot = slot;
+}
+
+// Take the best node off the heap (closing it)
+unsigned GridPaths::popHeap()
+{
+	unsigned node = heap[0].node;
+	nodes[heap[0].state].slot = CLOSED;
+	heap[0] = heap.back();
+	heap.pop_back();
+	if (!heap.empty()) {
+		siftDown(0);
+	}
+	return node;
+}
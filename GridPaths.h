@@ -0,0 +1,129 @@
+/*
+	Name: GridPaths.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Shortest paths & movement distances on a map.
+		Moves step across cell sides (through open walls & passable
+		doors, between cell halves split by diagonals) & optionally
+		corner to corner where nothing is in the way. A* search with
+		an indexed binary heap; per-map buffers are kept between
+		queries, so repeated queries allocate nothing. The jump-point
+		variant skims across plain open floor bounded by rock,
+		stopping near anything else (walls, doors, water & so on).
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDPATHS_H
+#define GRIDPATHS_H
+#include "GridRegions.h"
+#include <climits>
+#include <unordered_map>
+#include <vector>
+
+// Cost of no path
+const unsigned NO_PATH = UINT_MAX;
+
+// Most moves out of a cell half (four sides, the other half
+// & four corners)
+const unsigned MOVE_MAX = 9;
+
+/*
+	Movement rules & costs.
+	A step across a side costs stepCost, corner to corner
+	diagonalCost (so by default 1-2-1-2 diagonals, as 15 per step);
+	entering water or stairs & passing a door (including from half
+	to half of a diagonal door) cost extra.
+*/
+struct MoveOptions {
+	PassOptions pass;
+	bool diagonals = true;
+	unsigned stepCost = 10;
+	unsigned diagonalCost = 15;
+	unsigned waterCost = 10;
+	unsigned stairsCost = 10;
+	unsigned doorCost = 5;
+};
+
+// One move: the cell half moved into & its cost
+struct GridMove {
+	GridCoord cell;
+	int half;
+	unsigned cost;
+};
+
+// Move function(s)
+unsigned GetEntryCost(unsigned char floor, const MoveOptions& options);
+unsigned GetMoves(
+    const GridMap& map, GridCoord gc, int half, const MoveOptions& options,
+    GridMove moves[MOVE_MAX]);
+
+/*
+	GridPaths interface
+	Searches the map as it stands at each query (so edits since
+	need no notice), but the map must keep its size.
+*/
+class GridPaths {
+	public:
+
+		// Constructor
+		GridPaths(const GridMap& map, const MoveOptions& options = MoveOptions());
+
+		// Queries (NO_PATH if none)
+		unsigned findPath(
+		    GridCoord from, GridCoord to, std::vector<GridCoord>& path,
+		    bool jump = false);
+		unsigned getDistance(GridCoord from, GridCoord to, bool jump = false);
+		unsigned getNodesExpanded() const;
+
+	private:
+
+		// Search
+		unsigned search(GridCoord from, GridCoord to, bool jump);
+		void expandAll(unsigned node);
+		void expandJumps(unsigned node);
+		void jumpFrom(unsigned node, int dx, int dy);
+		bool jump(int& x, int& y, int dx, int dy) const;
+		bool jumpEastWest(int& x, int& y, int dx) const;
+		bool jumpNorthSouth(int& x, int& y, int dy) const;
+		const GridCell* getColumnAt(int x) const;
+		const GridCell* getCellIn(const GridCell *column, int y) const;
+		bool isClear(int x, int y) const;
+		bool isRoomy(int x, int y) const;
+		bool isPlain(int x, int y) const;
+		bool isPlainAround(int x, int y) const;
+		unsigned getHeuristic(unsigned cell) const;
+		void reachNode(unsigned node, unsigned parent, unsigned cost);
+
+		// Open list (binary heap on estimate, then nearer goal),
+		// with where each node's scratch is
+		struct HeapEntry {
+			unsigned estimate, remain, node, state;
+		};
+		bool isHeapBefore(const HeapEntry& a, const HeapEntry& b) const;
+		void siftUp(unsigned slot);
+		void siftDown(unsigned slot);
+		unsigned popHeap();
+
+		// Map & settings
+		const GridMap *map;
+		MoveOptions options;
+		unsigned width, height, cells;
+		unsigned heuristicStep, heuristicDiagonal;
+		bool canJump;
+
+		// Per-node scratch, reset after each query from the nodes
+		// touched; second halves (nodes after the cells) only of
+		// split cells reached, in slots after the cells for the query
+		struct NodeState {
+			unsigned cost, parent, slot;
+		};
+		std::vector<NodeState> nodes;
+		std::unordered_map<unsigned, unsigned> splitSlots;
+		unsigned getState(unsigned node);
+		std::vector<unsigned> touched;
+		std::vector<HeapEntry> heap;
+		GridCoord goal;
+		unsigned goalNode, expanded;
+};
+#endif
@@ -0,0 +1,231 @@
+/*
+	Name: GridPrint.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of map page layout & printing.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridPrint.h"
+#include "RasterCanvas.h"
+#include "ImageFile.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <string>
+using std::min;
+using std::max;
+
+//------------------------------------------------------------------
+// Layout
+//------------------------------------------------------------------
+
+// Cell size that prints at standard scale on a device
+unsigned GetPrintCellSize(int dpi)
+{
+	unsigned cellSize = dpi > 0 ? dpi / PRINT_SQUARES_PER_INCH : 0;
+	cellSize = max(cellSize, GridMap::getCellSizeMin());
+	return min(cellSize, GridMap::getCellSizeMax());
+}
+
+// Count pages to cover a length, each new page repeating the overlap
+static unsigned CountPages(
+    unsigned long long length, int content, int overlap)
+{
+	if (length <= (unsigned long long) content)
+		return 1;
+	unsigned long long step = content - overlap;
+	return 1 + (unsigned) ((length - content + step - 1) / step);
+}
+
+/*
+	Lay out a map over pages of a given printable size.
+	Crop marks take a quarter-inch border around each page's map.
+	Returns false if the pages are too small or the map too large.
+*/
+bool MakePrintLayout(
+    const GridMap& map, int dpi, int pageWidth, int pageHeight,
+    int overlap, bool cropMarks, size_t bandBudget, PrintLayout& layout)
+{
+	// Scale for device
+	unsigned cellSize = GetPrintCellSize(dpi);
+	unsigned cellSizeDefault = GridMap::getCellSizeDefault();
+	layout.cellSize = cellSize;
+	layout.lineScale =
+	    max(1, (int) ((cellSize + cellSizeDefault / 2) / cellSizeDefault));
+
+	// Find map area on each page
+	layout.pageWidth = pageWidth;
+	layout.pageHeight = pageHeight;
+	layout.markMargin = cropMarks ? max(dpi / 4, 4) : 0;
+	layout.contentWidth = pageWidth - 2 * layout.markMargin;
+	layout.contentHeight = pageHeight - 2 * layout.markMargin;
+	layout.overlap = overlap;
+	if (overlap < 0 || layout.contentWidth <= overlap
+	        || layout.contentHeight <= overlap) {
+		return false;
+	}
+
+	// Count pages for map at device size
+	unsigned long long mapWidth =
+	    (unsigned long long) map.getWidthCells() * cellSize;
+	unsigned long long mapHeight =
+	    (unsigned long long) map.getHeightCells() * cellSize;
+	if (mapWidth > INT_MAX || mapHeight > INT_MAX) {
+		return false;
+	}
+	layout.pagesAcross = CountPages(mapWidth, layout.contentWidth, overlap);
+	layout.pagesDown = CountPages(mapHeight, layout.contentHeight, overlap);
+
+	// Size bands to budget, in whole cell rows if possible
+	unsigned long long rows = bandBudget / pageWidth;
+	if (rows >= cellSize) {
+		rows -= rows % cellSize;
+	}
+	rows = min(rows, (unsigned long long) pageHeight);
+	layout.bandRows = rows > 0 ? (unsigned) rows : 1;
+	return true;
+}
+
+unsigned GetPageCount(const PrintLayout& layout)
+{
+	return layout.pagesAcross * layout.pagesDown;
+}
+
+//------------------------------------------------------------------
+// Painting
+//------------------------------------------------------------------
+
+/*
+	Draw crop marks in the border around a page's map,
+	lined up with the trim lines (map edge, or where the
+	next page's overlap starts).
+*/
+static void DrawCropMarks(
+    GridCanvas& canvas, int margin, int left, int top, int right,
+    int bottom, int trimRight, int trimBottom)
+{
+	int gap = margin / 4;
+	canvas.selectPen(PEN_BLACK);
+	const int markX[2] = {left, trimRight};
+	for (int x: markX) {
+		canvas.moveTo(x, top - margin + gap);
+		canvas.lineTo(x, top - gap);
+		canvas.moveTo(x, bottom + gap);
+		canvas.lineTo(x, bottom + margin - gap);
+	}
+	const int markY[2] = {top, trimBottom};
+	for (int y: markY) {
+		canvas.moveTo(left - margin + gap, y);
+		canvas.lineTo(left - gap, y);
+		canvas.moveTo(right + gap, y);
+		canvas.lineTo(right + margin - gap, y);
+	}
+}
+
+/*
+	Paint one band of rows [bandTop, bandBottom) of a page.
+	The canvas shows page row canvasTop at its top pixel
+	(zero for a full-page canvas, bandTop for a band buffer).
+	Map must be set to the layout's cell size.
+*/
+void PaintPageBand(
+    GridMap& map, GridCanvas& canvas, const PrintLayout& layout,
+    unsigned page, int bandTop, int bandBottom, int canvasTop)
+{
+	assert(map.getCellSizePixels() == layout.cellSize);
+	assert(page < GetPageCount(layout));
+
+	// Find this page's part of the map & where it goes
+	unsigned col = page % layout.pagesAcross;
+	unsigned row = page / layout.pagesAcross;
+	int mapLeft = col * (layout.contentWidth - layout.overlap);
+	int mapTop = row * (layout.contentHeight - layout.overlap);
+	int left = layout.markMargin;
+	int top = layout.markMargin;
+	int right =
+	    left + (int) min(
+	        (unsigned long long) layout.contentWidth,
+	        map.getWidthPixels() - mapLeft);
+	int bottom =
+	    top + (int) min(
+	        (unsigned long long) layout.contentHeight,
+	        map.getHeightPixels() - mapTop);
+
+	// Paint just the cells under this band
+	int clipTop = max(top, bandTop);
+	int clipBottom = min(bottom, bandBottom);
+	if (clipTop < clipBottom) {
+		unsigned cellSize = layout.cellSize;
+		canvas.setOrigin(mapLeft - left, mapTop - top + canvasTop);
+		canvas.setClip(
+		    left, clipTop - canvasTop, right, clipBottom - canvasTop);
+		map.paintRegion(
+		    canvas, mapLeft / cellSize,
+		    (mapTop + clipTop - top) / cellSize,
+		    (mapLeft + right - left - 1) / cellSize + 1,
+		    (mapTop + clipBottom - top - 1) / cellSize + 1);
+	}
+
+	// Add crop marks
+	if (layout.markMargin) {
+		int trimRight =
+		    col + 1 < layout.pagesAcross ?
+		    left + layout.contentWidth - layout.overlap : right;
+		int trimBottom =
+		    row + 1 < layout.pagesDown ?
+		    top + layout.contentHeight - layout.overlap : bottom;
+		canvas.setOrigin(0, canvasTop);
+		canvas.setClip(
+		    0, bandTop - canvasTop, layout.pageWidth,
+		    bandBottom - canvasTop);
+		DrawCropMarks(
+		    canvas, layout.markMargin, left, top, right, bottom,
+		    trimRight, trimBottom);
+	}
+	canvas.clearClip();
+	canvas.setOrigin(0, 0);
+}
+
+/*
+	Write each page as its own image file, named
+	baseName-pN.format. Pages are painted in bands,
+	so memory stays at one band however large the page.
+*/
+ExportResult ExportPageImages(
+    GridMap& map, const PrintLayout& layout,
+    const char *baseName, const char *format)
+{
+	RasterCanvas canvas(layout.pageWidth, layout.bandRows, layout.lineScale);
+	for (unsigned page = 0; page < GetPageCount(layout); page++) {
+
+		// Open page file
+		std::string filename =
+		    std::string(baseName) + "-p" + std::to_string(page + 1)
+		    + "." + format;
+		ImageWriter *writer = NewImageWriter(format);
+		if (!writer) {
+			return EXPORT_BAD_FORMAT;
+		}
+		bool ok = writer->open(
+		    filename.c_str(), layout.pageWidth, layout.pageHeight);
+
+		// Paint & write each band
+		for (int top = 0; ok && top < layout.pageHeight;
+		        top += layout.bandRows) {
+			int bottom = min(top + (int) layout.bandRows, layout.pageHeight);
+			canvas.clear(SHADE_WHITE);
+			PaintPageBand(map, canvas, layout, page, top, bottom, top);
+			for (int y = 0; ok && y < bottom - top; y++) {
+				ok = writer->writeRow(canvas.getRow(y));
+			}
+		}
+		ok = writer->close() && ok;
+		delete writer;
+		if (!ok) {
+			return EXPORT_WRITE_FAILED;
+		}
+	}
+	return EXPORT_OK;
+}
@@ -0,0 +1,49 @@
+/*
+	Name: GridPrint.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Page layout for printing maps at device resolution.
+		The map is painted natively at the printer's DPI, split
+		over as many pages as needed (with optional overlap and
+		crop marks), and each page is painted in bands so only
+		one band's worth of cells is drawn at a time.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDPRINT_H
+#define GRIDPRINT_H
+#include "GridMap.h"
+#include "GridExport.h"
+
+// Printed map scale
+const int PRINT_SQUARES_PER_INCH = 4;
+
+/*
+	Layout of a map over printed pages.
+	All sizes are in device pixels.
+*/
+struct PrintLayout {
+	unsigned cellSize;                  // map cell size on the device
+	int lineScale;                      // pen width multiplier
+	int pageWidth, pageHeight;          // printable area of a page
+	int markMargin;                     // border kept for crop marks
+	int contentWidth, contentHeight;    // map area on each page
+	int overlap;                        // map repeated on next page
+	unsigned pagesAcross, pagesDown;
+	unsigned bandRows;                  // page rows painted at a time
+};
+
+// Function prototypes
+unsigned GetPrintCellSize(int dpi);
+bool MakePrintLayout(
+    const GridMap& map, int dpi, int pageWidth, int pageHeight,
+    int overlap, bool cropMarks, size_t bandBudget, PrintLayout& layout);
+unsigned GetPageCount(const PrintLayout& layout);
+void PaintPageBand(
+    GridMap& map, GridCanvas& canvas, const PrintLayout& layout,
+    unsigned page, int bandTop, int bandBottom, int canvasTop);
+ExportResult ExportPageImages(
+    GridMap& map, const PrintLayout& layout,
+    const char *baseName, const char *format);
+#endif
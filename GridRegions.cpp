@@ -0,0 +1,810 @@
+/*
+	Name: GridRegions.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of connected regions.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridRegions.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <functional>
+#include <thread>
+using std::min;
+using std::max;
+
+// Cell half open to each side (NORTH, SOUTH, EAST, WEST) by floor;
+// a diagonal wall splits a cell into the half touching north
+// (half 0) & the half touching south (half 1)
+static const signed char SideHalves[FLOOR_WATER + 1][4] = {
+	{NO_HALF, NO_HALF, NO_HALF, NO_HALF},       // FLOOR_FILL
+	{0, 0, 0, 0},                               // FLOOR_OPEN
+	{0, 0, 0, 0},                               // FLOOR_NSTAIRS
+	{0, 0, 0, 0},                               // FLOOR_WSTAIRS
+	{0, 1, 1, 0},                               // FLOOR_NEWALL
+	{0, 1, 0, 1},                               // FLOOR_NWWALL
+	{0, 1, 1, 0},                               // FLOOR_NEDOOR
+	{0, 1, 0, 1},                               // FLOOR_NWDOOR
+	{NO_HALF, 0, 0, NO_HALF},                   // FLOOR_NWFILL
+	{NO_HALF, 0, NO_HALF, 0},                   // FLOOR_NEFILL
+	{0, NO_HALF, 0, NO_HALF},                   // FLOOR_SWFILL
+	{0, NO_HALF, NO_HALF, 0},                   // FLOOR_SEFILL
+	{0, 0, 0, 0},                               // FLOOR_SPIRALSTAIRS
+	{0, 0, 0, 0}                                // FLOOR_WATER
+};
+
+//------------------------------------------------------------------
+// Passage function(s)
+//------------------------------------------------------------------
+
+// Is this floor split in two by a diagonal wall or door?
+bool IsFloorSplit(FloorType floor)
+{
+	return FLOOR_NEWALL <= floor && floor <= FLOOR_NWDOOR;
+}
+
+// Get the half of a cell open to one side (or NO_HALF)
+int GetCellSideHalf(FloorType floor, Direction side)
+{
+	return floor <= FLOOR_WATER ? SideHalves[floor][side] : NO_HALF;
+}
+
+// Can we pass through this wall?
+bool IsWallPassable(WallType wall, const PassOptions& options)
+{
+	switch (wall) {
+		case WALL_OPEN:
+			return true;
+		case WALL_SINGLE_DOOR:
+			return options.singleDoors;
+		case WALL_DOUBLE_DOOR:
+			return options.doubleDoors;
+		case WALL_SECRET_DOOR:
+			return options.secretDoors;
+		default:
+			return false;
+	}
+}
+
+// Can we pass between the two halves of a split cell?
+bool AreHalvesJoined(FloorType floor, const PassOptions& options)
+{
+	return (floor == FLOOR_NEDOOR || floor == FLOOR_NWDOOR)
+	       && options.diagonalDoors;
+}
+
+/*
+	Can we step out of one half of a cell across a side?
+	If so, sets the cell & half stepped into.
+*/
+bool GetPassage(
+    const GridMap& map, GridCoord gc, int half, Direction side,
+    const PassOptions& options, GridCoord& next, int& nextHalf)
+{
+	if (GetCellSideHalf(map.getCellFloor(gc), side) != half) {
+		return false;
+	}
+	WallType wall;
+	switch (side) {
+		case NORTH:
+			if (gc.y == 0) {
+				return false;
+			}
+			next = {gc.x, gc.y - 1};
+			wall = map.getCellNWall(gc);
+			break;
+		case SOUTH:
+			if (gc.y + 1 >= map.getHeightCells()) {
+				return false;
+			}
+			next = {gc.x, gc.y + 1};
+			wall = map.getCellNWall(next);
+			break;
+		case EAST:
+			if (gc.x + 1 >= map.getWidthCells()) {
+				return false;
+			}
+			next = {gc.x + 1, gc.y};
+			wall = map.getCellWWall(next);
+			break;
+		default:
+			if (gc.x == 0) {
+				return false;
+			}
+			next = {gc.x - 1, gc.y};
+			wall = map.getCellWWall(gc);
+			break;
+	}
+	if (!IsWallPassable(wall, options)) {
+		return false;
+	}
+	nextHalf = GetCellSideHalf(map.getCellFloor(next), Opposite[side]);
+	return nextHalf != NO_HALF;
+}
+
+//------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------
+
+/*
+	Run a task for each of count bands on a thread of its own,
+	waiting for all to finish.
+*/
+static void RunBands(
+    unsigned count, const std::function<void(unsigned)>& task)
+{
+	if (count == 1) {
+		task(0);
+		return;
+	}
+	std::vector<std::thread> pool;
+	for (unsigned b = 0; b < count; b++) {
+		pool.push_back(std::thread(task, b));
+	}
+	for (std::thread& worker: pool) {
+		worker.join();
+	}
+}
+
+// Find the root of a node, halving the path
+static inline unsigned FindRoot(std::vector<unsigned>& parent, unsigned n)
+{
+	while (parent[n] != n) {
+		parent[n] = parent[parent[n]];
+		n = parent[n];
+	}
+	return n;
+}
+
+// Join the trees of two nodes (the lower root wins, so a region's
+// root is always its first node, however the work was split)
+static inline void UnionNodes(
+    std::vector<unsigned>& parent, unsigned a, unsigned b)
+{
+	a = FindRoot(parent, a);
+	b = FindRoot(parent, b);
+	if (a < b) {
+		parent[b] = a;
+	}
+	else if (b < a) {
+		parent[a] = b;
+	}
+}
+
+// Does a cell have any open part? (split cells have two)
+static inline bool IsCellOpen(FloorType floor)
+{
+	return GetCellSideHalf(floor, NORTH) != NO_HALF
+	       || GetCellSideHalf(floor, SOUTH) != NO_HALF;
+}
+
+// Grow a block to hold a cell
+static inline void ExtendBounds(GridRect& bounds, GridCoord gc)
+{
+	bounds.left = min(bounds.left, gc.x);
+	bounds.top = min(bounds.top, gc.y);
+	bounds.right = max(bounds.right, gc.x + 1);
+	bounds.bottom = max(bounds.bottom, gc.y + 1);
+}
+
+//------------------------------------------------------------------
+// Construction & nodes
+//------------------------------------------------------------------
+
+GridRegions::GridRegions(const PassOptions& _options)
+{
+	options = _options;
+	width = height = cells = 0;
+	regionCount = 0;
+	stamp = 0;
+	aliases.push_back(0);
+	stats.push_back({0, {0, 0, 0, 0}});
+}
+
+// Get the node for one half of a cell (second halves in slots)
+unsigned GridRegions::getNode(unsigned cell, int half) const
+{
+	return half == 0 ? cell : cells + splitSlots.find(cell)->second;
+}
+
+// Get the cell a node is in
+GridCoord GridRegions::getNodeCoord(unsigned node) const
+{
+	unsigned cell = node < cells ? node : slotCells[node - cells];
+	return {cell / height, cell % height};
+}
+
+/*
+	Get the nodes one step from a node, across open sides &
+	passable walls, & to the other half of a split cell if joined.
+	Returns how many.
+*/
+unsigned GridRegions::getNodeLinks(
+    const GridMap& map, unsigned node, unsigned links[5]) const
+{
+	GridCoord gc = getNodeCoord(node);
+	int half = node < cells ? 0 : 1;
+	unsigned count = 0;
+	for (int side = 0; side < 4; side++) {
+		GridCoord next;
+		int nextHalf;
+		if (GetPassage(
+		        map, gc, half, (Direction) side, options, next, nextHalf)) {
+			links[count++] = getNode(next.x * height + next.y, nextHalf);
+		}
+	}
+	FloorType floor = map.getCellFloor(gc);
+	if (IsFloorSplit(floor) && AreHalvesJoined(floor, options)) {
+		links[count++] = getNode(gc.x * height + gc.y, 1 - half);
+	}
+	return count;
+}
+
+// Find the region a raw label now belongs to
+unsigned GridRegions::findRegion(unsigned label) const
+{
+	while (aliases[label] != label) {
+		label = aliases[label];
+	}
+	return label;
+}
+
+// Find the region for a raw label, shortening the alias chain
+unsigned GridRegions::compressRegion(unsigned label)
+{
+	while (aliases[label] != label) {
+		aliases[label] = aliases[aliases[label]];
+		label = aliases[label];
+	}
+	return label;
+}
+
+//------------------------------------------------------------------
+// Labelling
+//------------------------------------------------------------------
+
+/*
+	Label every region of a map.
+	Each band of columns is joined up by union-find on its own
+	thread; then the bands are joined at their edges, & roots
+	numbered in map order (so labels don't depend on the threads).
+*/
+void GridRegions::labelMap(const GridMap& map, unsigned threads)
+{
+	if (threads == 0) {
+		threads = max(1u, std::thread::hardware_concurrency());
+	}
+	width = map.getWidthCells();
+	height = map.getHeightCells();
+	cells = width * height;
+	unsigned bands = max(1u, min(threads, width));
+	std::vector<unsigned> bandFirst(bands + 1);
+	for (unsigned b = 0; b <= bands; b++) {
+		bandFirst[b] = (unsigned) ((unsigned long long) width * b / bands);
+	}
+
+	// Find split cells, giving their second halves slots in order
+	std::vector<std::vector<unsigned>> bandSplits(bands);
+	RunBands(bands, [&](unsigned b) {
+		for (unsigned x = bandFirst[b]; x < bandFirst[b+1]; x++) {
+			const GridCell *column = map.getColumn(x);
+			for (unsigned y = 0; y < height; y++) {
+				if (IsFloorSplit((FloorType) column[y].floor)) {
+					bandSplits[b].push_back(x * height + y);
+				}
+			}
+		}
+	});
+	splitSlots.clear();
+	slotCells.clear();
+	freeSlots.clear();
+	std::vector<unsigned> bandSlot(bands + 1, 0);
+	for (unsigned b = 0; b < bands; b++) {
+		for (unsigned cell: bandSplits[b]) {
+			splitSlots[cell] = (unsigned) slotCells.size();
+			slotCells.push_back(cell);
+		}
+		bandSlot[b+1] = (unsigned) slotCells.size();
+	}
+	size_t nodes = (size_t) cells + slotCells.size();
+
+	// Join nodes within each band
+	std::vector<unsigned> parent(nodes);
+	RunBands(bands, [&](unsigned b) {
+		for (unsigned x = bandFirst[b]; x < bandFirst[b+1]; x++) {
+			const GridCell *column = map.getColumn(x);
+			for (unsigned y = 0; y < height; y++) {
+				unsigned cell = x * height + y;
+				FloorType floor = (FloorType) column[y].floor;
+				parent[cell] = IsCellOpen(floor) ? cell : NO_NODE;
+			}
+		}
+		for (unsigned s = bandSlot[b]; s < bandSlot[b+1]; s++) {
+			parent[cells + s] = cells + s;
+		}
+		for (unsigned x = bandFirst[b]; x < bandFirst[b+1]; x++) {
+			unionColumn(map, x, parent);
+			if (x > bandFirst[b]) {
+				unionWest(map, x, parent);
+			}
+		}
+	});
+
+	// Join bands at their edges
+	for (unsigned b = 1; b < bands; b++) {
+		unionWest(map, bandFirst[b], parent);
+	}
+
+	// Find roots (without writing any tree another band reads)
+	labels.resize(nodes);
+	auto findRoots = [&](size_t first, size_t last) {
+		for (size_t n = first; n < last; n++) {
+			unsigned root = parent[n];
+			if (root != NO_NODE) {
+				while (parent[root] != root) {
+					root = parent[root];
+				}
+			}
+			labels[n] = root;
+		}
+	};
+	RunBands(bands, [&](unsigned b) {
+		findRoots((size_t) bandFirst[b] * height,
+		          (size_t) bandFirst[b+1] * height);
+		findRoots(cells + bandSlot[b], cells + bandSlot[b+1]);
+	});
+
+	// Number roots in order: first halves, then second halves
+	std::vector<unsigned> firstRoots(bands, 0), secondRoots(bands, 0);
+	RunBands(bands, [&](unsigned b) {
+		for (size_t n = (size_t) bandFirst[b] * height;
+		        n < (size_t) bandFirst[b+1] * height; n++) {
+			firstRoots[b] += (labels[n] == n);
+		}
+		for (size_t n = cells + bandSlot[b]; n < cells + bandSlot[b+1]; n++) {
+			secondRoots[b] += (labels[n] == n);
+		}
+	});
+	std::vector<unsigned> firstBase(bands), secondBase(bands);
+	unsigned next = 1;
+	for (unsigned b = 0; b < bands; b++) {
+		firstBase[b] = next;
+		next += firstRoots[b];
+	}
+	for (unsigned b = 0; b < bands; b++) {
+		secondBase[b] = next;
+		next += secondRoots[b];
+	}
+	regionCount = next - 1;
+	RunBands(bands, [&](unsigned b) {
+		unsigned label = firstBase[b];
+		for (size_t n = (size_t) bandFirst[b] * height;
+		        n < (size_t) bandFirst[b+1] * height; n++) {
+			if (labels[n] == n) {
+				parent[n] = label++;
+			}
+		}
+		label = secondBase[b];
+		for (size_t n = cells + bandSlot[b]; n < cells + bandSlot[b+1]; n++) {
+			if (labels[n] == n) {
+				parent[n] = label++;
+			}
+		}
+	});
+
+	// Label nodes by their roots' numbers
+	auto labelNodes = [&](size_t first, size_t last) {
+		for (size_t n = first; n < last; n++) {
+			labels[n] = labels[n] == NO_NODE ? 0 : parent[labels[n]];
+		}
+	};
+	RunBands(bands, [&](unsigned b) {
+		labelNodes((size_t) bandFirst[b] * height,
+		           (size_t) bandFirst[b+1] * height);
+		labelNodes(cells + bandSlot[b], cells + bandSlot[b+1]);
+	});
+	makeStats();
+
+	// Reset search marks
+	marks.clear();
+	stamp = 0;
+}
+
+// Join nodes within a column: split halves, & each to the north
+void GridRegions::unionColumn(
+    const GridMap& map, unsigned x, std::vector<unsigned>& parent) const
+{
+	const GridCell *column = map.getColumn(x);
+	for (unsigned y = 0; y < height; y++) {
+		unsigned cell = x * height + y;
+		FloorType floor = (FloorType) column[y].floor;
+		if (IsFloorSplit(floor) && AreHalvesJoined(floor, options)) {
+			UnionNodes(parent, cell, getNode(cell, 1));
+		}
+		int half = GetCellSideHalf(floor, NORTH);
+		if (y > 0 && half != NO_HALF
+		        && IsWallPassable((WallType) column[y].nwall, options)) {
+			int nextHalf =
+			    GetCellSideHalf((FloorType) column[y-1].floor, SOUTH);
+			if (nextHalf != NO_HALF) {
+				UnionNodes(
+				    parent, getNode(cell, half), getNode(cell - 1, nextHalf));
+			}
+		}
+	}
+}
+
+// Join each node of a column to the west
+void GridRegions::unionWest(
+    const GridMap& map, unsigned x, std::vector<unsigned>& parent) const
+{
+	const GridCell *column = map.getColumn(x);
+	const GridCell *west = map.getColumn(x - 1);
+	for (unsigned y = 0; y < height; y++) {
+		unsigned cell = x * height + y;
+		int half = GetCellSideHalf((FloorType) column[y].floor, WEST);
+		if (half != NO_HALF
+		        && IsWallPassable((WallType) column[y].wwall, options)) {
+			int nextHalf = GetCellSideHalf((FloorType) west[y].floor, EAST);
+			if (nextHalf != NO_HALF) {
+				UnionNodes(
+				    parent, getNode(cell, half),
+				    getNode(cell - height, nextHalf));
+			}
+		}
+	}
+}
+
+// Count cells & find bounds of every region
+void GridRegions::makeStats()
+{
+	aliases.resize(regionCount + 1);
+	for (unsigned label = 0; label <= regionCount; label++) {
+		aliases[label] = label;
+	}
+	stats.assign(regionCount + 1, {0, {UINT_MAX, UINT_MAX, 0, 0}});
+	for (size_t n = 0; n < labels.size(); n++) {
+		if (labels[n]) {
+			RegionStats& region = stats[labels[n]];
+			region.cells++;
+			ExtendBounds(region.bounds, getNodeCoord((unsigned) n));
+		}
+	}
+	stats[0] = {0, {0, 0, 0, 0}};
+}
+
+//------------------------------------------------------------------
+// Editing
+//------------------------------------------------------------------
+
+/*
+	Relabel around one cell after its floor or walls change.
+	The cell's halves & those next to it are searched from
+	together, a step from each in turn, until they all meet
+	(regions merge) or all but one run out; those that ran out
+	are regions split off, & only they are relabelled.
+*/
+void GridRegions::updateCell(const GridMap& map, GridCoord gc)
+{
+	assert(map.getWidthCells() == width && map.getHeightCells() == height);
+	unsigned cell = gc.x * height + gc.y;
+
+	// Take the cell's halves out of their regions
+	dropNode(cell);
+	auto slot = splitSlots.find(cell);
+	if (slot != splitSlots.end()) {
+		dropNode(cells + slot->second);
+	}
+	FloorType floor = map.getCellFloor(gc);
+	setSplit(cell, IsFloorSplit(floor));
+
+	// Seed from the cell's open halves & the halves facing it
+	unsigned seeds[SEED_MAX];
+	unsigned count = 0;
+	if (IsCellOpen(floor)) {
+		seeds[count++] = cell;
+	}
+	if (IsFloorSplit(floor)) {
+		seeds[count++] = getNode(cell, 1);
+	}
+	for (int side = 0; side < 4; side++) {
+		GridCoord next = gc;
+		switch (side) {
+			case NORTH: next.y--; break;
+			case SOUTH: next.y++; break;
+			case EAST: next.x++; break;
+			default: next.x--; break;
+		}
+		if (next.x < width && next.y < height) {
+			int half = GetCellSideHalf(
+			    map.getCellFloor(next), Opposite[side]);
+			if (half != NO_HALF) {
+				seeds[count++] = getNode(next.x * height + next.y, half);
+			}
+		}
+	}
+	searchSeeds(map, seeds, count);
+}
+
+// Take a node out of its region
+void GridRegions::dropNode(unsigned node)
+{
+	if (labels[node]) {
+		unsigned region = compressRegion(labels[node]);
+		if (--stats[region].cells == 0) {
+			regionCount--;
+		}
+		labels[node] = 0;
+	}
+}
+
+// Give a cell a slot for its second half, or free it
+void GridRegions::setSplit(unsigned cell, bool split)
+{
+	auto slot = splitSlots.find(cell);
+	if (split && slot == splitSlots.end()) {
+		unsigned s;
+		if (freeSlots.empty()) {
+			s = (unsigned) slotCells.size();
+			slotCells.push_back(cell);
+			labels.push_back(0);
+		}
+		else {
+			s = freeSlots.back();
+			freeSlots.pop_back();
+			slotCells[s] = cell;
+		}
+		splitSlots[cell] = s;
+	}
+	else if (!split && slot != splitSlots.end()) {
+		slotCells[slot->second] = NO_NODE;
+		freeSlots.push_back(slot->second);
+		splitSlots.erase(slot);
+	}
+}
+
+/*
+	Search out from seeds (one group each) in turn & relabel.
+	Groups that meet are joined; a joined set that runs out has
+	found its whole region, so gets a label of its own; the one
+	set left (if any) merges the regions of its seeds.
+*/
+void GridRegions::searchSeeds(
+    const GridMap& map, const unsigned seeds[], unsigned count)
+{
+	// Start a new stamp (clearing marks when stamps run out)
+	if (marks.size() < labels.size()) {
+		marks.resize(labels.size(), 0);
+	}
+	if (stamp > UINT_MAX - 2 * SEED_MAX) {
+		std::fill(marks.begin(), marks.end(), 0);
+		stamp = 0;
+	}
+	stamp += SEED_MAX;
+
+	// Make a group per seed
+	unsigned groups[SEED_MAX];
+	size_t heads[SEED_MAX];
+	unsigned used = 0;
+	for (unsigned i = 0; i < count; i++) {
+		if (marks[seeds[i]] - stamp >= SEED_MAX) {
+			marks[seeds[i]] = stamp + used;
+			groups[used] = used;
+			heads[used] = 0;
+			queues[used].assign(1, seeds[i]);
+			used++;
+		}
+	}
+	auto findGroup = [&](unsigned g) {
+		while (groups[g] != g) {
+			g = groups[g];
+		}
+		return g;
+	};
+
+	// Step each group in turn
+	for (;;) {
+		unsigned sets = 0, activeSets = 0;
+		bool active[SEED_MAX] = {false};
+		for (unsigned g = 0; g < used; g++) {
+			unsigned root = findGroup(g);
+			sets += (root == g);
+			if (heads[g] < queues[g].size() && !active[root]) {
+				active[root] = true;
+				activeSets++;
+			}
+		}
+		if (sets <= 1 || activeSets <= 1) {
+			break;
+		}
+		for (unsigned g = 0; g < used; g++) {
+			if (heads[g] == queues[g].size()) {
+				continue;
+			}
+			unsigned links[5];
+			unsigned numLinks = getNodeLinks(map, queues[g][heads[g]++], links);
+			for (unsigned i = 0; i < numLinks; i++) {
+				unsigned other = marks[links[i]] - stamp;
+				if (other >= SEED_MAX) {
+					marks[links[i]] = stamp + g;
+					queues[g].push_back(links[i]);
+				}
+				else {
+					unsigned a = findGroup(g), b = findGroup(other);
+					groups[max(a, b)] = min(a, b);
+				}
+			}
+		}
+	}
+
+	// Relabel each set
+	unsigned sets = 0;
+	for (unsigned g = 0; g < used; g++) {
+		sets += (findGroup(g) == g);
+	}
+	for (unsigned root = 0; root < used; root++) {
+		if (findGroup(root) != root) {
+			continue;
+		}
+		bool done = true;
+		for (unsigned g = 0; g < used; g++) {
+			if (findGroup(g) == root && heads[g] < queues[g].size()) {
+				done = false;
+			}
+		}
+
+		// Whole region found apart from others: keep its label
+		// if it was all of one region, else give it a new one
+		if (done && sets > 1) {
+			unsigned old = 0, counted = 0;
+			bool same = true;
+			for (unsigned g = 0; g < used; g++) {
+				if (findGroup(g) != root) {
+					continue;
+				}
+				for (unsigned node: queues[g]) {
+					if (labels[node]) {
+						unsigned region = compressRegion(labels[node]);
+						same = same && (old == 0 || region == old);
+						old = region;
+						counted++;
+					}
+				}
+			}
+			bool keep = same && old && stats[old].cells == counted;
+			unsigned region = keep ? old : newRegion();
+			for (unsigned g = 0; g < used; g++) {
+				if (findGroup(g) != root) {
+					continue;
+				}
+				for (unsigned node: queues[g]) {
+					if (!keep) {
+						dropNode(node);
+					}
+					if (!labels[node]) {
+						addToRegion(region, node);
+					}
+				}
+			}
+		}
+
+		// Otherwise merge the regions of its seeds
+		else {
+			unsigned region = 0;
+			for (unsigned g = 0; g < used; g++) {
+				unsigned seed = queues[g][0];
+				if (findGroup(g) == root && labels[seed]) {
+					unsigned other = compressRegion(labels[seed]);
+					region = region ? mergeRegions(region, other) : other;
+				}
+			}
+			if (!region) {
+				region = newRegion();
+			}
+			for (unsigned g = 0; g < used; g++) {
+				unsigned seed = queues[g][0];
+				if (findGroup(g) == root && !labels[seed]) {
+					addToRegion(region, seed);
+				}
+			}
+		}
+	}
+}
+
+// Make a new empty region
+unsigned GridRegions::newRegion()
+{
+	unsigned label = (unsigned) aliases.size();
+	aliases.push_back(label);
+	stats.push_back({0, {UINT_MAX, UINT_MAX, 0, 0}});
+	regionCount++;
+	return label;
+}
+
+// Put an unlabelled node in a region
+void GridRegions::addToRegion(unsigned region, unsigned node)
+{
+	labels[node] = region;
+	stats[region].cells++;
+	ExtendBounds(stats[region].bounds, getNodeCoord(node));
+}
+
+// Merge two regions into the larger; returns the one kept
+unsigned GridRegions::mergeRegions(unsigned a, unsigned b)
+{
+	if (a == b) {
+		return a;
+	}
+	if (stats[b].cells > stats[a].cells
+	        || (stats[b].cells == stats[a].cells && b < a)) {
+		std::swap(a, b);
+	}
+	aliases[b] = a;
+	RegionStats& kept = stats[a];
+	const RegionStats& gone = stats[b];
+	kept.cells += gone.cells;
+	kept.bounds.left = min(kept.bounds.left, gone.bounds.left);
+	kept.bounds.top = min(kept.bounds.top, gone.bounds.top);
+	kept.bounds.right = max(kept.bounds.right, gone.bounds.right);
+	kept.bounds.bottom = max(kept.bounds.bottom, gone.bounds.bottom);
+	stats[b].cells = 0;
+	regionCount--;
+	return a;
+}
+
+//------------------------------------------------------------------
+// Results
+//------------------------------------------------------------------
+
+// Get the region of one half of a cell (0 if none)
+unsigned GridRegions::getLabel(GridCoord gc, int half) const
+{
+	assert(gc.x < width && gc.y < height);
+	unsigned cell = gc.x * height + gc.y;
+	if (half != 0) {
+		auto slot = splitSlots.find(cell);
+		if (slot == splitSlots.end()) {
+			return 0;
+		}
+		cell = cells + slot->second;
+	}
+	return findRegion(labels[cell]);
+}
+
+// Get the region of each cell's first half (column-major)
+void GridRegions::getLabelGrid(std::vector<unsigned>& grid) const
+{
+	grid.resize(cells);
+	for (unsigned cell = 0; cell < cells; cell++) {
+		grid[cell] = findRegion(labels[cell]);
+	}
+}
+
+// Are two cells (first halves) in the same region?
+bool GridRegions::isLinked(GridCoord a, GridCoord b) const
+{
+	unsigned label = getLabel(a);
+	return label && label == getLabel(b);
+}
+
+// Get one past the highest label given (some may be gone)
+unsigned GridRegions::getLabelLimit() const
+{
+	return (unsigned) aliases.size();
+}
+
+// Get the number of regions
+unsigned GridRegions::getRegionCount() const
+{
+	return regionCount;
+}
+
+// Get the stats of a region (zero cells if gone)
+const RegionStats& GridRegions::getRegionStats(unsigned label) const
+{
+	assert(label < stats.size());
+	return stats[label];
+}
@@ -0,0 +1,136 @@
+/*
+	Name: GridRegions.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Connected regions of open space in a map.
+		Fill floors & solid walls always divide regions; doors do
+		or don't by type. A cell split by a diagonal wall (or door)
+		is two halves, each joined to the sides it touches.
+		Regions are labelled by union-find over bands of columns on
+		separate threads, then merged across the bands; single
+		cell edits relabel only around the cell.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDREGIONS_H
+#define GRIDREGIONS_H
+#include "GridMap.h"
+#include <climits>
+#include <unordered_map>
+#include <vector>
+
+// Half of a cell no side opens into
+const int NO_HALF = -1;
+
+// No node (unlabelled, or no parent in a search)
+const unsigned NO_NODE = UINT_MAX;
+
+// Direction back the other way
+const Direction Opposite[4] = {SOUTH, NORTH, WEST, EAST};
+
+/*
+	Which doors let movement through (open walls always do).
+	Labelling with secret doors shut & again open shows
+	what is reached only through secret doors.
+*/
+struct PassOptions {
+	bool singleDoors = true;
+	bool doubleDoors = true;
+	bool secretDoors = false;
+	bool diagonalDoors = true;
+};
+
+/*
+	Size & extent of one region. Split cells count on both sides.
+	Bounds are exact after labelling a whole map; edits since
+	may leave them larger than the region.
+*/
+struct RegionStats {
+	unsigned cells;
+	GridRect bounds;
+};
+
+// Passage function(s)
+bool IsFloorSplit(FloorType floor);
+int GetCellSideHalf(FloorType floor, Direction side);
+bool IsWallPassable(WallType wall, const PassOptions& options);
+bool AreHalvesJoined(FloorType floor, const PassOptions& options);
+bool GetPassage(
+    const GridMap& map, GridCoord gc, int half, Direction side,
+    const PassOptions& options, GridCoord& next, int& nextHalf);
+
+/*
+	GridRegions interface
+	Labels are numbered from 1 (0 is no region, as for fill).
+	After any edit to a labelled map, call updateCell() for each
+	cell whose floor or north or west wall changed.
+*/
+class GridRegions {
+	public:
+
+		// Constructor
+		GridRegions(const PassOptions& options = PassOptions());
+
+		// Labelling
+		void labelMap(const GridMap& map, unsigned threads = 0);
+		void updateCell(const GridMap& map, GridCoord gc);
+
+		// Results
+		unsigned getLabel(GridCoord gc, int half = 0) const;
+		void getLabelGrid(std::vector<unsigned>& grid) const;
+		bool isLinked(GridCoord a, GridCoord b) const;
+		unsigned getLabelLimit() const;
+		unsigned getRegionCount() const;
+		const RegionStats& getRegionStats(unsigned label) const;
+
+	private:
+
+		// Nodes (cell halves)
+		unsigned getNode(unsigned cell, int half) const;
+		GridCoord getNodeCoord(unsigned node) const;
+		unsigned getNodeLinks(
+		    const GridMap& map, unsigned node, unsigned links[5]) const;
+		unsigned findRegion(unsigned label) const;
+		unsigned compressRegion(unsigned label);
+
+		// Labelling helpers
+		void unionColumn(
+		    const GridMap& map, unsigned x,
+		    std::vector<unsigned>& parent) const;
+		void unionWest(
+		    const GridMap& map, unsigned x,
+		    std::vector<unsigned>& parent) const;
+		void makeStats();
+
+		// Editing helpers
+		void dropNode(unsigned node);
+		void setSplit(unsigned cell, bool split);
+		void searchSeeds(
+		    const GridMap& map, const unsigned seeds[], unsigned count);
+		unsigned newRegion();
+		void addToRegion(unsigned region, unsigned node);
+		unsigned mergeRegions(unsigned a, unsigned b);
+
+		// Settings & map size
+		PassOptions options;
+		unsigned width, height, cells;
+
+		// Raw label per node, then aliases to the region for each
+		// (merged regions alias one another)
+		std::vector<unsigned> labels;
+		std::vector<unsigned> aliases;
+		std::vector<RegionStats> stats;
+		unsigned regionCount;
+
+		// Second halves of split cells, in slots after the cells
+		std::unordered_map<unsigned, unsigned> splitSlots;
+		std::vector<unsigned> slotCells, freeSlots;
+
+		// Search marks (stamp plus seed group per node)
+		static const unsigned SEED_MAX = 6;
+		std::vector<unsigned> marks;
+		unsigned stamp;
+		std::vector<unsigned> queues[SEED_MAX];
+};
+#endif
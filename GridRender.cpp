@@ -0,0 +1,455 @@
+/*
+	Name: GridRender.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Headless command-line renderer for GridMapper files.
+		Renders .gmap files to PNG, TIFF, or PPM images (whole maps,
+		or printer pages at a given DPI), spreading the files over
+		a pool of threads. Builds without windows.h.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridMap.h"
+#include "GridExport.h"
+#include "GridPrint.h"
+#include "GridThumb.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	Render settings from the command line.
+	Negative values mean "use the map's own setting".
+	Page width of zero means render one whole-map image;
+	a thumbnail size renders a small preview instead.
+*/
+struct RenderOptions {
+	int cellSize;
+	int roughEdges;
+	int hideGrid;
+	const char *format;
+	const char *outDir;
+	unsigned threads;
+	size_t memoryBudget;
+	unsigned thumbSize;
+	bool quiet, progress;
+
+	// Page output (sizes in inches)
+	double pageWidth, pageHeight, overlap;
+	int dpi;
+	bool cropMarks;
+};
+
+/*
+	State for reporting one file's export progress.
+*/
+struct ProgressReport {
+	const char *filename;
+	std::mutex *outputMutex;
+	int lastPercent;
+};
+
+// Function prototypes
+void PrintUsage();
+bool ParseOptions(
+    int argc, char *argv[], RenderOptions& options,
+    std::vector<char*>& files);
+std::string GetOutputBase(const char *filename, const RenderOptions& options);
+void ApplyOptions(GridMap& map, const RenderOptions& options);
+bool ReportProgress(
+    void *data, unsigned long long rowsDone, unsigned long long rowsTotal);
+bool RenderMapFile(
+    char *filename, const RenderOptions& options, std::mutex& outputMutex,
+    unsigned long long& pixels, std::string& message);
+bool RenderMapPages(
+    GridMap& map, const std::string& outBase, const RenderOptions& options,
+    unsigned long long& pixels, std::string& message);
+
+/*
+	Command-line entry point.
+*/
+int main(int argc, char *argv[])
+{
+	// Parse command line
+	RenderOptions options;
+	std::vector<char*> files;
+	if (!ParseOptions(argc, argv, options, files)) {
+		PrintUsage();
+		return 2;
+	}
+
+	// Render files across thread pool
+	std::atomic<size_t> nextFile(0);
+	std::atomic<unsigned> numFailed(0);
+	std::atomic<unsigned long long> totalPixels(0);
+	std::mutex outputMutex;
+	auto startTime = std::chrono::steady_clock::now();
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < options.threads; t++) {
+		pool.push_back(std::thread([&]() {
+			size_t i;
+			while ((i = nextFile++) < files.size()) {
+				unsigned long long pixels = 0;
+				std::string message;
+				bool ok = RenderMapFile(
+				    files[i], options, outputMutex, pixels, message);
+				totalPixels += pixels;
+				if (!ok) {
+					numFailed++;
+				}
+				if (!ok || !options.quiet) {
+					std::lock_guard<std::mutex> lock(outputMutex);
+					fprintf(ok ? stdout : stderr, "%s\n", message.c_str());
+				}
+			}
+		}));
+	}
+	for (std::thread& worker: pool) {
+		worker.join();
+	}
+
+	// Report throughput
+	double seconds =
+	    std::chrono::duration<double>(
+	        std::chrono::steady_clock::now() - startTime).count();
+	unsigned numDone = (unsigned) files.size() - numFailed;
+	printf("Rendered %u of %u maps in %.3f s on %u threads "
+	       "(%.1f maps/s, %.1f Mpixels/s)\n",
+	       numDone, (unsigned) files.size(), seconds, options.threads,
+	       seconds > 0 ? numDone / seconds : 0.0,
+	       seconds > 0 ? totalPixels / seconds / 1e6 : 0.0);
+	return numFailed ? 1 : 0;
+}
+
+/*
+	Print command-line help.
+*/
+void PrintUsage()
+{
+	fprintf(stderr,
+	    "Usage: gridrender [options] file.gmap ...\n"
+	    "Options:\n"
+	    "  -s pixels   Cell size in pixels (%u-%u; default: map's own)\n"
+	    "  -r          Draw rough edges\n"
+	    "  -R          Draw smooth edges\n"
+	    "  -g          Show grid lines\n"
+	    "  -G          Hide grid lines\n"
+	    "  -f format   Output format: png, tif, ppm, pgm, or svg (default png)\n"
+	    "  -o dir      Output directory (default: beside each map)\n"
+	    "  -j threads  Number of worker threads (default: all cores)\n"
+	    "  -m MB       Memory per thread for image bands (default %u)\n"
+	    "  -t pixels   Write a thumbnail at most this size (1-8192) instead\n"
+	    "  -p          Report progress of each map\n"
+	    "  -q          Quiet; only report errors & totals\n"
+	    "Page output (one image per printed page, %d squares/inch):\n"
+	    "  -P WxH      Printable page size in inches (e.g. 8x10.5)\n"
+	    "  -d dpi      Device resolution (default 300)\n"
+	    "  -O inches   Overlap repeated on adjoining pages (default 0)\n"
+	    "  -c          Draw crop marks\n",
+	    GridMap::getCellSizeMin(), GridMap::getCellSizeMax(),
+	    (unsigned) (EXPORT_BUDGET_DEFAULT >> 20), PRINT_SQUARES_PER_INCH);
+}
+
+/*
+	Parse the command line into options & file list.
+	Returns false on any error.
+*/
+bool ParseOptions(
+    int argc, char *argv[], RenderOptions& options,
+    std::vector<char*>& files)
+{
+	// Set defaults
+	options.cellSize = -1;
+	options.roughEdges = -1;
+	options.hideGrid = -1;
+	options.format = "png";
+	options.outDir = NULL;
+	options.threads = std::thread::hardware_concurrency();
+	options.memoryBudget = EXPORT_BUDGET_DEFAULT;
+	options.thumbSize = 0;
+	options.quiet = false;
+	options.progress = false;
+	options.pageWidth = options.pageHeight = options.overlap = 0;
+	options.dpi = 300;
+	options.cropMarks = false;
+	if (options.threads == 0) {
+		options.threads = 1;
+	}
+
+	// Read arguments
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg[0] != '-') {
+			files.push_back(argv[i]);
+		}
+		else if (!strcmp(arg, "-s") && hasValue) {
+			options.cellSize = atoi(argv[++i]);
+			if (options.cellSize < (int) GridMap::getCellSizeMin()
+			        || options.cellSize > (int) GridMap::getCellSizeMax()) {
+				fprintf(stderr, "Cell size out of range: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (!strcmp(arg, "-r")) {
+			options.roughEdges = 1;
+		}
+		else if (!strcmp(arg, "-R")) {
+			options.roughEdges = 0;
+		}
+		else if (!strcmp(arg, "-g")) {
+			options.hideGrid = 0;
+		}
+		else if (!strcmp(arg, "-G")) {
+			options.hideGrid = 1;
+		}
+		else if (!strcmp(arg, "-f") && hasValue) {
+			options.format = argv[++i];
+			if (!IsExportFormat(options.format)) {
+				fprintf(stderr, "Unknown format: %s\n", options.format);
+				return false;
+			}
+		}
+		else if (!strcmp(arg, "-o") && hasValue) {
+			options.outDir = argv[++i];
+		}
+		else if (!strcmp(arg, "-j") && hasValue) {
+			int threads = atoi(argv[++i]);
+			if (threads < 1) {
+				fprintf(stderr, "Bad thread count: %s\n", argv[i]);
+				return false;
+			}
+			options.threads = threads;
+		}
+		else if (!strcmp(arg, "-m") && hasValue) {
+			int megabytes = atoi(argv[++i]);
+			if (megabytes < 1) {
+				fprintf(stderr, "Bad memory size: %s\n", argv[i]);
+				return false;
+			}
+			options.memoryBudget = (size_t) megabytes << 20;
+		}
+		else if (!strcmp(arg, "-t") && hasValue) {
+			int size = atoi(argv[++i]);
+			if (size < 1 || size > (int) THUMB_SIZE_MAX) {
+				fprintf(stderr, "Bad thumbnail size: %s\n", argv[i]);
+				return false;
+			}
+			options.thumbSize = size;
+		}
+		else if (!strcmp(arg, "-p")) {
+			options.progress = true;
+		}
+		else if (!strcmp(arg, "-q")) {
+			options.quiet = true;
+		}
+		else if (!strcmp(arg, "-P") && hasValue) {
+			if (sscanf(argv[++i], "%lfx%lf",
+			           &options.pageWidth, &options.pageHeight) != 2
+			        || options.pageWidth <= 0 || options.pageHeight <= 0) {
+				fprintf(stderr, "Bad page size: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (!strcmp(arg, "-d") && hasValue) {
+			options.dpi = atoi(argv[++i]);
+			if (options.dpi < 1) {
+				fprintf(stderr, "Bad resolution: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (!strcmp(arg, "-O") && hasValue) {
+			options.overlap = atof(argv[++i]);
+			if (options.overlap < 0) {
+				fprintf(stderr, "Bad overlap: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (!strcmp(arg, "-c")) {
+			options.cropMarks = true;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n", arg);
+			return false;
+		}
+	}
+	if ((options.pageWidth > 0 || options.thumbSize > 0)
+	        && !strcmp(options.format, "svg")) {
+		fprintf(stderr, "Page & thumbnail output need an image format\n");
+		return false;
+	}
+	return !files.empty();
+}
+
+/*
+	Make output filename base: map name without extension,
+	in output directory if one was given.
+*/
+std::string GetOutputBase(const char *filename, const RenderOptions& options)
+{
+	std::string name = filename;
+
+	// Move to output directory
+	if (options.outDir) {
+		size_t slash = name.find_last_of("/\\");
+		if (slash != std::string::npos) {
+			name = name.substr(slash + 1);
+		}
+		std::string dir = options.outDir;
+		if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') {
+			dir += '/';
+		}
+		name = dir + name;
+	}
+
+	// Drop extension
+	size_t dot = name.find_last_of('.');
+	size_t slash = name.find_last_of("/\\");
+	if (dot != std::string::npos
+	        && (slash == std::string::npos || dot > slash)) {
+		name.erase(dot);
+	}
+	return name;
+}
+
+/*
+	Override map display settings from options.
+*/
+void ApplyOptions(GridMap& map, const RenderOptions& options)
+{
+	if (options.cellSize > 0) {
+		map.setCellSizePixels(options.cellSize);
+	}
+	if (options.roughEdges >= 0
+	        && map.displayRoughEdges() != (options.roughEdges == 1)) {
+		map.toggleRoughEdges();
+	}
+	if (options.hideGrid >= 0
+	        && map.displayNoGrid() != (options.hideGrid == 1)) {
+		map.toggleNoGrid();
+	}
+}
+
+/*
+	Export progress callback: print every ten percent.
+*/
+bool ReportProgress(
+    void *data, unsigned long long rowsDone, unsigned long long rowsTotal)
+{
+	ProgressReport *report = (ProgressReport*) data;
+	int percent = (int) (rowsDone * 100 / rowsTotal);
+	if (percent / 10 > report->lastPercent / 10) {
+		std::lock_guard<std::mutex> lock(*report->outputMutex);
+		fprintf(stderr, "%s: %d%%\n", report->filename, percent);
+	}
+	report->lastPercent = percent;
+	return true;
+}
+
+/*
+	Load, render, & save one map file.
+	Sets pixel count & a message for the user.
+*/
+bool RenderMapFile(
+    char *filename, const RenderOptions& options, std::mutex& outputMutex,
+    unsigned long long& pixels, std::string& message)
+{
+	// Load map
+	GridMap map(filename);
+	if (!map.isFileLoadOk()) {
+		message = std::string("Could not read map file: ") + filename;
+		return false;
+	}
+	if (map.getCellSizePixels() < GridMap::getCellSizeMin()) {
+		map.setCellSizePixels(GridMap::getCellSizeDefault());
+	}
+	ApplyOptions(map, options);
+
+	// Print pages if asked
+	std::string outBase = GetOutputBase(filename, options);
+	if (options.pageWidth > 0) {
+		if (!RenderMapPages(map, outBase, options, pixels, message)) {
+			message += std::string(": ") + filename;
+			return false;
+		}
+		message = std::string(filename) + " -> " + message;
+		return true;
+	}
+
+	// Reduce cells straight to a thumbnail if asked
+	// (pixel count reports the cells read)
+	if (options.thumbSize > 0) {
+		std::string outName = outBase + "-thumb." + options.format;
+		ExportResult result =
+		    ExportThumbnail(
+		        map, options.thumbSize, outName.c_str(), options.format);
+		if (result != EXPORT_OK) {
+			message =
+			    std::string(GetExportResultText(result)) + ": " + outName;
+			return false;
+		}
+		pixels =
+		    (unsigned long long) map.getWidthCells() * map.getHeightCells();
+		message = std::string(filename) + " -> " + outName;
+		return true;
+	}
+
+	// Paint & write image in bands
+	std::string outName = outBase + "." + options.format;
+	ProgressReport report = {filename, &outputMutex, 0};
+	ExportResult result =
+	    ExportMapImage(
+	        map, outName.c_str(), options.format, options.memoryBudget,
+	        options.progress ? ReportProgress : NULL, &report);
+	if (result != EXPORT_OK) {
+		message =
+		    std::string(GetExportResultText(result)) + ": " + outName;
+		return false;
+	}
+	pixels = map.getWidthPixels() * map.getHeightPixels();
+	message = std::string(filename) + " -> " + outName;
+	return true;
+}
+
+/*
+	Render a map as printer pages at the requested DPI.
+	Sets pixel count & a message (pages written, or error).
+*/
+bool RenderMapPages(
+    GridMap& map, const std::string& outBase, const RenderOptions& options,
+    unsigned long long& pixels, std::string& message)
+{
+	// Lay out pages & set print scale
+	PrintLayout layout;
+	int dpi = options.dpi;
+	if (!MakePrintLayout(
+	        map, dpi, (int) (options.pageWidth * dpi),
+	        (int) (options.pageHeight * dpi), (int) (options.overlap * dpi),
+	        options.cropMarks, options.memoryBudget, layout)) {
+		message = "Page layout failed";
+		return false;
+	}
+	map.setCellSizePixels(layout.cellSize);
+
+	// Write page images
+	ExportResult result =
+	    ExportPageImages(map, layout, outBase.c_str(), options.format);
+	if (result != EXPORT_OK) {
+		message = GetExportResultText(result);
+		return false;
+	}
+	unsigned pages = GetPageCount(layout);
+	pixels = (unsigned long long) pages * layout.pageWidth * layout.pageHeight;
+	message =
+	    outBase + "-p*." + options.format + " ("
+	    + std::to_string(layout.pagesAcross) + "x"
+	    + std::to_string(layout.pagesDown) + " pages)";
+	return true;
+}
@@ -0,0 +1,1294 @@
+/*
+	Name: GridRooms.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of room segmentation.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridRooms.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+using std::min;
+using std::max;
+
+// Piece not yet made
+const unsigned NO_PIECE = UINT_MAX;
+
+// Flags per node: open (in some region with doors shut), roomy
+// (in a 2x2 of open floor), wide (in a 3x3), & in the part
+// being segmented
+const unsigned char FLAG_AREA = 1;
+const unsigned char FLAG_ROOMY = 2;
+const unsigned char FLAG_WIDE = 4;
+const unsigned char FLAG_PART = 8;
+
+// Step bits per node (shifted by side): open, & into a second half
+const unsigned char STEP_OPEN = 1;
+const unsigned char STEP_HALF = 16;
+
+// Least opening between roomy cells that doesn't split them, &
+// least depth of a basin above a saddle that keeps it apart
+// from a deeper one
+const unsigned JoinOpening = 2;
+const unsigned SplitDepth = 2;
+
+// Largest square counted (3x3 makes cells wide), & deepest
+// depth kept (deeper is the same)
+const unsigned SquareMax = 3;
+const unsigned DepthMax = 255;
+
+// Most cells in an alcove joining the room it opens into, &
+// longest a piece of roomy cells not wide may be for its width
+// (any longer is a wide corridor)
+const unsigned AlcoveCells = 4;
+const unsigned HallRatio = 3;
+
+// Cells around an edit whose clearance or openings it can
+// change (squares reach back 2 cells, openings along a line)
+const unsigned EditReach = JoinOpening > SquareMax - 1
+                           ? JoinOpening : SquareMax - 1;
+
+// An update rebuilds instead once it edits, or re-segments over
+// all its tries, as many as one in this many of the cells
+const unsigned RebuildShare = 2;
+
+// Get the cell beside one across a side (which must be on the map)
+static GridCoord GetNeighbour(GridCoord gc, Direction side)
+{
+	switch (side) {
+		case NORTH: return {gc.x, gc.y - 1};
+		case SOUTH: return {gc.x, gc.y + 1};
+		case EAST: return {gc.x + 1, gc.y};
+		default: return {gc.x - 1, gc.y};
+	}
+}
+
+//------------------------------------------------------------------
+// Construction & building
+//------------------------------------------------------------------
+
+GridRooms::GridRooms(const GridMap& _map)
+{
+	map = &_map;
+	width = map->getWidthCells();
+	height = map->getHeightCells();
+	cells = width * height;
+	roomCount = 0;
+
+	// Step only through open walls
+	shut.singleDoors = false;
+	shut.doubleDoors = false;
+	shut.secretDoors = false;
+	shut.diagonalDoors = false;
+	segments.assign((size_t) cells * 2, 0);
+	segmentInfo.assign(1, {SEGMENT_ROOM, 0, {0, 0, 0, 0}, {0, 0}});
+	squares.assign(cells, 0);
+	openN.assign(cells, 0);
+	openW.assign(cells, 0);
+	flags.assign((size_t) cells * 2, 0);
+	steps.assign((size_t) cells * 2, 0);
+	depths.assign((size_t) cells * 2, 0);
+	parents.assign((size_t) cells * 2, 0);
+	climbs.assign((size_t) cells * 2, NO_NODE);
+	pieceOf.assign((size_t) cells * 2, NO_PIECE);
+	levels.resize(DepthMax + 1);
+}
+
+// Find clearance, openings & depths, & segment the whole map
+void GridRooms::build()
+{
+	GridRect all = {0, 0, width, height};
+	findArea(all);
+	findSquares(all);
+	findRoomy(all);
+	findOpenings(all);
+	findDepths(all);
+	segments.assign((size_t) cells * 2, 0);
+	segmentInfo.assign(1, {SEGMENT_ROOM, 0, {0, 0, 0, 0}, {0, 0}});
+	freeSegments.clear();
+	roomCount = 0;
+	part.clear();
+	for (unsigned x = 0; x < width; x++) {
+		for (unsigned y = 0; y < height; y++) {
+			for (int half = 0; half <= 1; half++) {
+				unsigned node = getNode({x, y}, half);
+				if (flags[node] & FLAG_AREA) {
+					flags[node] |= FLAG_PART;
+					part.push_back(node);
+				}
+			}
+		}
+	}
+	peakIds.clear();
+	bool whole = segmentPart();
+	assert(whole);
+	(void) whole;
+	makeSegments();
+	clearPart();
+}
+
+/*
+	Update after edits to a block of cells: find clearance &
+	openings again around it, & depths as far out as they
+	change. Then re-segment the segments with any of those (or
+	beside them), & the segments beside those, taking in the
+	segments of nodes outside wherever a result reaches them.
+*/
+void GridRooms::updateCells(GridRect edited)
+{
+	assert(map->getWidthCells() == width && map->getHeightCells() == height);
+	if (edited.left >= edited.right || edited.top >= edited.bottom) {
+		return;
+	}
+	if ((size_t) (edited.right - edited.left) * (edited.bottom - edited.top)
+	        * RebuildShare > cells) {
+		build();
+		return;
+	}
+	GridRect block = growBlock(edited, EditReach);
+	findArea(edited);
+	findSquares(block);
+	findRoomy(block);
+	findOpenings(block);
+	updateDepths(edited);
+
+	// Take in the segments changed, then those beside them
+	part.clear();
+	GridRect around = growBlock(block, 1);
+	for (unsigned x = around.left; x < around.right; x++) {
+		for (unsigned y = around.top; y < around.bottom; y++) {
+			for (int half = 0; half <= 1; half++) {
+				unsigned node = getNode({x, y}, half);
+				if (flags[node] & FLAG_AREA) {
+					addSegment(node);
+				}
+				else if (segments[node]) {
+					freeSegment(segments[node]);
+					segments[node] = 0;
+				}
+			}
+		}
+	}
+	for (const auto& old: oldDepths) {
+		if (depths[old.first] != old.second) {
+			addSegment(old.first);
+			for (int side = NORTH; side <= WEST; side++) {
+				unsigned next, opening;
+				if (getStep(old.first, (Direction) side, next, opening)) {
+					addSegment(next);
+				}
+			}
+		}
+	}
+	size_t changed = part.size();
+	for (size_t i = 0; i < changed; i++) {
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next, opening;
+			if (getStep(part[i], (Direction) side, next, opening)) {
+				addSegment(next);
+			}
+		}
+	}
+
+	// Segment them, taking in more until nothing reaches past
+	peakIds.clear();
+	size_t segmented = 0;
+	for (;;) {
+		segmented += part.size();
+		if (segmented * RebuildShare > cells) {
+			build();
+			return;
+		}
+		std::sort(part.begin(), part.end(), [this](unsigned a, unsigned b) {
+			unsigned cellA = a % cells, cellB = b % cells;
+			return cellA != cellB ? cellA < cellB : a < b;
+		});
+		if (segmentPart()) {
+			break;
+		}
+		for (unsigned node: grow) {
+			addSegment(node);
+		}
+	}
+	makeSegments();
+	clearPart();
+}
+
+// Update after edits to one cell
+void GridRooms::updateCell(GridCoord gc)
+{
+	updateCells({gc.x, gc.y, gc.x + 1, gc.y + 1});
+}
+
+//------------------------------------------------------------------
+// Results
+//------------------------------------------------------------------
+
+// Get the segment of one half of a cell (0 if none)
+unsigned GridRooms::getSegment(GridCoord gc, int half) const
+{
+	assert(gc.x < width && gc.y < height);
+	return segments[getNode(gc, half)];
+}
+
+// Get one past the highest segment given (some may be gone)
+unsigned GridRooms::getSegmentLimit() const
+{
+	return (unsigned) segmentInfo.size();
+}
+
+// Get a segment's details (zero cells if gone)
+const RoomSegment& GridRooms::getSegmentInfo(unsigned segment) const
+{
+	assert(segment < segmentInfo.size());
+	return segmentInfo[segment];
+}
+
+/*
+	Get the rooms in number order (room n is rooms[n - 1]):
+	by their labels, top to bottom, then left to right.
+*/
+void GridRooms::getRoomOrder(std::vector<unsigned>& rooms) const
+{
+	rooms.clear();
+	for (unsigned segment = 1; segment < segmentInfo.size(); segment++) {
+		const RoomSegment& info = segmentInfo[segment];
+		if (info.cells && info.kind == SEGMENT_ROOM) {
+			rooms.push_back(segment);
+		}
+	}
+	std::sort(rooms.begin(), rooms.end(), [this](unsigned a, unsigned b) {
+		GridCoord la = segmentInfo[a].label, lb = segmentInfo[b].label;
+		return la.y != lb.y ? la.y < lb.y : la.x < lb.x;
+	});
+}
+
+unsigned GridRooms::getRoomCount() const
+{
+	return roomCount;
+}
+
+//------------------------------------------------------------------
+// Clearance, openings & depths
+//------------------------------------------------------------------
+
+/*
+	Flag the open nodes in a block (clearing other flags), & find
+	the steps out of open nodes there & beside it: per side, a bit
+	if open (doors shut), & a bit if into a second half.
+*/
+void GridRooms::findArea(GridRect block)
+{
+	for (unsigned x = block.left; x < block.right; x++) {
+		const GridCell *column = map->getColumn(x);
+		for (unsigned y = block.top; y < block.bottom; y++) {
+			FloorType floor = (FloorType) column[y].floor;
+			bool open = GetCellSideHalf(floor, NORTH) != NO_HALF
+			            || GetCellSideHalf(floor, SOUTH) != NO_HALF;
+			flags[getNode({x, y}, 0)] = open ? FLAG_AREA : 0;
+			flags[getNode({x, y}, 1)] = IsFloorSplit(floor) ? FLAG_AREA : 0;
+		}
+	}
+	GridRect around = growBlock(block, 1);
+	for (unsigned x = around.left; x < around.right; x++) {
+		for (unsigned y = around.top; y < around.bottom; y++) {
+			for (int half = 0; half <= 1; half++) {
+				unsigned node = getNode({x, y}, half);
+				steps[node] = 0;
+				if (!(flags[node] & FLAG_AREA)) {
+					continue;
+				}
+				for (int side = NORTH; side <= WEST; side++) {
+					GridCoord next;
+					int nextHalf;
+					if (GetPassage(
+					        *map, {x, y}, half, (Direction) side, shut, next,
+					        nextHalf)) {
+						steps[node] |= (STEP_OPEN | (nextHalf ? STEP_HALF : 0))
+						               << side;
+					}
+				}
+			}
+		}
+	}
+}
+
+/*
+	Find the largest square of whole open cells (no walls
+	between) with each cell in a block at its bottom right, from
+	those above & to the left.
+*/
+void GridRooms::findSquares(GridRect block)
+{
+	for (unsigned x = block.left; x < block.right; x++) {
+		for (unsigned y = block.top; y < block.bottom; y++) {
+			unsigned cell = x * height + y;
+			if (!isCellWhole(cell)) {
+				squares[cell] = 0;
+			}
+			else if (x > 0 && y > 0 && isOpenBlock(x - 1, y - 1)) {
+				unsigned smallest = min(
+				    min(squares[cell - height], squares[cell - 1]),
+				    squares[cell - height - 1]);
+				squares[cell] = (unsigned char) min(smallest + 1, SquareMax);
+			}
+			else {
+				squares[cell] = 1;
+			}
+		}
+	}
+}
+
+// Flag roomy & wide cells in a block: those in squares of open
+// floor two & three across (ending below & to the right)
+void GridRooms::findRoomy(GridRect block)
+{
+	for (unsigned x = block.left; x < block.right; x++) {
+		for (unsigned y = block.top; y < block.bottom; y++) {
+			unsigned char found = 0;
+			for (unsigned i = 0; i < SquareMax && x + i < width; i++) {
+				for (unsigned j = 0; j < SquareMax && y + j < height; j++) {
+					unsigned square = squares[(x + i) * height + y + j];
+					if (square >= 3) {
+						found = FLAG_ROOMY | FLAG_WIDE;
+					}
+					else if (square == 2 && i < 2 && j < 2) {
+						found |= FLAG_ROOMY;
+					}
+				}
+			}
+			unsigned char& flag = flags[x * height + y];
+			flag = (unsigned char) ((flag & ~(FLAG_ROOMY | FLAG_WIDE)) | found);
+		}
+	}
+}
+
+// Is the 2x2 block with a top-left cell all whole open cells,
+// with no walls between? (Off the map, no.)
+bool GridRooms::isOpenBlock(unsigned x, unsigned y) const
+{
+	if (x + 1 >= width || y + 1 >= height) {
+		return false;
+	}
+	const GridCell *west = map->getColumn(x);
+	const GridCell *east = map->getColumn(x + 1);
+	return isCellWhole(x * height + y)
+	       && isCellWhole(x * height + y + 1)
+	       && isCellWhole((x + 1) * height + y)
+	       && isCellWhole((x + 1) * height + y + 1)
+	       && west[y + 1].nwall == WALL_OPEN
+	       && east[y + 1].nwall == WALL_OPEN
+	       && east[y].wwall == WALL_OPEN
+	       && east[y + 1].wwall == WALL_OPEN;
+}
+
+// Find the widths of the openings on the north & west edges
+// of the cells in a block
+void GridRooms::findOpenings(GridRect block)
+{
+	for (unsigned x = block.left; x < block.right; x++) {
+		for (unsigned y = block.top; y < block.bottom; y++) {
+			unsigned cell = x * height + y;
+			openN[cell] = y > 0 ? measureOpening({x, y - 1}, SOUTH) : 0;
+			openW[cell] = x > 0 ? measureOpening({x - 1, y}, EAST) : 0;
+		}
+	}
+}
+
+/*
+	Measure the opening (up to JoinOpening) an edge is in, across
+	the south or east side of a cell: the run of open edges along
+	its line, each joined to the last by an open side on either
+	side of the line.
+*/
+unsigned char GridRooms::measureOpening(GridCoord gc, Direction side) const
+{
+	if (!isEdgeOpen(gc, side)) {
+		return 0;
+	}
+	Direction along = side == SOUTH ? EAST : SOUTH;
+	unsigned run = 1;
+	for (int way = 0; way <= 1; way++) {
+		Direction step = way ? Opposite[along] : along;
+		GridCoord at = gc;
+		while (run < JoinOpening && isEdgeJoined(at, side, step)) {
+			at = GetNeighbour(at, step);
+			run++;
+		}
+	}
+	return (unsigned char) run;
+}
+
+// Can we step across one side of a cell (doors shut)?
+bool GridRooms::isEdgeOpen(GridCoord gc, Direction side) const
+{
+	int half = GetCellSideHalf(map->getCellFloor(gc), side);
+	GridCoord next;
+	int nextHalf;
+	return half != NO_HALF
+	       && GetPassage(*map, gc, half, side, shut, next, nextHalf);
+}
+
+// Is the edge across one side of a cell joined to the open edge
+// beside it along the line? (By either cell it lies between.)
+bool GridRooms::isEdgeJoined(
+    GridCoord gc, Direction side, Direction along) const
+{
+	if (!isSideJoined(gc, side, along)
+	        && !isSideJoined(GetNeighbour(gc, side), Opposite[side], along)) {
+		return false;
+	}
+	return isEdgeOpen(GetNeighbour(gc, along), side);
+}
+
+// Can we step from the half of a cell facing one way to the
+// half of the next cell along facing the same way?
+bool GridRooms::isSideJoined(
+    GridCoord gc, Direction face, Direction along) const
+{
+	int half = GetCellSideHalf(map->getCellFloor(gc), face);
+	GridCoord next;
+	int nextHalf;
+	return half != NO_HALF
+	       && GetPassage(*map, gc, half, along, shut, next, nextHalf)
+	       && nextHalf == GetCellSideHalf(map->getCellFloor(next), face);
+}
+
+/*
+	Find the depth of each node in a block: steps to the nearest
+	node with a side closed (1 for those), bucketed by depth. Nodes
+	outside the block keep their depths & count as sources.
+*/
+void GridRooms::findDepths(GridRect block)
+{
+	for (unsigned x = block.left; x < block.right; x++) {
+		for (unsigned y = block.top; y < block.bottom; y++) {
+			depths[getNode({x, y}, 0)] = 0;
+			depths[getNode({x, y}, 1)] = 0;
+		}
+	}
+	auto inBlock = [&](unsigned node) {
+		GridCoord gc = getCoord(node);
+		return gc.x >= block.left && gc.x < block.right
+		       && gc.y >= block.top && gc.y < block.bottom;
+	};
+	for (unsigned x = block.left; x < block.right; x++) {
+		for (unsigned y = block.top; y < block.bottom; y++) {
+			for (int half = 0; half <= 1; half++) {
+				unsigned node = getNode({x, y}, half);
+				if (!(flags[node] & FLAG_AREA)) {
+					continue;
+				}
+				unsigned depth = node >= cells || !isCellWhole(node)
+				                 ? 1 : UINT_MAX;
+				for (int side = NORTH; side <= WEST && depth > 1; side++) {
+					unsigned next, opening;
+					if (!getStep(node, (Direction) side, next, opening)) {
+						depth = 1;
+					}
+					else if (!inBlock(next)) {
+						depth = min(depth, depths[next] + 1u);
+					}
+				}
+				if (depth != UINT_MAX) {
+					depth = min(depth, DepthMax);
+					depths[node] = (unsigned char) depth;
+					levels[depth].push_back(node);
+				}
+			}
+		}
+	}
+	for (unsigned depth = 1; depth <= DepthMax; depth++) {
+		unsigned nextDepth = min(depth + 1, DepthMax);
+		for (size_t i = 0; i < levels[depth].size(); i++) {
+			unsigned node = levels[depth][i];
+			if (depths[node] != depth) {
+				continue;
+			}
+			for (int side = NORTH; side <= WEST; side++) {
+				unsigned next, opening;
+				if (getStep(node, (Direction) side, next, opening)
+				        && inBlock(next)
+				        && (!depths[next] || depths[next] > nextDepth)) {
+					depths[next] = (unsigned char) nextDepth;
+					levels[nextDepth].push_back(next);
+				}
+			}
+		}
+		levels[depth].clear();
+	}
+}
+
+/*
+	Find depths again around edits to a block, in a block around
+	it grown until the depths just outside still hold. Keeps the
+	depths before.
+*/
+void GridRooms::updateDepths(GridRect edited)
+{
+	oldDepths.clear();
+	GridRect done = {0, 0, 0, 0};
+	for (unsigned reach = EditReach; ; reach *= 2) {
+		GridRect block = growBlock(edited, reach);
+		for (unsigned x = block.left; x < block.right; x++) {
+			for (unsigned y = block.top; y < block.bottom; y++) {
+				if (x >= done.left && x < done.right
+				        && y >= done.top && y < done.bottom) {
+					continue;
+				}
+				for (int half = 0; half <= 1; half++) {
+					unsigned node = getNode({x, y}, half);
+					oldDepths.push_back({node, depths[node]});
+				}
+			}
+		}
+		findDepths(block);
+		bool whole = block.left == 0 && block.top == 0
+		             && block.right == width && block.bottom == height;
+		if (whole || areDepthsSettled(block)) {
+			break;
+		}
+		done = block;
+	}
+}
+
+/*
+	Do the depths of the nodes just outside a block still hold
+	(1 if a side is closed, else one more than the least beside)?
+	If so, those further out do too.
+*/
+bool GridRooms::areDepthsSettled(GridRect block) const
+{
+	GridRect ring = growBlock(block, 1);
+	for (unsigned x = ring.left; x < ring.right; x++) {
+		for (unsigned y = ring.top; y < ring.bottom; y++) {
+			if (x >= block.left && x < block.right
+			        && y >= block.top && y < block.bottom) {
+				y = block.bottom - 1;
+				continue;
+			}
+			for (int half = 0; half <= 1; half++) {
+				unsigned node = getNode({x, y}, half);
+				if (!(flags[node] & FLAG_AREA)) {
+					continue;
+				}
+				unsigned depth = isNodeClosed(node) ? 1 : DepthMax;
+				for (int side = NORTH; side <= WEST && depth > 1; side++) {
+					unsigned next, opening;
+					if (getStep(node, (Direction) side, next, opening)) {
+						depth = min(depth, depths[next] + 1u);
+					}
+				}
+				if (depths[node] != depth) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Does a node have a side closed? (Halves of split cells &
+// cells not whole always do.)
+bool GridRooms::isNodeClosed(unsigned node) const
+{
+	if (node >= cells || !isCellWhole(node)) {
+		return true;
+	}
+	for (int side = NORTH; side <= WEST; side++) {
+		unsigned next, opening;
+		if (!getStep(node, (Direction) side, next, opening)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//------------------------------------------------------------------
+// Segmenting the part
+//------------------------------------------------------------------
+
+// Add an open node to the part with the rest of its old segment
+// (if any), dropping that for reuse
+void GridRooms::addSegment(unsigned node)
+{
+	if ((flags[node] & FLAG_PART) || !(flags[node] & FLAG_AREA)) {
+		return;
+	}
+	unsigned segment = segments[node];
+	if (segment) {
+		freeSegment(segment);
+	}
+	size_t first = part.size();
+	flags[node] |= FLAG_PART;
+	part.push_back(node);
+	for (size_t i = first; segment && i < part.size(); i++) {
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next, opening;
+			if (getStep(part[i], (Direction) side, next, opening)
+			        && segments[next] == segment
+			        && !(flags[next] & FLAG_PART)) {
+				flags[next] |= FLAG_PART;
+				part.push_back(next);
+			}
+		}
+	}
+}
+
+/*
+	Segment the part (in reading order): cells join those alike
+	across open sides into pieces (wide space split into basins),
+	& alcoves join the rooms they open into. If any result
+	reaches past the part (joins or climbs to a node outside,
+	or changes what a piece outside joins), lists nodes there
+	whose segments it must take in, & returns false.
+*/
+bool GridRooms::segmentPart()
+{
+	for (unsigned node: part) {
+		parents[node] = node;
+		pieceOf[node] = NO_PIECE;
+	}
+	grow.clear();
+	joinPieces();
+	joinWide();
+	if (grow.empty()) {
+		joinBasins();
+	}
+	if (grow.empty()) {
+		makePieces();
+		touchPieces();
+	}
+	return grow.empty();
+}
+
+/*
+	Join nodes across open sides into pieces: narrow with narrow
+	& roomy with roomy (across openings wide enough; narrower ones
+	are chokepoints). Wide nodes are left to joinWide().
+*/
+void GridRooms::joinPieces()
+{
+	for (unsigned node: part) {
+		if (flags[node] & FLAG_WIDE) {
+			continue;
+		}
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next, opening;
+			if (!getStep(node, (Direction) side, next, opening)
+			        || !isJoined(node, next, opening)) {
+				continue;
+			}
+			if (flags[next] & FLAG_PART) {
+				unionNodes(node, next);
+			}
+			else {
+				grow.push_back(next);
+			}
+		}
+	}
+}
+
+/*
+	Join wide nodes into basins: each joins the deepest of its
+	neighbours deeper than it (across openings wide enough), &
+	those with none (peaks) join peaks of the same depth beside
+	them.
+*/
+void GridRooms::joinWide()
+{
+	for (unsigned node: part) {
+		if (flags[node] & FLAG_WIDE) {
+			climbs[node] = getUphill(node);
+		}
+	}
+	for (unsigned node: part) {
+		if (!(flags[node] & FLAG_WIDE)) {
+			continue;
+		}
+		unsigned up = climbs[node];
+		if (up != NO_NODE) {
+			if (flags[up] & FLAG_PART) {
+				unionNodes(node, up);
+			}
+			else {
+				grow.push_back(up);
+			}
+		}
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next;
+			if (!getWideStep(node, (Direction) side, next)) {
+				continue;
+			}
+			bool inPart = (flags[next] & FLAG_PART) != 0;
+			unsigned nextUp = inPart ? climbs[next] : getUphill(next);
+			if (up == NO_NODE && nextUp == NO_NODE
+			        && depths[next] == depths[node]) {
+				if (inPart) {
+					unionNodes(node, next);
+				}
+				else {
+					grow.push_back(next);
+				}
+			}
+			else if (!inPart && nextUp == node) {
+				grow.push_back(next);
+			}
+		}
+	}
+}
+
+/*
+	Join basins: those of the same peak depth not deep enough
+	above a saddle between them join, then each set joined that
+	is not deep enough above its highest saddle with a deeper
+	basin (ties to the lower id) joins that one. A set joining
+	none (topping its cavern) then joins another basin it meets
+	through a set joining one of the two, over the highest such
+	saddle, if not deep enough above it. Basins outside the part
+	count too, found by climbing.
+*/
+void GridRooms::joinBasins()
+{
+	basins.clear();
+	for (unsigned node: part) {
+		if (!(flags[node] & FLAG_WIDE) || climbs[node] != NO_NODE) {
+			continue;
+		}
+		unsigned root = findRoot(node);
+		if (pieceOf[root] == NO_PIECE) {
+			pieceOf[root] = (unsigned) basins.size();
+			basins.push_back({
+				root, node, 0, depths[node], 0, 0,
+				NO_NODE, NO_PIECE, NO_NODE, NO_PIECE, NO_NODE, false
+			});
+		}
+		Basin& basin = basins[pieceOf[root]];
+		basin.id = min(basin.id, node);
+	}
+	for (unsigned node: part) {
+		if (flags[node] & FLAG_WIDE) {
+			pieceOf[node] = pieceOf[findRoot(node)];
+		}
+	}
+
+	// Join basins of the same peak depth
+	for (unsigned node: part) {
+		if (!(flags[node] & FLAG_WIDE)) {
+			continue;
+		}
+		const Basin& basin = basins[pieceOf[node]];
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next, peak, id;
+			if (!getWideStep(node, (Direction) side, next)) {
+				continue;
+			}
+			bool inPart = (flags[next] & FLAG_PART) != 0;
+			if (inPart) {
+				peak = basins[pieceOf[next]].peak;
+			}
+			else {
+				getOutsideBasin(next, peak, id);
+			}
+			unsigned saddle = min(depths[node], depths[next]);
+			if (peak != basin.peak || peak >= saddle + SplitDepth) {
+				continue;
+			}
+			if (inPart) {
+				unionNodes(node, next);
+			}
+			else {
+				grow.push_back(next);
+			}
+		}
+	}
+
+	// Find the saddles of each set joined with other basins, & its
+	// key (kept at the basin at its root)
+	saddles.clear();
+	for (unsigned node: part) {
+		if (!(flags[node] & FLAG_WIDE)) {
+			continue;
+		}
+		unsigned index = pieceOf[findRoot(node)];
+		Basin& basin = basins[index];
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next, peak, id, key = NO_PIECE;
+			if (!getWideStep(node, (Direction) side, next)) {
+				continue;
+			}
+			if (flags[next] & FLAG_PART) {
+				key = pieceOf[next];
+				peak = basins[key].peak;
+				id = basins[key].id;
+			}
+			else {
+				getOutsideBasin(next, peak, id);
+			}
+			if (peak == basin.peak) {
+				continue;
+			}
+			unsigned char saddle = min(depths[node], depths[next]);
+			saddles.push_back({
+				index, key, next, id, (unsigned char) peak, saddle
+			});
+			if (peak > basin.peak
+			        && (basin.keyId == NO_NODE || saddle > basin.saddle
+			            || (saddle == basin.saddle && id < basin.keyId))) {
+				basin.saddle = saddle;
+				basin.keyId = id;
+				basin.key = key;
+			}
+		}
+	}
+	for (Basin& basin: basins) {
+		basin.top = basin.keyId == NO_NODE
+		            || basin.peak >= basin.saddle + SplitDepth;
+	}
+	for (Basin& basin: basins) {
+		basin.group = pieceOf[findRoot(basin.root)];
+		basin.top = basins[basin.group].top;
+	}
+
+	// Join each set not deep enough above its key's saddle to it;
+	// where it meets another deeper basin, & the key or that one
+	// tops its cavern (joins no deeper one) & isn't deep enough
+	// above the saddle, that one may join the other through it
+	for (const Saddle& saddle: saddles) {
+		const Basin& basin = basins[saddle.basin];
+		if (saddle.peak < basin.peak) {
+			if (saddle.key == NO_PIECE && basin.top
+			        && basin.peak < saddle.depth + SplitDepth) {
+				grow.push_back(saddle.node);
+			}
+			continue;
+		}
+		if (basin.top) {
+			continue;
+		}
+		if (saddle.id == basin.keyId) {
+			if (saddle.key != NO_PIECE) {
+				unionNodes(basin.root, basins[saddle.key].root);
+			}
+			else {
+				grow.push_back(saddle.node);
+			}
+		}
+		else if (basin.key != NO_PIECE) {
+			joinThrough(basin.key, saddle);
+			if (saddle.key != NO_PIECE) {
+				const Basin& key = basins[basin.key];
+				joinThrough(saddle.key, {
+					0, basin.key, NO_NODE, key.id, key.peak, saddle.depth
+				});
+			}
+			else if (saddle.peak < saddle.depth + SplitDepth) {
+				grow.push_back(saddle.node);
+			}
+		}
+	}
+	for (const Basin& basin: basins) {
+		if (basin.throughId == NO_NODE) {
+			continue;
+		}
+		if (basin.through != NO_PIECE) {
+			unionNodes(basin.root, basins[basin.through].root);
+		}
+		else {
+			grow.push_back(basin.throughNode);
+		}
+	}
+	for (unsigned node: part) {
+		pieceOf[node] = NO_PIECE;
+	}
+}
+
+/*
+	Note that a basin topping its cavern (with those joined to it),
+	if not deep enough above a saddle met with another through a
+	basin joining a third, may join that one: over the highest
+	such saddle (ties to the lower id).
+*/
+void GridRooms::joinThrough(unsigned top, const Saddle& saddle)
+{
+	Basin& basin = basins[basins[top].group];
+	if (!basin.top || basin.peak >= saddle.depth + SplitDepth) {
+		return;
+	}
+	if (basin.throughId == NO_NODE || saddle.depth > basin.throughSaddle
+	        || (saddle.depth == basin.throughSaddle
+	            && saddle.id < basin.throughId)) {
+		basin.throughSaddle = saddle.depth;
+		basin.throughId = saddle.id;
+		basin.through = saddle.key;
+		basin.throughNode = saddle.node;
+	}
+}
+
+// Make a piece for each set of nodes joined,
+// with its size, extent & centroid
+void GridRooms::makePieces()
+{
+	pieces.clear();
+	for (unsigned node: part) {
+		GridCoord gc = getCoord(node);
+		unsigned root = findRoot(node);
+		if (pieceOf[root] == NO_PIECE) {
+			pieceOf[root] = (unsigned) pieces.size();
+			pieces.push_back({
+				(flags[root] & FLAG_ROOMY) != 0,
+				(flags[root] & FLAG_WIDE) != 0, 0,
+				{gc.x, gc.y, gc.x + 1, gc.y + 1}, NO_PIECE, NO_NODE, false,
+				pieceOf[root], 0, 0, 0, 0
+			});
+		}
+		unsigned index = pieceOf[root];
+		pieceOf[node] = index;
+		Piece& piece = pieces[index];
+		piece.cells++;
+		piece.bounds.left = min(piece.bounds.left, gc.x);
+		piece.bounds.top = min(piece.bounds.top, gc.y);
+		piece.bounds.right = max(piece.bounds.right, gc.x + 1);
+		piece.bounds.bottom = max(piece.bounds.bottom, gc.y + 1);
+		piece.sumX += gc.x;
+		piece.sumY += gc.y;
+	}
+}
+
+/*
+	Find the wide pieces each other piece opens into (in the
+	part or out), & join small ones opening into just one. Small
+	pieces outside that would now join a room, & small ones
+	joining a room outside, need their segments taken in.
+*/
+void GridRooms::touchPieces()
+{
+	for (unsigned node: part) {
+		bool wide = (flags[node] & FLAG_WIDE) != 0;
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next, opening;
+			if (!getStep(node, (Direction) side, next, opening)
+			        || wide == ((flags[next] & FLAG_WIDE) != 0)) {
+				continue;
+			}
+			if (!(flags[next] & FLAG_PART)) {
+				if (!wide) {
+					touchPiece(pieces[pieceOf[node]], NO_PIECE, next);
+				}
+				else if (isPieceJoining(next)) {
+					grow.push_back(next);
+				}
+			}
+			else if (!wide) {
+				touchPiece(pieces[pieceOf[node]], pieceOf[next], NO_NODE);
+			}
+		}
+	}
+	for (Piece& piece: pieces) {
+		if (piece.wide || piece.touchMany || piece.cells > AlcoveCells) {
+			continue;
+		}
+		if (piece.touchOutside != NO_NODE) {
+			grow.push_back(piece.touchOutside);
+		}
+		else if (piece.touchRoom != NO_PIECE) {
+			piece.target = piece.touchRoom;
+			Piece& room = pieces[piece.touchRoom];
+			room.cells += piece.cells;
+			room.bounds.left = min(room.bounds.left, piece.bounds.left);
+			room.bounds.top = min(room.bounds.top, piece.bounds.top);
+			room.bounds.right = max(room.bounds.right, piece.bounds.right);
+			room.bounds.bottom = max(room.bounds.bottom, piece.bounds.bottom);
+			room.sumX += piece.sumX;
+			room.sumY += piece.sumY;
+		}
+	}
+}
+
+// Note a wide piece (or a wide node outside the part) that
+// a piece opens into
+void GridRooms::touchPiece(Piece& piece, unsigned room, unsigned outside)
+{
+	if (piece.touchRoom == NO_PIECE && piece.touchOutside == NO_NODE) {
+		piece.touchRoom = room;
+		piece.touchOutside = outside;
+	}
+	else if (room != NO_PIECE ? piece.touchRoom != room
+	         : piece.touchOutside == NO_NODE
+	         || segments[piece.touchOutside] != segments[outside]) {
+		piece.touchMany = true;
+	}
+}
+
+/*
+	Make a segment of each piece left (with those joined to it),
+	a room or corridor. Wide pieces are rooms, & roomy ones too
+	if they fill half their extent & aren't long (else they're
+	wide corridors); narrow ones are corridors. Label each at
+	the cell nearest its centroid.
+*/
+void GridRooms::makeSegments()
+{
+	for (unsigned index = 0; index < pieces.size(); index++) {
+		Piece& piece = pieces[index];
+		if (piece.target != index) {
+			continue;
+		}
+		unsigned across = piece.bounds.right - piece.bounds.left;
+		unsigned down = piece.bounds.bottom - piece.bounds.top;
+		bool room = piece.wide
+		            || (piece.roomy && piece.cells * 2 >= across * down
+		                && max(across, down) < HallRatio * min(across, down));
+		RoomSegment info = {
+			room ? SEGMENT_ROOM : SEGMENT_CORRIDOR,
+			piece.cells, piece.bounds, {piece.bounds.left, piece.bounds.top}
+		};
+		if (freeSegments.empty()) {
+			piece.segment = (unsigned) segmentInfo.size();
+			segmentInfo.push_back(info);
+		}
+		else {
+			piece.segment = freeSegments.back();
+			freeSegments.pop_back();
+			segmentInfo[piece.segment] = info;
+		}
+		if (info.kind == SEGMENT_ROOM) {
+			roomCount++;
+		}
+		piece.sumX /= piece.cells;
+		piece.sumY /= piece.cells;
+		piece.labelDistance = UINT_MAX;
+	}
+	for (unsigned node: part) {
+		GridCoord gc = getCoord(node);
+		Piece& piece = pieces[pieces[pieceOf[node]].target];
+		segments[node] = piece.segment;
+
+		// Nearest cell to centroid so far, in quarter cells
+		int dx = (int) (4 * gc.x) - (int) (4 * piece.sumX);
+		int dy = (int) (4 * gc.y) - (int) (4 * piece.sumY);
+		unsigned distance = dx * dx + dy * dy;
+		if (distance < piece.labelDistance) {
+			piece.labelDistance = distance;
+			segmentInfo[piece.segment].label = gc;
+		}
+	}
+}
+
+// Take every node out of the part
+void GridRooms::clearPart()
+{
+	for (unsigned node: part) {
+		flags[node] &= ~FLAG_PART;
+	}
+	part.clear();
+}
+
+// Drop a segment (if not dropped already) for reuse
+void GridRooms::freeSegment(unsigned segment)
+{
+	RoomSegment& info = segmentInfo[segment];
+	if (info.cells) {
+		if (info.kind == SEGMENT_ROOM) {
+			roomCount--;
+		}
+		info.cells = 0;
+		freeSegments.push_back(segment);
+	}
+}
+
+/*
+	Find the peak depth & id of the basin a wide node outside
+	the part is in: climb to its peak, & find the first node of
+	the peaks of the same depth joined there.
+*/
+void GridRooms::getOutsideBasin(unsigned node, unsigned& peak, unsigned& id)
+{
+	for (unsigned up = getUphill(node); up != NO_NODE; up = getUphill(node)) {
+		node = up;
+	}
+	peak = depths[node];
+	auto known = peakIds.find(node);
+	if (known != peakIds.end()) {
+		id = known->second;
+		return;
+	}
+	std::vector<unsigned> found(1, node);
+	peakIds[node] = NO_NODE;
+	id = node;
+	for (size_t i = 0; i < found.size(); i++) {
+		id = min(id, found[i]);
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next;
+			if (getWideStep(found[i], (Direction) side, next)
+			        && depths[next] == peak && !peakIds.count(next)
+			        && getUphill(next) == NO_NODE) {
+				peakIds[next] = NO_NODE;
+				found.push_back(next);
+			}
+		}
+	}
+	for (unsigned n: found) {
+		peakIds[n] = id;
+	}
+}
+
+/*
+	Would the piece of a node outside the part (not wide) join a
+	room, now that the part is segmented? Only if small enough
+	for an alcove & opening into one room (a piece of the part,
+	or one segment outside).
+*/
+bool GridRooms::isPieceJoining(unsigned node)
+{
+	std::vector<unsigned> found(1, node);
+	for (size_t i = 0; i < found.size() && found.size() <= AlcoveCells; i++) {
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next, opening;
+			if (getStep(found[i], (Direction) side, next, opening)
+			        && isJoined(found[i], next, opening)
+			        && std::find(found.begin(), found.end(), next)
+			           == found.end()) {
+				found.push_back(next);
+			}
+		}
+	}
+	if (found.size() > AlcoveCells) {
+		return false;
+	}
+	Piece touch = {};
+	touch.touchRoom = NO_PIECE;
+	touch.touchOutside = NO_NODE;
+	for (unsigned member: found) {
+		for (int side = NORTH; side <= WEST; side++) {
+			unsigned next, opening;
+			if (!getStep(member, (Direction) side, next, opening)
+			        || !(flags[next] & FLAG_WIDE)) {
+				continue;
+			}
+			if (flags[next] & FLAG_PART) {
+				touchPiece(touch, pieceOf[next], NO_NODE);
+			}
+			else {
+				touchPiece(touch, NO_PIECE, next);
+			}
+		}
+	}
+	return !touch.touchMany;
+}
+
+//------------------------------------------------------------------
+// Nodes
+//------------------------------------------------------------------
+
+// Get the node for one half of a cell
+unsigned GridRooms::getNode(GridCoord gc, int half) const
+{
+	return gc.x * height + gc.y + (half ? cells : 0);
+}
+
+// Get the cell of a node
+GridCoord GridRooms::getCoord(unsigned node) const
+{
+	unsigned cell = node % cells;
+	return {cell / height, cell % height};
+}
+
+// Grow a block by some cells each way (within the map)
+GridRect GridRooms::growBlock(GridRect block, unsigned by) const
+{
+	return {
+		block.left > by ? block.left - by : 0,
+		block.top > by ? block.top - by : 0,
+		min(block.right + by, width),
+		min(block.bottom + by, height)
+	};
+}
+
+// Is a cell whole open floor (no diagonal) & open?
+bool GridRooms::isCellWhole(unsigned cell) const
+{
+	FloorType floor = (FloorType) map->getColumn(cell / height)[cell % height].floor;
+	return (flags[cell] & FLAG_AREA) && IsFloorOpenType(floor)
+	       && !IsFloorSplit(floor);
+}
+
+/*
+	Step out of an open node across one side (doors shut) to
+	another. If so, sets the node stepped into & the width of
+	the opening stepped through.
+*/
+bool GridRooms::getStep(
+    unsigned node, Direction side, unsigned& next, unsigned& opening) const
+{
+	if (node >= 2 * cells || !(steps[node] & (STEP_OPEN << side))) {
+		return false;
+	}
+	unsigned cell = node % cells;
+	switch (side) {
+		case NORTH: next = cell - 1; opening = openN[cell]; break;
+		case SOUTH: next = cell + 1; opening = openN[next]; break;
+		case EAST: next = cell + height; opening = openW[next]; break;
+		default: next = cell - height; opening = openW[cell]; break;
+	}
+	if (steps[node] & (STEP_HALF << side)) {
+		next += cells;
+	}
+	return true;
+}
+
+// Step from a wide node to a wide node, across an opening wide
+// enough to join them
+bool GridRooms::getWideStep(unsigned node, Direction side, unsigned& next) const
+{
+	unsigned opening;
+	return getStep(node, side, next, opening) && (flags[next] & FLAG_WIDE)
+	       && opening >= JoinOpening;
+}
+
+// Do two nodes (not wide) stepped between join one piece?
+bool GridRooms::isJoined(unsigned node, unsigned next, unsigned opening) const
+{
+	const unsigned char kind = FLAG_ROOMY | FLAG_WIDE;
+	return (flags[node] & kind) == (flags[next] & kind)
+	       && (!(flags[node] & kind) || opening >= JoinOpening);
+}
+
+// Get the deepest wide node deeper than a wide node beside it
+// (the first such side if tied; NO_NODE if none)
+unsigned GridRooms::getUphill(unsigned node) const
+{
+	unsigned up = NO_NODE;
+	for (int side = NORTH; side <= WEST; side++) {
+		unsigned next;
+		if (getWideStep(node, (Direction) side, next)
+		        && depths[next] > depths[node]
+		        && (up == NO_NODE || depths[next] > depths[up])) {
+			up = next;
+		}
+	}
+	return up;
+}
+
+// Find the root of a node's set (halving the path)
+unsigned GridRooms::findRoot(unsigned node)
+{
+	while (parents[node] != node) {
+		parents[node] = parents[parents[node]];
+		node = parents[node];
+	}
+	return node;
+}
+
+// Join the sets of two nodes
+void GridRooms::unionNodes(unsigned a, unsigned b)
+{
+	a = findRoot(a);
+	b = findRoot(b);
+	if (a != b) {
+		parents[max(a, b)] = min(a, b);
+	}
+}
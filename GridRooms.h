@@ -0,0 +1,192 @@
+/*
+	Name: GridRooms.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Rooms & corridors of a map, found & numbered.
+		Open space (with every door shut) is sorted by clearance:
+		cells in a 2x2 of open floor are roomy, & in a 3x3 wide.
+		Like cells join across openings two or more wide (so gaps
+		one wide are chokepoints); wide space is then split into
+		basins by its depth (steps to the nearest wall), each node
+		climbing to its deepest neighbour. Basins as deep join
+		unless both are deep enough above a saddle between them,
+		& then any not deep enough above its highest saddle with
+		a deeper basin joins that one, so caverns part at necks.
+		Narrow cells make corridors, & small bits of them join the
+		room they open into (alcoves, corners). Every rule looks
+		only at cells nearby, so clearance, openings & depths are
+		kept & patched around edits, & edits re-segment only the
+		segments around the cells edited (& those beside them),
+		taking in more wherever a result would reach past them.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDROOMS_H
+#define GRIDROOMS_H
+#include "GridRegions.h"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Kinds of segment
+enum SegmentKind {SEGMENT_ROOM, SEGMENT_CORRIDOR};
+
+/*
+	One room or corridor: its kind, size (split cells count on
+	both sides), extent, & a cell to label it at (the one
+	nearest its centroid).
+*/
+struct RoomSegment {
+	SegmentKind kind;
+	unsigned cells;
+	GridRect bounds;
+	GridCoord label;
+};
+
+/*
+	GridRooms interface
+	Segments are numbered from 1 (0 is none, as for fill); rooms
+	are also numbered in reading order of their labels. Call
+	build() first; after any edit to the map, call updateCells()
+	with the cells whose floor or north or west wall changed (the
+	map must keep its size).
+*/
+class GridRooms {
+	public:
+
+		// Constructor
+		GridRooms(const GridMap& map);
+
+		// Building & editing
+		void build();
+		void updateCells(GridRect cells);
+		void updateCell(GridCoord gc);
+
+		// Results
+		unsigned getSegment(GridCoord gc, int half = 0) const;
+		unsigned getSegmentLimit() const;
+		const RoomSegment& getSegmentInfo(unsigned segment) const;
+		void getRoomOrder(std::vector<unsigned>& rooms) const;
+		unsigned getRoomCount() const;
+
+	private:
+
+		// Piece of the part being segmented: narrow, roomy or wide
+		// nodes joined, what it opens into (a piece, or a node
+		// outside the part), & what it becomes
+		struct Piece {
+			bool roomy, wide;
+			unsigned cells;
+			GridRect bounds;
+			unsigned touchRoom, touchOutside;
+			bool touchMany;
+			unsigned target;
+			double sumX, sumY;
+			unsigned segment;
+			unsigned labelDistance;
+		};
+
+		// Basin of wide nodes: its root, peak depth & id (first node
+		// at the peak), & the basin keeping the set of basins of its
+		// peak depth joined to it. That one keeps the set's key (the
+		// saddle, id & index, if in the part, of the deeper basin
+		// over their highest saddle), whether the set joins none
+		// (tops its cavern), & if so the saddle, id, index & node of
+		// the basin it joins through another
+		struct Basin {
+			unsigned root, id, group;
+			unsigned char peak, saddle, throughSaddle;
+			unsigned keyId, key, throughId, through, throughNode;
+			bool top;
+		};
+
+		// Saddle of basins joined (at a basin) with a basin of another
+		// peak depth (in the part, or a node of it outside)
+		struct Saddle {
+			unsigned basin, key, node, id;
+			unsigned char peak, depth;
+		};
+
+		// Clearance, openings & depths
+		void findArea(GridRect block);
+		void findSquares(GridRect block);
+		void findRoomy(GridRect block);
+		void findOpenings(GridRect block);
+		void findDepths(GridRect block);
+		void updateDepths(GridRect edited);
+		bool areDepthsSettled(GridRect block) const;
+		bool isOpenBlock(unsigned x, unsigned y) const;
+		bool isNodeClosed(unsigned node) const;
+		unsigned char measureOpening(GridCoord gc, Direction side) const;
+		bool isEdgeOpen(GridCoord gc, Direction side) const;
+		bool isEdgeJoined(GridCoord gc, Direction side, Direction along) const;
+		bool isSideJoined(GridCoord gc, Direction face, Direction along) const;
+
+		// Segmenting the part
+		void addSegment(unsigned node);
+		bool segmentPart();
+		void joinPieces();
+		void joinWide();
+		void joinBasins();
+		void joinThrough(unsigned top, const Saddle& saddle);
+		void makePieces();
+		void touchPieces();
+		void touchPiece(Piece& piece, unsigned room, unsigned outside);
+		void makeSegments();
+		void clearPart();
+		void freeSegment(unsigned segment);
+		void getOutsideBasin(unsigned node, unsigned& peak, unsigned& id);
+		bool isPieceJoining(unsigned node);
+
+		// Nodes (cell halves, second halves after the cells)
+		unsigned getNode(GridCoord gc, int half) const;
+		GridCoord getCoord(unsigned node) const;
+		GridRect growBlock(GridRect block, unsigned by) const;
+		bool isCellWhole(unsigned cell) const;
+		bool getStep(
+		    unsigned node, Direction side, unsigned& next,
+		    unsigned& opening) const;
+		bool getWideStep(unsigned node, Direction side, unsigned& next) const;
+		bool isJoined(unsigned node, unsigned next, unsigned opening) const;
+		unsigned getUphill(unsigned node) const;
+		unsigned findRoot(unsigned node);
+		void unionNodes(unsigned a, unsigned b);
+
+		// Map & passage with doors shut
+		const GridMap *map;
+		unsigned width, height, cells;
+		PassOptions shut;
+
+		// Segment per node, & each segment (free slots reused)
+		std::vector<unsigned> segments;
+		std::vector<RoomSegment> segmentInfo;
+		std::vector<unsigned> freeSegments;
+		unsigned roomCount;
+
+		// Per cell: largest open square ending at each (up to 3) &
+		// widths of openings on north & west edges (up to
+		// JoinOpening); per node: flags (open, roomy, wide, in the
+		// part), steps out of it & depth in open space
+		std::vector<unsigned char> squares, openN, openW;
+		std::vector<unsigned char> flags, steps, depths;
+
+		// Nodes to segment (the part) in reading order, nodes outside
+		// it whose segments it must take in, & nodes whose depth an
+		// update changed (with depths before)
+		std::vector<unsigned> part, grow;
+		std::vector<std::pair<unsigned, unsigned char>> oldDepths;
+
+		// Scratch per node: union-find parent, node climbed to, &
+		// piece (or basin); pieces, basins & saddles of the part
+		std::vector<unsigned> parents, climbs, pieceOf;
+		std::vector<Piece> pieces;
+		std::vector<Basin> basins;
+		std::vector<Saddle> saddles;
+
+		// Nodes by depth (finding depths), & ids of peaks outside the
+		// part (by any node at the peak)
+		std::vector<std::vector<unsigned>> levels;
+		std::unordered_map<unsigned, unsigned> peakIds;
+};
+#endif
@@ -0,0 +1,860 @@
+/*
+	Name: GridRoutes.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of routing by door graph.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridRoutes.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <utility>
+using std::min;
+using std::max;
+
+// Door keys: three per cell (north wall, west wall, diagonal)
+const unsigned KEY_NWALL = 0;
+const unsigned KEY_WWALL = 1;
+const unsigned KEY_DIAGONAL = 2;
+const unsigned NO_KEY = UINT_MAX;
+
+// Route parents: none, or the start (plus its half)
+const unsigned NO_END = UINT_MAX;
+const unsigned FROM_START = UINT_MAX - 3;
+
+//------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------
+
+// Get the cost of the fewest steps between two cells,
+// by the cheapest straight & corner-to-corner steps
+static unsigned GetOctileCost(
+    GridCoord a, GridCoord b, unsigned step, unsigned diagonal)
+{
+	unsigned dx = abs((int) a.x - (int) b.x);
+	unsigned dy = abs((int) a.y - (int) b.y);
+	unsigned both = min(dx, dy);
+	return both * diagonal + (max(dx, dy) - both) * step;
+}
+
+// Add a cell to a path, unless already at its end
+static void AddPathCell(std::vector<GridCoord>& path, GridCoord gc)
+{
+	if (path.empty() || path.back().x != gc.x || path.back().y != gc.y) {
+		path.push_back(gc);
+	}
+}
+
+//------------------------------------------------------------------
+// Construction & building
+//------------------------------------------------------------------
+
+GridRoutes::GridRoutes(const GridMap& _map, const MoveOptions& _options)
+{
+	map = &_map;
+	options = _options;
+	width = map->getWidthCells();
+	height = map->getHeightCells();
+
+	// Rooms are what's left joined with every door shut
+	shutOptions = options;
+	shutOptions.pass.singleDoors = false;
+	shutOptions.pass.doubleDoors = false;
+	shutOptions.pass.secretDoors = false;
+	shutOptions.pass.diagonalDoors = false;
+	rooms = GridRegions(shutOptions.pass);
+
+	// Cheapest straight & corner steps, for estimates
+	guessStep = options.stepCost;
+	guessDiagonal = 2 * options.stepCost;
+	if (options.diagonals) {
+		guessStep = min(guessStep, options.diagonalCost);
+		guessDiagonal = min(guessDiagonal, options.diagonalCost);
+	}
+	stamp = 0;
+	routeFromHalf = routeToHalf = 0;
+}
+
+/*
+	Label the rooms, find every door & cost every room
+	(rooms spread over threads; 0 for all cores).
+*/
+void GridRoutes::build(unsigned threads)
+{
+	if (threads == 0) {
+		threads = max(1u, std::thread::hardware_concurrency());
+	}
+	rooms.labelMap(*map, threads);
+
+	// Find doors
+	doors.clear();
+	freeDoors.clear();
+	doorKeys.clear();
+	roomEnds.clear();
+	for (unsigned x = 0; x < width; x++) {
+		const GridCell *column = map->getColumn(x);
+		for (unsigned y = 0; y < height; y++) {
+			unsigned key = (x * height + y) * 3;
+			if (column[y].nwall != WALL_OPEN && column[y].nwall != WALL_FILL) {
+				findDoor(key + KEY_NWALL);
+			}
+			if (column[y].wwall != WALL_OPEN && column[y].wwall != WALL_FILL) {
+				findDoor(key + KEY_WWALL);
+			}
+			if (IsFloorSplit((FloorType) column[y].floor)) {
+				findDoor(key + KEY_DIAGONAL);
+			}
+		}
+	}
+
+	// Cost the rooms with doors
+	std::vector<unsigned> labels;
+	for (unsigned end = 0; end < doors.size() * 2; end++) {
+		labels.push_back(getEndRoom(end));
+	}
+	std::sort(labels.begin(), labels.end());
+	labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+	collectRoomEnds(labels);
+	costRooms(labels, threads);
+}
+
+/*
+	Update after one cell's floor or north or west wall changed:
+	relabel rooms around it, find its doors again (& those it
+	faces south & east), & re-cost the rooms around it (all
+	that any change to it could reach).
+*/
+void GridRoutes::updateCell(GridCoord gc)
+{
+	assert(map->getWidthCells() == width && map->getHeightCells() == height);
+	std::vector<unsigned> labels;
+	getAroundLabels(gc, labels);
+	rooms.updateCell(*map, gc);
+
+	// Find doors again
+	unsigned key = (gc.x * height + gc.y) * 3;
+	std::vector<unsigned> keys = {
+		key + KEY_NWALL, key + KEY_WWALL, key + KEY_DIAGONAL
+	};
+	if (gc.y + 1 < height) {
+		keys.push_back(key + 3 + KEY_NWALL);
+	}
+	if (gc.x + 1 < width) {
+		keys.push_back(key + height * 3 + KEY_WWALL);
+	}
+	for (unsigned doorKey: keys) {
+		dropDoor(doorKey);
+		findDoor(doorKey);
+	}
+
+	// Drop rooms gone & re-cost those left
+	getAroundLabels(gc, labels);
+	std::sort(labels.begin(), labels.end());
+	labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+	std::vector<unsigned> live;
+	for (unsigned label: labels) {
+		if (rooms.getRegionStats(label).cells) {
+			live.push_back(label);
+		}
+		else {
+			roomEnds.erase(label);
+		}
+	}
+	collectRoomEnds(live);
+	costRooms(live, 1);
+}
+
+//------------------------------------------------------------------
+// Room searches
+//------------------------------------------------------------------
+
+GridRoutes::RoomSearch::RoomSearch()
+{
+	bounds = {0, 0, 0, 0};
+	high = area = 0;
+	stamp = 0;
+	aimed = false;
+	goal = {0, 0};
+	step = diagonal = 0;
+}
+
+// Get the node for one half of a cell in the bounds
+unsigned GridRoutes::RoomSearch::node(GridCoord gc, int half) const
+{
+	return (gc.x - bounds.left) * high + (gc.y - bounds.top)
+	       + (half ? area : 0);
+}
+
+// Get the cell of a node
+GridCoord GridRoutes::RoomSearch::coord(unsigned node) const
+{
+	unsigned cell = node % area;
+	return {bounds.left + cell / high, bounds.top + cell % high};
+}
+
+// Estimate the cost on from a node to the goal (0 if not aimed)
+unsigned GridRoutes::RoomSearch::guess(unsigned node) const
+{
+	return aimed ? GetOctileCost(coord(node), goal, step, diagonal) : 0;
+}
+
+// Start a search over a room's bounds (not aimed, no targets)
+void GridRoutes::RoomSearch::start(GridRect _bounds)
+{
+	bounds = _bounds;
+	high = bounds.bottom - bounds.top;
+	area = (bounds.right - bounds.left) * high;
+	if (marks.size() < (size_t) area * 2) {
+		costs.resize((size_t) area * 2);
+		parents.resize((size_t) area * 2);
+		marks.assign((size_t) area * 2, 0);
+		stamp = 0;
+	}
+	if (stamp == UINT_MAX) {
+		std::fill(marks.begin(), marks.end(), 0);
+		stamp = 0;
+	}
+	stamp++;
+	heap.clear();
+	targets.clear();
+	aimed = false;
+}
+
+// Aim a search at a goal, by the cheapest step costs
+// (before reaching any node)
+void GridRoutes::RoomSearch::aim(
+    GridCoord _goal, unsigned _step, unsigned _diagonal)
+{
+	assert(heap.empty());
+	aimed = true;
+	goal = _goal;
+	step = _step;
+	diagonal = _diagonal;
+}
+
+// Add one half of a cell the search must settle
+void GridRoutes::RoomSearch::addTarget(GridCoord gc, int half)
+{
+	targets.push_back(node(gc, half));
+}
+
+// Reach a node at a cost, if cheaper than before
+void GridRoutes::RoomSearch::reach(
+    unsigned node, unsigned parent, unsigned cost)
+{
+	if (marks[node] == stamp && cost >= costs[node]) {
+		return;
+	}
+	marks[node] = stamp;
+	costs[node] = cost;
+	parents[node] = parent;
+	heap.push_back({cost + guess(node), node});
+	std::push_heap(
+	    heap.begin(), heap.end(),
+	    std::greater<std::pair<unsigned, unsigned>>());
+}
+
+/*
+	Search out from the nodes reached so far, until every target
+	is settled (or, with none, every node of the room).
+*/
+void GridRoutes::RoomSearch::run(
+    const GridMap& map, const MoveOptions& options)
+{
+	std::sort(targets.begin(), targets.end());
+	targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+	size_t pending = targets.size();
+	GridMove moves[MOVE_MAX];
+	while (!heap.empty()) {
+		std::pop_heap(
+		    heap.begin(), heap.end(),
+		    std::greater<std::pair<unsigned, unsigned>>());
+		unsigned estimate = heap.back().first;
+		unsigned node = heap.back().second;
+		heap.pop_back();
+		unsigned cost = costs[node];
+		if (estimate != cost + guess(node)) {
+			continue;
+		}
+		if (pending && std::binary_search(targets.begin(), targets.end(), node)
+		        && --pending == 0) {
+			return;
+		}
+		GridCoord gc = coord(node);
+		unsigned count =
+		    GetMoves(map, gc, node < area ? 0 : 1, options, moves);
+		for (unsigned i = 0; i < count; i++) {
+			const GridMove& move = moves[i];
+			assert(move.cell.x >= bounds.left && move.cell.x < bounds.right
+			       && move.cell.y >= bounds.top && move.cell.y < bounds.bottom);
+			reach(this->node(move.cell, move.half), node, cost + move.cost);
+		}
+	}
+}
+
+// Get the cost found to one half of a cell (NO_PATH if none);
+// exact for targets & (if not aimed) every node
+unsigned GridRoutes::RoomSearch::getCost(GridCoord gc, int half) const
+{
+	unsigned n = node(gc, half);
+	return marks[n] == stamp ? costs[n] : NO_PATH;
+}
+
+// Add the cells passed on the way to one half of a cell
+// (after the source) to a path
+void GridRoutes::RoomSearch::addPath(
+    GridCoord gc, int half, std::vector<GridCoord>& path) const
+{
+	size_t first = path.size();
+	for (unsigned n = node(gc, half); parents[n] != NO_END; n = parents[n]) {
+		GridCoord cell = coord(n);
+		if (path.size() == first || path.back().x != cell.x
+		        || path.back().y != cell.y) {
+			path.push_back(cell);
+		}
+	}
+	std::reverse(path.begin() + first, path.end());
+	if (path.size() > first && first > 0
+	        && path[first].x == path[first - 1].x
+	        && path[first].y == path[first - 1].y) {
+		path.erase(path.begin() + first);
+	}
+}
+
+//------------------------------------------------------------------
+// Doors
+//------------------------------------------------------------------
+
+/*
+	Get the door at a key, if any: a door wall passable by the
+	move options with an open half on either side, or a passable
+	diagonal door.
+*/
+bool GridRoutes::getDoorAt(unsigned key, Door& door) const
+{
+	unsigned cell = key / 3;
+	GridCoord gc = {cell / height, cell % height};
+	FloorType floor = map->getCellFloor(gc);
+	door.key = key;
+	if (key % 3 == KEY_DIAGONAL) {
+		door.ends[0] = {gc, 0};
+		door.ends[1] = {gc, 1};
+		door.crossCosts[0] = door.crossCosts[1] = options.doorCost;
+		return IsFloorSplit(floor) && AreHalvesJoined(floor, options.pass);
+	}
+	WallType wall;
+	if (key % 3 == KEY_NWALL) {
+		if (gc.y == 0) {
+			return false;
+		}
+		wall = map->getCellNWall(gc);
+		GridCoord north = {gc.x, gc.y - 1};
+		door.ends[0] = {north, GetCellSideHalf(map->getCellFloor(north), SOUTH)};
+		door.ends[1] = {gc, GetCellSideHalf(floor, NORTH)};
+	}
+	else {
+		if (gc.x == 0) {
+			return false;
+		}
+		wall = map->getCellWWall(gc);
+		GridCoord west = {gc.x - 1, gc.y};
+		door.ends[0] = {west, GetCellSideHalf(map->getCellFloor(west), EAST)};
+		door.ends[1] = {gc, GetCellSideHalf(floor, WEST)};
+	}
+	if (wall == WALL_OPEN || !IsWallPassable(wall, options.pass)
+	        || door.ends[0].half == NO_HALF || door.ends[1].half == NO_HALF) {
+		return false;
+	}
+	for (int e = 0; e < 2; e++) {
+		door.crossCosts[e] = options.stepCost + options.doorCost
+		                     + getEntryCost(door.ends[1 - e].cell);
+	}
+	return true;
+}
+
+// Add the door at a key, if any
+void GridRoutes::findDoor(unsigned key)
+{
+	Door door;
+	if (!getDoorAt(key, door)) {
+		return;
+	}
+	unsigned index;
+	if (freeDoors.empty()) {
+		index = (unsigned) doors.size();
+		doors.push_back(door);
+		endRooms.resize(doors.size() * 2);
+		endSlots.resize(doors.size() * 2);
+	}
+	else {
+		index = freeDoors.back();
+		freeDoors.pop_back();
+		doors[index] = door;
+	}
+	doorKeys[key] = index;
+}
+
+// Take out the door at a key, if any
+void GridRoutes::dropDoor(unsigned key)
+{
+	auto found = doorKeys.find(key);
+	if (found != doorKeys.end()) {
+		doors[found->second].key = NO_KEY;
+		freeDoors.push_back(found->second);
+		doorKeys.erase(found);
+	}
+}
+
+// Get the room a door end is in
+unsigned GridRoutes::getEndRoom(unsigned end) const
+{
+	const DoorEnd& doorEnd = doors[end / 2].ends[end % 2];
+	return rooms.getLabel(doorEnd.cell, doorEnd.half);
+}
+
+//------------------------------------------------------------------
+// Rooms
+//------------------------------------------------------------------
+
+/*
+	List the door ends in each of some rooms (labels sorted).
+	Doors are looked for within the rooms' bounds, unless that's
+	more cells than doors in all.
+*/
+void GridRoutes::collectRoomEnds(const std::vector<unsigned>& labels)
+{
+	std::vector<unsigned> found;
+	unsigned long long area = 0;
+	for (unsigned label: labels) {
+		roomEnds.erase(label);
+		const GridRect& bounds = rooms.getRegionStats(label).bounds;
+		area += (unsigned long long) (bounds.right - bounds.left + 1)
+		        * (bounds.bottom - bounds.top + 1);
+	}
+	if (area < doors.size()) {
+
+		// Doors keyed in bounds, or just past (walls to south & east)
+		for (unsigned label: labels) {
+			const GridRect& bounds = rooms.getRegionStats(label).bounds;
+			unsigned right = min(bounds.right + 1, width);
+			unsigned bottom = min(bounds.bottom + 1, height);
+			for (unsigned x = bounds.left; x < right; x++) {
+				for (unsigned y = bounds.top; y < bottom; y++) {
+					unsigned key = (x * height + y) * 3;
+					for (unsigned k = 0; k < 3; k++) {
+						auto door = doorKeys.find(key + k);
+						if (door != doorKeys.end()) {
+							found.push_back(door->second);
+						}
+					}
+				}
+			}
+		}
+		std::sort(found.begin(), found.end());
+		found.erase(std::unique(found.begin(), found.end()), found.end());
+	}
+	else {
+		for (unsigned d = 0; d < doors.size(); d++) {
+			if (doors[d].key != NO_KEY) {
+				found.push_back(d);
+			}
+		}
+	}
+	for (unsigned d: found) {
+		for (unsigned end = 2 * d; end < 2 * d + 2; end++) {
+			unsigned label = getEndRoom(end);
+			if (std::binary_search(labels.begin(), labels.end(), label)) {
+				Room& room = roomEnds[label];
+				endRooms[end] = &room;
+				endSlots[end] = (unsigned) room.ends.size();
+				room.ends.push_back(end);
+			}
+		}
+	}
+}
+
+/*
+	Find the costs between the door ends of some rooms,
+	a search from each end over its room.
+*/
+void GridRoutes::costRooms(const std::vector<unsigned>& labels, unsigned threads)
+{
+	std::vector<std::pair<unsigned, Room*>> work;
+	for (unsigned label: labels) {
+		auto found = roomEnds.find(label);
+		if (found != roomEnds.end()) {
+			work.push_back({label, &found->second});
+		}
+	}
+	std::atomic<unsigned> next(0);
+	auto task = [&]() {
+		RoomSearch search;
+		unsigned i;
+		while ((i = next++) < work.size()) {
+			Room& room = *work[i].second;
+			GridRect bounds = rooms.getRegionStats(work[i].first).bounds;
+			unsigned count = (unsigned) room.ends.size();
+			room.costs.assign((size_t) count * count, NO_PATH);
+			if (count == 1) {
+				room.costs[0] = 0;
+				continue;
+			}
+			for (unsigned from = 0; from < count; from++) {
+				const DoorEnd& start =
+				    doors[room.ends[from] / 2].ends[room.ends[from] % 2];
+				search.start(bounds);
+				for (unsigned to = 0; to < count; to++) {
+					const DoorEnd& end =
+					    doors[room.ends[to] / 2].ends[room.ends[to] % 2];
+					search.addTarget(end.cell, end.half);
+				}
+				search.reach(search.node(start.cell, start.half), NO_END, 0);
+				search.run(*map, shutOptions);
+				for (unsigned to = 0; to < count; to++) {
+					const DoorEnd& end =
+					    doors[room.ends[to] / 2].ends[room.ends[to] % 2];
+					room.costs[from * count + to] =
+					    search.getCost(end.cell, end.half);
+				}
+			}
+		}
+	};
+	threads = max(1u, min(threads, (unsigned) work.size()));
+	if (threads == 1) {
+		task();
+		return;
+	}
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < threads; t++) {
+		pool.push_back(std::thread(task));
+	}
+	for (std::thread& worker: pool) {
+		worker.join();
+	}
+}
+
+// Add the rooms of a cell's halves & the halves next to it
+void GridRoutes::getAroundLabels(
+    GridCoord gc, std::vector<unsigned>& labels) const
+{
+	GridCoord around[5] = {
+		gc, {gc.x, gc.y - 1}, {gc.x, gc.y + 1},
+		{gc.x - 1, gc.y}, {gc.x + 1, gc.y}
+	};
+	for (const GridCoord& cell: around) {
+		if (cell.x < width && cell.y < height) {
+			for (int half = 0; half <= 1; half++) {
+				unsigned label = rooms.getLabel(cell, half);
+				if (label) {
+					labels.push_back(label);
+				}
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------
+
+/*
+	Find a cheapest route between two cells, as the cells
+	it starts in, passes doors by, & ends in. Returns its cost.
+*/
+unsigned GridRoutes::findRoute(
+    GridCoord from, GridCoord to, std::vector<GridCoord>& waypoints)
+{
+	waypoints.clear();
+	unsigned cost = searchRoute(from, to);
+	if (cost != NO_PATH) {
+		AddPathCell(waypoints, from);
+		for (unsigned end: routeEnds) {
+			AddPathCell(waypoints, doors[end / 2].ends[end % 2].cell);
+		}
+		AddPathCell(waypoints, to);
+	}
+	return cost;
+}
+
+/*
+	Find a cheapest path between two cells, as the cells passed
+	through in order (as GridPaths::findPath). The route is found
+	first, then filled in by a search within each room on it.
+*/
+unsigned GridRoutes::findPath(
+    GridCoord from, GridCoord to, std::vector<GridCoord>& path)
+{
+	path.clear();
+	unsigned cost = searchRoute(from, to);
+	if (cost == NO_PATH) {
+		return cost;
+	}
+
+	// Legs from start to goal by way of each door end
+	std::vector<DoorEnd> stops;
+	stops.push_back({from, routeFromHalf});
+	for (unsigned end: routeEnds) {
+		stops.push_back(doors[end / 2].ends[end % 2]);
+	}
+	stops.push_back({to, routeToHalf});
+	path.push_back(from);
+	for (size_t i = 1; i < stops.size(); i++) {
+		const DoorEnd& start = stops[i - 1];
+		const DoorEnd& stop = stops[i];
+
+		// Step across a door (unless its ends were joined in a room)
+		if (i > 1 && i + 1 < stops.size()) {
+			unsigned prior = routeEnds[i - 2], next = routeEnds[i - 1];
+			unsigned step = endStates[next].cost - endStates[prior].cost;
+			if (next == (prior ^ 1)
+			        && step == doors[prior / 2].crossCosts[prior % 2]) {
+				AddPathCell(path, stop.cell);
+				continue;
+			}
+		}
+
+		// Else search the room between
+		startSearch(fromSearch, start.cell, start.half);
+		aimSearch(fromSearch, stop.cell);
+		fromSearch.addTarget(stop.cell, stop.half);
+		fromSearch.reach(
+		    fromSearch.node(start.cell, start.half), NO_END, 0);
+		fromSearch.run(*map, shutOptions);
+		fromSearch.addPath(stop.cell, stop.half, path);
+	}
+	return cost;
+}
+
+// Get the cost of a cheapest path between two cells (or NO_PATH)
+unsigned GridRoutes::getDistance(GridCoord from, GridCoord to)
+{
+	return searchRoute(from, to);
+}
+
+// Get the number of rooms (including those without doors)
+unsigned GridRoutes::getRoomCount() const
+{
+	return rooms.getRegionCount();
+}
+
+// Get the number of doors in the graph
+unsigned GridRoutes::getDoorCount() const
+{
+	return (unsigned) (doors.size() - freeDoors.size());
+}
+
+/*
+	Search for a cheapest route; returns the cost & keeps the door
+	ends passed. Each open half of the start is searched over its
+	room for the cost to each door end there (& to the goal, if in
+	the same room, aimed at it), & likewise back from each half of
+	the goal; each stops once those ends are settled.
+	Then door ends are searched by A*, moving across doors & to
+	the other ends in the same room, until no route through them
+	could beat the best found.
+*/
+unsigned GridRoutes::searchRoute(GridCoord from, GridCoord to)
+{
+	assert(map->getWidthCells() == width && map->getHeightCells() == height);
+	assert(from.x < width && from.y < height);
+	assert(to.x < width && to.y < height);
+	routeEnds.clear();
+
+	// New stamp for the door ends touched
+	unsigned endCount = (unsigned) doors.size() * 2;
+	if (endStates.size() < endCount) {
+		endStates.resize(endCount, {0, 0, 0, 0});
+	}
+	if (stamp > UINT_MAX - 2) {
+		for (EndState& state: endStates) {
+			state.mark = 0;
+		}
+		stamp = 0;
+	}
+	stamp += 2;
+	auto touch = [&](unsigned end) -> EndState& {
+		EndState& state = endStates[end];
+		if (state.mark != stamp && state.mark != stamp + 1) {
+			state = {NO_PATH, NO_END, NO_PATH, stamp};
+		}
+		return state;
+	};
+
+	// Search back from the goal: the cost from each door end
+	// in its room(s) is the cost back, less entering the end
+	// & plus entering the goal
+	unsigned best = NO_PATH, bestEnd = NO_END;
+	unsigned toLabels[2];
+	for (int half = 0; half <= 1; half++) {
+		toLabels[half] = rooms.getLabel(to, half);
+		auto room = roomEnds.find(toLabels[half]);
+		if (!toLabels[half] || room == roomEnds.end()) {
+			continue;
+		}
+		RoomSearch& search = toSearches[half];
+		startSearch(search, to, half);
+		for (unsigned end: room->second.ends) {
+			const DoorEnd& doorEnd = doors[end / 2].ends[end % 2];
+			search.addTarget(doorEnd.cell, doorEnd.half);
+		}
+		search.reach(search.node(to, half), NO_END, 0);
+		search.run(*map, shutOptions);
+		for (unsigned end: room->second.ends) {
+			const DoorEnd& doorEnd = doors[end / 2].ends[end % 2];
+			unsigned back = search.getCost(doorEnd.cell, doorEnd.half);
+			if (back != NO_PATH) {
+				EndState& state = touch(end);
+				state.tail = min(
+				    state.tail,
+				    back + getEntryCost(to) - getEntryCost(doorEnd.cell));
+			}
+		}
+	}
+
+	// Search out from the start to its room's door ends
+	// (& straight to the goal, if there)
+	typedef std::pair<unsigned, unsigned> HeapEntry;
+	std::priority_queue<
+	    HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+	RoomSearch& search = fromSearch;
+	for (int half = 0; half <= 1; half++) {
+		unsigned label = rooms.getLabel(from, half);
+		auto room = roomEnds.find(label);
+		bool withGoal = label
+		                && (toLabels[0] == label || toLabels[1] == label);
+		if (!label || (room == roomEnds.end() && !withGoal)) {
+			continue;
+		}
+		startSearch(search, from, half);
+		if (withGoal) {
+			aimSearch(search, to);
+			for (int toHalf = 0; toHalf <= 1; toHalf++) {
+				if (toLabels[toHalf] == label) {
+					search.addTarget(to, toHalf);
+				}
+			}
+		}
+		if (room != roomEnds.end()) {
+			for (unsigned end: room->second.ends) {
+				const DoorEnd& doorEnd = doors[end / 2].ends[end % 2];
+				search.addTarget(doorEnd.cell, doorEnd.half);
+			}
+		}
+		search.reach(search.node(from, half), NO_END, 0);
+		search.run(*map, shutOptions);
+		for (int toHalf = 0; toHalf <= 1; toHalf++) {
+			if (toLabels[toHalf] == label) {
+				unsigned direct = search.getCost(to, toHalf);
+				if (direct < best) {
+					best = direct;
+					routeFromHalf = half;
+					routeToHalf = toHalf;
+				}
+			}
+		}
+		if (room == roomEnds.end()) {
+			continue;
+		}
+		for (unsigned end: room->second.ends) {
+			const DoorEnd& doorEnd = doors[end / 2].ends[end % 2];
+			unsigned cost = search.getCost(doorEnd.cell, doorEnd.half);
+			EndState& state = touch(end);
+			if (cost < state.cost) {
+				state.cost = cost;
+				state.parent = FROM_START + half;
+				heap.push({cost + getHeuristic(doorEnd.cell, to), end});
+			}
+		}
+	}
+
+	// A* over door ends till nothing left could do better
+	auto reach = [&](unsigned end, unsigned parent, unsigned cost) {
+		EndState& state = touch(end);
+		if (state.mark == stamp && cost < state.cost) {
+			state.cost = cost;
+			state.parent = parent;
+			const DoorEnd& doorEnd = doors[end / 2].ends[end % 2];
+			heap.push({cost + getHeuristic(doorEnd.cell, to), end});
+		}
+	};
+	while (!heap.empty() && heap.top().first < best) {
+		unsigned end = heap.top().second;
+		heap.pop();
+		EndState& state = endStates[end];
+		if (state.mark != stamp) {
+			continue;
+		}
+		state.mark = stamp + 1;
+		unsigned cost = state.cost;
+		if (state.tail != NO_PATH && cost + state.tail < best) {
+			best = cost + state.tail;
+			bestEnd = end;
+		}
+		reach(end ^ 1, end, cost + doors[end / 2].crossCosts[end % 2]);
+		const Room& room = *endRooms[end];
+		unsigned count = (unsigned) room.ends.size();
+		const unsigned *costs = &room.costs[(size_t) endSlots[end] * count];
+		for (unsigned i = 0; i < count; i++) {
+			if (costs[i] != NO_PATH && room.ends[i] != end) {
+				reach(room.ends[i], end, cost + costs[i]);
+			}
+		}
+	}
+
+	// Walk back along the best route, if through doors
+	if (bestEnd != NO_END) {
+		unsigned end = bestEnd;
+		for (; end < FROM_START; end = endStates[end].parent) {
+			routeEnds.push_back(end);
+		}
+		routeFromHalf = end - FROM_START;
+		std::reverse(routeEnds.begin(), routeEnds.end());
+
+		// Goal half the route ends in
+		const DoorEnd& last = doors[bestEnd / 2].ends[bestEnd % 2];
+		unsigned lastRoom = getEndRoom(bestEnd);
+		unsigned tail = NO_PATH;
+		for (int half = 0; half <= 1; half++) {
+			if (toLabels[half] == lastRoom) {
+				unsigned back =
+				    toSearches[half].getCost(last.cell, last.half);
+				if (back < tail) {
+					tail = back;
+					routeToHalf = half;
+				}
+			}
+		}
+	}
+	return best;
+}
+
+// Start a room search over the room of one half of a cell
+void GridRoutes::startSearch(RoomSearch& search, GridCoord gc, int half) const
+{
+	search.start(rooms.getRegionStats(rooms.getLabel(gc, half)).bounds);
+}
+
+// Aim a room search at a goal, by the same estimate as routes
+void GridRoutes::aimSearch(RoomSearch& search, GridCoord goal) const
+{
+	search.aim(goal, guessStep, guessDiagonal);
+}
+
+// Get the extra cost of entering a cell by floor
+unsigned GridRoutes::getEntryCost(GridCoord gc) const
+{
+	return GetEntryCost(map->getCellFloor(gc), options);
+}
+
+// Estimate the cost between two cells (never too high)
+unsigned GridRoutes::getHeuristic(GridCoord gc, GridCoord to) const
+{
+	return GetOctileCost(gc, to, guessStep, guessDiagonal);
+}
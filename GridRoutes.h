@@ -0,0 +1,158 @@
+/*
+	Name: GridRoutes.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Long-range routing on large maps by a graph of doors.
+		Rooms are the regions left with every door shut; each door
+		(wall door or diagonal door) is a pair of ends, one in the
+		room on either side. Each room keeps the cheapest costs
+		between the door ends in it, so a route is a search over
+		door ends, with local searches only in the rooms of its
+		start & goal. Edits re-cost only the rooms around a cell.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDROUTES_H
+#define GRIDROUTES_H
+#include "GridPaths.h"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+	GridRoutes interface
+	Costs match GridPaths with the same options. After any edit
+	to the map, call updateCell() for each cell whose floor or
+	north or west wall changed (the map must keep its size).
+*/
+class GridRoutes {
+	public:
+
+		// Constructor
+		GridRoutes(const GridMap& map, const MoveOptions& options = MoveOptions());
+
+		// Building & editing
+		void build(unsigned threads = 0);
+		void updateCell(GridCoord gc);
+
+		// Queries (NO_PATH if none)
+		unsigned findRoute(
+		    GridCoord from, GridCoord to, std::vector<GridCoord>& waypoints);
+		unsigned findPath(
+		    GridCoord from, GridCoord to, std::vector<GridCoord>& path);
+		unsigned getDistance(GridCoord from, GridCoord to);
+
+		// Graph size
+		unsigned getRoomCount() const;
+		unsigned getDoorCount() const;
+
+	private:
+
+		// Door end: one half of a cell beside a door
+		struct DoorEnd {
+			GridCoord cell;
+			int half;
+		};
+
+		// Door: two ends (end e of door d is end 2d + e) & the
+		// cost of crossing from each, found by key (cell & wall
+		// or diagonal)
+		struct Door {
+			DoorEnd ends[2];
+			unsigned crossCosts[2];
+			unsigned key;
+		};
+
+		// Room: its door ends & the costs between them
+		// (row from, column to)
+		struct Room {
+			std::vector<unsigned> ends;
+			std::vector<unsigned> costs;
+		};
+
+		/*
+			Search within one room (moves with doors shut never
+			leave it), over nodes for the cells of its bounds
+			(second halves after). Stops once every target is
+			settled; aimed at a goal, it's A*. Open list is a heap
+			of (estimate, node), stale entries skipped.
+		*/
+		struct RoomSearch {
+			GridRect bounds;
+			unsigned high, area;
+			std::vector<unsigned> costs, parents, marks;
+			unsigned stamp;
+			std::vector<std::pair<unsigned, unsigned>> heap;
+			std::vector<unsigned> targets;
+			bool aimed;
+			GridCoord goal;
+			unsigned step, diagonal;
+
+			RoomSearch();
+			unsigned node(GridCoord gc, int half) const;
+			GridCoord coord(unsigned node) const;
+			unsigned guess(unsigned node) const;
+			void start(GridRect bounds);
+			void aim(GridCoord goal, unsigned step, unsigned diagonal);
+			void addTarget(GridCoord gc, int half);
+			void reach(unsigned node, unsigned parent, unsigned cost);
+			void run(const GridMap& map, const MoveOptions& options);
+			unsigned getCost(GridCoord gc, int half) const;
+			void addPath(
+			    GridCoord gc, int half, std::vector<GridCoord>& path) const;
+		};
+
+		// Doors
+		void findDoor(unsigned key);
+		void dropDoor(unsigned key);
+		bool getDoorAt(unsigned key, Door& door) const;
+		unsigned getEndRoom(unsigned end) const;
+
+		// Rooms
+		void costRooms(const std::vector<unsigned>& labels, unsigned threads);
+		void collectRoomEnds(const std::vector<unsigned>& labels);
+		void getAroundLabels(GridCoord gc, std::vector<unsigned>& labels) const;
+
+		// Route search
+		unsigned searchRoute(GridCoord from, GridCoord to);
+		void startSearch(RoomSearch& search, GridCoord gc, int half) const;
+		void aimSearch(RoomSearch& search, GridCoord goal) const;
+		unsigned getEntryCost(GridCoord gc) const;
+		unsigned getHeuristic(GridCoord gc, GridCoord to) const;
+
+		// Map & settings (rooms searched with doors shut)
+		const GridMap *map;
+		MoveOptions options, shutOptions;
+		unsigned guessStep, guessDiagonal;
+		unsigned width, height;
+		GridRegions rooms;
+
+		// Doors (free slots reused) & rooms by label
+		std::vector<Door> doors;
+		std::vector<unsigned> freeDoors;
+		std::unordered_map<unsigned, unsigned> doorKeys;
+		std::unordered_map<unsigned, Room> roomEnds;
+
+		// Room of each door end & its place in the room's list
+		std::vector<const Room*> endRooms;
+		std::vector<unsigned> endSlots;
+
+		// Route scratch per door end (stamped, so never cleared):
+		// cost from start, parent end, cost on to goal (if in its room)
+		struct EndState {
+			unsigned cost, parent, tail, mark;
+		};
+		std::vector<EndState> endStates;
+		unsigned stamp;
+
+		// Last route found: the door ends passed, in order,
+		// & the halves it starts & ends in
+		std::vector<unsigned> routeEnds;
+		int routeFromHalf, routeToHalf;
+
+		// Room searches kept between queries (from the start,
+		// back from either half of the goal)
+		RoomSearch fromSearch, toSearches[2];
+};
+#endif
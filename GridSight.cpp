@@ -0,0 +1,360 @@
+/*
+	Name: GridSight.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of field of view.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridSight.h"
+#include <algorithm>
+#include <cassert>
+using std::min;
+using std::max;
+
+// Bits per bitset word
+const unsigned WORD_BITS = 64;
+
+// Quadrants of sight around a viewpoint
+enum Quadrant {
+	QUAD_NORTH, QUAD_SOUTH, QUAD_EAST, QUAD_WEST
+};
+
+// Last tile scanned in a row
+enum TileKind {
+	TILE_NONE, TILE_FLOOR, TILE_WALL
+};
+
+//------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------
+
+// Divide, rounding down (denominator positive)
+static inline long long FloorDiv(long long num, long long den)
+{
+	return num >= 0 ? num / den : -((-num + den - 1) / den);
+}
+
+// Divide, rounding up (denominator positive)
+static inline long long CeilDiv(long long num, long long den)
+{
+	return -FloorDiv(-num, den);
+}
+
+//------------------------------------------------------------------
+// Construction & viewpoints
+//------------------------------------------------------------------
+
+GridSight::GridSight(const GridMap& _map, const SightOptions& _options)
+{
+	map = &_map;
+	options = _options;
+	width = map->getWidthCells();
+	height = map->getHeightCells();
+	rowWords = (width + WORD_BITS - 1) / WORD_BITS;
+	visible.assign((size_t) rowWords * height, 0);
+	explored.assign((size_t) rowWords * height, 0);
+	visibleBounds = {0, 0, 0, 0};
+	rangeSquared = 4LL * options.range * options.range;
+}
+
+// Clear what's visible (only the words set since last time)
+void GridSight::clearVisible()
+{
+	if (visibleBounds.left >= visibleBounds.right) {
+		return;
+	}
+	unsigned first = visibleBounds.left / WORD_BITS;
+	unsigned last = (visibleBounds.right - 1) / WORD_BITS;
+	for (unsigned y = visibleBounds.top; y < visibleBounds.bottom; y++) {
+		uint64_t *row = &visible[(size_t) y * rowWords];
+		std::fill(row + first, row + last + 1, 0);
+	}
+	visibleBounds = {0, 0, 0, 0};
+}
+
+/*
+	Add what's seen from one cell to what's visible (& explored).
+	The cell itself is always seen.
+*/
+void GridSight::addViewpoint(GridCoord gc)
+{
+	assert(map->getWidthCells() == width && map->getHeightCells() == height);
+	assert(gc.x < width && gc.y < height);
+	int originX = 2 * gc.x + 1, originY = 2 * gc.y + 1;
+	markVisible(originX, originY);
+	for (int quadrant = QUAD_NORTH; quadrant <= QUAD_WEST; quadrant++) {
+		castQuadrant(quadrant, originX, originY);
+	}
+}
+
+// Make what's visible just what's seen from some cells
+void GridSight::setViewpoints(const std::vector<GridCoord>& viewpoints)
+{
+	clearVisible();
+	for (GridCoord gc: viewpoints) {
+		addViewpoint(gc);
+	}
+}
+
+// Forget everything explored (keeping what's visible now)
+void GridSight::clearExplored()
+{
+	std::fill(explored.begin(), explored.end(), 0);
+	for (unsigned y = visibleBounds.top; y < visibleBounds.bottom; y++) {
+		std::copy(
+		    visible.begin() + (size_t) y * rowWords,
+		    visible.begin() + (size_t) (y + 1) * rowWords,
+		    explored.begin() + (size_t) y * rowWords);
+	}
+}
+
+//------------------------------------------------------------------
+// Results
+//------------------------------------------------------------------
+
+bool GridSight::isVisible(GridCoord gc) const
+{
+	assert(gc.x < width && gc.y < height);
+	return (visible[(size_t) gc.y * rowWords + gc.x / WORD_BITS]
+	        >> (gc.x % WORD_BITS)) & 1;
+}
+
+bool GridSight::isExplored(GridCoord gc) const
+{
+	assert(gc.x < width && gc.y < height);
+	return (explored[(size_t) gc.y * rowWords + gc.x / WORD_BITS]
+	        >> (gc.x % WORD_BITS)) & 1;
+}
+
+unsigned GridSight::getRowWords() const
+{
+	return rowWords;
+}
+
+const uint64_t* GridSight::getVisibleRow(unsigned y) const
+{
+	assert(y < height);
+	return &visible[(size_t) y * rowWords];
+}
+
+const uint64_t* GridSight::getExploredRow(unsigned y) const
+{
+	assert(y < height);
+	return &explored[(size_t) y * rowWords];
+}
+
+// Get a block holding every visible cell (empty if none)
+GridRect GridSight::getVisibleBounds() const
+{
+	return visibleBounds;
+}
+
+//------------------------------------------------------------------
+// Shadowcasting
+//------------------------------------------------------------------
+
+/*
+	Cast sight over one quadrant from a lattice point, row by row
+	out from it. Each row spans the slopes still lit; a floor tile
+	is seen if its center is within them (so sight is symmetric),
+	a wall tile if any of it is. Runs of floor go on to the next
+	row, narrowed by the walls at their ends. Rows are kept on a
+	stack rather than by recursion, as they may run thousands deep.
+*/
+void GridSight::castQuadrant(int quadrant, int originX, int originY)
+{
+	// Depth & columns of the lattice (map edges are walls)
+	int edgeX = 2 * width, edgeY = 2 * height;
+	int maxDepth, colLow, colHigh;
+	switch (quadrant) {
+		case QUAD_NORTH:
+			maxDepth = originY;
+			colLow = -originX;
+			colHigh = edgeX - originX;
+			break;
+		case QUAD_SOUTH:
+			maxDepth = edgeY - originY;
+			colLow = -originX;
+			colHigh = edgeX - originX;
+			break;
+		case QUAD_EAST:
+			maxDepth = edgeX - originX;
+			colLow = -originY;
+			colHigh = edgeY - originY;
+			break;
+		default:
+			maxDepth = originX;
+			colLow = -originY;
+			colHigh = edgeY - originY;
+			break;
+	}
+	if (options.range) {
+		maxDepth = min(maxDepth, (int) (2 * options.range));
+	}
+
+	// Scan rows, starting with the whole quadrant
+	scanRows.clear();
+	scanRows.push_back({1, -1, 1, 1, 1});
+	while (!scanRows.empty()) {
+		ScanRow row = scanRows.back();
+		scanRows.pop_back();
+		if (row.depth > maxDepth) {
+			continue;
+		}
+
+		// Columns with centers rounding into the slopes
+		long long depth = row.depth;
+		long long first = FloorDiv(
+		    2 * depth * row.startNum + row.startDen, 2 * row.startDen);
+		long long last = CeilDiv(
+		    2 * depth * row.endNum - row.endDen, 2 * row.endDen);
+		first = max(first, (long long) colLow);
+		last = min(last, (long long) colHigh);
+		TileKind prior = TILE_NONE;
+		for (long long col = first; col <= last; col++) {
+			int px, py;
+			switch (quadrant) {
+				case QUAD_NORTH:
+					px = originX + col;
+					py = originY - depth;
+					break;
+				case QUAD_SOUTH:
+					px = originX + col;
+					py = originY + depth;
+					break;
+				case QUAD_EAST:
+					px = originX + depth;
+					py = originY + col;
+					break;
+				default:
+					px = originX - depth;
+					py = originY + col;
+					break;
+			}
+			bool wall = isOpaque(px, py);
+			bool centered = col * row.startDen >= depth * row.startNum
+			                && col * row.endDen <= depth * row.endNum;
+			if ((wall || centered)
+			        && (!options.range
+			            || col * col + depth * depth <= rangeSquared)) {
+				markVisible(px, py);
+			}
+			if (prior == TILE_WALL && !wall) {
+				row.startNum = 2 * col - 1;
+				row.startDen = 2 * depth;
+			}
+			if (prior == TILE_FLOOR && wall) {
+				scanRows.push_back({
+					row.depth + 1, row.startNum, row.startDen,
+					2 * col - 1, 2 * depth
+				});
+			}
+			prior = wall ? TILE_WALL : TILE_FLOOR;
+		}
+		if (prior == TILE_FLOOR) {
+			row.depth++;
+			scanRows.push_back(row);
+		}
+	}
+}
+
+/*
+	Does a lattice point block sight? Odd points are cells; points
+	odd on one axis are edges, blocking if their wall or a cell to
+	either side does. Even points are corner posts: going round
+	the corner (arms & cells), they block if what blocks there is
+	in two or more separate runs (so sight can't slip between
+	things that meet at the corner) or all the way round.
+	The map's outer edges always block.
+*/
+bool GridSight::isOpaque(int px, int py) const
+{
+	if (px <= 0 || py <= 0
+	        || px >= (int) (2 * width) || py >= (int) (2 * height)) {
+		return true;
+	}
+	unsigned x = px / 2, y = py / 2;
+	if (px & 1) {
+		if (py & 1) {
+			return isCellOpaque(x, y);
+		}
+		return isWallOpaque(map->getColumn(x)[y].nwall)
+		       || isCellOpaque(x, y - 1) || isCellOpaque(x, y);
+	}
+	const GridCell *east = map->getColumn(x);
+	if (py & 1) {
+		return isWallOpaque(east[y].wwall)
+		       || isCellOpaque(x - 1, y) || isCellOpaque(x, y);
+	}
+
+	// Round the corner from the north arm, clockwise
+	const GridCell *west = map->getColumn(x - 1);
+	bool nw = isCellOpaque(x - 1, y - 1), ne = isCellOpaque(x, y - 1);
+	bool se = isCellOpaque(x, y), sw = isCellOpaque(x - 1, y);
+	bool ring[8] = {
+		isWallOpaque(east[y - 1].wwall) || nw || ne, ne,
+		isWallOpaque(east[y].nwall) || ne || se, se,
+		isWallOpaque(east[y].wwall) || se || sw, sw,
+		isWallOpaque(west[y].nwall) || sw || nw, nw
+	};
+	unsigned runs = 0, blocked = 0;
+	for (int i = 0; i < 8; i++) {
+		blocked += ring[i];
+		runs += ring[i] && !ring[(i + 1) % 8];
+	}
+	return runs >= 2 || blocked == 8;
+}
+
+// Does a whole cell block sight?
+bool GridSight::isCellOpaque(unsigned x, unsigned y) const
+{
+	switch (map->getColumn(x)[y].floor) {
+		case FLOOR_FILL:
+		case FLOOR_NEWALL:
+		case FLOOR_NWWALL:
+			return true;
+		case FLOOR_NEDOOR:
+		case FLOOR_NWDOOR:
+			return !options.openDoors;
+		default:
+			return false;
+	}
+}
+
+// Does a wall on a cell edge block sight?
+bool GridSight::isWallOpaque(unsigned char wall) const
+{
+	switch (wall) {
+		case WALL_OPEN:
+			return false;
+		case WALL_SINGLE_DOOR:
+		case WALL_DOUBLE_DOOR:
+			return !options.openDoors;
+		default:
+			return true;
+	}
+}
+
+// Mark the cell at a lattice point (if any) visible & explored
+void GridSight::markVisible(int px, int py)
+{
+	if (!(px & py & 1)) {
+		return;
+	}
+	unsigned x = px / 2, y = py / 2;
+	size_t word = (size_t) y * rowWords + x / WORD_BITS;
+	uint64_t bit = (uint64_t) 1 << (x % WORD_BITS);
+	visible[word] |= bit;
+	explored[word] |= bit;
+	if (visibleBounds.left >= visibleBounds.right) {
+		visibleBounds = {x, y, x + 1, y + 1};
+	}
+	else {
+		visibleBounds.left = min(visibleBounds.left, x);
+		visibleBounds.top = min(visibleBounds.top, y);
+		visibleBounds.right = max(visibleBounds.right, x + 1);
+		visibleBounds.bottom = max(visibleBounds.bottom, y + 1);
+	}
+}
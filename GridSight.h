@@ -0,0 +1,92 @@
+/*
+	Name: GridSight.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Field of view & fog of war.
+		Sight is cast by symmetric shadowcasting (after Albert Ford)
+		over a lattice of half cells: cell centers at odd points,
+		the edges between, & posts at cell corners. So walls on
+		edges block as thin obstacles, & a cell is seen if its
+		center is. Fill cells, diagonal walls, solid walls & secret
+		doors always block; other doors block unless open. Diagonal
+		fills don't (to see down diagonal passages). Work is in
+		proportion to the area seen, not the size of the map.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDSIGHT_H
+#define GRIDSIGHT_H
+#include "GridMap.h"
+#include <cstdint>
+#include <vector>
+
+/*
+	Sight settings: whether doors (other than secret) stand open,
+	& the range in cells (0 for no limit).
+*/
+struct SightOptions {
+	bool openDoors = false;
+	unsigned range = 0;
+};
+
+/*
+	GridSight interface
+	Visible & explored cells are bitsets with a row of words per
+	map row (cell x at bit x % 64 of word x / 64). Viewpoints add
+	to what's visible, & everything visible is also explored till
+	cleared. Sight is cast on the map as it stands at each call
+	(so edits since need no notice), but the map must keep its size.
+*/
+class GridSight {
+	public:
+
+		// Constructor
+		GridSight(const GridMap& map, const SightOptions& options = SightOptions());
+
+		// Viewpoints
+		void clearVisible();
+		void addViewpoint(GridCoord gc);
+		void setViewpoints(const std::vector<GridCoord>& viewpoints);
+
+		// Explored layer
+		void clearExplored();
+
+		// Results
+		bool isVisible(GridCoord gc) const;
+		bool isExplored(GridCoord gc) const;
+		unsigned getRowWords() const;
+		const uint64_t* getVisibleRow(unsigned y) const;
+		const uint64_t* getExploredRow(unsigned y) const;
+		GridRect getVisibleBounds() const;
+
+	private:
+
+		// Row of the lattice to scan in one quadrant, between two
+		// slopes (columns over depth, as fractions)
+		struct ScanRow {
+			int depth;
+			long long startNum, startDen, endNum, endDen;
+		};
+
+		// Shadowcasting
+		void castQuadrant(int quadrant, int originX, int originY);
+		bool isOpaque(int px, int py) const;
+		bool isCellOpaque(unsigned x, unsigned y) const;
+		bool isWallOpaque(unsigned char wall) const;
+		void markVisible(int px, int py);
+
+		// Map & settings
+		const GridMap *map;
+		SightOptions options;
+		unsigned width, height, rowWords;
+
+		// Bitsets & the block of cells visible
+		std::vector<uint64_t> visible, explored;
+		GridRect visibleBounds;
+
+		// Rows left to scan
+		std::vector<ScanRow> scanRows;
+		long long rangeSquared;
+};
+#endif
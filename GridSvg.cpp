@@ -0,0 +1,979 @@
+/*
+	Name: GridSvg.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of streaming SVG map export.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridSvg.h"
+#include <climits>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <vector>
+using std::max;
+
+// Constants
+const int PATH_BATCH = 1000;
+const unsigned NO_RUN = UINT_MAX;
+const double PI = 3.14159265358979;
+
+// Arial metrics (fraction of em height)
+const double TEXT_ASCENT = 0.91;
+const double TEXT_DESCENT = 0.21;
+const double TEXT_S_ADVANCE = 0.67;
+
+/*
+	Layers of the drawing, in paint order.
+	Fills (the bulk of a rough map) stream straight to the output;
+	the others go to temporary files while the map is scanned,
+	and are joined on after the fills at the end.
+*/
+enum SvgLayer {
+	LAYER_FILL, LAYER_FEATURE, LAYER_RUBBLE, LAYER_WALL, LAYER_DOOR,
+	LAYER_COUNT
+};
+
+// Shared feature symbols (stalagmites take one per size)
+enum SvgSymbol {
+	SYM_NSTAIRS, SYM_WSTAIRS, SYM_SPIRAL, SYM_WATER, SYM_DIAGDOOR,
+	SYM_PILLAR, SYM_STATUE, SYM_TRAPDOOR, SYM_PIT, SYM_XMARK,
+	SYM_NDOOR, SYM_WDOOR, SYM_NDOUBLE, SYM_WDOUBLE,
+	SYM_NSECRET, SYM_WSECRET, SYM_STALAGMITE,
+	SYM_COUNT = SYM_STALAGMITE + STALAGMITE_SIZES
+};
+
+const char *const SymbolNames[SYM_STALAGMITE] = {
+	"nstairs", "wstairs", "spiral", "water", "diagdoor",
+	"pillar", "statue", "trapdoor", "pit", "xmark",
+	"ndoor", "wdoor", "ndouble", "wdouble", "nsecret", "wsecret"
+};
+
+//------------------------------------------------------------------
+// Path batches
+//------------------------------------------------------------------
+
+/*
+	Path data for one layer, written as a series of <path>
+	elements of at most PATH_BATCH subpaths each, so no single
+	element grows without bound on a huge map.
+*/
+class SvgPathWriter {
+	public:
+		void start(FILE *file, const char *style);
+		void add(const char *format, ...);
+		void finish();
+
+	private:
+		FILE *file = NULL;
+		const char *style = NULL;
+		int count = 0;
+};
+
+void SvgPathWriter::start(FILE *file, const char *style)
+{
+	this->file = file;
+	this->style = style;
+	count = 0;
+}
+
+/*
+	Start one subpath (caller may append more path data
+	to the file until the next call).
+*/
+void SvgPathWriter::add(const char *format, ...)
+{
+	if (count == PATH_BATCH) {
+		finish();
+	}
+	if (count == 0) {
+		fprintf(file, "<path%s d=\"", style);
+	}
+	va_list args;
+	va_start(args, format);
+	vfprintf(file, format, args);
+	va_end(args);
+	count++;
+}
+
+// Close any open path element
+void SvgPathWriter::finish()
+{
+	if (count > 0) {
+		fputs("\"/>\n", file);
+		count = 0;
+	}
+}
+
+/*
+	Append an integer to a string.
+	Rough maps write millions of polygon steps,
+	where printf-style formatting dominates the run time.
+*/
+static void AppendInt(std::string& text, int value)
+{
+	char digits[12];
+	int count = 0;
+	unsigned magnitude = value < 0 ? 0u - (unsigned) value : (unsigned) value;
+	do {
+		digits[count++] = (char) ('0' + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude);
+	if (value < 0) {
+		text += '-';
+	}
+	while (count > 0) {
+		text += digits[--count];
+	}
+}
+
+//------------------------------------------------------------------
+// Exporter
+//------------------------------------------------------------------
+
+/*
+	Scans the map & writes the layers.
+	Run state is kept per row of the current column,
+	so memory is proportional to map height only.
+*/
+class SvgExporter {
+	public:
+		SvgExporter(GridMap& map);
+		~SvgExporter();
+		ExportResult write(
+		    const char *filename,
+		    ExportProgressFunc progress, void *progressData);
+
+	private:
+		ExportResult writeLayers(
+		    FILE *out, ExportProgressFunc progress, void *progressData);
+		bool openLayers(FILE *out);
+		void scanColumn(unsigned x);
+		void finishRuns();
+		void scanFill(unsigned x, unsigned y, bool solid);
+		void closeFillRect(unsigned top, unsigned x);
+		void addPolygon(const CanvasPoint *points, int count);
+		void scanWalls(unsigned x, unsigned y);
+		void endNWDiagonal(unsigned startX, unsigned x, unsigned y);
+		void endNEDiagonal(unsigned startX, unsigned x, unsigned y);
+		void scanFeatures(unsigned x, unsigned y);
+		void scanObject(unsigned x, unsigned y);
+		void addRubble(unsigned x, unsigned y);
+		void useSymbol(SvgLayer layer, int symbol, int x, int y);
+		void writeHeader(FILE *out);
+		void writeSymbols(FILE *out);
+		void writeSymbol(FILE *out, int symbol);
+		void writeGrid(FILE *out);
+		bool copyLayer(FILE *out, SvgLayer layer);
+
+		// Map & scale
+		GridMap& map;
+		unsigned width, height;
+		int cellSize;
+		CellShapes shapes;
+		std::string polygonText;
+
+		// Layer files & path batches
+		FILE *layers[LAYER_COUNT];
+		SvgPathWriter fillPath, rubblePath, wallPath;
+		bool symbolUsed[SYM_COUNT];
+
+		// Filled rectangles open in prior column (by top row)
+		std::vector<unsigned> rectBottom, rectLeft, rectSeen;
+		std::vector<unsigned> openRects, nextRects;
+		unsigned fillRunTop;
+
+		// Wall runs: north walls along rows, diagonals across columns
+		std::vector<unsigned> northRun;
+		std::vector<unsigned> nwRun, nwNext, neRun, neNext;
+		unsigned westRunTop;
+};
+
+SvgExporter::SvgExporter(GridMap& map): map(map)
+{
+	width = map.getWidthCells();
+	height = map.getHeightCells();
+	cellSize = (int) map.getCellSizePixels();
+	for (int i = 0; i < LAYER_COUNT; i++) {
+		layers[i] = NULL;
+	}
+	for (int i = 0; i < SYM_COUNT; i++) {
+		symbolUsed[i] = false;
+	}
+	rectBottom.assign(height, NO_RUN);
+	rectLeft.assign(height, 0);
+	rectSeen.assign(height, NO_RUN);
+	northRun.assign(height, NO_RUN);
+	nwRun.assign(height, NO_RUN);
+	nwNext.assign(height, NO_RUN);
+	neRun.assign(height, NO_RUN);
+	neNext.assign(height, NO_RUN);
+	fillRunTop = westRunTop = NO_RUN;
+}
+
+SvgExporter::~SvgExporter()
+{
+	for (int i = LAYER_FILL + 1; i < LAYER_COUNT; i++) {
+		if (layers[i]) {
+			fclose(layers[i]);
+		}
+	}
+}
+
+// Set up output & temporary files for layers
+bool SvgExporter::openLayers(FILE *out)
+{
+	layers[LAYER_FILL] = out;
+	for (int i = LAYER_FILL + 1; i < LAYER_COUNT; i++) {
+		layers[i] = tmpfile();
+		if (!layers[i]) {
+			return false;
+		}
+	}
+	fillPath.start(layers[LAYER_FILL], "");
+	rubblePath.start(layers[LAYER_RUBBLE], "");
+	wallPath.start(layers[LAYER_WALL], "");
+	return true;
+}
+
+/*
+	Write the whole drawing.
+	Layers are filled in one pass over the cells, then joined
+	in order, with shared symbol definitions at the end.
+*/
+ExportResult SvgExporter::write(
+    const char *filename, ExportProgressFunc progress, void *progressData)
+{
+	FILE *out = fopen(filename, "wb");
+	if (!out) {
+		return EXPORT_WRITE_FAILED;
+	}
+	ExportResult result = EXPORT_OK;
+	if (!openLayers(out)) {
+		result = EXPORT_WRITE_FAILED;
+	}
+	else {
+		writeHeader(out);
+		result = writeLayers(out, progress, progressData);
+	}
+	if (fclose(out) != 0 && result == EXPORT_OK) {
+		result = EXPORT_WRITE_FAILED;
+	}
+	return result;
+}
+
+// Scan the map & join the layers
+ExportResult SvgExporter::writeLayers(
+    FILE *out, ExportProgressFunc progress, void *progressData)
+{
+	fputs("<g fill=\"#000\" shape-rendering=\"crispEdges\">\n", out);
+
+	// Scan cells (columns outermost, as stored)
+	int lastPercent = -1;
+	for (unsigned x = 0; x < width; x++) {
+		scanColumn(x);
+		int percent = (int) ((x + 1) * 100ull / width);
+		if (progress && percent != lastPercent) {
+			lastPercent = percent;
+			if (!progress(progressData, x + 1, width)) {
+				return EXPORT_CANCELLED;
+			}
+		}
+	}
+	finishRuns();
+
+	// Join other layers on after the fills
+	fputs("</g>\n<g transform=\"translate(0.5 0.5)\">\n", out);
+	bool ok = copyLayer(out, LAYER_FEATURE);
+	int rubbleWeight = max(1, (int) (cellSize * 0.30) / 7);
+	fprintf(
+	    out, "<g fill=\"none\" stroke=\"#000\" stroke-width=\"%d\""
+	    " stroke-linecap=\"round\">\n", rubbleWeight);
+	ok = ok && copyLayer(out, LAYER_RUBBLE);
+	fputs("</g>\n", out);
+	writeGrid(out);
+	fputs(
+	    "<g fill=\"none\" stroke=\"#000\" stroke-width=\"3\""
+	    " stroke-linecap=\"square\">\n", out);
+	ok = ok && copyLayer(out, LAYER_WALL);
+	fputs("</g>\n", out);
+	ok = ok && copyLayer(out, LAYER_DOOR);
+	fputs("</g>\n", out);
+	writeSymbols(out);
+	fputs("</svg>\n", out);
+	return (ok && !ferror(out)) ? EXPORT_OK : EXPORT_WRITE_FAILED;
+}
+
+// Scan one column of cells into the layers
+void SvgExporter::scanColumn(unsigned x)
+{
+	for (unsigned y = 0; y < height; y++) {
+		GridCoord gc = {x, y};
+		FloorType floor = map.getCellFloor(gc);
+		ObjectType object = map.getCellObject(gc);
+		bool solid = false;
+
+		// Filled spaces (rough & diagonal shapes per cell)
+		if (floor == FLOOR_FILL || IsFloorDiagonalFill(floor)
+		        || object == OBJECT_RUBBLE || object == OBJECT_STALAGMITE) {
+			map.getCellShapes(gc, shapes);
+			solid = shapes.solidFill;
+			const CanvasPoint *points = shapes.points.data();
+			for (int count: shapes.polygonSizes) {
+				addPolygon(points, count);
+				points += count;
+			}
+		}
+		scanFill(x, y, solid);
+		scanWalls(x, y);
+		scanFeatures(x, y);
+	}
+	scanFill(x, height, false);
+
+	// Close fill rectangles that did not continue
+	for (unsigned top: openRects) {
+		if (rectSeen[top] != x && rectBottom[top] != NO_RUN) {
+			closeFillRect(top, x);
+		}
+	}
+	openRects.swap(nextRects);
+	nextRects.clear();
+
+	// Diagonal runs move on to the next column
+	nwRun.swap(nwNext);
+	neRun.swap(neNext);
+	nwNext.assign(height, NO_RUN);
+	neNext.assign(height, NO_RUN);
+}
+
+// Close all runs still open after the last column
+void SvgExporter::finishRuns()
+{
+	for (unsigned top: openRects) {
+		if (rectBottom[top] != NO_RUN) {
+			closeFillRect(top, width);
+		}
+	}
+	for (unsigned y = 0; y < height; y++) {
+		if (northRun[y] != NO_RUN) {
+			wallPath.add(
+			    "M%d %dH%d", northRun[y] * cellSize, y * cellSize,
+			    width * cellSize);
+		}
+		if (nwRun[y] != NO_RUN) {
+			endNWDiagonal(nwRun[y], width - 1, y - 1);
+		}
+		if (neRun[y] != NO_RUN) {
+			endNEDiagonal(neRun[y], width - 1, y + 1);
+		}
+	}
+	fillPath.finish();
+	rubblePath.finish();
+	wallPath.finish();
+}
+
+/*
+	Track runs of solid cells down a column.
+	Each finished run extends the rectangle started at the same
+	rows in the prior column, or else starts a new rectangle.
+*/
+void SvgExporter::scanFill(unsigned x, unsigned y, bool solid)
+{
+	if (solid && fillRunTop == NO_RUN) {
+		fillRunTop = y;
+	}
+	if (!solid && fillRunTop != NO_RUN) {
+		unsigned top = fillRunTop;
+		fillRunTop = NO_RUN;
+		if (rectBottom[top] != y) {
+			if (rectBottom[top] != NO_RUN) {
+				closeFillRect(top, x);
+			}
+			rectBottom[top] = y;
+			rectLeft[top] = x;
+		}
+		rectSeen[top] = x;
+		nextRects.push_back(top);
+	}
+}
+
+// Write a merged fill rectangle ending before column x
+void SvgExporter::closeFillRect(unsigned top, unsigned x)
+{
+	int w = (x - rectLeft[top]) * cellSize;
+	int h = (rectBottom[top] - top) * cellSize;
+	fillPath.add(
+	    "M%d %dh%dv%dh%dz",
+	    rectLeft[top] * cellSize, top * cellSize, w, h, -w);
+	rectBottom[top] = NO_RUN;
+}
+
+/*
+	Write one fill polygon, in relative steps (short numbers).
+	Winding is made clockwise so overlapping shapes
+	merge (nonzero fill) instead of cutting holes.
+*/
+void SvgExporter::addPolygon(const CanvasPoint *points, int count)
+{
+	long long area = 0;
+	for (int i = 0; i < count; i++) {
+		const CanvasPoint& a = points[i];
+		const CanvasPoint& b = points[(i + 1) % count];
+		area += (long long) a.x * b.y - (long long) b.x * a.y;
+	}
+	CanvasPoint last = points[0];
+	fillPath.add("M%d %dl", last.x, last.y);
+	polygonText.clear();
+	for (int i = 1; i < count; i++) {
+		const CanvasPoint& p = points[area >= 0 ? i : count - i];
+		if (i > 1) {
+			polygonText += ' ';
+		}
+		AppendInt(polygonText, p.x - last.x);
+		polygonText += ' ';
+		AppendInt(polygonText, p.y - last.y);
+		last = p;
+	}
+	polygonText += 'z';
+	fwrite(polygonText.data(), 1, polygonText.size(), layers[LAYER_FILL]);
+}
+
+//------------------------------------------------------------------
+// Walls
+//------------------------------------------------------------------
+
+/*
+	Extend wall runs with one cell.
+	North walls run along rows (across columns), west walls
+	down the column, and diagonal walls corner to corner.
+*/
+void SvgExporter::scanWalls(unsigned x, unsigned y)
+{
+	GridCoord gc = {x, y};
+	int px = x * cellSize;
+	int py = y * cellSize;
+
+	// North wall
+	bool north = (map.getCellNWall(gc) != WALL_OPEN);
+	if (north && northRun[y] == NO_RUN) {
+		northRun[y] = x;
+	}
+	if (!north && northRun[y] != NO_RUN) {
+		wallPath.add("M%d %dH%d", northRun[y] * cellSize, py, px);
+		northRun[y] = NO_RUN;
+	}
+
+	// West wall
+	bool west = (map.getCellWWall(gc) != WALL_OPEN);
+	if (west && westRunTop == NO_RUN) {
+		westRunTop = y;
+	}
+	if ((!west || y + 1 == height) && westRunTop != NO_RUN) {
+		int bottom = west ? py + cellSize : py;
+		wallPath.add("M%d %dV%d", px, westRunTop * cellSize, bottom);
+		westRunTop = NO_RUN;
+	}
+
+	// Diagonal NW/SE (continues to next column, row below)
+	FloorType floor = map.getCellFloor(gc);
+	if (floor == FLOOR_NWWALL || floor == FLOOR_NWDOOR) {
+		unsigned start = (nwRun[y] != NO_RUN ? nwRun[y] : x);
+		if (y + 1 < height) {
+			nwNext[y + 1] = start;
+		}
+		else {
+			endNWDiagonal(start, x, y);
+		}
+	}
+	else if (nwRun[y] != NO_RUN) {
+		endNWDiagonal(nwRun[y], x - 1, y - 1);
+	}
+
+	// Diagonal NE/SW (continues to next column, row above)
+	if (floor == FLOOR_NEWALL || floor == FLOOR_NEDOOR) {
+		unsigned start = (neRun[y] != NO_RUN ? neRun[y] : x);
+		if (y > 0) {
+			neNext[y - 1] = start;
+		}
+		else {
+			endNEDiagonal(start, x, y);
+		}
+	}
+	else if (neRun[y] != NO_RUN) {
+		endNEDiagonal(neRun[y], x - 1, y + 1);
+	}
+}
+
+// Write a NW/SE diagonal run from column startX to cell (x, y)
+void SvgExporter::endNWDiagonal(unsigned startX, unsigned x, unsigned y)
+{
+	unsigned startY = y - (x - startX);
+	wallPath.add(
+	    "M%d %dL%d %d", startX * cellSize, startY * cellSize,
+	    (x + 1) * cellSize, (y + 1) * cellSize);
+}
+
+// Write a NE/SW diagonal run from column startX to cell (x, y)
+void SvgExporter::endNEDiagonal(unsigned startX, unsigned x, unsigned y)
+{
+	unsigned startY = y + (x - startX);
+	wallPath.add(
+	    "M%d %dL%d %d", startX * cellSize, (startY + 1) * cellSize,
+	    (x + 1) * cellSize, y * cellSize);
+}
+
+//------------------------------------------------------------------
+// Features
+//------------------------------------------------------------------
+
+// Place symbols for one cell's floor, object & doors
+void SvgExporter::scanFeatures(unsigned x, unsigned y)
+{
+	GridCoord gc = {x, y};
+	int px = x * cellSize;
+	int py = y * cellSize;
+
+	// Floor features
+	switch (map.getCellFloor(gc)) {
+		case FLOOR_NSTAIRS:
+			useSymbol(LAYER_FEATURE, SYM_NSTAIRS, px, py);
+			break;
+		case FLOOR_WSTAIRS:
+			useSymbol(LAYER_FEATURE, SYM_WSTAIRS, px, py);
+			break;
+		case FLOOR_SPIRALSTAIRS:
+			useSymbol(LAYER_FEATURE, SYM_SPIRAL, px, py);
+			break;
+		case FLOOR_WATER:
+			useSymbol(LAYER_FEATURE, SYM_WATER, px, py);
+			break;
+		case FLOOR_NEDOOR:
+		case FLOOR_NWDOOR:
+			useSymbol(LAYER_DOOR, SYM_DIAGDOOR, px, py);
+			break;
+		default:
+			break;
+	}
+	scanObject(x, y);
+
+	// Doors on walls
+	switch (map.getCellNWall(gc)) {
+		case WALL_SINGLE_DOOR:
+			useSymbol(LAYER_DOOR, SYM_NDOOR, px, py);
+			break;
+		case WALL_DOUBLE_DOOR:
+			useSymbol(LAYER_DOOR, SYM_NDOUBLE, px, py);
+			break;
+		case WALL_SECRET_DOOR:
+			useSymbol(LAYER_DOOR, SYM_NSECRET, px, py);
+			break;
+		default:
+			break;
+	}
+	switch (map.getCellWWall(gc)) {
+		case WALL_SINGLE_DOOR:
+			useSymbol(LAYER_DOOR, SYM_WDOOR, px, py);
+			break;
+		case WALL_DOUBLE_DOOR:
+			useSymbol(LAYER_DOOR, SYM_WDOUBLE, px, py);
+			break;
+		case WALL_SECRET_DOOR:
+			useSymbol(LAYER_DOOR, SYM_WSECRET, px, py);
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+	Place one cell's object.
+	Assumes getCellShapes() was just called for
+	rubble & stalagmites (random placements).
+*/
+void SvgExporter::scanObject(unsigned x, unsigned y)
+{
+	int px = x * cellSize;
+	int py = y * cellSize;
+	switch (map.getCellObject({x, y})) {
+		case OBJECT_PILLAR:
+			useSymbol(LAYER_FEATURE, SYM_PILLAR, px, py);
+			break;
+		case OBJECT_STATUE:
+			useSymbol(LAYER_FEATURE, SYM_STATUE, px, py);
+			break;
+		case OBJECT_TRAPDOOR:
+			useSymbol(LAYER_FEATURE, SYM_TRAPDOOR, px, py);
+			break;
+		case OBJECT_PIT:
+			useSymbol(LAYER_FEATURE, SYM_PIT, px, py);
+			break;
+		case OBJECT_XMARK:
+			useSymbol(LAYER_FEATURE, SYM_XMARK, px, py);
+			break;
+		case OBJECT_RUBBLE:
+			addRubble(x, y);
+			break;
+		case OBJECT_STALAGMITE:
+			useSymbol(
+			    LAYER_FEATURE, SYM_STALAGMITE + shapes.stalagmiteSize,
+			    px + shapes.stalagmiteCenter.x,
+			    py + shapes.stalagmiteCenter.y);
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+	Add one cell's rubble marks (small "x" strokes).
+	Placed as the painter places its "x" characters.
+*/
+void SvgExporter::addRubble(unsigned x, unsigned y)
+{
+	int fontHeight = (int) (cellSize * 0.30);
+	int advance = (fontHeight * 50 + 50) / 100;
+	int ascent = (int) (fontHeight * TEXT_ASCENT + 0.5);
+	int textHeight = ascent + (int) (fontHeight * TEXT_DESCENT + 0.5);
+	int markWidth = advance - 2 * (advance / 10);
+	int markHeight = fontHeight * 52 / 100;
+	for (int i = 0; i < RUBBLE_MARKS; i++) {
+		const CanvasPoint& pct = shapes.rubble[i];
+		int left = x * cellSize + (cellSize - advance) * pct.x / 100
+		           + advance / 10;
+		int bottom = y * cellSize + (cellSize - textHeight) * pct.y / 100
+		             + ascent;
+		int top = bottom - markHeight;
+		rubblePath.add(
+		    "M%d %dl%d %dm0 %dl%d %d", left, top, markWidth, markHeight,
+		    -markHeight, -markWidth, markHeight);
+	}
+}
+
+// Place a shared symbol on a layer
+void SvgExporter::useSymbol(SvgLayer layer, int symbol, int x, int y)
+{
+	symbolUsed[symbol] = true;
+	if (symbol >= SYM_STALAGMITE) {
+		fprintf(
+		    layers[layer],
+		    "<use xlink:href=\"#stalagmite%d\" x=\"%d\" y=\"%d\"/>\n",
+		    symbol - SYM_STALAGMITE, x, y);
+	}
+	else {
+		fprintf(
+		    layers[layer], "<use xlink:href=\"#%s\" x=\"%d\" y=\"%d\"/>\n",
+		    SymbolNames[symbol], x, y);
+	}
+}
+
+//------------------------------------------------------------------
+// Output
+//------------------------------------------------------------------
+
+// Write SVG header & background
+void SvgExporter::writeHeader(FILE *out)
+{
+	unsigned long long w = map.getWidthPixels();
+	unsigned long long h = map.getHeightPixels();
+	fprintf(
+	    out,
+	    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	    "<svg xmlns=\"http://www.w3.org/2000/svg\""
+	    " xmlns:xlink=\"http://www.w3.org/1999/xlink\""
+	    " width=\"%llu\" height=\"%llu\" viewBox=\"0 0 %llu %llu\">\n"
+	    "<rect width=\"%llu\" height=\"%llu\" fill=\"#fff\"/>\n",
+	    w, h, w, h, w, h);
+}
+
+// Write definitions of the symbols placed
+void SvgExporter::writeSymbols(FILE *out)
+{
+	fputs("<defs>\n", out);
+	for (int i = 0; i < SYM_COUNT; i++) {
+		if (symbolUsed[i]) {
+			writeSymbol(out, i);
+		}
+	}
+	fputs("</defs>\n", out);
+}
+
+// Write a rectangle outline as the painter draws it (right/bottom open)
+static void WriteRect(
+    FILE *out, int left, int top, int right, int bottom, const char *fill)
+{
+	fprintf(
+	    out, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"%s\"/>",
+	    left, top, right - left - 1, bottom - top - 1, fill);
+}
+
+// Write text centered on x with the given baseline
+static void WriteText(
+    FILE *out, int x, int baseline, int fontHeight, const char *family,
+    bool bold, const char *text)
+{
+	fprintf(
+	    out, "<text x=\"%d\" y=\"%d\" font-family=\"%s\" font-size=\"%d\""
+	    "%s text-anchor=\"middle\" fill=\"#000\" stroke=\"none\">%s</text>",
+	    x, baseline, family, fontHeight,
+	    bold ? " font-weight=\"bold\"" : "", text);
+}
+
+// Write a secret door letter centered at (x, y) on a white box
+static void WriteSecretDoor(FILE *out, int x, int y, int cellSize)
+{
+	int fontHeight = (int) (cellSize * 0.70);
+	int ascent = (int) (fontHeight * TEXT_ASCENT + 0.5);
+	int textWidth = (int) (fontHeight * TEXT_S_ADVANCE + 0.5);
+	int textHeight = ascent + (int) (fontHeight * TEXT_DESCENT + 0.5);
+	int left = x - textWidth / 2;
+	int top = y - textHeight / 2;
+	fprintf(
+	    out, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\""
+	    " fill=\"#fff\" stroke=\"none\"/>",
+	    left, top, textWidth, textHeight);
+	WriteText(out, x, top + ascent, fontHeight, "Arial", false, "S");
+}
+
+/*
+	Write one symbol definition.
+	Symbols are drawn from the cell corner at (0, 0),
+	with the same shapes as the painter uses.
+*/
+void SvgExporter::writeSymbol(FILE *out, int symbol)
+{
+	const FeatureGeometry& g = map.getFeatureGeometry();
+	int s = cellSize;
+	int half = s / 2;
+	int h = s / 4;
+	if (symbol >= SYM_STALAGMITE) {
+		fprintf(out, "<symbol id=\"stalagmite%d\"", symbol - SYM_STALAGMITE);
+	}
+	else {
+		fprintf(out, "<symbol id=\"%s\"", SymbolNames[symbol]);
+	}
+	fputs(" overflow=\"visible\" fill=\"none\" stroke=\"#000\">", out);
+
+	switch (symbol) {
+		case SYM_NSTAIRS:
+		case SYM_WSTAIRS: {
+			fputs("<path d=\"", out);
+			for (int i = 0; i <= 5; i++) {
+				int d = i * s / 5;
+				if (symbol == SYM_NSTAIRS)
+					fprintf(out, "M0 %dH%d", d, s);
+				else
+					fprintf(out, "M%d 0V%d", d, s);
+			}
+			fputs("\"/>", out);
+			break;
+		}
+
+		case SYM_SPIRAL: {
+			int r = g.spiralRadius;
+			double start = atan2(-g.spiralArcStart.y, g.spiralArcStart.x);
+			double end = atan2(-g.spiralArcEnd.y, g.spiralArcEnd.x);
+			double sweep = fmod(end - start + 4 * PI, 2 * PI);
+			fprintf(
+			    out, "<path d=\"M%g %gA%d %d 0 %d 0 %g %g",
+			    half + r * cos(start), half - r * sin(start), r, r,
+			    sweep > PI ? 1 : 0, half + r * cos(end), half - r * sin(end));
+			for (int i = 0; i <= SPIRAL_SPOKES; i++) {
+				fprintf(
+				    out, "M%d %dl%d %d", half, half,
+				    g.spiralSpokes[i].x, g.spiralSpokes[i].y);
+			}
+			fprintf(
+			    out, "\"/><circle cx=\"%d\" cy=\"%d\" r=\"%d\" fill=\"#000\"/>",
+			    half, half, g.spiralInnerRadius);
+			break;
+		}
+
+		case SYM_WATER: {
+			int inc = s / 4;
+			fputs("<path d=\"", out);
+			for (int offset = -s; offset <= s; offset += inc) {
+				fprintf(
+				    out, "M%d %dL%d %d",
+				    offset > 0 ? offset : 0, offset < 0 ? -offset : 0,
+				    offset < 0 ? s + offset : s, offset > 0 ? s - offset : s);
+			}
+			for (int offset = 1; offset <= 2 * s; offset += inc) {
+				fprintf(
+				    out, "M%d %dL%d %d",
+				    offset < s ? offset : s, offset > s ? offset - s : 0,
+				    offset > s ? offset - s : 0, offset < s ? offset : s);
+			}
+			fputs("\"/>", out);
+			break;
+		}
+
+		case SYM_DIAGDOOR: {
+			int offset = (int) (half * 0.70710678);
+			fprintf(
+			    out, "<path d=\"M%d %dL%d %d %d %d %d %dz\" fill=\"#fff\"/>",
+			    half - offset, half, half, half + offset,
+			    half + offset, half, half, half - offset);
+			break;
+		}
+
+		case SYM_PILLAR:
+			fprintf(
+			    out, "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" fill=\"#000\"/>",
+			    half, half, (int) (half * 0.50));
+			break;
+
+		case SYM_STATUE:
+			fprintf(
+			    out, "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" fill=\"#fff\"/>"
+			    "<path d=\"M", half, half, g.statueRadius);
+			for (int i = 0; i < STATUE_STAR_POINTS; i++) {
+				fprintf(
+				    out, "%s%d %d", i ? " " : "",
+				    half + g.statueStar[i].x, half + g.statueStar[i].y);
+			}
+			fputs("z\" fill=\"#000\"/>", out);
+			break;
+
+		case SYM_TRAPDOOR: {
+			int inner = (int) (s * 0.80f);
+			int corner = (s - inner) / 2;
+			int fontHeight = (int) (inner * 0.80f);
+			WriteRect(out, corner, corner, corner + inner, corner + inner, "none");
+			WriteText(
+			    out, corner + inner / 2,
+			    corner + inner / 2 + (int) (fontHeight * 0.43),
+			    fontHeight, "Arial", true, "T");
+			break;
+		}
+
+		case SYM_PIT: {
+			int inner = (int) (s * 0.70);
+			int corner = (s - inner) / 2;
+			WriteRect(out, corner, corner, corner + inner, corner + inner, "none");
+			fprintf(
+			    out, "<path d=\"M%d %dl%d %dm0 %dl%d %d\"/>",
+			    corner, corner, inner, inner, -inner, -inner, inner);
+			break;
+		}
+
+		case SYM_XMARK: {
+			int fontHeight = (int) (s * 0.65);
+			int ascent = (int) (fontHeight * TEXT_ASCENT + 0.5);
+			int textHeight = ascent + (int) (fontHeight * TEXT_DESCENT + 0.5);
+			WriteText(
+			    out, half, half - textHeight / 2 + ascent, fontHeight,
+			    "Segoe UI, Arial", true, "X");
+			break;
+		}
+
+		case SYM_NDOOR:
+			WriteRect(out, h + 1, -h + 1, 3 * h, h, "#fff");
+			break;
+
+		case SYM_WDOOR:
+			WriteRect(out, -h + 1, h + 1, h, 3 * h, "#fff");
+			break;
+
+		case SYM_NDOUBLE:
+			WriteRect(out, 2, -h + 1, 2 * h + 1, h, "#fff");
+			WriteRect(out, 2 * h, -h + 1, 4 * h - 1, h, "#fff");
+			break;
+
+		case SYM_WDOUBLE:
+			WriteRect(out, -h + 1, 2, h, 2 * h + 1, "#fff");
+			WriteRect(out, -h + 1, 2 * h, h, 4 * h - 1, "#fff");
+			break;
+
+		case SYM_NSECRET:
+			WriteSecretDoor(out, 2 * h, 1, s);
+			break;
+
+		case SYM_WSECRET:
+			WriteSecretDoor(out, 0, 2 * h + 1, s);
+			break;
+
+		default: {
+
+			// Stalagmite, drawn about its center
+			int size = symbol - SYM_STALAGMITE;
+			fprintf(
+			    out, "<circle r=\"%d\" fill=\"#fff\"/><path d=\"",
+			    g.stalagmiteDiameter[size] / 2);
+			for (int i = 0; i < STALAGMITE_SPOKES; i++) {
+				const CanvasPoint& outer = g.stalagmiteOuter[size][i];
+				const CanvasPoint& inner = g.stalagmiteInner[size][i];
+				fprintf(
+				    out, "M%d %dL%d %d", outer.x, outer.y, inner.x, inner.y);
+			}
+			fputs("\"/>", out);
+			break;
+		}
+	}
+	fputs("</symbol>\n", out);
+}
+
+/*
+	Write grid lines as full-length lines,
+	under the walls (which cover them where closed).
+*/
+void SvgExporter::writeGrid(FILE *out)
+{
+	if (map.displayNoGrid())
+		return;
+	SvgPathWriter gridPath;
+	gridPath.start(out, " fill=\"none\" stroke=\"#808080\"");
+	unsigned long long w = map.getWidthPixels();
+	unsigned long long h = map.getHeightPixels();
+	for (unsigned y = 0; y < height; y++) {
+		gridPath.add("M0 %dH%llu", y * cellSize, w);
+	}
+	for (unsigned x = 0; x < width; x++) {
+		gridPath.add("M%d 0V%llu", x * cellSize, h);
+	}
+	gridPath.finish();
+}
+
+// Append one layer's temporary file to the output
+bool SvgExporter::copyLayer(FILE *out, SvgLayer layer)
+{
+	FILE *in = layers[layer];
+	if (ferror(in)) {
+		return false;
+	}
+	rewind(in);
+	char buffer[1 << 16];
+	size_t count;
+	while ((count = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+		if (fwrite(buffer, 1, count, out) != count) {
+			return false;
+		}
+	}
+	return !ferror(in);
+}
+
+/*
+	Export a map as an SVG drawing.
+	A cancelled or failed export deletes its partial file.
+*/
+ExportResult ExportMapSvg(
+    GridMap& map, const char *filename,
+    ExportProgressFunc progress, void *progressData)
+{
+	// Check drawing size (coordinates are ints)
+	unsigned long long width = map.getWidthPixels();
+	unsigned long long height = map.getHeightPixels();
+	if (width == 0 || height == 0 || width > INT_MAX || height > INT_MAX) {
+		return EXPORT_TOO_LARGE;
+	}
+
+	SvgExporter exporter(map);
+	ExportResult result = exporter.write(filename, progress, progressData);
+	if (result != EXPORT_OK) {
+		remove(filename);
+	}
+	return result;
+}
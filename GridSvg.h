@@ -0,0 +1,22 @@
+/*
+	Name: GridSvg.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Export of a whole map to an SVG vector drawing.
+		Cells are read once, column by column, and written straight
+		out: fills & walls merged into long runs, repeated features
+		placed as copies of shared symbols. No document is held in
+		memory, so even huge maps export in bounded space.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDSVG_H
+#define GRIDSVG_H
+#include "GridExport.h"
+
+// Function prototypes
+ExportResult ExportMapSvg(
+    GridMap& map, const char *filename,
+    ExportProgressFunc progress = NULL, void *progressData = NULL);
+#endif
@@ -0,0 +1,258 @@
+/*
+	Name: GridThumb.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of cell-data thumbnails.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "GridThumb.h"
+#include "ImageFile.h"
+#include <algorithm>
+using std::min;
+using std::max;
+
+// Shades for expanded cells
+const unsigned char SHADE_WALL = 0x00;
+const unsigned char SHADE_DOOR = 0x60;
+const unsigned char SHADE_OBJECT = 0x40;
+
+/*
+	Shade tables, indexed by raw cell bytes.
+	Floors give a base shade; walls & objects darken it
+	where a cell is smaller than a pixel.
+*/
+struct ShadeTables {
+	int floor[256];
+	int wallDarken[256];
+	int objectDarken[256];
+	unsigned char wall[256];
+};
+
+// Fill in the shade tables
+static ShadeTables MakeShadeTables()
+{
+	ShadeTables tables;
+	for (int i = 0; i < 256; i++) {
+		tables.floor[i] = 0xff;
+		tables.wallDarken[i] = 0x30;
+		tables.objectDarken[i] = 0x30;
+		tables.wall[i] = SHADE_DOOR;
+	}
+	tables.floor[FLOOR_FILL] = 0x00;
+	tables.floor[FLOOR_NSTAIRS] = 0xb0;
+	tables.floor[FLOOR_WSTAIRS] = 0xb0;
+	tables.floor[FLOOR_SPIRALSTAIRS] = 0xb0;
+	tables.floor[FLOOR_NEWALL] = 0xa0;
+	tables.floor[FLOOR_NWWALL] = 0xa0;
+	tables.floor[FLOOR_NEDOOR] = 0xa0;
+	tables.floor[FLOOR_NWDOOR] = 0xa0;
+	tables.floor[FLOOR_NWFILL] = 0x80;
+	tables.floor[FLOOR_NEFILL] = 0x80;
+	tables.floor[FLOOR_SWFILL] = 0x80;
+	tables.floor[FLOOR_SEFILL] = 0x80;
+	tables.floor[FLOOR_WATER] = 0xd0;
+	tables.wallDarken[WALL_OPEN] = 0;
+	tables.wall[WALL_FILL] = SHADE_WALL;
+	tables.objectDarken[OBJECT_NONE] = 0;
+	return tables;
+}
+
+// Get the shade tables (built once)
+static const ShadeTables& GetShadeTables()
+{
+	static const ShadeTables tables = MakeShadeTables();
+	return tables;
+}
+
+// Shade of a whole cell as one pixel
+static inline int CellShade(const ShadeTables& tables, const GridCell& cell)
+{
+	int shade = tables.floor[cell.floor] - tables.wallDarken[cell.nwall]
+	            - tables.wallDarken[cell.wwall]
+	            - tables.objectDarken[cell.object];
+	return shade > 0 ? shade : 0;
+}
+
+/*
+	Reduce one column of blocks (cellPixels is 1).
+	Sums the shade of every cell in a block, reading each
+	grid column top to bottom as it is stored.
+*/
+static void ReduceBlockColumn(
+    const GridMap& map, MapThumbnail& thumb, unsigned bx,
+    std::vector<unsigned long long>& sums)
+{
+	const ShadeTables& tables = GetShadeTables();
+	unsigned block = thumb.blockCells;
+	unsigned height = map.getHeightCells();
+	unsigned left = bx * block;
+	unsigned right = min(left + block, map.getWidthCells());
+
+	// Sum cell shades per block row
+	std::fill(sums.begin(), sums.end(), 0);
+	for (unsigned x = left; x < right; x++) {
+		const GridCell *column = map.getColumn(x);
+		for (unsigned by = 0; by < thumb.height; by++) {
+			unsigned top = by * block;
+			unsigned bottom = min(top + block, height);
+			unsigned sum = 0;
+			for (unsigned y = top; y < bottom; y++) {
+				sum += CellShade(tables, column[y]);
+			}
+			sums[by] += sum;
+		}
+	}
+
+	// Average into pixels
+	for (unsigned by = 0; by < thumb.height; by++) {
+		unsigned rows = min(block, height - by * block);
+		unsigned long long count = (unsigned long long) (right - left) * rows;
+		thumb.pixels[by * thumb.rowBytes + bx] =
+		    (unsigned char) (sums[by] / count);
+	}
+}
+
+/*
+	Draw one cell as a square of pixels (cellPixels of 2 or more):
+	floor shade, north & west wall edges, and an object mark.
+*/
+static void ExpandCell(
+    const MapThumbnail& thumb, const GridCell& cell,
+    unsigned x, unsigned y, unsigned char *pixels)
+{
+	const ShadeTables& tables = GetShadeTables();
+	unsigned size = thumb.cellPixels;
+	unsigned char *corner = pixels + y * size * thumb.rowBytes + x * size;
+
+	// Floor (objects drawn inset, if there's room)
+	unsigned char floor = (unsigned char) tables.floor[cell.floor];
+	unsigned inset = size / 4;
+	bool object = (cell.object != OBJECT_NONE);
+	for (unsigned i = 0; i < size; i++) {
+		unsigned char *row = corner + i * thumb.rowBytes;
+		bool objectRow = object && i >= inset && i < size - inset;
+		for (unsigned j = 0; j < size; j++) {
+			row[j] = (objectRow && j >= inset && j < size - inset)
+			         ? SHADE_OBJECT : floor;
+		}
+	}
+
+	// Walls (doors lighter)
+	if (cell.nwall != WALL_OPEN) {
+		std::fill(corner, corner + size, tables.wall[cell.nwall]);
+	}
+	if (cell.wwall != WALL_OPEN) {
+		for (unsigned i = 0; i < size; i++) {
+			corner[i * thumb.rowBytes] = tables.wall[cell.wwall];
+		}
+	}
+}
+
+/*
+	Make a thumbnail of a map fitting inside a maximum size.
+	Small maps get whole pixels per cell; big maps get
+	blocks of cells per pixel. One pass over the grid.
+*/
+void MakeThumbnail(
+    const GridMap& map, unsigned maxWidth, unsigned maxHeight,
+    MapThumbnail& thumb)
+{
+	unsigned width = map.getWidthCells();
+	unsigned height = map.getHeightCells();
+	maxWidth = max(maxWidth, 1u);
+	maxHeight = max(maxHeight, 1u);
+
+	// Choose scale
+	if (width <= maxWidth && height <= maxHeight) {
+		thumb.cellPixels = min(maxWidth / width, maxHeight / height);
+		thumb.blockCells = 1;
+	}
+	else {
+		thumb.cellPixels = 1;
+		thumb.blockCells =
+		    max((width + maxWidth - 1) / maxWidth,
+		        (height + maxHeight - 1) / maxHeight);
+	}
+	unsigned block = thumb.blockCells;
+	thumb.width = (width + block - 1) / block * thumb.cellPixels;
+	thumb.height = (height + block - 1) / block * thumb.cellPixels;
+	thumb.rowBytes = (thumb.width + 3) & ~3u;
+	thumb.pixels.assign((size_t) thumb.rowBytes * thumb.height, 0xff);
+
+	// Reduce or expand cells, columns outermost (as stored)
+	if (thumb.cellPixels == 1) {
+		std::vector<unsigned long long> sums(thumb.height);
+		for (unsigned bx = 0; bx < thumb.width; bx++) {
+			ReduceBlockColumn(map, thumb, bx, sums);
+		}
+	}
+	else {
+		for (unsigned x = 0; x < width; x++) {
+			const GridCell *column = map.getColumn(x);
+			for (unsigned y = 0; y < height; y++) {
+				ExpandCell(thumb, column[y], x, y, thumb.pixels.data());
+			}
+		}
+	}
+}
+
+/*
+	Update a thumbnail after one cell changes.
+	Redraws just that cell's pixels (or its block's pixel).
+*/
+void UpdateThumbnailCell(
+    const GridMap& map, MapThumbnail& thumb, GridCoord gc)
+{
+	if (gc.x >= map.getWidthCells() || gc.y >= map.getHeightCells()
+	        || thumb.pixels.empty()) {
+		return;
+	}
+	if (thumb.cellPixels > 1) {
+		ExpandCell(
+		    thumb, map.getColumn(gc.x)[gc.y], gc.x, gc.y,
+		    thumb.pixels.data());
+	}
+	else {
+		const ShadeTables& tables = GetShadeTables();
+		unsigned block = thumb.blockCells;
+		unsigned left = gc.x / block * block;
+		unsigned top = gc.y / block * block;
+		unsigned right = min(left + block, map.getWidthCells());
+		unsigned bottom = min(top + block, map.getHeightCells());
+		unsigned long long sum = 0;
+		for (unsigned x = left; x < right; x++) {
+			const GridCell *column = map.getColumn(x);
+			for (unsigned y = top; y < bottom; y++) {
+				sum += CellShade(tables, column[y]);
+			}
+		}
+		thumb.pixels[gc.y / block * thumb.rowBytes + gc.x / block] =
+		    (unsigned char) (sum / ((unsigned long long) (right - left)
+		                            * (bottom - top)));
+	}
+}
+
+// Write a thumbnail of at most maxSize pixels on a side
+ExportResult ExportThumbnail(
+    const GridMap& map, unsigned maxSize,
+    const char *filename, const char *format)
+{
+	if (maxSize > THUMB_SIZE_MAX) {
+		return EXPORT_TOO_LARGE;
+	}
+	ImageWriter *writer = NewImageWriter(format);
+	if (!writer) {
+		return EXPORT_BAD_FORMAT;
+	}
+	MapThumbnail thumb;
+	MakeThumbnail(map, maxSize, maxSize, thumb);
+	bool ok = writer->open(filename, thumb.width, thumb.height);
+	for (unsigned y = 0; ok && y < thumb.height; y++) {
+		ok = writer->writeRow(&thumb.pixels[(size_t) y * thumb.rowBytes]);
+	}
+	ok = writer->close() && ok;
+	delete writer;
+	return ok ? EXPORT_OK : EXPORT_WRITE_FAILED;
+}
@@ -0,0 +1,42 @@
+/*
+	Name: GridThumb.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Thumbnails & minimaps reduced straight from cell data.
+		Each cell (or square block of cells) maps to a few pixels
+		by floor, wall & object type, in one pass over the grid,
+		without painting the map at full size.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef GRIDTHUMB_H
+#define GRIDTHUMB_H
+#include "GridMap.h"
+#include "GridExport.h"
+
+// Largest thumbnail side (thumbnails are held in memory)
+const unsigned THUMB_SIZE_MAX = 8192;
+
+/*
+	Gray thumbnail image of a map.
+	Either each cell is a square of cellPixels (blockCells is 1),
+	or each square block of blockCells is one pixel (cellPixels is 1).
+	Rows are padded to 4 bytes (ready for a Windows DIB).
+*/
+struct MapThumbnail {
+	unsigned width, height, rowBytes;
+	unsigned cellPixels, blockCells;
+	std::vector<unsigned char> pixels;
+};
+
+// Function prototypes
+void MakeThumbnail(
+    const GridMap& map, unsigned maxWidth, unsigned maxHeight,
+    MapThumbnail& thumb);
+void UpdateThumbnailCell(
+    const GridMap& map, MapThumbnail& thumb, GridCoord gc);
+ExportResult ExportThumbnail(
+    const GridMap& map, unsigned maxSize,
+    const char *filename, const char *format);
+#endif
@@ -0,0 +1,520 @@
+/*
+	Name: ImageFile.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of the image file writers.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "ImageFile.h"
+#include <cstdlib>
+#include <cstring>
+
+// Constants
+const size_t PNG_CHUNK_SIZE = 1 << 16;
+const int DEFLATE_MAX_MATCH = 258;
+
+//------------------------------------------------------------------
+// Checksums
+//------------------------------------------------------------------
+
+// CRC-32 lookup table
+struct CrcTable {
+	unsigned entry[256];
+};
+
+// Build the CRC-32 lookup table
+static CrcTable MakeCrcTable()
+{
+	CrcTable table;
+	for (unsigned n = 0; n < 256; n++) {
+		unsigned c = n;
+		for (int k = 0; k < 8; k++) {
+			c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+		}
+		table.entry[n] = c;
+	}
+	return table;
+}
+
+// Update running CRC-32 over some bytes
+static unsigned UpdateCrc(unsigned crc, const unsigned char *buf, size_t len)
+{
+	static const CrcTable table = MakeCrcTable();
+	for (size_t i = 0; i < len; i++) {
+		crc = table.entry[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+// Store big-endian 32-bit value in buffer
+static void PutUint32(unsigned char *buf, unsigned value)
+{
+	buf[0] = (unsigned char)(value >> 24);
+	buf[1] = (unsigned char)(value >> 16);
+	buf[2] = (unsigned char)(value >> 8);
+	buf[3] = (unsigned char)(value);
+}
+
+//------------------------------------------------------------------
+// PNG writer
+//------------------------------------------------------------------
+
+/*
+	Deflate length codes for match lengths 3-258
+	(RFC 1951, section 3.2.5).
+*/
+const int LengthBase[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const int LengthExtra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+PngWriter::PngWriter()
+{
+	file = NULL;
+	ok = false;
+}
+
+PngWriter::~PngWriter()
+{
+	if (file) {
+		fclose(file);
+	}
+}
+
+bool PngWriter::open(const char *filename, unsigned _width, unsigned _height)
+{
+	// Check size limits (31 bits per side)
+	if (_width > 0x7fffffffu || _height > 0x7fffffffu) {
+		return false;
+	}
+
+	// Open file
+	file = fopen(filename, "wb");
+	if (!file) {
+		return false;
+	}
+	width = _width;
+	height = _height;
+	rowsWritten = 0;
+	ok = true;
+
+	// Reset encoder state
+	prevRow.assign(width, 0);
+	upRow.resize(width + 1);
+	subRow.resize(width + 1);
+	data.clear();
+	bitBuffer = 0;
+	bitCount = 0;
+	adlerA = 1;
+	adlerB = 0;
+	lastByte = -1;
+	runLength = 0;
+
+	// Signature & header (8-bit grayscale, no interlace)
+	const unsigned char signature[8] = {
+		0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'
+	};
+	ok = fwrite(signature, 1, 8, file) == 8;
+	unsigned char header[13];
+	PutUint32(header, width);
+	PutUint32(header + 4, height);
+	header[8] = 8;
+	header[9] = header[10] = header[11] = header[12] = 0;
+	writeChunk("IHDR", header, 13);
+
+	// Zlib header & start single fixed-Huffman block (final)
+	data.push_back(0x78);
+	data.push_back(0x01);
+	putBits(1, 1);
+	putBits(1, 2);
+	return ok;
+}
+
+/*
+	Filter one row (Up or Sub, whichever looks smaller)
+	and feed it to the deflate stream.
+*/
+bool PngWriter::writeRow(const unsigned char *row)
+{
+	if (!ok || rowsWritten >= height) {
+		return false;
+	}
+
+	// Compute both filters & their costs
+	unsigned long upCost = 0, subCost = 0;
+	upRow[0] = 2;
+	subRow[0] = 1;
+	for (unsigned x = 0; x < width; x++) {
+		unsigned char up = (unsigned char)(row[x] - prevRow[x]);
+		unsigned char sub = (unsigned char)(row[x] - (x ? row[x-1] : 0));
+		upRow[x+1] = up;
+		subRow[x+1] = sub;
+		upCost += up < 128 ? up : 256 - up;
+		subCost += sub < 128 ? sub : 256 - sub;
+	}
+
+	// Emit the cheaper one
+	const std::vector<unsigned char>& best =
+	    upCost <= subCost ? upRow : subRow;
+	for (unsigned i = 0; i <= width; i++) {
+		putByte(best[i]);
+	}
+	memcpy(prevRow.data(), row, width);
+	rowsWritten++;
+	flushData(false);
+	return ok;
+}
+
+bool PngWriter::close()
+{
+	if (!file) {
+		return false;
+	}
+
+	// Pad any missing rows with white
+	std::vector<unsigned char> blank(width, 0xff);
+	while (ok && rowsWritten < height) {
+		writeRow(blank.data());
+	}
+
+	// End block, checksum, & trailer
+	putRun();
+	putHuffman(0, 7);
+	if (bitCount > 0) {
+		putBits(0, 8 - bitCount);
+	}
+	unsigned char adler[4];
+	PutUint32(adler, (adlerB << 16) | adlerA);
+	data.insert(data.end(), adler, adler + 4);
+	flushData(true);
+	writeChunk("IEND", NULL, 0);
+
+	// Close file
+	ok = (fclose(file) == 0) && ok;
+	file = NULL;
+	return ok;
+}
+
+// Add one uncompressed byte to deflate stream
+void PngWriter::putByte(unsigned char c)
+{
+	adlerA = (adlerA + c) % 65521;
+	adlerB = (adlerB + adlerA) % 65521;
+	if (c == lastByte) {
+		if (++runLength == DEFLATE_MAX_MATCH) {
+			putRun();
+		}
+	}
+	else {
+		putRun();
+		putLiteral(c);
+		lastByte = c;
+	}
+}
+
+// Code a literal byte
+void PngWriter::putLiteral(unsigned char c)
+{
+	if (c < 144) {
+		putHuffman(0x30 + c, 8);
+	}
+	else {
+		putHuffman(0x190 + (c - 144), 9);
+	}
+}
+
+// Code pending repeats of last byte (as distance-1 match)
+void PngWriter::putRun()
+{
+	if (runLength < 3) {
+		for (int i = 0; i < runLength; i++) {
+			putLiteral((unsigned char) lastByte);
+		}
+	}
+	else {
+		int code = 28;
+		while (LengthBase[code] > runLength) {
+			code--;
+		}
+		unsigned symbol = 257 + code;
+		if (symbol < 280) {
+			putHuffman(symbol - 256, 7);
+		}
+		else {
+			putHuffman(0xc0 + (symbol - 280), 8);
+		}
+		putBits(runLength - LengthBase[code], LengthExtra[code]);
+		putHuffman(0, 5);
+	}
+	runLength = 0;
+}
+
+// Write bits, least-significant first
+void PngWriter::putBits(unsigned value, int count)
+{
+	bitBuffer |= value << bitCount;
+	bitCount += count;
+	while (bitCount >= 8) {
+		data.push_back((unsigned char) bitBuffer);
+		bitBuffer >>= 8;
+		bitCount -= 8;
+	}
+}
+
+// Write Huffman code, most-significant first
+void PngWriter::putHuffman(unsigned code, int length)
+{
+	unsigned reversed = 0;
+	for (int i = 0; i < length; i++) {
+		reversed = (reversed << 1) | ((code >> i) & 1);
+	}
+	putBits(reversed, length);
+}
+
+// Write buffered compressed data to IDAT chunk(s)
+void PngWriter::flushData(bool all)
+{
+	if (data.size() >= PNG_CHUNK_SIZE || (all && !data.empty())) {
+		writeChunk("IDAT", data.data(), data.size());
+		data.clear();
+	}
+}
+
+// Write one PNG chunk
+void PngWriter::writeChunk(
+    const char *type, const unsigned char *buf, size_t length)
+{
+	unsigned char header[8];
+	PutUint32(header, (unsigned) length);
+	memcpy(header + 4, type, 4);
+	unsigned crc = UpdateCrc(0xffffffffu, header + 4, 4);
+	crc = UpdateCrc(crc, buf, length) ^ 0xffffffffu;
+	unsigned char trailer[4];
+	PutUint32(trailer, crc);
+	ok = fwrite(header, 1, 8, file) == 8 && ok;
+	if (length) {
+		ok = fwrite(buf, 1, length, file) == length && ok;
+	}
+	ok = fwrite(trailer, 1, 4, file) == 4 && ok;
+}
+
+//------------------------------------------------------------------
+// TIFF writer
+//------------------------------------------------------------------
+
+// TIFF field types
+const int TIFF_SHORT = 3;
+const int TIFF_LONG = 4;
+const int TIFF_RATIONAL = 5;
+
+// TIFF file layout: header, directory, resolution, then pixels
+const int TIFF_NUM_TAGS = 11;
+const unsigned TIFF_DIR_OFFSET = 8;
+const unsigned TIFF_RES_OFFSET = TIFF_DIR_OFFSET + 2 + TIFF_NUM_TAGS * 12 + 4;
+const unsigned TIFF_DATA_OFFSET = TIFF_RES_OFFSET + 16;
+
+// Store little-endian 16-bit value in buffer
+static void PutUint16LE(unsigned char *buf, unsigned value)
+{
+	buf[0] = (unsigned char)(value);
+	buf[1] = (unsigned char)(value >> 8);
+}
+
+// Store little-endian 32-bit value in buffer
+static void PutUint32LE(unsigned char *buf, unsigned value)
+{
+	PutUint16LE(buf, value & 0xffff);
+	PutUint16LE(buf + 2, value >> 16);
+}
+
+// One TIFF directory entry (single value)
+struct TiffTag {
+	unsigned tag;
+	int type;
+	unsigned value;
+};
+
+// Store one TIFF directory entry
+static void PutTiffTag(unsigned char *buf, const TiffTag& entry)
+{
+	PutUint16LE(buf, entry.tag);
+	PutUint16LE(buf + 2, entry.type);
+	PutUint32LE(buf + 4, 1);
+	if (entry.type == TIFF_SHORT) {
+		PutUint16LE(buf + 8, entry.value);
+		PutUint16LE(buf + 10, 0);
+	}
+	else {
+		PutUint32LE(buf + 8, entry.value);
+	}
+}
+
+TiffWriter::TiffWriter()
+{
+	file = NULL;
+	ok = false;
+}
+
+TiffWriter::~TiffWriter()
+{
+	if (file) {
+		fclose(file);
+	}
+}
+
+bool TiffWriter::open(const char *filename, unsigned _width, unsigned _height)
+{
+	// Check size fits 32-bit offsets
+	unsigned long long dataSize = (unsigned long long) _width * _height;
+	if (dataSize + TIFF_DATA_OFFSET > 0xffffffffull) {
+		return false;
+	}
+
+	// Open file
+	file = fopen(filename, "wb");
+	if (!file) {
+		return false;
+	}
+	width = _width;
+	height = _height;
+	rowsWritten = 0;
+
+	// Header & image file directory (tags in ascending order)
+	unsigned char head[TIFF_DATA_OFFSET];
+	memset(head, 0, sizeof(head));
+	head[0] = head[1] = 'I';
+	PutUint16LE(head + 2, 42);
+	PutUint32LE(head + 4, TIFF_DIR_OFFSET);
+	unsigned char *dir = head + TIFF_DIR_OFFSET;
+	PutUint16LE(dir, TIFF_NUM_TAGS);
+	const TiffTag tags[TIFF_NUM_TAGS] = {
+		{256, TIFF_LONG, width},                    // Image width
+		{257, TIFF_LONG, height},                   // Image length
+		{258, TIFF_SHORT, 8},                       // Bits per sample
+		{259, TIFF_SHORT, 1},                       // No compression
+		{262, TIFF_SHORT, 1},                       // Black is zero
+		{273, TIFF_LONG, TIFF_DATA_OFFSET},         // Strip offsets
+		{277, TIFF_SHORT, 1},                       // Samples per pixel
+		{278, TIFF_LONG, height},                   // Rows per strip
+		{279, TIFF_LONG, (unsigned) dataSize},      // Strip byte counts
+		{282, TIFF_RATIONAL, TIFF_RES_OFFSET},      // X resolution
+		{283, TIFF_RATIONAL, TIFF_RES_OFFSET}       // Y resolution
+	};
+	for (int i = 0; i < TIFF_NUM_TAGS; i++) {
+		PutTiffTag(dir + 2 + 12 * i, tags[i]);
+	}
+	PutUint32LE(dir + 2 + 12 * TIFF_NUM_TAGS, 0);  // No next directory
+
+	// Resolution (72/1 per inch, the default unit)
+	PutUint32LE(head + TIFF_RES_OFFSET, 72);
+	PutUint32LE(head + TIFF_RES_OFFSET + 4, 1);
+	ok = fwrite(head, 1, TIFF_DATA_OFFSET, file) == TIFF_DATA_OFFSET;
+	return ok;
+}
+
+bool TiffWriter::writeRow(const unsigned char *row)
+{
+	if (!ok || rowsWritten >= height) {
+		return false;
+	}
+	ok = fwrite(row, 1, width, file) == width;
+	rowsWritten++;
+	return ok;
+}
+
+bool TiffWriter::close()
+{
+	if (!file) {
+		return false;
+	}
+
+	// Pad any missing rows with white
+	std::vector<unsigned char> blank(width, 0xff);
+	while (ok && rowsWritten < height) {
+		writeRow(blank.data());
+	}
+	ok = (fclose(file) == 0) && ok;
+	file = NULL;
+	return ok;
+}
+
+//------------------------------------------------------------------
+// Netpbm writer
+//------------------------------------------------------------------
+
+PnmWriter::PnmWriter(bool _color)
+{
+	file = NULL;
+	color = _color;
+	ok = false;
+}
+
+PnmWriter::~PnmWriter()
+{
+	if (file) {
+		fclose(file);
+	}
+}
+
+bool PnmWriter::open(const char *filename, unsigned _width, unsigned height)
+{
+	file = fopen(filename, "wb");
+	if (!file) {
+		return false;
+	}
+	width = _width;
+	rgbRow.resize(color ? (size_t) width * 3 : 0);
+	ok = fprintf(file, "%s\n%u %u\n255\n",
+	             color ? "P6" : "P5", width, height) > 0;
+	return ok;
+}
+
+bool PnmWriter::writeRow(const unsigned char *row)
+{
+	if (!ok) {
+		return false;
+	}
+	if (color) {
+		for (unsigned x = 0; x < width; x++) {
+			rgbRow[3*x] = rgbRow[3*x+1] = rgbRow[3*x+2] = row[x];
+		}
+		ok = fwrite(rgbRow.data(), 1, rgbRow.size(), file) == rgbRow.size();
+	}
+	else {
+		ok = fwrite(row, 1, width, file) == width;
+	}
+	return ok;
+}
+
+bool PnmWriter::close()
+{
+	if (!file) {
+		return false;
+	}
+	ok = (fclose(file) == 0) && ok;
+	file = NULL;
+	return ok;
+}
+
+//------------------------------------------------------------------
+// Factory
+//------------------------------------------------------------------
+
+ImageWriter* NewImageWriter(const char *format)
+{
+	if (!strcmp(format, "png"))
+		return new PngWriter();
+	if (!strcmp(format, "tif") || !strcmp(format, "tiff"))
+		return new TiffWriter();
+	if (!strcmp(format, "ppm"))
+		return new PnmWriter(true);
+	if (!strcmp(format, "pgm"))
+		return new PnmWriter(false);
+	return NULL;
+}
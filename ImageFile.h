@@ -0,0 +1,111 @@
+/*
+	Name: ImageFile.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Streaming writers for grayscale image files.
+		Rows are written top to bottom as they are produced,
+		so an image never needs to be in memory all at once.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef IMAGEFILE_H
+#define IMAGEFILE_H
+#include <cstdio>
+#include <vector>
+
+/*
+	ImageWriter interface
+	Pixels are 8-bit gray, one byte per pixel.
+*/
+class ImageWriter {
+	public:
+		virtual ~ImageWriter() {}
+		virtual bool open(
+		    const char *filename, unsigned width, unsigned height) = 0;
+		virtual bool writeRow(const unsigned char *row) = 0;
+		virtual bool close() = 0;
+};
+
+/*
+	PNG writer (8-bit grayscale).
+	Self-contained deflate encoder: rows are filtered, then coded
+	with fixed Huffman codes and run-length matches, which suits
+	the long flat runs of a map image.
+*/
+class PngWriter: public ImageWriter {
+	public:
+		PngWriter();
+		~PngWriter();
+		bool open(
+		    const char *filename, unsigned width, unsigned height) override;
+		bool writeRow(const unsigned char *row) override;
+		bool close() override;
+
+	private:
+
+		// Deflate helpers
+		void putByte(unsigned char c);
+		void putLiteral(unsigned char c);
+		void putRun();
+		void putBits(unsigned value, int count);
+		void putHuffman(unsigned code, int length);
+		void flushData(bool all);
+		void writeChunk(
+		    const char *type, const unsigned char *buf, size_t length);
+
+		// Data fields
+		FILE *file;
+		unsigned width, height, rowsWritten;
+		std::vector<unsigned char> prevRow, upRow, subRow;
+		std::vector<unsigned char> data;
+		unsigned bitBuffer;
+		int bitCount;
+		unsigned adlerA, adlerB;
+		int lastByte;
+		int runLength;
+		bool ok;
+};
+
+/*
+	Netpbm writer (binary PPM color or PGM gray).
+*/
+class PnmWriter: public ImageWriter {
+	public:
+		PnmWriter(bool color);
+		~PnmWriter();
+		bool open(
+		    const char *filename, unsigned width, unsigned height) override;
+		bool writeRow(const unsigned char *row) override;
+		bool close() override;
+
+	private:
+		FILE *file;
+		unsigned width;
+		bool color, ok;
+		std::vector<unsigned char> rgbRow;
+};
+
+/*
+	TIFF writer (8-bit grayscale, uncompressed, single strip).
+	Uses classic 32-bit offsets, so the image data must
+	stay under 4 GB.
+*/
+class TiffWriter: public ImageWriter {
+	public:
+		TiffWriter();
+		~TiffWriter();
+		bool open(
+		    const char *filename, unsigned width, unsigned height) override;
+		bool writeRow(const unsigned char *row) override;
+		bool close() override;
+
+	private:
+		FILE *file;
+		unsigned width, height, rowsWritten;
+		bool ok;
+};
+
+// Make writer for a format name ("png", "tif", "ppm", "pgm") or NULL
+ImageWriter* NewImageWriter(const char *format);
+#endif
@@ -0,0 +1,561 @@
+/*
+	Name: RasterCanvas.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of the RasterCanvas class.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "RasterCanvas.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+using std::min;
+using std::max;
+
+// Constants
+const double PI = 3.14159265358979;
+
+//------------------------------------------------------------------
+// Stroke font
+//------------------------------------------------------------------
+
+/*
+	Map text only ever uses a few single letters,
+	so we carry simple stroked outlines of those.
+	Points are on a 0-100 box: x across the glyph,
+	y down from the top of the letter to the baseline.
+	A negative x ends one stroke & starts another.
+*/
+struct StrokeGlyph {
+	char ch;
+	int advance;        // percent of em height
+	bool capital;       // cap height (else x-height)
+	int numPoints;
+	CanvasPoint pts[16];
+};
+
+const StrokeGlyph StrokeFont[] = {
+	{'S', 67, true, 14, {
+		{88, 18}, {72, 3}, {50, 0}, {28, 3}, {12, 16}, {12, 32},
+		{28, 44}, {72, 56}, {88, 68}, {88, 84}, {72, 97}, {50, 100},
+		{28, 97}, {10, 82}
+	}},
+	{'T', 61, true, 5, {
+		{5, 0}, {95, 0}, {-1, 0}, {50, 0}, {50, 100}
+	}},
+	{'X', 67, true, 5, {
+		{8, 0}, {92, 100}, {-1, 0}, {92, 0}, {8, 100}
+	}},
+	{'x', 50, false, 5, {
+		{10, 0}, {90, 100}, {-1, 0}, {90, 0}, {10, 100}
+	}}
+};
+
+// Font metrics (percent of em height)
+const int FONT_ASCENT = 91;
+const int FONT_DESCENT = 21;
+const int FONT_CAP_HEIGHT = 72;
+const int FONT_X_HEIGHT = 52;
+const int FONT_DEFAULT_ADVANCE = 50;
+
+// Find stroke glyph for a character (or NULL)
+static const StrokeGlyph* FindGlyph(char ch)
+{
+	for (const StrokeGlyph& glyph: StrokeFont) {
+		if (glyph.ch == ch)
+			return &glyph;
+	}
+	return NULL;
+}
+
+//------------------------------------------------------------------
+// Constructor & accessors
+//------------------------------------------------------------------
+
+// Constructor taking dimensions & pen scale (starts white)
+RasterCanvas::RasterCanvas(int _width, int _height, int _lineScale)
+{
+	assert(_width >= 0 && _height >= 0 && _lineScale >= 1);
+	width = _width;
+	height = _height;
+	lineScale = _lineScale;
+	originX = originY = 0;
+	clearClip();
+	pixels.assign((size_t) width * height, SHADE_WHITE);
+	pen = PEN_BLACK;
+	brush = BRUSH_WHITE;
+	font = {"", 12, false};
+	current = {0, 0};
+}
+
+int RasterCanvas::getWidth() const
+{
+	return width;
+}
+
+int RasterCanvas::getHeight() const
+{
+	return height;
+}
+
+const unsigned char* RasterCanvas::getRow(int y) const
+{
+	assert(0 <= y && y < height);
+	return pixels.data() + (size_t) y * width;
+}
+
+void RasterCanvas::clear(unsigned char shade)
+{
+	std::fill(pixels.begin(), pixels.end(), shade);
+}
+
+//------------------------------------------------------------------
+// Placement
+//------------------------------------------------------------------
+
+// Set drawing coordinate shown at top-left pixel
+void RasterCanvas::setOrigin(int x, int y)
+{
+	originX = x;
+	originY = y;
+}
+
+// Clip to a rectangle of pixels (within the canvas)
+void RasterCanvas::setClip(int left, int top, int right, int bottom)
+{
+	clipLeft = max(left, 0);
+	clipTop = max(top, 0);
+	clipRight = min(right, width);
+	clipBottom = min(bottom, height);
+}
+
+void RasterCanvas::clearClip()
+{
+	setClip(0, 0, width, height);
+}
+
+//------------------------------------------------------------------
+// Drawing tools
+//------------------------------------------------------------------
+
+void RasterCanvas::selectPen(CanvasPen _pen)
+{
+	pen = _pen;
+}
+
+void RasterCanvas::selectBrush(CanvasBrush _brush)
+{
+	brush = _brush;
+}
+
+void RasterCanvas::selectFont(const CanvasFont& _font)
+{
+	font = _font;
+}
+
+// Width of current pen (zero if none)
+int RasterCanvas::penSize() const
+{
+	switch (pen) {
+		case PEN_NULL:
+			return 0;
+		case PEN_WALL:
+			return 3 * lineScale;
+		default:
+			return lineScale;
+	}
+}
+
+// Get current brush shade (false if hollow)
+bool RasterCanvas::brushShade(unsigned char& shade) const
+{
+	switch (brush) {
+		case BRUSH_BLACK:
+			shade = SHADE_BLACK;
+			return true;
+		case BRUSH_WHITE:
+			shade = SHADE_WHITE;
+			return true;
+		default:
+			return false;
+	}
+}
+
+// Shade of current pen
+static unsigned char PenShade(CanvasPen pen)
+{
+	switch (pen) {
+		case PEN_WHITE:
+			return SHADE_WHITE;
+		case PEN_GRID:
+			return SHADE_GRAY;
+		default:
+			return SHADE_BLACK;
+	}
+}
+
+//------------------------------------------------------------------
+// Pixel helpers
+//------------------------------------------------------------------
+
+// Set one pixel (clipped)
+void RasterCanvas::plot(int x, int y, unsigned char shade)
+{
+	if (clipLeft <= x && x < clipRight && clipTop <= y && y < clipBottom) {
+		pixels[(size_t) y * width + x] = shade;
+	}
+}
+
+// Set pixels [x0, x1) on one row (clipped)
+void RasterCanvas::fillSpan(int y, int x0, int x1, unsigned char shade)
+{
+	if (y < clipTop || y >= clipBottom)
+		return;
+	x0 = max(x0, clipLeft);
+	x1 = min(x1, clipRight);
+	if (x0 < x1) {
+		memset(&pixels[(size_t) y * width + x0], shade, x1 - x0);
+	}
+}
+
+// Set a square of pixels centered on a point
+void RasterCanvas::stamp(int x, int y, int size, unsigned char shade)
+{
+	if (size <= 1) {
+		plot(x, y, shade);
+	}
+	else {
+		int x0 = x - (size - 1) / 2;
+		int y0 = y - (size - 1) / 2;
+		for (int dy = 0; dy < size; dy++) {
+			fillSpan(y0 + dy, x0, x0 + size, shade);
+		}
+	}
+}
+
+// Draw a Bresenham line, stamping pen-sized squares
+void RasterCanvas::drawLine(
+    int x0, int y0, int x1, int y1,
+    int size, bool lastPoint, unsigned char shade)
+{
+	int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+	int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+	int err = dx + dy;
+	while (x0 != x1 || y0 != y1) {
+		stamp(x0, y0, size, shade);
+		int e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+	if (lastPoint) {
+		stamp(x0, y0, size, shade);
+	}
+}
+
+//------------------------------------------------------------------
+// Shapes & lines
+//------------------------------------------------------------------
+
+void RasterCanvas::rectangle(int left, int top, int right, int bottom)
+{
+	left -= originX;
+	right -= originX;
+	top -= originY;
+	bottom -= originY;
+	if (left > right) std::swap(left, right);
+	if (top > bottom) std::swap(top, bottom);
+
+	// Fill interior
+	unsigned char shade;
+	int inset = penSize() ? 1 : 0;
+	if (brushShade(shade)) {
+		int y0 = max(top + inset, 0), y1 = min(bottom - inset, height);
+		for (int y = y0; y < y1; y++) {
+			fillSpan(y, left + inset, right - inset, shade);
+		}
+	}
+
+	// Outline with pen (centered on edge pixels)
+	int size = penSize();
+	if (size && left < right && top < bottom) {
+		unsigned char edge = PenShade(pen);
+		drawLine(left, top, right - 1, top, size, true, edge);
+		drawLine(left, bottom - 1, right - 1, bottom - 1, size, true, edge);
+		drawLine(left, top, left, bottom - 1, size, true, edge);
+		drawLine(right - 1, top, right - 1, bottom - 1, size, true, edge);
+	}
+}
+
+// Is pixel center inside ellipse bounded by box?
+bool RasterCanvas::insideEllipse(
+    int x, int y, int left, int top, int right, int bottom) const
+{
+	double rx = (right - left) / 2.0;
+	double ry = (bottom - top) / 2.0;
+	if (rx <= 0 || ry <= 0)
+		return false;
+	double nx = (x + 0.5 - (left + rx)) / rx;
+	double ny = (y + 0.5 - (top + ry)) / ry;
+	return nx * nx + ny * ny <= 1.0;
+}
+
+// Is pixel inside ellipse, but next to some pixel outside?
+bool RasterCanvas::onEllipseEdge(
+    int x, int y, int left, int top, int right, int bottom) const
+{
+	return insideEllipse(x, y, left, top, right, bottom)
+	       && (!insideEllipse(x - 1, y, left, top, right, bottom)
+	           || !insideEllipse(x + 1, y, left, top, right, bottom)
+	           || !insideEllipse(x, y - 1, left, top, right, bottom)
+	           || !insideEllipse(x, y + 1, left, top, right, bottom));
+}
+
+void RasterCanvas::ellipse(int left, int top, int right, int bottom)
+{
+	left -= originX;
+	right -= originX;
+	top -= originY;
+	bottom -= originY;
+	if (left > right) std::swap(left, right);
+	if (top > bottom) std::swap(top, bottom);
+	unsigned char fill = SHADE_WHITE;
+	bool filled = brushShade(fill);
+	unsigned char edge = PenShade(pen);
+	int size = penSize();
+	for (int y = max(top, 0); y < min(bottom, height); y++) {
+		for (int x = max(left, 0); x < min(right, width); x++) {
+			if (size && onEllipseEdge(x, y, left, top, right, bottom)) {
+				stamp(x, y, size, edge);
+			}
+			else if (filled && insideEllipse(x, y, left, top, right, bottom)) {
+				plot(x, y, fill);
+			}
+		}
+	}
+}
+
+/*
+	Fill polygon by alternate (even-odd) rule, sampling at
+	pixel centers, then outline it with the current pen.
+*/
+void RasterCanvas::polygon(const CanvasPoint *pts, int count)
+{
+	if (count < 2)
+		return;
+
+	// Shift to pixel coordinates
+	shifted.resize(count);
+	for (int i = 0; i < count; i++) {
+		shifted[i] = {pts[i].x - originX, pts[i].y - originY};
+	}
+	pts = shifted.data();
+
+	// Fill scanlines
+	unsigned char fill;
+	if (count > 2 && brushShade(fill)) {
+		int minY = pts[0].y, maxY = pts[0].y;
+		for (int i = 1; i < count; i++) {
+			minY = min(minY, pts[i].y);
+			maxY = max(maxY, pts[i].y);
+		}
+		std::vector<double> crossings;
+		for (int y = max(minY, 0); y <= min(maxY, height - 1); y++) {
+			double yc = y + 0.5;
+			crossings.clear();
+			for (int i = 0; i < count; i++) {
+				const CanvasPoint& a = pts[i];
+				const CanvasPoint& b = pts[(i + 1) % count];
+				if ((a.y <= yc && yc < b.y) || (b.y <= yc && yc < a.y)) {
+					double t = (yc - a.y) / (b.y - a.y);
+					crossings.push_back(a.x + t * (b.x - a.x));
+				}
+			}
+			std::sort(crossings.begin(), crossings.end());
+			for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+				int x0 = (int) ceil(crossings[i] - 0.5);
+				int x1 = (int) ceil(crossings[i + 1] - 0.5);
+				fillSpan(y, x0, x1, fill);
+			}
+		}
+	}
+
+	// Outline
+	if (penSize()) {
+		for (int i = 0; i < count; i++) {
+			const CanvasPoint& a = pts[i];
+			const CanvasPoint& b = pts[(i + 1) % count];
+			drawLine(a.x, a.y, b.x, b.y, penSize(), false, PenShade(pen));
+		}
+	}
+}
+
+void RasterCanvas::moveTo(int x, int y)
+{
+	current = {x - originX, y - originY};
+}
+
+/*
+	Cosmetic (thin) lines omit the last point, as in GDI;
+	thick lines are drawn end-to-end.
+*/
+void RasterCanvas::lineTo(int x, int y)
+{
+	x -= originX;
+	y -= originY;
+	int size = penSize();
+	if (size) {
+		drawLine(
+		    current.x, current.y, x, y, size, size > 1, PenShade(pen));
+	}
+	current = {x, y};
+}
+
+/*
+	Draw elliptical arc counterclockwise from start radial
+	to end radial (GDI default direction).
+*/
+void RasterCanvas::arc(
+    int left, int top, int right, int bottom,
+    int xStart, int yStart, int xEnd, int yEnd)
+{
+	if (!penSize())
+		return;
+	left -= originX;
+	right -= originX;
+	top -= originY;
+	bottom -= originY;
+	xStart -= originX;
+	yStart -= originY;
+	xEnd -= originX;
+	yEnd -= originY;
+	if (left > right) std::swap(left, right);
+	if (top > bottom) std::swap(top, bottom);
+
+	// Find center & sweep angles (y up)
+	double cx = (left + right) / 2.0;
+	double cy = (top + bottom) / 2.0;
+	double startAngle = atan2(cy - yStart, xStart - cx);
+	double endAngle = atan2(cy - yEnd, xEnd - cx);
+	double sweep = fmod(endAngle - startAngle + 4 * PI, 2 * PI);
+
+	// Draw edge pixels within sweep
+	for (int y = max(top, 0); y < min(bottom, height); y++) {
+		for (int x = max(left, 0); x < min(right, width); x++) {
+			if (onEllipseEdge(x, y, left, top, right, bottom)) {
+				double angle = atan2(cy - (y + 0.5), (x + 0.5) - cx);
+				double offset = fmod(angle - startAngle + 4 * PI, 2 * PI);
+				if (offset <= sweep) {
+					stamp(x, y, penSize(), PenShade(pen));
+				}
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------
+// Text
+//------------------------------------------------------------------
+
+int RasterCanvas::fontAscent() const
+{
+	return (font.height * FONT_ASCENT + 50) / 100;
+}
+
+int RasterCanvas::fontDescent() const
+{
+	return (font.height * FONT_DESCENT + 50) / 100;
+}
+
+int RasterCanvas::glyphAdvance(char ch) const
+{
+	const StrokeGlyph *glyph = FindGlyph(ch);
+	int advance = glyph ? glyph->advance : FONT_DEFAULT_ADVANCE;
+	return (font.height * advance + 50) / 100;
+}
+
+CanvasSize RasterCanvas::textExtent(const char *text)
+{
+	int cx = 0;
+	for (const char *c = text; *c; c++) {
+		cx += glyphAdvance(*c);
+	}
+	return {cx, textHeight()};
+}
+
+int RasterCanvas::textHeight()
+{
+	return fontAscent() + fontDescent();
+}
+
+// Draw one glyph with left edge x on a baseline
+void RasterCanvas::drawGlyph(char ch, int x, int baseline)
+{
+	const StrokeGlyph *glyph = FindGlyph(ch);
+	if (!glyph)
+		return;
+
+	// Find glyph box & stroke weight
+	int advance = glyphAdvance(ch);
+	int boxLeft = x + advance / 10;
+	int boxWidth = advance - 2 * (advance / 10);
+	int boxHeight = font.height
+	                * (glyph->capital ? FONT_CAP_HEIGHT : FONT_X_HEIGHT) / 100;
+	int boxTop = baseline - boxHeight;
+	int weight = max(1, font.height / (font.bold ? 7 : 11));
+
+	// Stroke each polyline
+	for (int i = 0; i + 1 < glyph->numPoints; i++) {
+		const CanvasPoint& a = glyph->pts[i];
+		const CanvasPoint& b = glyph->pts[i + 1];
+		if (a.x < 0 || b.x < 0)
+			continue;
+		drawLine(
+		    boxLeft + a.x * boxWidth / 100, boxTop + a.y * boxHeight / 100,
+		    boxLeft + b.x * boxWidth / 100, boxTop + b.y * boxHeight / 100,
+		    weight, true, SHADE_BLACK);
+	}
+}
+
+void RasterCanvas::textOut(
+    int x, int y, const char *text, CanvasTextAlign align, bool opaque)
+{
+	// Find left edge & baseline
+	x -= originX;
+	y -= originY;
+	CanvasSize size = textExtent(text);
+	int baseline = y + fontAscent();
+	switch (align) {
+		case ALIGN_TOP_LEFT:
+			break;
+		case ALIGN_TOP_CENTER:
+			x -= size.cx / 2;
+			break;
+		case ALIGN_BASELINE_CENTER:
+			x -= size.cx / 2;
+			baseline = y;
+			break;
+	}
+
+	// Paint background if opaque
+	if (opaque) {
+		int top = baseline - fontAscent();
+		for (int row = top; row < top + size.cy; row++) {
+			fillSpan(row, x, x + size.cx, SHADE_WHITE);
+		}
+	}
+
+	// Draw each glyph
+	for (const char *c = text; *c; c++) {
+		drawGlyph(*c, x, baseline);
+		x += glyphAdvance(*c);
+	}
+}
@@ -0,0 +1,98 @@
+/*
+	Name: RasterCanvas.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: GridCanvas drawing on an in-memory grayscale image.
+		Platform-independent (no windows.h), for headless rendering.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef RASTERCANVAS_H
+#define RASTERCANVAS_H
+#include "GridCanvas.h"
+#include <vector>
+
+// Pixel shades
+const unsigned char SHADE_BLACK = 0x00;
+const unsigned char SHADE_GRAY = 0x80;
+const unsigned char SHADE_WHITE = 0xff;
+
+/*
+	RasterCanvas interface
+	Pixels are 8-bit gray, row-major, one byte per pixel.
+	Setting the origin lets a small canvas hold one band or tile
+	of a large image. Line scale multiplies pen widths.
+*/
+class RasterCanvas: public GridCanvas {
+	public:
+
+		// Constructor
+		RasterCanvas(int width, int height, int lineScale = 1);
+
+		// Accessors
+		int getWidth() const;
+		int getHeight() const;
+		const unsigned char* getRow(int y) const;
+
+		// Mutators
+		void clear(unsigned char shade);
+
+		// GridCanvas implementation
+		void setOrigin(int x, int y) override;
+		void setClip(int left, int top, int right, int bottom) override;
+		void clearClip() override;
+		void selectPen(CanvasPen pen) override;
+		void selectBrush(CanvasBrush brush) override;
+		void selectFont(const CanvasFont& font) override;
+		void rectangle(int left, int top, int right, int bottom) override;
+		void ellipse(int left, int top, int right, int bottom) override;
+		void polygon(const CanvasPoint *pts, int count) override;
+		void moveTo(int x, int y) override;
+		void lineTo(int x, int y) override;
+		void arc(
+		    int left, int top, int right, int bottom,
+		    int xStart, int yStart, int xEnd, int yEnd) override;
+		CanvasSize textExtent(const char *text) override;
+		int textHeight() override;
+		void textOut(
+		    int x, int y, const char *text,
+		    CanvasTextAlign align, bool opaque) override;
+
+	private:
+
+		// Pixel helpers
+		void plot(int x, int y, unsigned char shade);
+		void fillSpan(int y, int x0, int x1, unsigned char shade);
+		void stamp(int x, int y, int size, unsigned char shade);
+		void drawLine(
+		    int x0, int y0, int x1, int y1,
+		    int size, bool lastPoint, unsigned char shade);
+		int penSize() const;
+		bool brushShade(unsigned char& shade) const;
+
+		// Ellipse helpers
+		bool insideEllipse(
+		    int x, int y, int left, int top, int right, int bottom) const;
+		bool onEllipseEdge(
+		    int x, int y, int left, int top, int right, int bottom) const;
+
+		// Text helpers
+		int fontAscent() const;
+		int fontDescent() const;
+		int glyphAdvance(char ch) const;
+		void drawGlyph(char ch, int x, int baseline);
+
+		// Data fields
+		int width, height;
+		int originX, originY;
+		int clipLeft, clipTop, clipRight, clipBottom;
+		int lineScale;
+		std::vector<unsigned char> pixels;
+		std::vector<CanvasPoint> shifted;
+		CanvasPen pen;
+		CanvasBrush brush;
+		CanvasFont font;
+		CanvasPoint current;
+};
+#endif
@@ -15,6 +15,16 @@
 #define IDC_NEW_HEIGHT                  113
 #define IDC_PXLS_PER_SQUARE             114
 #define IDC_DEFAULT                     115
+#define IDD_RESIZEMAP                   116
+#define IDC_ANCHOR_NW                   117
+#define IDC_ANCHOR_N                    118
+#define IDC_ANCHOR_NE                   119
+#define IDC_ANCHOR_W                    120
+#define IDC_ANCHOR_CENTER               121
+#define IDC_ANCHOR_E                    122
+#define IDC_ANCHOR_SW                   123
+#define IDC_ANCHOR_S                    124
+#define IDC_ANCHOR_SE                   125
 
 #define IDM_NEW                         201
 #define IDM_ABOUT                       202
@@ -31,6 +41,30 @@
 #define IDM_HIDE_GRID                   213
 #define IDM_ROUGH_EDGES                 214
 #define IDM_SET_GRID_SIZE               215
+#define IDM_EXPORT                      216
+#define IDM_FLOOD_FILL                  217
+#define IDM_PASTE                       218
+#define IDM_ROTATE_RIGHT                219
+#define IDM_ROTATE_LEFT                 220
+#define IDM_ROTATE_180                  221
+#define IDM_FLIP_HORZ                   222
+#define IDM_FLIP_VERT                   223
+#define IDM_RESIZE_MAP                  224
+#define IDM_CROP_MAP                    225
+#define IDM_TRIM_MAP                    226
+#define IDM_GENERATE_CAVE               227
+#define IDM_GENERATE_DUNGEON            228
+#define IDM_GENERATE_SAMPLE             229
+#define IDM_CHECK_REGIONS               230
+#define IDM_FOG_OF_WAR                  231
+#define IDM_RESET_EXPLORED              232
+#define IDM_STAIRS_DISTANCES            233
+#define IDM_NUMBER_ROOMS                234
+#define IDM_AUTO_WALL                   235
+#define IDM_AUTO_WALL_SMOOTH            236
+#define IDM_FILL_FLOOR                  237
+#define IDM_CLEAR_OBJECTS               238
+#define IDM_WALL_PERIMETER              239
 
 #define START_BASIC_FLOOR_TOOLS         300
 #define IDM_FLOOR_OPEN                  301
@@ -71,4 +105,12 @@
 #define IDM_OBJECT_XMARK                608
 #define END_OBJECT_TOOLS                699
 
+#define START_REGION_TOOLS              700
+#define IDM_REGION_ROOM                 701
+#define IDM_REGION_SELECT               702
+#define IDM_REGION_PATH                 703
+#define IDM_REGION_VIEW                 704
+#define IDM_REGION_RANGE                705
+#define END_REGION_TOOLS                799
+
 #define IDC_STATIC                      -1
@@ -0,0 +1,428 @@
+/*
+	Name: TileRenderer.cpp
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Implementation of background tile painting.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#include "TileRenderer.h"
+#include "GdiCanvas.h"
+#include <algorithm>
+using std::min;
+using std::max;
+
+//------------------------------------------------------------------
+// Constructor/ Destructor
+//------------------------------------------------------------------
+
+TileRenderer::TileRenderer(HWND _hWnd, UINT _doneMessage)
+{
+	hWnd = _hWnd;
+	doneMessage = _doneMessage;
+	quit = posted = false;
+	latest = NULL;
+	current = NULL;
+	epoch = 0;
+	widthCells = heightCells = cellSize = marginCells = 0;
+	tileCells = 1;
+	tilesWide = tilesHigh = 0;
+	idleCursor = 0;
+	view = {0, 0, 0, 0};
+	scrollX = scrollY = 0;
+	InitializeCriticalSection(&lock);
+	hWake = CreateEvent(NULL, FALSE, FALSE, NULL);
+	hThread = CreateThread(NULL, 0, threadMain, this, 0, NULL);
+}
+
+TileRenderer::~TileRenderer()
+{
+	EnterCriticalSection(&lock);
+	quit = true;
+	LeaveCriticalSection(&lock);
+	SetEvent(hWake);
+	if (hThread) {
+		WaitForSingleObject(hThread, INFINITE);
+		CloseHandle(hThread);
+	}
+	CloseHandle(hWake);
+	for (TileResult& result: finished) {
+		DeleteObject(result.hBitmap);
+	}
+	for (Snapshot *snapshot: {latest.exchange(NULL), current}) {
+		if (snapshot) {
+			delete snapshot->map;
+			delete snapshot;
+		}
+	}
+	DeleteCriticalSection(&lock);
+}
+
+//------------------------------------------------------------------
+// Content & view
+//------------------------------------------------------------------
+
+/*
+	Start painting a new map (or new cell size or display settings).
+	Everything queued is cancelled. If keepShown, tiles already shown
+	on the same size bitmap stay up until repainted.
+*/
+void TileRenderer::setMap(const GridMap& newMap, bool keepShown)
+{
+	publish(newMap);
+	bool newBitmap =
+	    !keepShown
+	    || newMap.getWidthCells() != widthCells
+	    || newMap.getHeightCells() != heightCells
+	    || newMap.getCellSizePixels() != cellSize;
+
+	// Replace tile layout
+	EnterCriticalSection(&lock);
+	widthCells = newMap.getWidthCells();
+	heightCells = newMap.getHeightCells();
+	cellSize = newMap.getCellSizePixels();
+	marginCells = newMap.getPaintMarginCells();
+	tileCells = max(1u, TILE_PIXELS / cellSize);
+	tilesWide = (widthCells + tileCells - 1) / tileCells;
+	tilesHigh = (heightCells + tileCells - 1) / tileCells;
+	tileNeed.assign(tilesWide * tilesHigh, epoch);
+	tilePending.assign(tilesWide * tilesHigh, true);
+	idleCursor = 0;
+	for (TileResult& result: finished) {
+		DeleteObject(result.hBitmap);
+	}
+	finished.clear();
+	LeaveCriticalSection(&lock);
+
+	// Forget shown tiles if bitmap is new
+	if (newBitmap) {
+		tileShown.assign(tilesWide * tilesHigh, false);
+	}
+	SetEvent(hWake);
+}
+
+/*
+	Take a snapshot after cells [left, right) x [top, bottom) are edited,
+	and repaint every tile they can paint on.
+*/
+void TileRenderer::updateCells(
+    const GridMap& source, unsigned left, unsigned top,
+    unsigned right, unsigned bottom)
+{
+	right = min(right, min(source.getWidthCells(), widthCells));
+	bottom = min(bottom, min(source.getHeightCells(), heightCells));
+	if (left >= right || top >= bottom) {
+		return;
+	}
+	publish(source);
+	EnterCriticalSection(&lock);
+	markDirty(left, top, right, bottom);
+	LeaveCriticalSection(&lock);
+	SetEvent(hWake);
+}
+
+// Set area in view (map pixels), noting the way it moved
+void TileRenderer::setViewport(int left, int top, int right, int bottom)
+{
+	EnterCriticalSection(&lock);
+	bool moved =
+	    left != view.left || top != view.top
+	    || right != view.right || bottom != view.bottom;
+	if (left != view.left) {
+		scrollX = (left > view.left ? 1 : -1);
+	}
+	if (top != view.top) {
+		scrollY = (top > view.top ? 1 : -1);
+	}
+	view = {left, top, right, bottom};
+	LeaveCriticalSection(&lock);
+	if (moved) {
+		SetEvent(hWake);
+	}
+}
+
+/*
+	Hand a snapshot of the map to the worker, replacing any it
+	hasn't taken yet. The copy shares cell storage, so this costs
+	a pointer per column, and the worker reads it with no lock
+	while the map goes on being edited.
+*/
+void TileRenderer::publish(const GridMap& source)
+{
+	Snapshot *snapshot = new Snapshot;
+	snapshot->map = new GridMap(source);
+	snapshot->epoch = ++epoch;
+	Snapshot *old = latest.exchange(snapshot);
+	if (old) {
+		delete old->map;
+		delete old;
+	}
+}
+
+// Queue tiles painted on by cells in a block (plus paint margin)
+void TileRenderer::markDirty(
+    unsigned left, unsigned top, unsigned right, unsigned bottom)
+{
+	left = left > marginCells ? left - marginCells : 0;
+	top = top > marginCells ? top - marginCells : 0;
+	right = min(right + marginCells, widthCells);
+	bottom = min(bottom + marginCells, heightCells);
+	for (unsigned ty = top / tileCells; ty <= (bottom - 1) / tileCells;
+	        ty++) {
+		for (unsigned tx = left / tileCells;
+		        tx <= (right - 1) / tileCells; tx++) {
+			unsigned index = ty * tilesWide + tx;
+			tileNeed[index] = epoch;
+			tilePending[index] = true;
+			idleCursor = min(idleCursor, index);
+		}
+	}
+}
+
+//------------------------------------------------------------------
+// Results
+//------------------------------------------------------------------
+
+/*
+	Take one finished tile to blit (caller deletes its bitmap).
+	Returns false when none are left.
+*/
+bool TileRenderer::takeTile(TileResult& result)
+{
+	EnterCriticalSection(&lock);
+	bool found = !finished.empty();
+	if (found) {
+		result = finished.back();
+		finished.pop_back();
+		int tilePixels = getTilePixels();
+		tileShown[result.top / tilePixels * tilesWide
+		          + result.left / tilePixels] = true;
+	}
+	else {
+		posted = false;
+	}
+	LeaveCriticalSection(&lock);
+	return found;
+}
+
+// Get size of a whole tile in pixels
+int TileRenderer::getTilePixels() const
+{
+	return tileCells * cellSize;
+}
+
+// Has a tile been blitted since the bitmap was made?
+bool TileRenderer::isTileShown(int tx, int ty) const
+{
+	return tx >= 0 && ty >= 0
+	       && (unsigned) tx < tilesWide && (unsigned) ty < tilesHigh
+	       && tileShown[ty * tilesWide + tx];
+}
+
+// Are all tiles in an area (map pixels) shown?
+bool TileRenderer::isAreaShown(
+    int left, int top, int right, int bottom) const
+{
+	int tilePixels = getTilePixels();
+	if (tilePixels == 0) {
+		return true;
+	}
+	int tx1 = min(right - 1, (int) (widthCells * cellSize) - 1);
+	int ty1 = min(bottom - 1, (int) (heightCells * cellSize) - 1);
+	for (int ty = max(top, 0) / tilePixels; ty <= ty1 / tilePixels; ty++) {
+		for (int tx = max(left, 0) / tilePixels; tx <= tx1 / tilePixels;
+		        tx++) {
+			if (!isTileShown(tx, ty)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+//------------------------------------------------------------------
+// Worker thread
+//------------------------------------------------------------------
+
+DWORD WINAPI TileRenderer::threadMain(LPVOID param)
+{
+	((TileRenderer *) param)->run();
+	return 0;
+}
+
+/*
+	Paint tiles until told to quit, sleeping when none are pending.
+	The newest snapshot is taken between tiles, so a tile is always
+	painted from one consistent state of the map, and the lock is
+	held only to schedule tiles, never while painting.
+*/
+void TileRenderer::run()
+{
+	HDC screenDC = GetDC(NULL);
+	HDC hDC = CreateCompatibleDC(screenDC);
+	bool idle = false;
+	{
+		GdiCanvas canvas(hDC);
+		for (;;) {
+
+			// Catch up on map changes
+			Snapshot *snapshot = latest.exchange(NULL);
+			if (snapshot) {
+				if (current) {
+					delete current->map;
+					delete current;
+				}
+				current = snapshot;
+			}
+
+			// Pick a tile (retake the snapshot if too old for it)
+			EnterCriticalSection(&lock);
+			if (quit) {
+				LeaveCriticalSection(&lock);
+				break;
+			}
+			unsigned index;
+			TilePriority priority;
+			if (!current || !pickTile(index, priority)) {
+				LeaveCriticalSection(&lock);
+				WaitForSingleObject(hWake, INFINITE);
+				continue;
+			}
+			if (current->epoch < tileNeed[index]) {
+				LeaveCriticalSection(&lock);
+				continue;
+			}
+			unsigned left = index % tilesWide * tileCells;
+			unsigned top = index / tilesWide * tileCells;
+			unsigned right = min(left + tileCells, widthCells);
+			unsigned bottom = min(top + tileCells, heightCells);
+			LeaveCriticalSection(&lock);
+
+			// Drop to idle priority for tiles out of view
+			if ((priority == TILE_IDLE) != idle) {
+				idle = (priority == TILE_IDLE);
+				SetThreadPriority(
+				    GetCurrentThread(),
+				    idle ? THREAD_PRIORITY_IDLE : THREAD_PRIORITY_NORMAL);
+			}
+
+			// Paint tile on its own bitmap
+			GridMap *map = current->map;
+			int size = map->getCellSizePixels();
+			TileResult result = {
+				NULL, (int) left * size, (int) top * size,
+				(int) (right - left) * size, (int) (bottom - top) * size
+			};
+			result.hBitmap =
+			    CreateCompatibleBitmap(screenDC, result.width, result.height);
+			if (result.hBitmap) {
+				HGDIOBJ oldBitmap = SelectObject(hDC, result.hBitmap);
+				canvas.setOrigin(result.left, result.top);
+				canvas.setClip(0, 0, result.width, result.height);
+				map->paintRegion(canvas, left, top, right, bottom);
+				SelectObject(hDC, oldBitmap);
+			}
+
+			// Hand back unless a later change needs it (or layout changed)
+			// (a tile we can't make a bitmap for is given up)
+			EnterCriticalSection(&lock);
+			bool upToDate =
+			    index < tileNeed.size() && current->epoch >= tileNeed[index];
+			if (upToDate) {
+				tilePending[index] = false;
+			}
+			bool wanted = upToDate && result.hBitmap;
+			if (wanted) {
+				finished.push_back(result);
+				if (!posted) {
+					posted = PostMessage(hWnd, doneMessage, 0, 0);
+				}
+			}
+			LeaveCriticalSection(&lock);
+			if (!wanted && result.hBitmap) {
+				DeleteObject(result.hBitmap);
+			}
+		}
+	}
+	DeleteDC(hDC);
+	ReleaseDC(NULL, screenDC);
+}
+
+/*
+	Choose the next tile to paint (lock held): the pending tile
+	nearest the middle of the view, else the nearest in a margin
+	around it (wider ahead of the last scroll), else the next in
+	map order.
+*/
+bool TileRenderer::pickTile(unsigned& index, TilePriority& priority)
+{
+	if (pickNearest(view.left, view.top, view.right, view.bottom,
+	                false, index)) {
+		priority = TILE_VISIBLE;
+		return true;
+	}
+	int tilePixels = getTilePixels();
+	int width = view.right - view.left;
+	int height = view.bottom - view.top;
+	if (pickNearest(
+	            view.left - tilePixels - (scrollX < 0 ? width : 0),
+	            view.top - tilePixels - (scrollY < 0 ? height : 0),
+	            view.right + tilePixels + (scrollX > 0 ? width : 0),
+	            view.bottom + tilePixels + (scrollY > 0 ? height : 0),
+	            true, index)) {
+		priority = TILE_PREFETCH;
+		return true;
+	}
+	while (idleCursor < tilePending.size() && !tilePending[idleCursor]) {
+		idleCursor++;
+	}
+	if (idleCursor < tilePending.size()) {
+		index = idleCursor;
+		priority = TILE_IDLE;
+		return true;
+	}
+	return false;
+}
+
+// Find the pending tile in an area (map pixels) nearest the view middle
+bool TileRenderer::pickNearest(
+    int left, int top, int right, int bottom, bool skipVisible,
+    unsigned& index)
+{
+	int tilePixels = getTilePixels();
+	right = min(right, (int) (widthCells * cellSize));
+	bottom = min(bottom, (int) (heightCells * cellSize));
+	left = max(left, 0);
+	top = max(top, 0);
+	if (tilePixels == 0 || left >= right || top >= bottom) {
+		return false;
+	}
+	long long middleX = (view.left + view.right) / 2;
+	long long middleY = (view.top + view.bottom) / 2;
+	long long best = -1;
+	for (int ty = top / tilePixels; ty <= (bottom - 1) / tilePixels; ty++) {
+		for (int tx = left / tilePixels; tx <= (right - 1) / tilePixels;
+		        tx++) {
+			unsigned tile = ty * tilesWide + tx;
+			int tileLeft = tx * tilePixels;
+			int tileTop = ty * tilePixels;
+			if (!tilePending[tile]
+			        || (skipVisible
+			            && tileLeft < view.right
+			            && tileLeft + tilePixels > view.left
+			            && tileTop < view.bottom
+			            && tileTop + tilePixels > view.top)) {
+				continue;
+			}
+			long long dx = tileLeft + tilePixels / 2 - middleX;
+			long long dy = tileTop + tilePixels / 2 - middleY;
+			long long distance = dx * dx + dy * dy;
+			if (best < 0 || distance < best) {
+				best = distance;
+				index = tile;
+			}
+		}
+	}
+	return best >= 0;
+}
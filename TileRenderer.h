@@ -0,0 +1,110 @@
+/*
+	Name: TileRenderer.h
+	Copyright: 2026
+	Author: Daniel R. Collins
+	Date: 18-10-26
+	Description: Background painting of the editor map in tiles.
+		A worker thread paints square tiles of cells from snapshots
+		of the map, handed over without locks: visible tiles first,
+		then a margin reaching ahead in the scroll direction, then
+		the rest at idle priority.
+		Finished tiles are handed back for the UI thread to blit,
+		so the editor never waits on a paint.
+		See file LICENSE for licensing information.
+		Contact author at delta@superdan.net
+*/
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+#include <windows.h>
+#include "GridMap.h"
+#include <atomic>
+#include <vector>
+
+// Scheduling classes for tiles (most urgent first)
+enum TilePriority {
+	TILE_VISIBLE, TILE_PREFETCH, TILE_IDLE
+};
+
+// A finished tile, to blit onto the map bitmap at (left, top)
+struct TileResult {
+	HBITMAP hBitmap;
+	int left, top, width, height;
+};
+
+/*
+	TileRenderer interface
+	All public calls are from the UI thread, on the map it edits.
+	Content changes (new map, cell edits, zoom) publish a new snapshot
+	and cancel tiles queued or being painted from older ones.
+*/
+class TileRenderer {
+	public:
+
+		// Constructor (posts doneMessage to window when tiles finish)
+		TileRenderer(HWND hWnd, UINT doneMessage);
+		~TileRenderer();
+
+		// Content & view
+		void setMap(const GridMap& map, bool keepShown = false);
+		void updateCells(
+		    const GridMap& map, unsigned left, unsigned top,
+		    unsigned right, unsigned bottom);
+		void setViewport(int left, int top, int right, int bottom);
+
+		// Results
+		bool takeTile(TileResult& result);
+		int getTilePixels() const;
+		bool isTileShown(int tx, int ty) const;
+		bool isAreaShown(int left, int top, int right, int bottom) const;
+
+	private:
+
+		// Worker thread
+		static DWORD WINAPI threadMain(LPVOID param);
+		void run();
+		bool pickTile(unsigned& index, TilePriority& priority);
+		bool pickNearest(
+		    int left, int top, int right, int bottom, bool skipVisible,
+		    unsigned& index);
+		void markDirty(
+		    unsigned left, unsigned top, unsigned right, unsigned bottom);
+
+		// Map copy published for the worker, numbered by epoch
+		struct Snapshot {
+			GridMap *map;
+			unsigned epoch;
+		};
+		void publish(const GridMap& map);
+
+		// Thread handles (fixed for life)
+		HWND hWnd;
+		UINT doneMessage;
+		HANDLE hThread, hWake;
+		CRITICAL_SECTION lock;
+
+		// Latest snapshot not yet taken by worker (swapped atomically)
+		std::atomic<Snapshot*> latest;
+
+		// Shared state (under lock)
+		// (tileNeed is the first snapshot epoch a tile can be shown from)
+		bool quit, posted;
+		unsigned widthCells, heightCells, cellSize, marginCells;
+		unsigned tileCells, tilesWide, tilesHigh;
+		std::vector<unsigned> tileNeed;
+		std::vector<bool> tilePending;
+		unsigned idleCursor;
+		RECT view;
+		int scrollX, scrollY;
+		std::vector<TileResult> finished;
+
+		// UI thread only
+		unsigned epoch;
+		std::vector<bool> tileShown;
+
+		// Worker thread only
+		Snapshot *current;
+
+		// Tile size aimed for, in pixels
+		static const int TILE_PIXELS = 256;
+};
+#endif